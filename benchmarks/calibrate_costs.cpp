@@ -0,0 +1,50 @@
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include "cost_calibration.hpp"
+
+// Fits the planners' cost constants to this machine and writes them where
+// QueryPlanner::load_cost_config and PhysicalPlanner::load_cost_config read
+// them from.
+//
+// Usage: calibrate_costs [output file] [workload scale]
+int main(int argc, char* argv[]) {
+    const std::string output = argc > 1 ? argv[1] : "planner_costs.conf";
+    db25::CalibrationConfig config;
+    if (argc > 2) {
+        config.scale = std::atof(argv[2]);
+        if (config.scale <= 0.0) {
+            std::cerr << "Workload scale must be positive" << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        const db25::CostCalibration calibration = db25::calibrate_cost_model(config);
+
+        std::cout << std::left << std::setw(24) << "Workload" << std::right << std::setw(12) << "Time (ms)" << std::endl;
+        for (const auto& sample : calibration.samples) {
+            std::cout << std::left << std::setw(24) << sample.workload << std::right << std::setw(12)
+                      << std::fixed << std::setprecision(3) << sample.seconds * 1000.0 << std::endl;
+        }
+        std::cout << "\nFit error: " << std::setprecision(1) << calibration.fit_error * 100.0 << "%\n\n";
+        std::cout.unsetf(std::ios::floatfield);
+        db25::write_cost_constants(std::cout, calibration.constants);
+
+        std::ofstream out(output);
+        if (!out) {
+            std::cerr << "Cannot write " << output << std::endl;
+            return 1;
+        }
+        out << "# Planner cost constants fitted by calibrate_costs (fit error "
+            << std::fixed << std::setprecision(1) << calibration.fit_error * 100.0 << "%)\n";
+        out.unsetf(std::ios::floatfield);
+        db25::write_cost_constants(out, calibration.constants);
+        std::cout << "\nWrote " << output << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Calibration failed: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
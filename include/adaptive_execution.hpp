@@ -0,0 +1,54 @@
+#pragma once
+
+#include "physical_planner.hpp"
+#include "query_planner.hpp"
+#include <string>
+#include <vector>
+
+namespace db25 {
+    struct AdaptiveExecutionConfig {
+        // Re-plan when a checkpoint returns this many times more or fewer
+        // rows than estimated
+        double misestimate_threshold = 10.0;
+        size_t max_replans = 3;
+    };
+
+    // One re-plan triggered by a misestimated checkpoint
+    struct AdaptiveReplan {
+        std::string signature; // Of the checkpoint subplan
+        double estimated_rows = 0.0;
+        double actual_rows = 0.0;
+        std::string plan; // Physical plan chosen for the rest of the query
+    };
+
+    // Executes a plan in stages, cut at the inputs of its pipeline breakers:
+    // sort and aggregate inputs and the inner side of nested loop joins.
+    // Each checkpoint is run to completion and kept in memory. When its row
+    // count is off by misestimate_threshold or more, the rest of the query is
+    // planned again with the rows seen so far, so joins above it can change
+    // algorithm, order or sides; checkpoints already run are read back
+    // instead of being executed again.
+    class AdaptiveExecutor {
+    public:
+        AdaptiveExecutor(QueryPlanner &query_planner, PhysicalPlanner &physical_planner,
+                         const AdaptiveExecutionConfig &config = {});
+
+        // plan as returned by QueryPlanner::create_plan or optimize_plan; it
+        // is optimized again on every re-plan. Row counts of every stage are
+        // recorded in the query planner's cardinality feedback.
+        std::vector<Tuple> execute(const LogicalPlan &plan);
+
+        // Re-plans of the last execute, in order
+        [[nodiscard]] const std::vector<AdaptiveReplan> &replans() const { return replans_; }
+
+        // Physical plan the last execute finished with
+        [[nodiscard]] const PhysicalPlan &final_plan() const { return final_plan_; }
+
+    private:
+        QueryPlanner &query_planner_;
+        PhysicalPlanner &physical_planner_;
+        AdaptiveExecutionConfig config_;
+        std::vector<AdaptiveReplan> replans_;
+        PhysicalPlan final_plan_;
+    };
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "logical_plan.hpp"
+#include "physical_plan.hpp"
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace db25 {
+    // Canonical text of the rows a logical subplan produces. Join algorithms,
+    // access paths, sorts and projections are left out, and the inputs and
+    // conditions of inner join blocks are put in order, so every plan that
+    // computes the same rows gets the same signature.
+    std::string plan_signature(const LogicalPlanNodePtr &node);
+
+    // Estimated against actual rows of one subplan
+    struct CardinalityObservation {
+        std::string signature;
+        double estimated_rows = 0.0; // Of the latest execution
+        double actual_rows = 0.0; // Smoothed over executions
+        double q_error = 1.0; // Larger of estimate and actual over the smaller, latest execution
+        size_t executions = 0;
+    };
+
+    // Row counts seen by executing plans, keyed by query fingerprint and
+    // subplan signature. The planner looks subplans up while costing, so a
+    // recurring query is planned with what its subplans actually returned;
+    // what other queries saw is used for subplans this one has not run.
+    class CardinalityFeedback {
+    public:
+        explicit CardinalityFeedback(double smoothing = 0.5);
+
+        // Records each node of an executed plan that carries a signature and
+        // ran to completion; nodes cut short by a limit, or whose rows a
+        // pushed-down Top-N boundary cut, are skipped
+        void record(const std::string &fingerprint, const PhysicalPlanNodePtr &root);
+
+        void record(const PhysicalPlan &plan) { record(plan.fingerprint, plan.root); }
+
+        void record(const std::string &fingerprint, const std::string &signature, double estimated_rows,
+                    double actual_rows);
+
+        [[nodiscard]] std::optional<double> actual_rows(const std::string &fingerprint,
+                                                        const std::string &signature) const;
+
+        // Observations of one query, worst estimate first
+        [[nodiscard]] std::vector<CardinalityObservation> observations(const std::string &fingerprint) const;
+
+        [[nodiscard]] bool empty() const;
+
+        void clear();
+
+    private:
+        double smoothing_; // Weight of the newest execution in actual_rows
+        mutable std::mutex mutex_;
+        std::unordered_map<std::string, std::unordered_map<std::string, CardinalityObservation> > queries_;
+        std::unordered_map<std::string, CardinalityObservation> subplans_; // Over every query
+
+        void observe(CardinalityObservation &observation, double estimated_rows, double actual_rows) const;
+    };
+}
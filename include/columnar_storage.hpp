@@ -0,0 +1,207 @@
+#pragma once
+
+#include "table_storage.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace db25 {
+
+enum class ColumnEncoding {
+    PLAIN,              // One typed value per row
+    DICTIONARY,         // Bit-packed codes into the distinct values, in ascending order
+    RLE,                // One value per run of equal values
+    FRAME_OF_REFERENCE  // Bit-packed offsets from the smallest integer, date or timestamp
+};
+
+// count values of one column, typed by kind. For plain segments the arrays
+// point into the segment, so reading a vector copies nothing; other
+// encodings are decoded into a VectorBuffer. Vectors start at multiples of
+// 64 rows, so validity words line up with the segment's.
+struct ColumnVector {
+    StorageKind kind = StorageKind::VARIABLE;
+    size_t count = 0;
+    const uint64_t* validity = nullptr; // Bit i set when value i is not NULL
+    const int64_t* integers = nullptr;
+    const double* decimals = nullptr;
+    const uint8_t* booleans = nullptr;
+    const uint32_t* offsets = nullptr; // Value i is bytes [offsets[i], offsets[i + 1])
+    const char* bytes = nullptr;
+
+    bool is_null(size_t i) const { return !((validity[i / 64] >> (i % 64)) & 1); }
+
+    // Value i as the executor writes it; "" for NULL
+    std::string value(size_t i) const;
+};
+
+// Values a ColumnVector of a compressed segment is decoded into; reused
+// from one vector to the next
+struct VectorBuffer {
+    std::vector<int64_t> integers;
+    std::vector<double> decimals;
+    std::vector<uint8_t> booleans;
+    std::vector<uint32_t> offsets;
+    std::string bytes;
+    std::vector<uint64_t> codes;
+    std::vector<uint64_t> validity;
+};
+
+// A ColumnPredicate prepared for one segment, so that rows are tested
+// without decoding them: dictionary codes and runs against the entries
+// that match, frame-of-reference offsets against the ranges that do
+struct SegmentFilter {
+    ColumnPredicate predicate;
+    std::vector<double> numbers;   // The constants as numbers, when they are
+    std::vector<uint64_t> entries; // Dictionary and RLE: a bit per matching entry
+    std::vector<std::pair<uint64_t, uint64_t>> ranges; // Frame of reference: matching offsets, inclusive
+    bool negate = false; // The ranges hold the offsets that do not match
+};
+
+// Rows that share one RLE entry
+struct ColumnRun {
+    size_t entry = 0;
+    size_t length = 0;
+};
+
+// Values of one column within a row group, with a validity bitmap. Plain
+// segments hold a typed array, or concatenated bytes with count + 1 offsets
+// delimiting them. compress() re-encodes a segment with the scheme that a
+// sample of its values suggests is smallest.
+class ColumnSegment {
+public:
+    explicit ColumnSegment(ColumnType type);
+
+    // Whether value ("" for NULL) can be stored in a column of kind
+    static bool accepts(StorageKind kind, const std::string& value);
+
+    // Appends value, which accepts must allow; a compressed segment is
+    // decompressed first
+    void append(const std::string& value);
+
+    // Dictionary for repeated values, RLE for runs, frame of reference for
+    // integers, dates and timestamps in a narrow range; plain when none
+    // of them comes out smaller
+    void compress();
+    void decompress();
+
+    ColumnType type() const { return type_; }
+    StorageKind kind() const { return kind_; }
+    ColumnEncoding encoding() const { return encoding_; }
+    size_t size() const { return size_; }
+    size_t null_count() const { return null_count_; }
+    size_t bytes_used() const;
+    const ZoneMap& zone() const { return zone_; }
+
+    // count values from offset, a multiple of 64. Only plain segments may
+    // be read without a buffer.
+    ColumnVector vector(size_t offset, size_t count) const;
+    ColumnVector vector(size_t offset, size_t count, VectorBuffer& buffer) const;
+
+    std::string value(size_t row) const;
+
+    // Kernels on the encoded values. select clears the bit of each row from
+    // offset, of count rows, that filter rejects; NULLs always are.
+    SegmentFilter prepare(const ColumnPredicate& predicate) const;
+    void select(const SegmentFilter& filter, size_t offset, size_t count, uint64_t* selection) const;
+
+    // Validity words from offset, a multiple of 64
+    const uint64_t* validity(size_t offset) const { return validity_.data() + offset / 64; }
+
+    // Dictionary codes of the rows, and RLE runs covering them; each is an
+    // index into entries, the distinct values or run values, never NULL
+    void codes(size_t offset, size_t count, uint32_t* codes) const;
+    void runs(size_t offset, size_t count, std::vector<ColumnRun>& runs) const;
+    size_t entry_count() const { return values(); }
+    ColumnVector entries(VectorBuffer& buffer) const;
+
+private:
+    ColumnType type_;
+    StorageKind kind_;
+    ColumnEncoding encoding_ = ColumnEncoding::PLAIN;
+    size_t size_ = 0;
+    size_t null_count_ = 0;
+    ZoneMap zone_;
+    std::vector<uint64_t> validity_;
+
+    // Plain: a value per row; dictionary: the distinct values; RLE: a value per run
+    std::vector<int64_t> integers_;
+    std::vector<double> decimals_;
+    std::vector<uint8_t> booleans_;
+    std::vector<uint32_t> offsets_{0};
+    std::string bytes_;
+
+    std::vector<uint32_t> run_ends_; // RLE: row after each run
+    std::vector<uint64_t> packed_;   // Dictionary codes or offsets from reference_, width_ bits each
+    int64_t reference_ = 0;
+    unsigned width_ = 0;
+
+    bool valid(size_t row) const { return (validity_[row / 64] >> (row % 64)) & 1; }
+    size_t values() const; // Entries in the typed arrays
+    std::string_view text(size_t index) const;
+    int compare_entries(size_t a, size_t b) const;
+    bool entry_matches(const SegmentFilter& filter, size_t index) const;
+    uint64_t first_offset(const SegmentFilter& filter, size_t constant, bool above) const;
+    void push_value(const ColumnSegment& from, size_t index);
+    bool temporal() const { return type_ == ColumnType::DATE || type_ == ColumnType::TIMESTAMP; }
+    bool integer_values(std::vector<int64_t>& values) const;
+
+    ColumnSegment encode_dictionary() const;
+    ColumnSegment encode_rle() const;
+    ColumnSegment encode_frame_of_reference(const std::vector<int64_t>& values) const;
+};
+
+// Rows first_row to first_row + row_count - 1, one segment per column,
+// each with the zone map of its values
+struct RowGroup {
+    size_t first_row = 0;
+    size_t row_count = 0;
+    std::vector<ColumnSegment> columns;
+};
+
+// Column store of one table: rows are appended to row groups of
+// row_group_size rows, each holding one segment per column, so a scan
+// reads the segments of the columns it needs and none of the others.
+// A row group's segments are compressed once it is full. Row ids are
+// positions in insert order, as in TableHeap.
+class ColumnarTable {
+public:
+    static constexpr size_t default_row_group_size = 16384;
+
+    // row_group_size must be a positive multiple of 64. Throws
+    // std::runtime_error otherwise.
+    explicit ColumnarTable(const Table& table, size_t row_group_size = default_row_group_size);
+
+    // Appends a row with one value per column and returns its row id.
+    // Throws std::runtime_error, storing nothing, when a value does not fit
+    // its column type.
+    size_t insert(const std::vector<std::string>& values);
+
+    const std::string& name() const { return name_; }
+    const std::vector<Column>& columns() const { return columns_; }
+    size_t row_count() const { return row_count_; }
+    size_t row_group_size() const { return row_group_size_; }
+    size_t row_group_count() const { return row_groups_.size(); }
+    const RowGroup& row_group(size_t index) const { return row_groups_[index]; }
+
+    // Bytes of the segments of columns, of all of them when columns is empty
+    size_t bytes_used(const std::vector<size_t>& columns = {}) const;
+
+    // Compresses the last row group too, typically after a bulk load. Rows
+    // appended later decompress its segments again.
+    void compress();
+
+    std::string value(size_t row, size_t column) const;
+
+private:
+    std::string name_;
+    std::vector<Column> columns_;
+    size_t row_group_size_;
+    std::vector<RowGroup> row_groups_;
+    size_t row_count_ = 0;
+};
+
+} // namespace db25
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "logical_plan.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace db25 {
+
+// Display text of an expression tree, e.g. "upper(u.name)" or "p.price * 2"
+std::string expression_to_string(const ExpressionPtr& expr);
+
+// Expression compiled against a fixed input row layout. Column references
+// are resolved to positions once and the tree is flattened into a postfix
+// program run on a value stack, so evaluating a row costs no name lookups or
+// recursion. Values follow the tuple conventions: NULL is the empty string,
+// booleans are "true"/"false", and NULL propagates through operators.
+class CompiledExpression {
+public:
+    // Compiles expr for rows laid out as input_columns. Returns false if the
+    // expression uses an operator or function that cannot be evaluated or
+    // names a column the input does not have.
+    bool compile(const ExpressionPtr& expr, const std::vector<std::string>& input_columns);
+
+    // Evaluates the program on one row. Not safe to call concurrently on the
+    // same instance: the value stack is reused between rows.
+    std::string evaluate(const std::vector<std::string>& row) const;
+
+    // Input position when the expression is a bare column reference, else -1
+    int column_index() const;
+    bool empty() const { return program.empty(); }
+
+private:
+    enum class OpCode : uint8_t {
+        LOAD_COLUMN,
+        LOAD_CONSTANT,
+        ADD,
+        SUBTRACT,
+        MULTIPLY,
+        DIVIDE,
+        MODULO,
+        NEGATE,
+        CONCAT,
+        EQUAL,
+        NOT_EQUAL,
+        LESS,
+        LESS_EQUAL,
+        GREATER,
+        GREATER_EQUAL,
+        AND,
+        OR,
+        NOT,
+        UPPER,
+        LOWER,
+        LENGTH,
+        ABS,
+        COALESCE,
+        CONCAT_ALL
+    };
+
+    struct Instruction {
+        OpCode op;
+        size_t operand = 0; // Column position, constant slot or argument count
+    };
+
+    std::vector<Instruction> program;
+    std::vector<std::string> constants;
+    mutable std::vector<std::string> stack;
+
+    bool emit(const ExpressionPtr& expr, const std::vector<std::string>& input_columns);
+    void execute(const Instruction& instruction) const;
+};
+
+} // namespace db25
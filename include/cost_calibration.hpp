@@ -0,0 +1,71 @@
+#pragma once
+
+#include "physical_planner.hpp"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace db25 {
+    // Cost model constants shared by the logical and physical planners, in
+    // the same arbitrary unit. Defaults are PostgreSQL's.
+    struct CostConstants {
+        double seq_page_cost = 1.0;
+        double random_page_cost = 4.0;
+        double cpu_tuple_cost = 0.01;
+        double cpu_index_tuple_cost = 0.005;
+        double cpu_operator_cost = 0.0025;
+
+        void apply(PlannerConfig &config) const;
+
+        // The physical planner only charges the CPU constants
+        void apply(PhysicalPlannerConfig &config) const;
+    };
+
+    // Reads "name = value" lines as written by write_cost_constants; blank
+    // lines and # comments are skipped and missing names keep their default.
+    // Throws std::runtime_error on an unknown name or a malformed value.
+    CostConstants read_cost_constants(std::istream &in);
+
+    CostConstants load_cost_constants(const std::string &path);
+
+    void write_cost_constants(std::ostream &out, const CostConstants &constants);
+
+    // Work a plan is charged for, counted in the units each constant prices
+    struct CostUnits {
+        double seq_pages = 0.0;
+        double random_pages = 0.0;
+        double tuples = 0.0;
+        double index_tuples = 0.0;
+        double operators = 0.0;
+    };
+
+    // One timed run of a micro-workload
+    struct CalibrationSample {
+        std::string workload;
+        CostUnits units; // As the planners would charge the workload
+        double seconds = 0.0;
+    };
+
+    struct CalibrationConfig {
+        size_t repetitions = 5; // Runs per workload; the fastest one is kept
+        double scale = 1.0; // Multiplies the row counts of every workload
+    };
+
+    struct CostCalibration {
+        CostConstants constants;
+        std::vector<CalibrationSample> samples;
+        double fit_error = 0.0; // Root mean square of the relative error over samples
+    };
+
+    // Non-negative least squares fit of the seconds each unit of work takes,
+    // weighted so every sample counts by its relative error. The result is
+    // scaled so cpu_tuple_cost keeps its default, the per-row cost being the
+    // best determined one; constants the fit drives to zero are floored at a
+    // hundredth of it so no work is ever planned as free.
+    CostConstants fit_cost_constants(const std::vector<CalibrationSample> &samples, double *fit_error = nullptr);
+
+    // Times scan, filter, hash build and probe, sort and index lookup
+    // micro-workloads with this executor on this machine and fits the cost
+    // constants to them
+    CostCalibration calibrate_cost_model(const CalibrationConfig &config = {});
+}
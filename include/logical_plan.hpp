@@ -116,6 +116,7 @@ namespace db25 {
         std::string table_name;
         std::string alias;
         std::vector<ExpressionPtr> filter_conditions;
+        std::vector<std::string> required_columns; // Columns read above the scan; empty means all
 
         explicit TableScanNode(std::string table)
             : LogicalPlanNode(PlanNodeType::TABLE_SCAN), table_name(std::move(table)) {
@@ -133,6 +134,7 @@ namespace db25 {
         std::string alias;
         std::vector<ExpressionPtr> index_conditions;
         std::vector<ExpressionPtr> filter_conditions;
+        std::vector<std::string> required_columns; // Columns read above the scan; empty means all
 
         IndexScanNode(std::string table, std::string index)
             : LogicalPlanNode(PlanNodeType::INDEX_SCAN), table_name(std::move(table)), index_name(std::move(index)) {
@@ -180,6 +182,17 @@ namespace db25 {
         [[nodiscard]] LogicalPlanNodePtr copy() const override;
     };
 
+    // Merge join node: both inputs ordered on the equi-join keys
+    struct MergeJoinNode : JoinNode {
+        explicit MergeJoinNode(JoinType jt)
+            : JoinNode(PlanNodeType::MERGE_JOIN, jt) {
+        }
+
+        [[nodiscard]] std::string to_string(int indent) const override;
+
+        [[nodiscard]] LogicalPlanNodePtr copy() const override;
+    };
+
     // Projection node
     struct ProjectionNode : LogicalPlanNode {
         std::vector<ExpressionPtr> projections;
@@ -302,6 +315,7 @@ namespace db25 {
         LogicalPlanNodePtr root;
         std::unordered_map<std::string, std::string> table_aliases;
         PlanCost total_cost;
+        std::string fingerprint; // Of the query, for cardinality feedback
 
         LogicalPlan() = default;
 
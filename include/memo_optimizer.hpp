@@ -0,0 +1,134 @@
+#pragma once
+
+#include "query_planner.hpp"
+#include <map>
+#include <set>
+
+namespace db25 {
+    // Cascades-style search over a memo of equivalence groups. A group holds
+    // the logical expressions known to produce the same rows, each reading
+    // its inputs as groups, so a subplan shared by many alternatives is
+    // planned once. Transformation rules add equivalent expressions (join
+    // commutativity and associativity); implementation rules turn each one
+    // into operators: sequential or index scans, nested loop, hash or merge
+    // joins. Sort orders are physical properties that an operator either
+    // delivers or has enforced by a sort, so sort placement is costed together
+    // with join algorithms and access paths.
+    //
+    // Groups are optimized top-down with the cheapest plan found so far as an
+    // upper bound: the inputs of an alternative are not planned once its own
+    // cost reaches the bound.
+    class MemoOptimizer {
+    public:
+        MemoOptimizer(const QueryPlanner &planner, std::shared_ptr<DatabaseSchema> schema);
+
+        // Cheapest plan equivalent to root
+        LogicalPlanNodePtr optimize(const LogicalPlanNodePtr &root);
+
+        // After optimize: the cheapest plan for each way of implementing each
+        // expression of the root group, cheapest first
+        std::vector<LogicalPlanNodePtr> alternatives();
+
+        [[nodiscard]] size_t group_count() const { return groups_.size(); }
+
+        [[nodiscard]] size_t expression_count() const;
+
+    private:
+        using GroupId = size_t;
+        using InputSet = uint64_t; // Inputs of a join block, by bit position
+        using Ordering = std::vector<SortNode::SortKey>;
+
+        // Logical operator over input groups
+        struct MemoExpression {
+            LogicalPlanNodePtr op; // Children cleared
+            std::vector<GroupId> inputs;
+            unsigned applied_rules = 0; // Transformation rules already fired, by bit
+        };
+
+        struct Winner {
+            LogicalPlanNodePtr plan; // Null if no plan beat bound
+            double bound = 0.0;
+        };
+
+        struct Group {
+            std::vector<MemoExpression> expressions;
+            std::map<std::string, std::string> relations; // Scanned below: alias -> table
+            size_t rows = 0;
+            size_t block = 0; // Join block the group is a join of, 0 for none
+            InputSet members = 0; // Block inputs covered, for block joins and inputs
+            std::map<std::string, Winner> winners; // By required ordering
+        };
+
+        // Inner joins over the same inputs, which may be reordered freely
+        struct JoinBlock {
+            std::vector<GroupId> inputs;
+            std::vector<std::pair<ExpressionPtr, InputSet> > conditions; // With the inputs each reads
+            std::map<InputSet, GroupId> groups;
+            bool reorder = false;
+        };
+
+        // Input an operator needs planned, in a given order
+        struct InputRequest {
+            GroupId group;
+            Ordering ordering;
+            bool enforce; // Whether a sort may provide the order
+        };
+
+        using TransformationRule = void (MemoOptimizer::*)(GroupId group, size_t expression);
+
+        const QueryPlanner &planner_;
+        std::shared_ptr<DatabaseSchema> schema_;
+        std::vector<Group> groups_;
+        std::vector<JoinBlock> blocks_; // Block 0 stands for none
+        std::map<std::string, std::string> relations_; // Every relation in the plan
+        GroupId root_ = 0;
+
+        // Memo construction
+        GroupId copy_in(const LogicalPlanNodePtr &node);
+
+        GroupId copy_in_block(const LogicalPlanNodePtr &node, size_t block,
+                              const std::vector<LogicalPlanNodePtr> &inputs);
+
+        GroupId join_group(size_t block, GroupId left, GroupId right);
+
+        void add_expression(GroupId group, MemoExpression expression);
+
+        [[nodiscard]] std::vector<ExpressionPtr> conditions_between(size_t block, InputSet left, InputSet right) const;
+
+        // Transformation rules
+        void explore();
+
+        void commute_join(GroupId group, size_t expression);
+
+        void associate_join(GroupId group, size_t expression);
+
+        // Implementation rules and search
+        LogicalPlanNodePtr optimize_group(GroupId group, const Ordering &ordering, double bound);
+
+        LogicalPlanNodePtr optimize_enforced(GroupId group, const Ordering &ordering, double bound);
+
+        std::vector<LogicalPlanNodePtr> implement(GroupId group, const MemoExpression &expression,
+                                                  const Ordering &ordering, double bound);
+
+        void implement_scan(const std::shared_ptr<TableScanNode> &scan, const Ordering &ordering, double bound,
+                            std::vector<LogicalPlanNodePtr> &candidates);
+
+        void implement_join(const MemoExpression &expression, const Ordering &ordering, double bound,
+                            std::vector<LogicalPlanNodePtr> &candidates);
+
+        LogicalPlanNodePtr plan_alternative(const LogicalPlanNodePtr &node, const std::vector<InputRequest> &requests,
+                                            double bound);
+
+        // Sort order properties
+        [[nodiscard]] std::string column_key(const ExpressionPtr &expr) const;
+
+        [[nodiscard]] std::string ordering_key(const Ordering &ordering) const;
+
+        [[nodiscard]] bool satisfies(const Ordering &provided, const Ordering &required) const;
+
+        [[nodiscard]] bool resolves_within(const Ordering &ordering, GroupId group) const;
+
+        [[nodiscard]] Ordering index_ordering(const std::string &table_name, const std::string &alias,
+                                              const std::string &index_name) const;
+    };
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace db25 {
+
+// Value domain used to encode a sort key. INFERRED keys are typed from the
+// values being sorted; numeric types widen (INTEGER -> FLOAT -> TEXT) when a
+// value does not fit, so a declared type is a hint rather than a guarantee.
+enum class SortKeyType {
+    INFERRED,
+    INTEGER,
+    FLOAT,
+    TEXT
+};
+
+// Returns the narrowest type at least as wide as current that can encode value.
+// NULL (the empty string) fits every type.
+SortKeyType widen_sort_key_type(SortKeyType current, const std::string& value);
+
+// Appends the normalized encoding of value to out. Concatenating the encodings
+// of several keys yields a byte string whose memcmp order is the requested
+// multi-column order, including direction and NULL placement. Values must fit
+// type (see widen_sort_key_type); INFERRED is encoded as TEXT.
+void append_normalized_key(std::string& out, const std::string& value, SortKeyType type,
+                           bool ascending, bool nulls_first);
+
+// A normalized key stored in an external buffer, tagged with the row it sorts
+struct NormalizedKeyRef {
+    const unsigned char* data = nullptr;
+    uint32_t length = 0;
+    uint32_t row = 0;
+};
+
+// Orders two normalized keys bytewise; shorter keys sort first on a tie
+int compare_normalized_keys(const NormalizedKeyRef& a, const NormalizedKeyRef& b);
+
+// Sorts keys into memcmp order: MSD radix sort on the key bytes, with
+// pattern-defeating quicksort for small buckets and long shared prefixes
+void sort_normalized_keys(std::vector<NormalizedKeyRef>& keys);
+
+// Sorts keys on up to degree threads. A sorted sample picks degree - 1
+// splitters, keys are scattered into the disjoint ranges they define, and each
+// range is sorted independently, so the ranges concatenate without a merge.
+void parallel_sort_normalized_keys(std::vector<NormalizedKeyRef>& keys, size_t degree);
+
+} // namespace db25
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "logical_plan.hpp"
+#include "compiled_expression.hpp"
+#include "normalized_key.hpp"
+#include "row_bitmap.hpp"
+#include "columnar_storage.hpp"
 #include <memory>
 #include <vector>
 #include <unordered_map>
@@ -33,6 +37,7 @@ struct Tuple {
     
     Tuple() = default;
     Tuple(const std::vector<std::string>& vals) : values(vals) {}
+    Tuple(std::vector<std::string>&& vals) : values(std::move(vals)) {}
     
     std::string get_value(size_t index) const {
         return index < values.size() ? values[index] : "";
@@ -77,23 +82,54 @@ struct TupleBatch {
     bool is_full() const { return tuples.size() >= batch_size; }
 };
 
+// Batch of rows as one typed vector per column, for operators that work a
+// column at a time
+struct ColumnBatch {
+    std::vector<std::string> column_names;
+    std::vector<ColumnVector> columns;
+    size_t row_count = 0;
+    size_t first_row = 0;            // Row id of the first row
+    std::vector<uint64_t> selection; // Bit i set when row i passes the filters
+};
+
+// Stretch of a row group and which of its rows pass a scan's filters, for
+// operators that read the encoded segments themselves
+struct ColumnSelection {
+    const RowGroup* group = nullptr;
+    size_t offset = 0; // First row within group, a multiple of 64
+    size_t row_count = 0;
+    std::vector<uint64_t> rows; // Bit i set when row offset + i passes
+    
+    bool any() const;
+};
+
 // Physical operator interface
 enum class PhysicalOperatorType {
     SEQUENTIAL_SCAN,
+    COLUMNAR_SCAN,
     INDEX_SCAN,
+    INDEX_ONLY_SCAN,
+    BITMAP_INDEX_SCAN,
+    BITMAP_AND,
+    BITMAP_OR,
     BITMAP_HEAP_SCAN,
     NESTED_LOOP_JOIN,
+    INDEX_NESTED_LOOP_JOIN,
     HASH_JOIN,
     MERGE_JOIN,
     SORT,
     HASH_AGGREGATE,
     GROUP_AGGREGATE,
+    COLUMNAR_AGGREGATE,
     LIMIT,
+    PROJECTION,
+    FILTER,
     MATERIALIZE,
     GATHER,
     GATHER_MERGE,
     PARALLEL_SEQ_SCAN,
-    PARALLEL_HASH_JOIN
+    PARALLEL_HASH_JOIN,
+    TOP_N
 };
 
 // Execution statistics
@@ -104,6 +140,8 @@ struct ExecutionStats {
     size_t memory_used_bytes = 0;
     size_t disk_reads = 0;
     size_t disk_writes = 0;
+    size_t blocks_skipped = 0; // Pages or row groups zone maps ruled out
+    size_t rows_cut = 0;       // Matching rows a pushed-down Top-N boundary kept from the output
     bool used_temp_files = false;
     
     void merge(const ExecutionStats& other) {
@@ -113,18 +151,30 @@ struct ExecutionStats {
         memory_used_bytes = std::max(memory_used_bytes, other.memory_used_bytes);
         disk_reads += other.disk_reads;
         disk_writes += other.disk_writes;
+        blocks_skipped += other.blocks_skipped;
+        rows_cut += other.rows_cut;
         used_temp_files = used_temp_files || other.used_temp_files;
     }
 };
 
+// Sort key shared by the sort-based operators and by output orderings
+struct PhysicalSortKey {
+    ExpressionPtr expression;
+    bool ascending = true;
+    bool nulls_first = false;
+    SortKeyType type = SortKeyType::INFERRED; // Declared column type, if known
+};
+
 // Base physical plan node
 struct PhysicalPlanNode {
     PhysicalOperatorType type;
     std::vector<PhysicalPlanNodePtr> children;
     std::vector<std::string> output_columns;
+    std::vector<PhysicalSortKey> output_ordering; // Order the output is known to have
     PlanCost estimated_cost;
     ExecutionStats actual_stats;
     ExecutionContext* context = nullptr;
+    std::string signature; // Logical subplan computed, for cardinality feedback; empty if none
     
     PhysicalPlanNode(PhysicalOperatorType t) : type(t) {}
     virtual ~PhysicalPlanNode() = default;
@@ -158,15 +208,105 @@ protected:
     }
 };
 
+// Column lookup helpers shared by operators that evaluate keys on tuples.
+// resolve_column_index returns -1 when the expression names no input column.
+int resolve_column_index(const std::vector<std::string>& columns, const ExpressionPtr& expr);
+size_t sort_key_column_index(const std::vector<std::string>& columns, const ExpressionPtr& expr);
+
+// One column = column equality of an equi-join
+struct EquiJoinKey {
+    ExpressionPtr left;
+    ExpressionPtr right;
+};
+
+// Splits join conditions (AND trees or "a = b AND c = d" text) into column
+// equalities. Returns false if any condition is not such an equality.
+bool extract_equi_join_keys(const std::vector<ExpressionPtr>& conditions, std::vector<EquiJoinKey>& keys);
+
+// Reads condition as column op value, a comparison (=, <, <=, >, >=) of a
+// column with a constant, the constant moved to the right. column is the
+// name without its qualifier. False for any other condition.
+bool column_comparison(const ExpressionPtr& condition, std::string& column, std::string& op, std::string& value);
+
+// Widens types, one per column, until the values of rows at columns fit them
+void widen_key_types(std::vector<SortKeyType>& types, const std::vector<Tuple>& rows,
+                     const std::vector<size_t>& columns);
+
+// Normalized key of the values of row at columns, encoded in types with the
+// direction and NULL placement of keys (ascending, NULLs last when keys is
+// empty). Byte order of these keys is the order PhysicalSortNode produces
+// for the same types.
+std::string normalized_row_key(const Tuple& row, const std::vector<size_t>& columns,
+                               const std::vector<SortKeyType>& types, const std::vector<PhysicalSortKey>& keys = {});
+
+// Running boundary of a Top-N heap, published to the scan below it. Once the
+// heap is full, rows whose leading key sorts after the boundary can never be
+// returned, so the scan drops them before they are copied up the plan.
+struct TopNThreshold {
+    PhysicalSortKey key;
+    SortKeyType type = SortKeyType::INFERRED; // The heap's type for the leading key
+    bool active = false;
+    std::string boundary; // Normalized leading key of the heap's last row
+    size_t rows_skipped = 0;
+    
+    // Values that do not fit type are let through, so the heap can widen it
+    bool admits(const std::string& value) const;
+};
+
+// Rows of a table by row id, read in place from its heap when it has one
+// and from tuples otherwise
+struct TableRows {
+    const TableHeap* heap = nullptr;
+    const std::vector<Tuple>* tuples = nullptr;
+    
+    size_t size() const;
+    std::string value(size_t row, size_t column) const;
+    
+    // The given table columns of a row; all of them when columns is empty
+    Tuple read(size_t row, const std::vector<size_t>& columns) const;
+};
+
+// Sorts rows into index order: ascending on their normalized keys at
+// key_columns, NULLs last, in the declared types of the columns, widened
+// only where a value does not fit one. Rows with equal keys keep their
+// order. Returns the types.
+std::vector<SortKeyType> sort_index_rows(std::vector<Tuple>& rows, const std::vector<size_t>& key_columns,
+                                         const std::vector<SortKeyType>& declared_types);
+
+// Entries of an index: the key_columns values of every table row in key
+// order, each with the id of its row. Entries of equal keys keep row id
+// order.
+struct IndexEntries {
+    std::vector<Tuple> keys;
+    std::vector<uint32_t> rows;
+    std::vector<SortKeyType> key_types; // Types keys are ordered in
+    
+    IndexEntries(const TableRows& table, const std::vector<size_t>& key_columns,
+                 const std::vector<SortKeyType>& declared_types);
+};
+
 // Sequential scan operator
 struct SequentialScanNode : PhysicalPlanNode {
     std::string table_name;
     std::string alias;
     std::vector<ExpressionPtr> filter_conditions;
+    std::shared_ptr<TopNThreshold> topn_threshold;
     
-    // Mock data source - in real implementation this would connect to storage
+    // Worker slice of the table: partition_index of partition_count equal row ranges
+    size_t partition_index = 0;
+    size_t partition_count = 1;
+    
+    // Table row positions of output_columns; empty when every column is returned
+    std::vector<size_t> projected_columns;
+    
+    // Rows are read in place from heap when set; mock_data stands in otherwise.
+    // Heap pages whose zone maps rule out a condition on a column and
+    // constants are skipped; disk_reads counts the pages read.
+    std::shared_ptr<const TableHeap> heap;
     std::vector<Tuple> mock_data;
     size_t current_position = 0;
+    size_t last_page = SIZE_MAX; // Heap page of the last row read
+    int threshold_column = -1;
     
     SequentialScanNode(const std::string& table) 
         : PhysicalPlanNode(PhysicalOperatorType::SEQUENTIAL_SCAN), table_name(table) {}
@@ -179,6 +319,73 @@ struct SequentialScanNode : PhysicalPlanNode {
     PhysicalPlanNodePtr copy() const override;
     
     void generate_mock_data(size_t num_rows);
+    
+    TableRows rows() const { return {heap.get(), &mock_data}; }
+    size_t partition_begin() const { return rows().size() * partition_index / std::max<size_t>(partition_count, 1); }
+    size_t partition_end() const { return rows().size() * (partition_index + 1) / std::max<size_t>(partition_count, 1); }
+    
+private:
+    std::vector<CompiledExpression> compiled_filters; // filter_conditions evaluated on each row
+    std::vector<ExpressionPtr> text_filters;          // Conditions the compiler rejects, matched on their text
+    std::vector<std::pair<size_t, ColumnPredicate>> zone_filters; // Table column and condition, for the heap's zone maps
+};
+
+// Columnar scan: reads only the segments of the projected columns, row
+// group by row group, as typed column batches of up to vector_size rows.
+// Compressed segments are decoded into buffers the node reuses, so a
+// batch's vectors last until the next call. Row operators get the batches
+// as tuples, after filter_conditions, from get_next_batch. disk_reads
+// counts the pages of the segments read.
+//
+// Conditions comparing a column with constants (=, <>, <, <=, >, >= and
+// IN lists, written as IN or as equalities joined by OR) are tested on the
+// encoded segments: dictionary codes, runs and frame-of-reference offsets.
+// Only the rows they select are decoded for the other conditions and
+// turned into tuples. Row groups whose zone maps rule out one of them are
+// not read at all.
+struct PhysicalColumnarScanNode : PhysicalPlanNode {
+    static constexpr size_t vector_size = 2048;
+    
+    std::string table_name;
+    std::string alias;
+    std::vector<ExpressionPtr> filter_conditions;
+    std::vector<size_t> projected_columns; // Table positions of output_columns; empty for all
+    std::shared_ptr<const ColumnarTable> table;
+    
+    explicit PhysicalColumnarScanNode(const std::string& table_name)
+        : PhysicalPlanNode(PhysicalOperatorType::COLUMNAR_SCAN), table_name(table_name) {}
+    
+    void initialize(ExecutionContext* ctx) override;
+    TupleBatch get_next_batch() override;
+    void reset() override;
+    
+    std::string to_string(int indent = 0) const override;
+    PhysicalPlanNodePtr copy() const override;
+    
+    // The next rows of the table, with the selection of those that pass
+    // filter_conditions; row_count is 0 once every row has been read
+    ColumnBatch next_column_batch();
+    
+    // The same without decoding any column the conditions do not need
+    ColumnSelection next_selection();
+    
+    // Table position of output column position, once initialized
+    size_t table_column(size_t position) const { return read_columns[position]; }
+    
+    // Conditions tested on the encoded segments, once initialized
+    size_t encoded_filter_count() const { return encoded_filters.size(); }
+    
+private:
+    std::vector<size_t> read_columns; // Table positions of output_columns
+    std::vector<VectorBuffer> buffers; // One per read column
+    std::vector<std::pair<size_t, ColumnPredicate>> encoded_filters; // Output position and predicate
+    std::vector<SegmentFilter> segment_filters; // encoded_filters prepared for row_group
+    std::vector<CompiledExpression> compiled_filters;
+    std::vector<ColumnVector> vectors; // Read columns of the last selection, once decoded
+    size_t row_group = 0;
+    size_t group_offset = 0; // Next row within row_group
+    
+    void decode(const ColumnSelection& selection);
 };
 
 // Index scan operator
@@ -186,11 +393,19 @@ struct PhysicalIndexScanNode : PhysicalPlanNode {
     std::string table_name;
     std::string index_name;
     std::string alias;
+    std::vector<std::string> index_columns; // Key columns; rows are returned in this order
+    std::vector<SortKeyType> index_key_types; // Schema types of index_columns; INFERRED follows the values
     std::vector<ExpressionPtr> index_conditions;
     std::vector<ExpressionPtr> filter_conditions;
+    std::vector<size_t> projected_columns; // Table row positions of output_columns; empty for all
     
+    // With a heap the index is built over it on first use and rows are
+    // fetched from it by row id; otherwise mock_data holds rows in key order
+    std::shared_ptr<const TableHeap> heap;
     std::vector<Tuple> mock_data;
     size_t current_position = 0;
+    size_t scan_begin = 0; // Index positions index_conditions select
+    size_t scan_end = 0;
     
     PhysicalIndexScanNode(const std::string& table, const std::string& index) 
         : PhysicalPlanNode(PhysicalOperatorType::INDEX_SCAN), 
@@ -204,6 +419,125 @@ struct PhysicalIndexScanNode : PhysicalPlanNode {
     PhysicalPlanNodePtr copy() const override;
     
     void generate_mock_data(size_t num_rows);
+    
+    // Index lookup for nested-loop probes: the rows [first, second) whose
+    // leading index columns equal key. Probes with ascending keys can pass the
+    // previous result's first row as hint to search forward from it.
+    std::pair<size_t, size_t> probe(const std::vector<std::string>& key, size_t hint = 0) const;
+    
+    // Row at an index position, narrowed to output_columns
+    Tuple fetch(size_t position) const;
+    
+    // Whether a fetched row satisfies filter_conditions
+    bool passes_filters(const Tuple& row) const;
+    
+    // Types rows are ordered in on the leading index columns, once initialized
+    const std::vector<SortKeyType>& ordered_key_types() const { return key_types; }
+    
+private:
+    std::vector<size_t> key_positions; // index_columns resolved against the rows searched
+    std::vector<SortKeyType> key_types; // Types the index rows are ordered in
+    std::vector<CompiledExpression> compiled_filters;
+    std::shared_ptr<const IndexEntries> entries; // Over heap; shared by copies
+    
+    const std::vector<Tuple>& index_rows() const { return entries ? entries->keys : mock_data; }
+    
+    void seek_index_conditions();
+};
+
+// Index-only scan: answers from the index entries alone, for queries whose
+// every column is an index column, so no table row is fetched. mock_data
+// holds the entries, which carry the index columns in table order as
+// output_columns lists them; heap is not read.
+struct PhysicalIndexOnlyScanNode : PhysicalIndexScanNode {
+    std::vector<size_t> entry_columns; // Table row positions of the entry values
+    
+    PhysicalIndexOnlyScanNode(const std::string& table, const std::string& index);
+    
+    void initialize(ExecutionContext* ctx) override;
+    PhysicalPlanNodePtr copy() const override;
+    
+    // Replaces mock_data with the entries of the rows of table, in index key order
+    void build_entries(const TableRows& table);
+};
+
+// Produces a bitmap of table row ids (positions of rows in the table)
+// instead of rows; a bitmap heap scan reads the table through a tree of
+// these. Parents initialize their children, as for row operators.
+struct PhysicalBitmapNode : PhysicalPlanNode {
+    using PhysicalPlanNode::PhysicalPlanNode;
+    
+    // Row ids of the rows of table this node selects
+    virtual RowBitmap build_bitmap(const TableRows& table) = 0;
+    
+    // Bitmap nodes return no rows of their own
+    TupleBatch get_next_batch() override;
+    void reset() override { actual_stats = ExecutionStats(); }
+};
+
+// Bitmap index scan: searches index_name with index_conditions and collects
+// the row ids of the matching entries. rows_returned counts the entries.
+struct PhysicalBitmapIndexScanNode : PhysicalBitmapNode {
+    std::string table_name;
+    std::string index_name;
+    std::vector<std::string> index_columns;
+    std::vector<SortKeyType> index_key_types; // Schema types of index_columns; INFERRED follows the values
+    std::vector<ExpressionPtr> index_conditions;
+    std::vector<std::string> table_columns; // Layout of the table rows
+    
+    PhysicalBitmapIndexScanNode(const std::string& table, const std::string& index)
+        : PhysicalBitmapNode(PhysicalOperatorType::BITMAP_INDEX_SCAN), table_name(table), index_name(index) {}
+    
+    RowBitmap build_bitmap(const TableRows& table) override;
+    
+    std::string to_string(int indent = 0) const override;
+    PhysicalPlanNodePtr copy() const override;
+    
+private:
+    std::shared_ptr<const IndexEntries> entries;
+};
+
+// BitmapAnd and BitmapOr: intersect or unite the bitmaps of their children
+struct PhysicalBitmapCombineNode : PhysicalBitmapNode {
+    explicit PhysicalBitmapCombineNode(PhysicalOperatorType t) : PhysicalBitmapNode(t) {}
+    
+    void initialize(ExecutionContext* ctx) override;
+    RowBitmap build_bitmap(const TableRows& table) override;
+    
+    std::string to_string(int indent = 0) const override;
+    PhysicalPlanNodePtr copy() const override;
+};
+
+// Bitmap heap scan: reads the rows of its child's bitmap in row id order,
+// so each table page is fetched once and in physical order however many
+// index entries point into it, then applies filter_conditions. Pages are
+// those of heap when set and of rows_per_page rows of mock_data otherwise.
+struct PhysicalBitmapHeapScanNode : PhysicalPlanNode {
+    static constexpr size_t rows_per_page = 100; // Rows of one simulated table page
+    
+    std::string table_name;
+    std::string alias;
+    std::vector<ExpressionPtr> filter_conditions;
+    std::vector<size_t> projected_columns; // Table row positions of output_columns; empty for all
+    
+    std::shared_ptr<const TableHeap> heap;
+    std::vector<Tuple> mock_data; // Table rows in physical order
+    std::vector<uint32_t> row_ids;
+    size_t current_position = 0;
+    
+    explicit PhysicalBitmapHeapScanNode(const std::string& table)
+        : PhysicalPlanNode(PhysicalOperatorType::BITMAP_HEAP_SCAN), table_name(table) {}
+    
+    void initialize(ExecutionContext* ctx) override;
+    TupleBatch get_next_batch() override;
+    void reset() override;
+    
+    std::string to_string(int indent = 0) const override;
+    PhysicalPlanNodePtr copy() const override;
+    
+private:
+    std::vector<CompiledExpression> compiled_filters;
+    size_t last_page = SIZE_MAX; // Page of the last row read
 };
 
 // Nested loop join operator
@@ -233,6 +567,49 @@ private:
     Tuple merge_tuples(const Tuple& outer_tuple, const Tuple& inner_tuple);
 };
 
+// Index nested-loop join: for each batch of outer rows, looks up the matching
+// inner rows in the index of the inner PhysicalIndexScanNode instead of
+// rescanning it. The batch's keys are probed in ascending order so each
+// lookup continues from the previous one; results keep the outer row order.
+struct PhysicalIndexNestedLoopJoinNode : PhysicalPlanNode {
+    JoinType join_type;
+    std::vector<ExpressionPtr> join_conditions;
+    std::vector<ExpressionPtr> outer_keys;
+    std::vector<ExpressionPtr> inner_keys; // Leading keys follow the index column order
+    size_t index_key_count = 1;            // Keys answered by the index; the rest are rechecked
+    
+    explicit PhysicalIndexNestedLoopJoinNode(JoinType jt)
+        : PhysicalPlanNode(PhysicalOperatorType::INDEX_NESTED_LOOP_JOIN), join_type(jt) {}
+    
+    void initialize(ExecutionContext* ctx) override;
+    TupleBatch get_next_batch() override;
+    void reset() override;
+    void cleanup() override;
+    
+    std::string to_string(int indent = 0) const override;
+    PhysicalPlanNodePtr copy() const override;
+    
+    size_t get_probe_count() const { return probe_count; }
+    
+private:
+    std::shared_ptr<PhysicalIndexScanNode> index;
+    std::vector<size_t> outer_columns;
+    std::vector<size_t> inner_columns;
+    std::vector<SortKeyType> inner_types; // Index types of inner key columns; INFERRED off the index
+    size_t inner_width = 0;
+    
+    // Current outer batch and the index range probed for each of its rows
+    TupleBatch outer_batch;
+    std::vector<std::pair<size_t, size_t>> probe_ranges;
+    size_t outer_index = 0;
+    size_t match_position = 0;
+    bool outer_matched = false;
+    size_t probe_count = 0;
+    
+    void probe_outer_batch();
+    bool keys_match(const Tuple& outer_tuple, const Tuple& inner_tuple) const;
+};
+
 // Hash join operator
 struct PhysicalHashJoinNode : PhysicalPlanNode {
     JoinType join_type;
@@ -265,15 +642,70 @@ private:
     Tuple merge_tuples(const Tuple& left_tuple, const Tuple& right_tuple);
 };
 
+// Merge join operator: joins two inputs sorted ascending (NULLs last) on the
+// equi-join keys, buffering the current group of equal inner keys so that
+// duplicate keys on both sides produce every matching pair
+struct PhysicalMergeJoinNode : PhysicalPlanNode {
+    JoinType join_type;
+    std::vector<ExpressionPtr> join_conditions;
+    std::vector<ExpressionPtr> left_keys;
+    std::vector<ExpressionPtr> right_keys;
+    std::vector<SortKeyType> key_types; // Schema types both inputs are ordered in
+    
+    explicit PhysicalMergeJoinNode(JoinType jt)
+        : PhysicalPlanNode(PhysicalOperatorType::MERGE_JOIN), join_type(jt) {}
+    
+    void initialize(ExecutionContext* ctx) override;
+    TupleBatch get_next_batch() override;
+    void reset() override;
+    void cleanup() override;
+    
+    std::string to_string(int indent = 0) const override;
+    PhysicalPlanNodePtr copy() const override;
+    
+private:
+    // Batch-at-a-time cursor over one sorted input
+    struct Input {
+        PhysicalPlanNodePtr child;
+        TupleBatch batch;
+        size_t index = 0;
+        bool exhausted = false;
+        
+        const Tuple* current();
+        void advance() { ++index; }
+    };
+    
+    Input left_input;
+    Input right_input;
+    std::vector<size_t> left_columns;
+    std::vector<size_t> right_columns;
+    size_t left_width = 0;
+    size_t right_width = 0;
+    std::vector<SortKeyType> merge_types; // key_types widened to fit both inputs
+    bool keys_settled = false;
+    
+    // Inner rows sharing the key currently being matched
+    std::vector<Tuple> right_group;
+    std::vector<std::string> group_key;
+    bool group_matched = false;
+    size_t group_position = 0;
+    
+    void settle_key_types();
+    bool index_orders_keys(const PhysicalIndexScanNode& index, const std::vector<size_t>& columns) const;
+    std::vector<std::string> extract_keys(const Tuple& tuple, const std::vector<size_t>& columns) const;
+    int compare_keys(const std::vector<std::string>& a, const std::vector<std::string>& b) const;
+    Tuple pad_left(const Tuple& right_tuple) const;
+    Tuple pad_right(const Tuple& left_tuple) const;
+    bool emits_unmatched_left() const;
+    bool emits_unmatched_right() const;
+};
+
 // Sort operator
 struct PhysicalSortNode : PhysicalPlanNode {
-    struct SortKey {
-        ExpressionPtr expression;
-        bool ascending = true;
-        bool nulls_first = false;
-    };
+    using SortKey = PhysicalSortKey;
     
     std::vector<SortKey> sort_keys;
+    size_t parallel_degree = 1; // Workers used to encode and sort large inputs
     std::vector<Tuple> sorted_data;
     size_t current_position = 0;
     bool sorting_complete = false;
@@ -288,10 +720,75 @@ struct PhysicalSortNode : PhysicalPlanNode {
     std::string to_string(int indent = 0) const override;
     PhysicalPlanNodePtr copy() const override;
     
+    // Reads the whole input, unless it was read already, and returns the
+    // types the keys would be ordered in. Types passed to settle_key_types
+    // before the first batch widen these, so two sorts can share one order.
+    std::vector<SortKeyType> collect_input();
+    void settle_key_types(const std::vector<SortKeyType>& types);
+    
 private:
+    std::vector<size_t> key_columns;
+    std::vector<SortKeyType> settled_types;
+    bool input_collected = false;
+    
     void perform_sort();
-    bool compare_tuples(const Tuple& a, const Tuple& b);
-    std::string extract_sort_value(const Tuple& tuple, const ExpressionPtr& expr);
+    std::vector<SortKeyType> resolve_key_types() const;
+    size_t sort_workers() const;
+};
+
+// Projection operator: evaluates the SELECT list on every input row, with
+// expressions compiled against the input layout when the node is initialized.
+// Plain column references are copied without running a program.
+struct PhysicalProjectionNode : PhysicalPlanNode {
+    std::vector<ExpressionPtr> expressions; // One per output column
+    
+    PhysicalProjectionNode() : PhysicalPlanNode(PhysicalOperatorType::PROJECTION) {}
+    
+    void initialize(ExecutionContext* ctx) override;
+    TupleBatch get_next_batch() override;
+    void reset() override;
+    
+    std::string to_string(int indent = 0) const override;
+    PhysicalPlanNodePtr copy() const override;
+    
+private:
+    std::vector<CompiledExpression> compiled;
+};
+
+// Filter operator: keeps the input rows for which every condition is true.
+// Conditions on a single table run in the scans; this evaluates the rest,
+// such as predicates over the null-supplying side of an outer join.
+struct PhysicalFilterNode : PhysicalPlanNode {
+    std::vector<ExpressionPtr> conditions;
+    
+    PhysicalFilterNode() : PhysicalPlanNode(PhysicalOperatorType::FILTER) {}
+    
+    void initialize(ExecutionContext* ctx) override;
+    TupleBatch get_next_batch() override;
+    void reset() override;
+    
+    std::string to_string(int indent = 0) const override;
+    PhysicalPlanNodePtr copy() const override;
+    
+private:
+    std::vector<CompiledExpression> compiled;
+};
+
+// Materialize operator: replays rows computed earlier, such as a subplan
+// that adaptive execution ran to completion before re-planning the rest.
+// Copies share the rows.
+struct PhysicalMaterializeNode : PhysicalPlanNode {
+    std::shared_ptr<const std::vector<Tuple>> rows;
+    size_t current_position = 0;
+    
+    PhysicalMaterializeNode() : PhysicalPlanNode(PhysicalOperatorType::MATERIALIZE) {}
+    
+    void initialize(ExecutionContext* ctx) override;
+    TupleBatch get_next_batch() override;
+    void reset() override;
+    
+    std::string to_string(int indent = 0) const override;
+    PhysicalPlanNodePtr copy() const override;
 };
 
 // Hash aggregate operator
@@ -323,6 +820,59 @@ private:
     Tuple create_result_tuple(const std::string& group_key);
 };
 
+// Aggregate over a columnar scan, its only child, that works on the
+// encoded segments: grouping on a dictionary or RLE column numbers the
+// groups by code or run instead of hashing each row's values, and without
+// GROUP BY, aggregates of RLE columns add a run at a time. Other columns
+// are decoded. SUM, AVG, MIN and MAX take integer and decimal columns.
+// Output: the group columns, then one column per aggregate, one row per
+// group in the order groups first appear.
+struct PhysicalColumnarAggregateNode : PhysicalPlanNode {
+    enum class Function { COUNT, SUM, AVG, MIN, MAX };
+    
+    struct Aggregate {
+        Function function = Function::COUNT;
+        std::optional<size_t> column; // Scan output position; none for COUNT(*)
+    };
+    
+    std::vector<size_t> group_columns; // Scan output positions
+    std::vector<Aggregate> aggregates;
+    
+    PhysicalColumnarAggregateNode() : PhysicalPlanNode(PhysicalOperatorType::COLUMNAR_AGGREGATE) {}
+    
+    void initialize(ExecutionContext* ctx) override;
+    TupleBatch get_next_batch() override;
+    void reset() override;
+    
+    std::string to_string(int indent = 0) const override;
+    PhysicalPlanNodePtr copy() const override;
+    
+private:
+    struct Accumulator {
+        size_t count = 0;
+        int64_t integer_sum = 0;
+        double sum = 0;
+        int64_t integer_min = 0;
+        int64_t integer_max = 0;
+        double min = 0;
+        double max = 0;
+        
+        void add(int64_t value, size_t rows);
+        void add(double value, size_t rows);
+    };
+    
+    std::vector<StorageKind> kinds; // Of each aggregate's column
+    std::vector<std::vector<std::string>> group_values; // Of each group
+    std::vector<std::vector<Accumulator>> accumulators;  // Of each group, one per aggregate
+    std::unordered_map<std::string, size_t> group_numbers;
+    size_t next_group = 0;
+    bool aggregation_complete = false;
+    
+    void perform_aggregation();
+    size_t group_number(const std::vector<std::string>& values);
+    std::string result(size_t aggregate, const Accumulator& accumulator) const;
+};
+
 // Limit operator
 struct PhysicalLimitNode : PhysicalPlanNode {
     std::optional<size_t> limit;
@@ -340,11 +890,77 @@ struct PhysicalLimitNode : PhysicalPlanNode {
     PhysicalPlanNodePtr copy() const override;
 };
 
+// Top-N operator: fused ORDER BY ... LIMIT [OFFSET] that keeps only the best
+// limit + offset rows in a bounded heap instead of sorting the whole input
+struct PhysicalTopNNode : PhysicalPlanNode {
+    std::vector<PhysicalSortKey> sort_keys;
+    size_t limit = 0;
+    size_t offset = 0;
+    std::shared_ptr<TopNThreshold> threshold;
+    
+    std::vector<Tuple> result_data;
+    size_t current_position = 0;
+    bool heap_complete = false;
+    
+    PhysicalTopNNode() : PhysicalPlanNode(PhysicalOperatorType::TOP_N) {}
+    
+    void initialize(ExecutionContext* ctx) override;
+    TupleBatch get_next_batch() override;
+    void reset() override;
+    void cleanup() override;
+    
+    std::string to_string(int indent = 0) const override;
+    PhysicalPlanNodePtr copy() const override;
+    
+private:
+    struct HeapEntry {
+        std::string key; // Normalized sort key in key_types
+        Tuple tuple;
+    };
+    
+    std::vector<size_t> key_columns;
+    std::vector<SortKeyType> key_types; // Declared types, widened as values arrive
+    
+    void build_heap();
+    bool fill_heap(std::vector<HeapEntry>& heap);
+};
+
+// Gather merge operator: runs each child (a worker producing a sorted stream)
+// on its own thread and merges the streams into one ordered output
+struct GatherMergeNode : PhysicalPlanNode {
+    std::vector<PhysicalSortKey> sort_keys;
+    
+    std::vector<std::vector<Tuple>> worker_results;
+    bool workers_complete = false;
+    
+    GatherMergeNode() : PhysicalPlanNode(PhysicalOperatorType::GATHER_MERGE) {}
+    
+    void initialize(ExecutionContext* ctx) override;
+    TupleBatch get_next_batch() override;
+    void reset() override;
+    void cleanup() override;
+    
+    std::string to_string(int indent = 0) const override;
+    PhysicalPlanNodePtr copy() const override;
+    
+private:
+    std::vector<size_t> key_columns;
+    std::vector<SortKeyType> key_types; // Settled for all workers, keys are merged in them
+    std::vector<std::vector<std::string>> worker_keys; // Normalized key of each worker row
+    std::vector<size_t> cursors;
+    std::vector<size_t> merge_heap; // Workers with rows left, ordered by their next row
+    
+    void run_workers();
+    void order_worker(size_t worker);
+    bool worker_after(size_t a, size_t b) const;
+};
+
 // Physical plan container
 struct PhysicalPlan {
     PhysicalPlanNodePtr root;
     ExecutionContext context;
     ExecutionStats total_stats;
+    std::string fingerprint; // Of the query planned, for cardinality feedback
     
     PhysicalPlan() = default;
     PhysicalPlan(PhysicalPlanNodePtr r) : root(r) {}
@@ -387,6 +1003,7 @@ struct ParallelSequentialScanNode : PhysicalPlanNode {
     
     std::shared_ptr<ParallelContext> parallel_ctx;
     std::vector<std::thread> worker_threads;
+    std::shared_ptr<const TableHeap> heap; // Read in place when set, instead of mock_data
     std::vector<Tuple> mock_data;
     
     ParallelSequentialScanNode(const std::string& table, size_t degree) 
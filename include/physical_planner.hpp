@@ -5,6 +5,7 @@
 #include "database.hpp"
 #include "query_planner.hpp"
 #include <memory>
+#include <optional>
 #include <unordered_map>
 #include <random>
 
@@ -18,6 +19,12 @@ struct PhysicalPlannerConfig {
     size_t hash_join_threshold = 10000; // Prefer hash join above this size
     size_t index_scan_threshold = 1000; // Prefer index scan below this size
     double parallel_threshold = 0.1; // Parallelize if cost > 10% of total
+    size_t parallel_sort_threshold = 100000; // Sort on all workers above this many rows
+    bool enable_merge_join = true;
+    bool enable_index_nested_loop_join = true;
+    double cpu_tuple_cost = 0.01;        // Per row produced by a join
+    double cpu_index_tuple_cost = 0.005; // Per index entry fetched
+    double cpu_operator_cost = 0.0025;   // Per key comparison
     bool enable_vectorization = true;
     size_t batch_size = 1000;
     std::string temp_dir = "/tmp";
@@ -28,19 +35,25 @@ struct AccessMethod {
     enum Type {
         HEAP_SCAN,
         INDEX_SCAN,
+        INDEX_ONLY_SCAN, // Index scan that never reads the table
         BITMAP_SCAN
     } type;
     
     std::string index_name;
     std::vector<std::string> key_columns;
+    std::vector<ExpressionPtr> index_conditions; // Scan conditions the index searches
+    std::vector<AccessMethod> bitmap_inputs;     // BITMAP_SCAN: index scans and nested bitmap scans
+    bool bitmap_or = false;                      // Unite the inputs' bitmaps instead of intersecting them
     double selectivity = 1.0;
     double cost = 0.0;
 };
 
 // Physical plan statistics and metadata
 struct PhysicalPlanMetadata {
-    std::unordered_map<std::string, TableStats> table_stats;
+    std::shared_ptr<StatisticsCatalog> statistics = std::make_shared<StatisticsCatalog>();
     std::unordered_map<std::string, std::vector<AccessMethod>> access_methods;
+    std::unordered_map<std::string, std::shared_ptr<const std::vector<Tuple>>> table_data;
+    std::shared_ptr<const TableStorage> storage;
     ExecutionContext execution_context;
 };
 
@@ -57,10 +70,26 @@ public:
     void set_config(const PhysicalPlannerConfig& config) { config_ = config; }
     const PhysicalPlannerConfig& get_config() const { return config_; }
     
+    // Cost constants from a file written by the calibration benchmark
+    void load_cost_config(const std::string& path);
+    
     // Statistics and metadata
     void set_table_stats(const std::string& table_name, const TableStats& stats);
+    void set_statistics_catalog(std::shared_ptr<StatisticsCatalog> catalog) { metadata_.statistics = std::move(catalog); }
+    const std::shared_ptr<StatisticsCatalog>& get_statistics_catalog() const { return metadata_.statistics; }
+    
+    // ANALYZE: scan table_name and store its statistics in the catalog
+    TableStats analyze_table(const std::string& table_name, const AnalyzeConfig& config = {});
     void add_access_method(const std::string& table_name, const AccessMethod& method);
     
+    // Rows every scan of table_name in later plans reads instead of mock data,
+    // in table column order
+    void set_table_data(const std::string& table_name, std::vector<Tuple> rows);
+    
+    // Table heaps scans of later plans read in place; a table with a heap
+    // takes it over any rows given to set_table_data
+    void set_table_storage(std::shared_ptr<const TableStorage> storage) { metadata_.storage = std::move(storage); }
+    
     // Optimization and analysis
     PhysicalPlan optimize_physical_plan(const PhysicalPlan& plan);
     std::vector<PhysicalPlan> generate_alternative_physical_plans(const LogicalPlan& logical_plan);
@@ -83,26 +112,70 @@ private:
     PhysicalPlanNodePtr convert_aggregation(std::shared_ptr<AggregationNode> logical_node);
     PhysicalPlanNodePtr convert_sort(std::shared_ptr<SortNode> logical_node);
     PhysicalPlanNodePtr convert_limit(std::shared_ptr<LimitNode> logical_node);
+    PhysicalPlanNodePtr convert_top_n(std::shared_ptr<LimitNode> limit_node,
+                                      std::shared_ptr<SortNode> sort_node);
+    PhysicalSortKey convert_sort_key(const SortNode::SortKey& logical_key,
+                                     const LogicalPlanNodePtr& input) const;
+    // Sort key types of the schema types of columns of table_name; INFERRED
+    // for columns the schema does not know
+    std::vector<SortKeyType> column_key_types(const std::string& table_name,
+                                              const std::vector<std::string>& columns) const;
+    std::shared_ptr<PhysicalProjectionNode> projection_below_sort(PhysicalPlanNodePtr& input,
+                                                                  const std::vector<PhysicalSortKey>& keys) const;
+    PhysicalPlanNodePtr reapply_projection(const std::shared_ptr<PhysicalProjectionNode>& projection,
+                                           const PhysicalPlanNodePtr& ordered, const PlanCost& cost) const;
+    
+    void attach_table_data(const PhysicalPlanNodePtr& node) const;
     
-    // Access method selection
+    // Access method selection. required_columns are the columns the query
+    // reads from the table; empty means all of them.
     AccessMethod select_best_access_method(const std::string& table_name,
-                                          const std::vector<ExpressionPtr>& conditions);
-    std::vector<AccessMethod> get_available_access_methods(const std::string& table_name);
+                                          const std::vector<ExpressionPtr>& conditions,
+                                          const std::vector<std::string>& required_columns = {});
+    // A heap scan, the methods added by hand, an index scan on every B-tree
+    // index of the table that can search some of conditions, an index-only
+    // scan on every B-tree index holding all required_columns, and a bitmap
+    // scan when several indexes or the branches of an OR can be combined
+    std::vector<AccessMethod> get_available_access_methods(const std::string& table_name,
+                                                           const std::vector<ExpressionPtr>& conditions,
+                                                           const std::vector<std::string>& required_columns = {});
+    std::optional<AccessMethod> plan_bitmap_scan(const std::string& table_name,
+                                                 const std::vector<ExpressionPtr>& conditions);
+    PhysicalPlanNodePtr build_bitmap_node(const std::string& table_name, const std::string& alias,
+                                          const AccessMethod& method) const;
+    double estimate_scan_selectivity(const std::string& table_name, const std::vector<ExpressionPtr>& conditions) const;
     
     // Join algorithm selection
     PhysicalPlanNodePtr select_join_algorithm(LogicalPlanNodePtr logical_join);
     bool should_use_hash_join(LogicalPlanNodePtr left, LogicalPlanNodePtr right);
-    bool should_use_merge_join(LogicalPlanNodePtr left, LogicalPlanNodePtr right);
+    bool should_use_merge_join(const PhysicalPlanNodePtr& left_input, const PhysicalPlanNodePtr& right_input,
+                               const std::vector<EquiJoinKey>& keys);
+    PhysicalPlanNodePtr plan_index_nested_loop_join(LogicalPlanNodePtr logical_join, JoinType join_type,
+                                                    const PhysicalPlanNodePtr& outer_input,
+                                                    std::vector<EquiJoinKey> keys);
+    bool orient_join_keys(const PhysicalPlanNodePtr& left_input, const PhysicalPlanNodePtr& right_input,
+                          std::vector<EquiJoinKey>& keys) const;
+    
+    // Interesting orders
+    std::vector<PhysicalSortKey> derive_output_ordering(const PhysicalPlanNodePtr& node) const;
+    bool ordering_satisfies(const PhysicalPlanNodePtr& node, const std::vector<PhysicalSortKey>& required) const;
+    PhysicalPlanNodePtr ensure_ordering(const PhysicalPlanNodePtr& node, const std::vector<PhysicalSortKey>& required) const;
     
     // Parallelization decisions
     bool should_parallelize(LogicalPlanNodePtr node);
     size_t calculate_parallel_degree(LogicalPlanNodePtr node);
     PhysicalPlanNodePtr add_parallelization(PhysicalPlanNodePtr physical_node);
+    PhysicalPlanNodePtr parallelize_sorts(PhysicalPlanNodePtr physical_node);
     
     // Memory and cost analysis
     double estimate_physical_cost(PhysicalPlanNodePtr node);
     size_t estimate_memory_for_hash_join(PhysicalPlanNodePtr build_side);
     size_t estimate_memory_for_sort(PhysicalPlanNodePtr input);
+    double estimate_sort_cost(const PlanCost& input) const;
+    double estimate_nested_loop_cost(const PlanCost& outer, const PlanCost& inner) const;
+    double estimate_merge_join_cost(const PhysicalPlanNodePtr& left_input, const PhysicalPlanNodePtr& right_input,
+                                    const std::vector<EquiJoinKey>& keys) const;
+    double estimate_index_nested_loop_cost(const PlanCost& outer, size_t inner_rows, double matches_per_probe) const;
     
     // Optimization transformations
     PhysicalPlanNodePtr apply_vectorization(PhysicalPlanNodePtr node);
@@ -110,7 +183,20 @@ private:
     PhysicalPlanNodePtr add_materialization_nodes(PhysicalPlanNodePtr node);
     
     // Utility methods
-    TableStats get_table_stats(const std::string& table_name) const;
+    std::shared_ptr<const TableStats> get_table_stats(const std::string& table_name) const;
+    std::vector<std::string> get_table_columns(const std::string& table_name, const std::string& alias) const;
+    std::vector<size_t> prune_scan_columns(std::vector<std::string>& columns, const std::vector<std::string>& required,
+                                           const std::vector<std::string>& keep) const;
+    std::vector<std::string> derive_output_columns(const PhysicalPlanNodePtr& node) const;
+    std::vector<std::string> get_index_columns(const std::string& table_name, const std::string& index_name) const;
+    bool index_covers(const std::string& table_name, const std::vector<std::string>& index_columns,
+                      const std::vector<std::string>& required_columns) const;
+    // Scan of table_name through index_name, index-only when the index
+    // covers required_columns
+    std::shared_ptr<PhysicalIndexScanNode> make_index_scan(const std::string& table_name, const std::string& alias,
+                                                           const std::string& index_name,
+                                                           const std::vector<std::string>& index_columns,
+                                                           const std::vector<std::string>& required_columns) const;
     bool table_has_index(const std::string& table_name, const std::vector<std::string>& columns);
     double estimate_join_selectivity(const std::vector<ExpressionPtr>& conditions);
 };
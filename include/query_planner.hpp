@@ -1,19 +1,15 @@
 #pragma once
 
+#include "cardinality_feedback.hpp"
 #include "logical_plan.hpp"
 #include "database.hpp"
 #include "pg_query_wrapper.hpp"
+#include "statistics.hpp"
+#include <map>
+#include <set>
 #include <unordered_set>
 
 namespace db25 {
-    // Statistics for cost estimation
-    struct TableStats {
-        size_t row_count = 1000;
-        double avg_row_size = 100.0;
-        std::unordered_map<std::string, double> column_selectivity;
-        std::unordered_map<std::string, size_t> distinct_values;
-    };
-
     // Planner configuration
     struct PlannerConfig {
         bool enable_hash_joins = true;
@@ -25,6 +21,8 @@ namespace db25 {
         double cpu_index_tuple_cost = 0.005;
         double cpu_operator_cost = 0.0025;
         size_t work_mem = 1024 * 1024; // 1MB in bytes
+        size_t dp_join_limit = 10; // Join blocks with more inputs are ordered greedily
+        bool enable_memo_search = true; // Choose join algorithms, access paths and sorts in one search
     };
 
     // Query planner class
@@ -41,22 +39,60 @@ namespace db25 {
         void set_config(const PlannerConfig &config) { config_ = config; }
         [[nodiscard]] const PlannerConfig &get_config() const { return config_; }
 
+        // Cost constants from a file written by the calibration benchmark
+        void load_cost_config(const std::string &path);
+
         // Statistics management
         void set_table_stats(const std::string &table_name, const TableStats &stats);
 
-        [[nodiscard]] TableStats get_table_stats(const std::string &table_name) const;
+        [[nodiscard]] std::shared_ptr<const TableStats> get_table_stats(const std::string &table_name) const;
+
+        // Share one catalog with the physical planner so both see ANALYZE results
+        void set_statistics_catalog(std::shared_ptr<StatisticsCatalog> catalog) { statistics_ = std::move(catalog); }
+        [[nodiscard]] const std::shared_ptr<StatisticsCatalog> &get_statistics_catalog() const { return statistics_; }
+
+        // Row counts of executed plans, used in place of the estimates of
+        // subplans seen before; share one store across planner instances
+        void set_cardinality_feedback(std::shared_ptr<CardinalityFeedback> feedback) { feedback_ = std::move(feedback); }
+        [[nodiscard]] const std::shared_ptr<CardinalityFeedback> &get_cardinality_feedback() const { return feedback_; }
+
+        // Signatures of subplans whose rows are already held in memory, costed
+        // as reading them back; set by adaptive execution while re-planning
+        void set_materialized_subplans(std::unordered_set<std::string> signatures) {
+            materialized_ = std::move(signatures);
+        }
 
         // Plan optimization
         [[nodiscard]] LogicalPlan optimize_plan(const LogicalPlan &plan);
 
         [[nodiscard]] std::vector<LogicalPlan> generate_alternative_plans(const std::string &query);
 
+        // Cheapest inner join tree over inputs, bushy trees included. Blocks
+        // of up to dp_join_limit inputs are enumerated exhaustively (DPccp),
+        // larger ones greedily (GOO). Each condition is attached to the join
+        // that first brings together the relations it reads.
+        [[nodiscard]] LogicalPlanNodePtr optimize_join_order(const std::vector<LogicalPlanNodePtr> &inputs,
+                                                             const std::vector<ExpressionPtr> &join_conditions) const;
+
         // Cost estimation
-        void estimate_costs(const LogicalPlanNodePtr &node);
+        void estimate_costs(const LogicalPlanNodePtr &node) const;
+
+        // Costs node from its children's estimates
+        void estimate_node_cost(const LogicalPlanNodePtr &node) const;
 
         [[nodiscard]] double estimate_selectivity(const std::vector<ExpressionPtr> &conditions,
                                     const std::string &table_name) const;
 
+        // Index selection: the index of table_name whose scan, searching the
+        // conditions it can, is cheapest and cheaper than a sequential scan
+        [[nodiscard]] std::optional<std::string> select_best_index(const std::string &table_name,
+                                                                   const std::vector<ExpressionPtr> &conditions) const;
+
+        // Whether the index can search condition on its own
+        [[nodiscard]] bool can_use_index_for_condition(const ExpressionPtr &condition,
+                                                       const std::string &table_name,
+                                                       const std::string &index_name) const;
+
         // Enhanced AST-based join condition extraction
         [[nodiscard]] std::vector<ExpressionPtr> extract_join_conditions_from_ast(const std::string& query) const;
 
@@ -72,7 +108,11 @@ namespace db25 {
         std::shared_ptr<DatabaseSchema> schema_;
         QueryParser parser_;
         PlannerConfig config_;
-        std::unordered_map<std::string, TableStats> table_stats_;
+        std::shared_ptr<StatisticsCatalog> statistics_;
+        mutable std::map<std::string, std::string> relation_tables_; // Alias -> table of every scan costed
+        std::shared_ptr<CardinalityFeedback> feedback_;
+        mutable std::string fingerprint_; // Of the query being costed, for feedback lookups
+        std::unordered_set<std::string> materialized_;
 
         // Plan generation from parse tree
         LogicalPlanNodePtr build_plan_from_select(const std::string &query);
@@ -87,6 +127,11 @@ namespace db25 {
 
         [[nodiscard]] std::optional<size_t> extract_limit_from_ast(const std::string &query) const;
 
+        [[nodiscard]] std::optional<size_t> extract_offset_from_ast(const std::string &query) const;
+
+        [[nodiscard]] std::optional<size_t> extract_limit_clause_from_ast(const std::string &query,
+                                                                          const std::string &clause) const;
+
         LogicalPlanNodePtr build_plan_from_insert(const std::string &query);
 
         LogicalPlanNodePtr build_plan_from_update(const std::string &query);
@@ -145,18 +190,9 @@ namespace db25 {
 
         std::vector<ExpressionPtr> parse_condition_list(const std::string &where_clause);
 
-        // Join order optimization
-        LogicalPlanNodePtr optimize_join_order(const std::vector<LogicalPlanNodePtr> &tables,
-                                               const std::vector<ExpressionPtr> &join_conditions);
-
-
         [[nodiscard]] double estimate_join_cost(LogicalPlanNodePtr left, LogicalPlanNodePtr right,
                                   const std::vector<ExpressionPtr> &conditions) const;
 
-        // Index selection
-        [[nodiscard]] std::optional<std::string> select_best_index(const std::string &table_name,
-                                                                   const std::vector<ExpressionPtr> &conditions) const;
-
         // Plan transformation rules
         LogicalPlanNodePtr apply_predicate_pushdown(LogicalPlanNodePtr node);
 
@@ -168,10 +204,6 @@ namespace db25 {
 
         [[nodiscard]] std::vector<ExpressionPtr> extract_join_conditions(const std::string &query) const;
 
-        [[nodiscard]] bool can_use_index_for_condition(const ExpressionPtr &condition,
-                                         const std::string &table_name,
-                                         const std::string &index_name) const;
-
         // Cost estimation helpers
         [[nodiscard]] double estimate_table_scan_cost(const std::string &table_name) const;
 
@@ -183,8 +215,39 @@ namespace db25 {
                                                          size_t left_rows,
                                                          size_t right_rows,
                                                          double selectivity) const;
+
+        // Selectivity estimation over bound expressions
+        struct ResolvedColumn {
+            std::string table_name;
+            Column column;
+            std::shared_ptr<const TableStats> stats;
+            const ColumnStats *column_stats = nullptr; // Null unless the table was analyzed
+        };
+
+        [[nodiscard]] std::optional<ResolvedColumn> resolve_column(const ExpressionPtr &expr,
+                                                                   const std::string &table_name) const;
+
+        [[nodiscard]] double condition_selectivity(const ExpressionPtr &condition, const std::string &table_name) const;
+
+        [[nodiscard]] double comparison_selectivity(const std::string &op, const ResolvedColumn &column,
+                                                    const std::string &value) const;
+
+        [[nodiscard]] double join_selectivity(const ResolvedColumn &left, const ResolvedColumn &right) const;
+
+        [[nodiscard]] double correlated_selectivity(
+            const std::vector<std::pair<ResolvedColumn, std::string> > &equalities) const;
+
+        [[nodiscard]] double distinct_values(const ResolvedColumn &column) const;
     };
 
+    // Relations scanned in a subtree: alias -> table name
+    void collect_relations(const LogicalPlanNodePtr &node, std::map<std::string, std::string> &relations);
+
+    // Adds the aliases of the relations expr reads; the schema attributes
+    // unqualified column names. Returns false if they cannot be told.
+    bool referenced_relations(const ExpressionPtr &expr, const std::map<std::string, std::string> &relations,
+                              const DatabaseSchema *schema, std::set<std::string> &referenced);
+
     // Plan visitor pattern for traversing and transforming plans
     class PlanVisitor {
     public:
@@ -232,7 +295,7 @@ namespace db25 {
     // Plan transformer for applying optimization rules
     class PlanTransformer : public PlanVisitor {
     public:
-        LogicalPlanNodePtr transform(const LogicalPlanNodePtr &node);
+        virtual LogicalPlanNodePtr transform(const LogicalPlanNodePtr &node);
 
     protected:
         virtual LogicalPlanNodePtr transform_node(LogicalPlanNodePtr node) { return node; }
@@ -242,23 +305,108 @@ namespace db25 {
     };
 
     // Specific optimization transformers
+
+    // Moves every WHERE and ON conjunct to the lowest operator that sees all
+    // the relations it reads: single-table predicates become scan filters and
+    // predicates spanning both sides of an inner join become join conditions.
+    // Predicates never move into the null-supplying side of an outer join from
+    // above, nor out of an outer join's ON clause onto its preserved side.
+    //
+    // Before routing, the column equalities of each block of inner joins form
+    // equivalence classes. A constant or range restriction on one member is
+    // copied to every other member, and equalities implied by the rest of the
+    // class are dropped, so u.id = o.user_id AND u.id = 42 filters both scans.
     class PredicatePushdownTransformer : public PlanTransformer {
-    protected:
-        LogicalPlanNodePtr transform_node(LogicalPlanNodePtr node) override;
+    public:
+        // The schema attributes unqualified column names to a table
+        explicit PredicatePushdownTransformer(std::shared_ptr<DatabaseSchema> schema = nullptr)
+            : schema_(std::move(schema)) {
+        }
+
+        LogicalPlanNodePtr transform(const LogicalPlanNodePtr &node) override;
+
+    private:
+        // Relations scanned below a node: alias -> table name
+        using RelationMap = std::map<std::string, std::string>;
+
+        std::shared_ptr<DatabaseSchema> schema_;
+        std::unordered_set<const Expression *> placed_; // Conjuncts already routed from a higher node
+
+        LogicalPlanNodePtr push_down(const LogicalPlanNodePtr &node, std::vector<ExpressionPtr> predicates);
+
+        void infer_implied_predicates(const LogicalPlanNodePtr &node);
+
+        [[nodiscard]] bool column_key(const ExpressionPtr &expr, const RelationMap &relations, std::string &key) const;
     };
 
+    // Records on every scan below a projection the columns that the projection
+    // and the operators in between read, so scans and joins carry only those.
+    // Works top-down, since a scan's requirement comes from its ancestors.
     class ProjectionPushdownTransformer : public PlanTransformer {
-    protected:
-        LogicalPlanNodePtr transform_node(LogicalPlanNodePtr node) override;
+    public:
+        LogicalPlanNodePtr transform(const LogicalPlanNodePtr &node) override;
+
+    private:
+        void push_down(const LogicalPlanNodePtr &node, std::set<std::string> required, bool projected);
     };
 
+    // Removes joins that cannot change the result: the joined table is
+    // scanned unfiltered, none of its columns is read above the join, and
+    // every row on the other side is known to find exactly one match. That
+    // holds for an inner join along a non-nullable foreign key to a unique
+    // key, and for a left join to a unique key, which finds at most one.
+    class JoinEliminationTransformer : public PlanTransformer {
+    public:
+        explicit JoinEliminationTransformer(std::shared_ptr<DatabaseSchema> schema) : schema_(std::move(schema)) {
+        }
+
+        LogicalPlanNodePtr transform(const LogicalPlanNodePtr &node) override;
+
+    private:
+        std::shared_ptr<DatabaseSchema> schema_;
+
+        LogicalPlanNodePtr eliminate(const LogicalPlanNodePtr &node, std::set<std::string> required, bool projected);
+
+        [[nodiscard]] bool removable(const LogicalPlanNodePtr &join, size_t side, const std::set<std::string> &required,
+                                     bool projected) const;
+    };
+
+    // Drops DISTINCT and GROUP BY without aggregates when the grouping
+    // columns include a unique key of the input, so every group is one row
+    class DistinctEliminationTransformer : public PlanTransformer {
+    public:
+        explicit DistinctEliminationTransformer(std::shared_ptr<DatabaseSchema> schema) : schema_(std::move(schema)) {
+        }
+
+        LogicalPlanNodePtr transform(const LogicalPlanNodePtr &node) override;
+
+    private:
+        std::shared_ptr<DatabaseSchema> schema_;
+    };
+
+    // Column sets that are unique in the output of node, as "alias.column".
+    // Scans contribute their primary key, unique columns and unique indexes;
+    // a join keeps the keys of a side whose every row matches at most one
+    // row of the other.
+    std::vector<std::set<std::string> > unique_keys(const LogicalPlanNodePtr &node, const DatabaseSchema *schema);
+
+    // Splits the conditions of a scan into those a B-tree index can search
+    // and the rest: equalities with a constant on a prefix of its columns,
+    // then comparisons with a constant on the next column. Columns match by
+    // unqualified name, so every condition must read only the scanned table.
+    // Returns the number of index columns searched.
+    size_t match_index_conditions(const Index &index, const std::vector<ExpressionPtr> &conditions,
+                                  std::vector<ExpressionPtr> &index_conditions, std::vector<ExpressionPtr> &residual);
+
+    // Replaces every block of inner joins with the cheapest join tree the
+    // planner finds for its inputs. Outer joins and other operators bound
+    // the blocks; the inputs below them are reordered on their own.
     class JoinReorderingTransformer : public PlanTransformer {
     public:
         JoinReorderingTransformer(const QueryPlanner &planner) : planner_(planner) {
         }
 
-    protected:
-        LogicalPlanNodePtr transform_node(LogicalPlanNodePtr node) override;
+        LogicalPlanNodePtr transform(const LogicalPlanNodePtr &node) override;
 
     private:
         const QueryPlanner &planner_;
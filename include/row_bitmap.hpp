@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace db25 {
+
+// Set of table row ids, compressed the way Roaring bitmaps are: ids are
+// split on their high 16 bits into containers, each holding the low 16
+// bits either as a sorted array (sparse, up to array_limit ids) or as a
+// 65536-bit bitset (dense). Intersection and union work container by
+// container, so they cost in proportion to the ids present rather than
+// the range they span.
+class RowBitmap {
+public:
+    static constexpr size_t array_limit = 4096; // Beyond this a bitset is smaller
+
+    RowBitmap() = default;
+    explicit RowBitmap(std::vector<uint32_t> rows);
+
+    void add(uint32_t row);
+    bool contains(uint32_t row) const;
+    size_t cardinality() const;
+    bool empty() const { return containers_.empty(); }
+
+    RowBitmap& operator&=(const RowBitmap& other);
+    RowBitmap& operator|=(const RowBitmap& other);
+
+    // Row ids in ascending order, the order rows are stored in
+    std::vector<uint32_t> to_vector() const;
+
+    size_t container_count() const { return containers_.size(); }
+    size_t bitset_count() const;
+
+private:
+    struct Container {
+        uint16_t key = 0;              // High 16 bits of the ids
+        std::vector<uint16_t> array;   // Sorted low bits while sparse
+        std::vector<uint64_t> bits;    // 1024 words once dense; array is then empty
+        size_t cardinality = 0;
+
+        bool is_bitset() const { return !bits.empty(); }
+        bool contains(uint16_t low) const;
+        void add(uint16_t low);
+        void to_bitset();
+        void to_array();
+    };
+
+    std::vector<Container> containers_; // Ascending by key, none empty
+
+    static Container intersect(const Container& a, const Container& b);
+    static Container unite(const Container& a, const Container& b);
+};
+
+} // namespace db25
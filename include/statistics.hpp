@@ -0,0 +1,131 @@
+#pragma once
+
+#include "physical_plan.hpp"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace db25 {
+    // Distribution of one column, as gathered by ANALYZE. Values are kept in
+    // their text form; NULL is the empty string.
+    struct ColumnStats {
+        double null_fraction = 0.0;
+        double avg_width = 0.0; // Bytes per non-NULL value
+        double distinct_values = 0.0; // Non-NULL values, estimated over every row
+
+        // Most common values with the fraction of all rows holding each, most
+        // frequent first
+        std::vector<std::pair<std::string, double> > most_common_values;
+
+        // Equi-depth histogram over the values not in most_common_values:
+        // each adjacent pair of bounds holds the same share of those rows
+        std::vector<std::string> histogram_bounds;
+        SortKeyType value_type = SortKeyType::INFERRED; // Order of the bounds
+
+        // Fractions of all rows, NULLs included in the denominator
+        [[nodiscard]] double common_fraction() const; // Held by most_common_values
+        [[nodiscard]] double equal_fraction(const std::string &value) const;
+        [[nodiscard]] double less_fraction(const std::string &value, bool or_equal) const;
+        [[nodiscard]] double like_fraction(const std::string &pattern) const;
+
+        // Position of value within the histogram, 0 at the first bound and 1
+        // at the last, or -1 if there is no histogram
+        [[nodiscard]] double histogram_position(const std::string &value) const;
+    };
+
+    // SQL LIKE: % matches any run of characters, _ any single one
+    bool like_match(std::string_view value, std::string_view pattern);
+
+    // Statistics over a group of correlated columns of one table (CREATE
+    // STATISTICS), for conjunctions that per-column statistics would treat
+    // as independent
+    struct ExtendedStats {
+        // a -> b holds to degree: the share of rows whose a value occurs with
+        // a single b value
+        struct Dependency {
+            std::string determinant;
+            std::string dependent;
+            double degree = 0.0;
+        };
+
+        std::vector<std::string> columns;
+        double distinct_values = 0.0; // Combinations with no NULL, estimated over every row
+        std::vector<std::pair<std::vector<std::string>, double> > most_common_values; // Values in columns order
+        std::vector<Dependency> dependencies; // Between every ordered pair of columns
+
+        [[nodiscard]] double common_fraction() const;
+    };
+
+    // Statistics for cost estimation
+    struct TableStats {
+        size_t row_count = 1000;
+        double avg_row_size = 100.0;
+        std::unordered_map<std::string, double> column_selectivity; // Of an equality match, by column
+        std::unordered_map<std::string, size_t> distinct_values;
+        std::unordered_map<std::string, ColumnStats> columns; // Filled by ANALYZE, by column
+        std::vector<ExtendedStats> extended; // Filled by ANALYZE for each declared column group
+    };
+
+    // Distinct count sketch: each value hashes to one of 2^precision registers,
+    // which keeps the longest run of leading zeros seen in the rest of the
+    // hash. Memory is fixed and the standard error is about 1.04 / sqrt(2^precision).
+    class HyperLogLog {
+    public:
+        explicit HyperLogLog(uint8_t precision = 14);
+
+        void add(std::string_view value);
+
+        // Registers of other must have the same precision
+        void merge(const HyperLogLog &other);
+
+        [[nodiscard]] double estimate() const;
+
+    private:
+        uint8_t precision_;
+        std::vector<uint8_t> registers_;
+    };
+
+    struct AnalyzeConfig {
+        size_t sample_rows = 30000; // Rows kept for the MCV list and histogram
+        size_t statistics_target = 100; // Maximum MCVs and histogram buckets per column
+        uint8_t hll_precision = 14;
+        std::vector<std::vector<std::string> > column_groups; // Columns to build ExtendedStats for
+    };
+
+    // Reads every row of source and builds statistics for each of its output
+    // columns, keyed by unqualified column name. Row count, widths, NULLs
+    // and NDV cover every row; MCVs and histograms come from a uniform
+    // reservoir sample.
+    TableStats analyze_rows(const PhysicalPlanNodePtr &source, const AnalyzeConfig &config = {});
+
+    // Table statistics shared by the planners. ANALYZE stores into it; the
+    // logical and physical planners read from it, so a catalog handed to
+    // both makes them cost plans with the same numbers. Entries are immutable
+    // once stored, so readers keep a snapshot without copying histograms.
+    class StatisticsCatalog {
+    public:
+        void set_table_stats(const std::string &table_name, const TableStats &stats);
+
+        // Null if table_name was never analyzed
+        [[nodiscard]] std::shared_ptr<const TableStats> find_table_stats(const std::string &table_name) const;
+
+        // Statistics of table_name, or defaults if it was never analyzed
+        [[nodiscard]] std::shared_ptr<const TableStats> get_table_stats(const std::string &table_name) const;
+
+        // CREATE STATISTICS: later ANALYZEs of table_name also gather
+        // statistics over the combination of columns
+        void create_statistics(const std::string &table_name, std::vector<std::string> columns);
+
+        // ANALYZE table_name by reading source, a scan of the table
+        TableStats analyze_table(const std::string &table_name, const PhysicalPlanNodePtr &source,
+                                 const AnalyzeConfig &config = {});
+
+    private:
+        mutable std::mutex mutex_;
+        std::unordered_map<std::string, std::shared_ptr<const TableStats> > tables_;
+        std::unordered_map<std::string, std::vector<std::vector<std::string> > > column_groups_;
+    };
+}
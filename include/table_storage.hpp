@@ -0,0 +1,197 @@
+#pragma once
+
+#include "database.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace db25 {
+
+class ColumnarTable;
+
+// How storage lays out values of a column type: 8-byte integers and
+// decimals, 1-byte booleans, and variable-length bytes for the rest (text,
+// and dates and timestamps kept in ISO form)
+enum class StorageKind { INTEGER, DECIMAL, BOOLEAN, VARIABLE };
+
+StorageKind storage_kind(ColumnType type);
+
+// Typed form of a non-NULL value as the executor writes it; false when the
+// text does not fit the type
+bool parse_integer(const std::string& text, int64_t& value);
+bool parse_decimal(const std::string& text, double& value);
+bool parse_boolean(const std::string& text, bool& value);
+
+// Shortest text that reads back as value
+std::string format_decimal(double value);
+
+// Dates as days and timestamps as microseconds since 1970-01-01, from and
+// to ISO text: "2024-03-01" and "2024-03-01 12:30:00", with six fraction
+// digits when there is a fraction. Parsing is false for other forms.
+bool parse_date(const std::string& text, int64_t& days);
+bool parse_timestamp(const std::string& text, int64_t& micros);
+std::string format_date(int64_t days);
+std::string format_timestamp(int64_t micros);
+
+// Reads all of text as a number, as the executor does when comparing
+bool read_number(std::string_view text, double& number);
+
+// value against constant as the executor compares them: as numbers when
+// number (the constant read as one) is given and value reads as one too,
+// as text otherwise. Negative, zero or positive.
+int compare_value(std::string_view value, const std::string& constant, const double* number);
+
+// A condition on one column that storage tests without the executor:
+// segments on their encoded values, zone maps on a block's bounds. Values
+// compare with the constants as compare_value does; NULL matches nothing.
+struct ColumnPredicate {
+    enum class Op { EQUAL, NOT_EQUAL, LESS, LESS_EQUAL, GREATER, GREATER_EQUAL, IN };
+
+    Op op = Op::EQUAL;
+    std::vector<std::string> values; // The constant, or the list for IN
+
+    // Whether storage of kind can test it: integer and decimal columns
+    // only against numeric constants, so that they compare as numbers
+    bool applies_to(StorageKind kind) const;
+
+    // Whether a value comparing cmp with a constant satisfies op; for IN,
+    // cmp is against one of the constants
+    bool satisfied_by(int cmp) const;
+
+    // Whether value ("" for NULL) satisfies it
+    bool matches(const std::string& value) const;
+};
+
+// Smallest and largest value and NULL count of one column over a block of
+// rows (a heap page, a row group), so that scans can skip blocks where no
+// row can satisfy a predicate
+class ZoneMap {
+public:
+    explicit ZoneMap(StorageKind kind = StorageKind::VARIABLE) : kind_(kind) {}
+
+    // Adds a value ("" for NULL) that fits kind
+    void add(const std::string& value);
+
+    size_t row_count() const { return row_count_; }
+    size_t null_count() const { return null_count_; }
+
+    // Bounds as the executor writes them; "" while every value is NULL
+    std::string min() const;
+    std::string max() const;
+
+    // False when no row of the block can satisfy predicate
+    bool may_match(const ColumnPredicate& predicate) const;
+
+private:
+    StorageKind kind_;
+    size_t row_count_ = 0;
+    size_t null_count_ = 0;
+    bool ordered_ = true; // Cleared by a NaN decimal
+    int64_t integer_min_ = 0; // Integers, and booleans as 0 and 1
+    int64_t integer_max_ = 0;
+    double decimal_min_ = 0;
+    double decimal_max_ = 0;
+    std::string text_min_;
+    std::string text_max_;
+
+    int compare_bound(bool max, size_t constant, const std::vector<double>& numbers,
+                      const ColumnPredicate& predicate) const;
+};
+
+// Row store of one table in slotted pages. Each page keeps a slot
+// directory growing from its header and row images growing down from its
+// end. A row image is a null bitmap, one fixed-width field per column
+// (8-byte integers and decimals, 1-byte booleans, offset and length of
+// variable-length values) and the variable-length bytes. Rows are only
+// appended and never move, so a row id (the position of its slot among all
+// slots of the table) stays valid for the life of the heap.
+//
+// Values cross the interface as text, the executor's representation:
+// NULL is the empty string, integers and booleans come back in canonical
+// form. Reads are const and may run concurrently; inserts may not run
+// alongside them.
+class TableHeap {
+public:
+    static constexpr size_t page_size = 8192;
+
+    explicit TableHeap(const Table& table);
+
+    // Appends a row with one value per column and returns its row id.
+    // Throws std::runtime_error when a value does not fit its column type
+    // or the row does not fit in a page.
+    size_t insert(const std::vector<std::string>& values);
+
+    const std::string& name() const { return name_; }
+    const std::vector<Column>& columns() const { return columns_; }
+    size_t row_count() const { return row_count_; }
+    size_t page_count() const { return pages_.size(); }
+    size_t page_of(size_t row) const;
+    size_t first_row(size_t page) const { return page < pages_.size() ? page_first_row_[page] : row_count_; }
+
+    // Bounds of column over the rows of page
+    const ZoneMap& zone(size_t page, size_t column) const { return page_zones_[page][column]; }
+    size_t bytes_used() const; // Page bytes holding slots and row images
+
+    // Decodes one column of a row straight from its page
+    std::string value(size_t row, size_t column) const;
+
+    // Decodes the given columns of a row, in that order; all columns when
+    // columns is empty
+    std::vector<std::string> read(size_t row, const std::vector<size_t>& columns = {}) const;
+
+private:
+    using Page = std::array<uint8_t, page_size>;
+
+    std::string name_;
+    std::vector<Column> columns_;
+    std::vector<size_t> field_offsets_; // Of each column's fixed-width field in a row image
+    size_t fixed_size_ = 0;             // Null bitmap and fixed-width fields
+    std::vector<std::unique_ptr<Page>> pages_;
+    std::vector<size_t> page_first_row_; // Row id of each page's first slot
+    std::vector<std::vector<ZoneMap>> page_zones_; // Of each page, one per column
+    size_t row_count_ = 0;
+
+    const uint8_t* row_image(size_t row) const;
+    std::string decode(const uint8_t* image, size_t column) const;
+};
+
+// Row heaps and column stores of the tables of a schema, by table name.
+// A table may have either or both; inserts go to every one it has.
+class TableStorage {
+public:
+    explicit TableStorage(std::shared_ptr<const DatabaseSchema> schema);
+
+    // Heap of table_name, created empty on first use. Throws
+    // std::runtime_error for tables the schema does not have.
+    std::shared_ptr<TableHeap> create_table(const std::string& table_name);
+
+    // nullptr when no heap was created for table_name
+    std::shared_ptr<const TableHeap> get_table(const std::string& table_name) const;
+
+    // Column store of table_name, created empty on first use; row_group_size
+    // applies only then. Throws std::runtime_error for tables the schema
+    // does not have.
+    std::shared_ptr<ColumnarTable> create_columnar_table(const std::string& table_name, size_t row_group_size);
+    std::shared_ptr<ColumnarTable> create_columnar_table(const std::string& table_name);
+
+    // nullptr when no column store was created for table_name
+    std::shared_ptr<const ColumnarTable> get_columnar_table(const std::string& table_name) const;
+
+    // Appends a row to the heap and the column store of table_name, creating
+    // a heap when it has neither, and returns its row id
+    size_t insert(const std::string& table_name, const std::vector<std::string>& values);
+
+private:
+    std::shared_ptr<const DatabaseSchema> schema_;
+    std::unordered_map<std::string, std::shared_ptr<TableHeap>> tables_;
+    std::unordered_map<std::string, std::shared_ptr<ColumnarTable>> columnar_tables_;
+
+    Table schema_table(const std::string& table_name) const;
+};
+
+} // namespace db25
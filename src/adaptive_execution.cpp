@@ -0,0 +1,136 @@
+#include "adaptive_execution.hpp"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace db25 {
+    using MaterializedStages = std::unordered_map<std::string, std::shared_ptr<PhysicalMaterializeNode> >;
+
+    // Whether child i of node is read to completion before node returns a row
+    static bool is_checkpoint_input(const PhysicalPlanNodePtr &node, const size_t i) {
+        switch (node->type) {
+            case PhysicalOperatorType::SORT:
+            case PhysicalOperatorType::TOP_N:
+            case PhysicalOperatorType::HASH_AGGREGATE:
+            case PhysicalOperatorType::GROUP_AGGREGATE:
+                return i == 0;
+            // The inner side is rescanned for every outer row or hashed
+            case PhysicalOperatorType::NESTED_LOOP_JOIN:
+            case PhysicalOperatorType::HASH_JOIN:
+                return i == 1;
+            default:
+                return false;
+        }
+    }
+
+    // The deepest checkpoint not run yet, so stages run bottom up
+    static bool find_checkpoint(const PhysicalPlanNodePtr &node, const MaterializedStages &materialized, // NOLINT(misc-no-recursion)
+                                PhysicalPlanNodePtr &parent, size_t &index) {
+        if (!node) return false;
+        for (const auto &child: node->children) {
+            if (find_checkpoint(child, materialized, parent, index)) return true;
+        }
+        for (size_t i = 0; i < node->children.size(); ++i) {
+            const auto &child = node->children[i];
+            if (is_checkpoint_input(node, i) && child && child->type != PhysicalOperatorType::MATERIALIZE &&
+                !child->signature.empty() && materialized.count(child->signature) == 0) {
+                parent = node;
+                index = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool same_sort_key(const PhysicalSortKey &a, const PhysicalSortKey &b) {
+        return a.ascending == b.ascending && a.nulls_first == b.nulls_first &&
+               expression_to_string(a.expression) == expression_to_string(b.expression);
+    }
+
+    // Whether rows sorted by order are also sorted by required
+    static bool ordering_covers(const std::vector<PhysicalSortKey> &order,
+                                const std::vector<PhysicalSortKey> &required) {
+        return required.size() <= order.size() &&
+               std::equal(required.begin(), required.end(), order.begin(), same_sort_key);
+    }
+
+    // Replaces subplans already run with their rows. Sorts share their
+    // input's signature but not its order, so they are never replaced.
+    static void reuse_materialized(PhysicalPlanNodePtr &node, const MaterializedStages &materialized) { // NOLINT(misc-no-recursion)
+        if (!node) return;
+        if (node->type != PhysicalOperatorType::SORT && node->type != PhysicalOperatorType::PROJECTION) {
+            const auto stage = materialized.find(node->signature);
+            if (stage != materialized.end() && stage->second->output_columns == node->output_columns &&
+                ordering_covers(stage->second->output_ordering, node->output_ordering)) {
+                node = stage->second;
+                return;
+            }
+        }
+        for (auto &child: node->children) {
+            reuse_materialized(child, materialized);
+        }
+    }
+
+    AdaptiveExecutor::AdaptiveExecutor(QueryPlanner &query_planner, PhysicalPlanner &physical_planner,
+                                       const AdaptiveExecutionConfig &config)
+        : query_planner_(query_planner), physical_planner_(physical_planner), config_(config) {
+    }
+
+    std::vector<Tuple> AdaptiveExecutor::execute(const LogicalPlan &plan) {
+        replans_.clear();
+        const auto feedback = query_planner_.get_cardinality_feedback();
+
+        PhysicalPlan physical = physical_planner_.create_physical_plan(query_planner_.optimize_plan(plan));
+        MaterializedStages materialized;
+
+        PhysicalPlanNodePtr parent;
+        size_t index = 0;
+        while (find_checkpoint(physical.root, materialized, parent, index)) {
+            const PhysicalPlanNodePtr checkpoint = parent->children[index];
+
+            PhysicalPlan stage(checkpoint);
+            stage.context = physical.context;
+            auto stage_node = std::make_shared<PhysicalMaterializeNode>();
+            stage_node->rows = std::make_shared<const std::vector<Tuple> >(stage.execute());
+            stage_node->estimated_cost.estimated_rows = stage_node->rows->size();
+            stage_node->estimated_cost.total_cost =
+                    static_cast<double>(stage_node->rows->size()) * physical_planner_.get_config().cpu_tuple_cost;
+            stage_node->output_columns = checkpoint->output_columns;
+            stage_node->output_ordering = checkpoint->output_ordering;
+            parent->children[index] = stage_node;
+            materialized[checkpoint->signature] = stage_node;
+            if (feedback) feedback->record(plan.fingerprint, checkpoint);
+
+            const double estimated_rows = static_cast<double>(checkpoint->estimated_cost.estimated_rows);
+            const double actual_rows = static_cast<double>(stage_node->rows->size());
+            const double q_error = std::max({estimated_rows, actual_rows, 1.0}) /
+                                   std::max(std::min(estimated_rows, actual_rows), 1.0);
+            if (!feedback || q_error < config_.misestimate_threshold || replans_.size() >= config_.max_replans) {
+                continue;
+            }
+
+            // Plan the rest with the rows seen so far; stages already run
+            // cost only reading them back
+            std::unordered_set<std::string> signatures;
+            for (const auto &[signature, node]: materialized) {
+                signatures.insert(signature);
+            }
+            query_planner_.set_materialized_subplans(std::move(signatures));
+            physical = physical_planner_.create_physical_plan(query_planner_.optimize_plan(plan));
+            query_planner_.set_materialized_subplans({});
+            reuse_materialized(physical.root, materialized);
+
+            AdaptiveReplan replan;
+            replan.signature = checkpoint->signature;
+            replan.estimated_rows = estimated_rows;
+            replan.actual_rows = actual_rows;
+            replan.plan = physical.to_string();
+            replans_.push_back(std::move(replan));
+        }
+
+        std::vector<Tuple> rows = physical.execute();
+        if (feedback) feedback->record(physical);
+        final_plan_ = physical;
+        return rows;
+    }
+}
@@ -0,0 +1,223 @@
+#include "cardinality_feedback.hpp"
+#include "compiled_expression.hpp"
+#include <algorithm>
+
+namespace db25 {
+    // Conditions in a fixed order, joined by AND
+    static std::string conditions_text(std::vector<std::string> conditions) {
+        std::sort(conditions.begin(), conditions.end());
+        std::string text;
+        for (const auto &condition: conditions) {
+            if (!text.empty()) text += " AND ";
+            text += condition;
+        }
+        return text;
+    }
+
+    static void append_conditions(const std::vector<ExpressionPtr> &exprs, std::vector<std::string> &conditions) {
+        for (const auto &expr: exprs) {
+            conditions.push_back(expression_to_string(expr));
+        }
+    }
+
+    static bool is_join(const LogicalPlanNodePtr &node) {
+        return node->type == PlanNodeType::NESTED_LOOP_JOIN || node->type == PlanNodeType::HASH_JOIN ||
+               node->type == PlanNodeType::MERGE_JOIN;
+    }
+
+    static bool is_inner_join_node(const LogicalPlanNodePtr &node) {
+        if (!is_join(node) || node->children.size() != 2) return false;
+        const JoinType type = std::static_pointer_cast<JoinNode>(node)->join_type;
+        return type == JoinType::INNER || type == JoinType::CROSS;
+    }
+
+    // Inputs and conditions of the block of inner joins rooted at node
+    static void collect_join_block(const LogicalPlanNodePtr &node, // NOLINT(misc-no-recursion)
+                                   std::vector<std::string> &inputs, std::vector<std::string> &conditions) {
+        if (!is_inner_join_node(node)) {
+            inputs.push_back(plan_signature(node));
+            return;
+        }
+        append_conditions(std::static_pointer_cast<JoinNode>(node)->join_conditions, conditions);
+        for (const auto &child: node->children) {
+            collect_join_block(child, inputs, conditions);
+        }
+    }
+
+    // A scan with extra conditions applied to its rows
+    static std::string scan_signature(const LogicalPlanNodePtr &node, std::vector<std::string> conditions) {
+        std::string table;
+        std::string alias;
+        if (node->type == PlanNodeType::TABLE_SCAN) {
+            const auto scan = std::static_pointer_cast<TableScanNode>(node);
+            table = scan->table_name;
+            alias = scan->alias;
+            append_conditions(scan->filter_conditions, conditions);
+        } else {
+            const auto scan = std::static_pointer_cast<IndexScanNode>(node);
+            table = scan->table_name;
+            alias = scan->alias;
+            append_conditions(scan->index_conditions, conditions);
+            append_conditions(scan->filter_conditions, conditions);
+        }
+        std::string signature = "scan " + table;
+        if (!alias.empty() && alias != table) signature += " " + alias;
+        if (!conditions.empty()) signature += " where " + conditions_text(std::move(conditions));
+        return signature;
+    }
+
+    std::string plan_signature(const LogicalPlanNodePtr &node) { // NOLINT(misc-no-recursion)
+        if (!node) return "";
+
+        const auto child_signature = [&node](size_t i) {
+            return i < node->children.size() ? plan_signature(node->children[i]) : std::string();
+        };
+
+        switch (node->type) {
+            case PlanNodeType::TABLE_SCAN:
+            case PlanNodeType::INDEX_SCAN:
+                return scan_signature(node, {});
+
+            case PlanNodeType::SELECTION: {
+                std::vector<std::string> conditions;
+                append_conditions(std::static_pointer_cast<SelectionNode>(node)->conditions, conditions);
+                const auto &child = node->children.empty() ? nullptr : node->children[0];
+                if (child && (child->type == PlanNodeType::TABLE_SCAN || child->type == PlanNodeType::INDEX_SCAN)) {
+                    return scan_signature(child, std::move(conditions));
+                }
+                return "filter " + conditions_text(std::move(conditions)) + " (" + child_signature(0) + ")";
+            }
+
+            // Same rows as their input
+            case PlanNodeType::PROJECTION:
+            case PlanNodeType::SORT:
+                return child_signature(0);
+
+            case PlanNodeType::NESTED_LOOP_JOIN:
+            case PlanNodeType::HASH_JOIN:
+            case PlanNodeType::MERGE_JOIN: {
+                const auto join = std::static_pointer_cast<JoinNode>(node);
+                if (is_inner_join_node(node)) {
+                    std::vector<std::string> inputs;
+                    std::vector<std::string> conditions;
+                    collect_join_block(node, inputs, conditions);
+                    std::sort(inputs.begin(), inputs.end());
+                    std::string signature = "join";
+                    for (const auto &input: inputs) {
+                        signature += " (" + input + ")";
+                    }
+                    if (!conditions.empty()) signature += " on " + conditions_text(std::move(conditions));
+                    return signature;
+                }
+                std::vector<std::string> conditions;
+                append_conditions(join->join_conditions, conditions);
+                return join->join_type_to_string() + " join (" + child_signature(0) + ") (" + child_signature(1) +
+                       ") on " + conditions_text(std::move(conditions));
+            }
+
+            case PlanNodeType::AGGREGATION: {
+                const auto aggregation = std::static_pointer_cast<AggregationNode>(node);
+                std::vector<std::string> groups;
+                append_conditions(aggregation->group_by_exprs, groups);
+                std::vector<std::string> having;
+                append_conditions(aggregation->having_conditions, having);
+                std::string signature = "group by " + conditions_text(std::move(groups));
+                if (!having.empty()) signature += " having " + conditions_text(std::move(having));
+                return signature + " (" + child_signature(0) + ")";
+            }
+
+            case PlanNodeType::LIMIT: {
+                const auto limit = std::static_pointer_cast<LimitNode>(node);
+                return "limit " + (limit->limit ? std::to_string(*limit->limit) : "all") + " offset " +
+                       std::to_string(limit->offset.value_or(0)) + " (" + child_signature(0) + ")";
+            }
+
+            default: {
+                std::string signature = "node " + std::to_string(static_cast<int>(node->type));
+                for (size_t i = 0; i < node->children.size(); ++i) {
+                    signature += " (" + child_signature(i) + ")";
+                }
+                return signature;
+            }
+        }
+    }
+
+    CardinalityFeedback::CardinalityFeedback(const double smoothing)
+        : smoothing_(std::clamp(smoothing, 0.0, 1.0)) {
+    }
+
+    void CardinalityFeedback::record(const std::string &fingerprint, // NOLINT(misc-no-recursion)
+                                     const PhysicalPlanNodePtr &root) {
+        if (!root) return;
+        // A Top-N boundary drops rows in the scan itself, so what it returned
+        // is not what its subplan yields
+        if (!root->signature.empty() && !root->has_more_data() && root->actual_stats.rows_cut == 0) {
+            record(fingerprint, root->signature, static_cast<double>(root->estimated_cost.estimated_rows),
+                   static_cast<double>(root->actual_stats.rows_returned));
+        }
+        for (const auto &child: root->children) {
+            record(fingerprint, child);
+        }
+    }
+
+    void CardinalityFeedback::record(const std::string &fingerprint, const std::string &signature,
+                                     const double estimated_rows, const double actual_rows) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &observation = queries_[fingerprint][signature];
+        observation.signature = signature;
+        observe(observation, estimated_rows, actual_rows);
+
+        auto &subplan = subplans_[signature];
+        subplan.signature = signature;
+        observe(subplan, estimated_rows, actual_rows);
+    }
+
+    void CardinalityFeedback::observe(CardinalityObservation &observation, const double estimated_rows,
+                                      const double actual_rows) const {
+        observation.actual_rows = observation.executions == 0
+                                      ? actual_rows
+                                      : smoothing_ * actual_rows + (1.0 - smoothing_) * observation.actual_rows;
+        observation.estimated_rows = estimated_rows;
+        const double low = std::max(std::min(estimated_rows, actual_rows), 1.0);
+        observation.q_error = std::max({estimated_rows, actual_rows, 1.0}) / low;
+        observation.executions++;
+    }
+
+    std::optional<double> CardinalityFeedback::actual_rows(const std::string &fingerprint,
+                                                           const std::string &signature) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto query = queries_.find(fingerprint);
+        if (query != queries_.end()) {
+            const auto observation = query->second.find(signature);
+            if (observation != query->second.end()) return observation->second.actual_rows;
+        }
+        const auto subplan = subplans_.find(signature);
+        if (subplan != subplans_.end()) return subplan->second.actual_rows;
+        return std::nullopt;
+    }
+
+    std::vector<CardinalityObservation> CardinalityFeedback::observations(const std::string &fingerprint) const {
+        std::vector<CardinalityObservation> result;
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto query = queries_.find(fingerprint);
+        if (query == queries_.end()) return result;
+        for (const auto &[signature, observation]: query->second) {
+            result.push_back(observation);
+        }
+        std::sort(result.begin(), result.end(), [](const CardinalityObservation &a, const CardinalityObservation &b) {
+            return a.q_error > b.q_error;
+        });
+        return result;
+    }
+
+    bool CardinalityFeedback::empty() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return subplans_.empty();
+    }
+
+    void CardinalityFeedback::clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queries_.clear();
+        subplans_.clear();
+    }
+}
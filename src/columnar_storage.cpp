@@ -0,0 +1,748 @@
+#include "columnar_storage.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+namespace db25 {
+
+// Rows sampled to choose an encoding: stretches of consecutive rows spread
+// over the segment, so that runs show up in the sample
+static constexpr size_t sample_stretches = 16;
+static constexpr size_t stretch_rows = 64;
+
+// Bits needed for values up to max
+static unsigned bit_width(uint64_t max) {
+    return max == 0 ? 0 : 64 - static_cast<unsigned>(__builtin_clzll(max));
+}
+
+// values of width bits each, back to back. A spare word lets unpack read
+// two words for every value without checking where the value ends.
+static std::vector<uint64_t> pack(const std::vector<uint64_t>& values, unsigned width) {
+    std::vector<uint64_t> words(values.size() * width / 64 + 2, 0);
+    for (size_t i = 0; i < values.size(); ++i) {
+        const size_t bit = i * width;
+        words[bit / 64] |= values[i] << (bit % 64);
+        if (bit % 64 + width > 64) words[bit / 64 + 1] |= values[i] >> (64 - bit % 64);
+    }
+    return words;
+}
+
+// base plus values first to first + count - 1 of words. The loop has no
+// branches, so the compiler vectorizes it.
+template <typename T>
+static void unpack(const std::vector<uint64_t>& words, unsigned width, size_t first, size_t count, uint64_t base,
+                   T* out) {
+    const uint64_t mask = width == 64 ? ~uint64_t{0} : (uint64_t{1} << width) - 1;
+    for (size_t i = 0; i < count; ++i) {
+        const size_t bit = (first + i) * width;
+        const uint64_t low = words[bit / 64] >> (bit % 64);
+        const uint64_t high = (words[bit / 64 + 1] << 1) << (63 - bit % 64);
+        out[i] = static_cast<T>(base + ((low | high) & mask));
+    }
+}
+
+// Sets bits first to last - 1 of words
+static void set_bits(uint64_t* words, size_t first, size_t last) {
+    for (size_t bit = first; bit < last;) {
+        const size_t stop = std::min(last, (bit / 64 + 1) * 64);
+        const uint64_t ones = stop - bit == 64 ? ~uint64_t{0} : ((uint64_t{1} << (stop - bit)) - 1);
+        words[bit / 64] |= ones << (bit % 64);
+        bit = stop;
+    }
+}
+
+// Total order on doubles that agrees with < where that is defined
+static int64_t decimal_key(double value) {
+    int64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits < 0 ? bits ^ INT64_MAX : bits;
+}
+
+template <typename T>
+static int three_way(const T& a, const T& b) {
+    return (a > b) - (a < b);
+}
+
+// Whether a value satisfies predicate, given compare(i), the value
+// compared with constant i
+template <typename Compare>
+static bool evaluate(const ColumnPredicate& predicate, Compare compare) {
+    if (predicate.op != ColumnPredicate::Op::IN) {
+        return !predicate.values.empty() && predicate.satisfied_by(compare(0));
+    }
+    for (size_t i = 0; i < predicate.values.size(); ++i) {
+        if (compare(i) == 0) return true;
+    }
+    return false;
+}
+
+std::string ColumnVector::value(size_t i) const {
+    if (is_null(i)) return "";
+    switch (kind) {
+        case StorageKind::INTEGER:
+            return std::to_string(integers[i]);
+        case StorageKind::DECIMAL:
+            return format_decimal(decimals[i]);
+        case StorageKind::BOOLEAN:
+            return booleans[i] ? "true" : "false";
+        default:
+            return std::string(bytes + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+}
+
+ColumnSegment::ColumnSegment(ColumnType type) : type_(type), kind_(storage_kind(type)), zone_(kind_) {}
+
+bool ColumnSegment::accepts(StorageKind kind, const std::string& value) {
+    if (value.empty()) return true;
+    int64_t integer = 0;
+    double decimal = 0;
+    bool boolean = false;
+    switch (kind) {
+        case StorageKind::INTEGER:
+            return parse_integer(value, integer);
+        case StorageKind::DECIMAL:
+            return parse_decimal(value, decimal);
+        case StorageKind::BOOLEAN:
+            return parse_boolean(value, boolean);
+        default:
+            return true;
+    }
+}
+
+void ColumnSegment::append(const std::string& value) {
+    if (encoding_ != ColumnEncoding::PLAIN) decompress();
+    zone_.add(value);
+    if (size_ % 64 == 0) validity_.push_back(0);
+    if (value.empty()) {
+        null_count_++;
+    } else {
+        validity_.back() |= uint64_t{1} << (size_ % 64);
+    }
+
+    // NULLs keep a zero or empty slot so positions stay aligned
+    switch (kind_) {
+        case StorageKind::INTEGER: {
+            int64_t parsed = 0;
+            if (!value.empty()) parse_integer(value, parsed);
+            integers_.push_back(parsed);
+            break;
+        }
+        case StorageKind::DECIMAL: {
+            double parsed = 0;
+            if (!value.empty()) parse_decimal(value, parsed);
+            decimals_.push_back(parsed);
+            break;
+        }
+        case StorageKind::BOOLEAN: {
+            bool parsed = false;
+            if (!value.empty()) parse_boolean(value, parsed);
+            booleans_.push_back(parsed ? 1 : 0);
+            break;
+        }
+        case StorageKind::VARIABLE:
+            bytes_ += value;
+            offsets_.push_back(static_cast<uint32_t>(bytes_.size()));
+            break;
+    }
+    size_++;
+}
+
+size_t ColumnSegment::values() const {
+    switch (kind_) {
+        case StorageKind::INTEGER:
+            return integers_.size();
+        case StorageKind::DECIMAL:
+            return decimals_.size();
+        case StorageKind::BOOLEAN:
+            return booleans_.size();
+        default:
+            return offsets_.size() - 1;
+    }
+}
+
+std::string_view ColumnSegment::text(size_t index) const {
+    return std::string_view(bytes_.data() + offsets_[index], offsets_[index + 1] - offsets_[index]);
+}
+
+int ColumnSegment::compare_entries(size_t a, size_t b) const {
+    switch (kind_) {
+        case StorageKind::INTEGER:
+            return three_way(integers_[a], integers_[b]);
+        case StorageKind::DECIMAL:
+            return three_way(decimal_key(decimals_[a]), decimal_key(decimals_[b]));
+        case StorageKind::BOOLEAN:
+            return three_way(booleans_[a], booleans_[b]);
+        default:
+            return three_way(text(a).compare(text(b)), 0);
+    }
+}
+
+void ColumnSegment::push_value(const ColumnSegment& from, size_t index) {
+    switch (kind_) {
+        case StorageKind::INTEGER:
+            integers_.push_back(from.integers_[index]);
+            break;
+        case StorageKind::DECIMAL:
+            decimals_.push_back(from.decimals_[index]);
+            break;
+        case StorageKind::BOOLEAN:
+            booleans_.push_back(from.booleans_[index]);
+            break;
+        case StorageKind::VARIABLE:
+            bytes_ += from.text(index);
+            offsets_.push_back(static_cast<uint32_t>(bytes_.size()));
+            break;
+    }
+}
+
+// The rows as integers: integer columns, and dates and timestamps whose
+// text reads back unchanged from the integer form
+bool ColumnSegment::integer_values(std::vector<int64_t>& values) const {
+    if (kind_ == StorageKind::INTEGER) {
+        values = integers_;
+        return true;
+    }
+    if (!temporal()) return false;
+
+    // Only years 0 to 9999, whose text sorts as the integers do
+    values.assign(size_, 0);
+    for (size_t row = 0; row < size_; ++row) {
+        if (!valid(row)) continue;
+        const std::string value(text(row));
+        if (!std::isdigit(static_cast<unsigned char>(value[0]))) return false;
+        const bool parsed = type_ == ColumnType::DATE ? parse_date(value, values[row])
+                                                      : parse_timestamp(value, values[row]);
+        if (!parsed) return false;
+        const std::string canonical =
+            type_ == ColumnType::DATE ? format_date(values[row]) : format_timestamp(values[row]);
+        if (canonical != value) return false;
+    }
+    return true;
+}
+
+ColumnSegment ColumnSegment::encode_dictionary() const {
+    std::vector<uint32_t> order(size_);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [this](uint32_t a, uint32_t b) { return compare_entries(a, b) < 0; });
+
+    ColumnSegment encoded(type_);
+    encoded.encoding_ = ColumnEncoding::DICTIONARY;
+    encoded.size_ = size_;
+    encoded.null_count_ = null_count_;
+    encoded.validity_ = validity_;
+    std::vector<uint64_t> codes(size_);
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i == 0 || compare_entries(order[i - 1], order[i]) != 0) encoded.push_value(*this, order[i]);
+        codes[order[i]] = encoded.values() - 1;
+    }
+    encoded.width_ = bit_width(encoded.values() - 1);
+    encoded.packed_ = pack(codes, encoded.width_);
+    return encoded;
+}
+
+ColumnSegment ColumnSegment::encode_rle() const {
+    ColumnSegment encoded(type_);
+    encoded.encoding_ = ColumnEncoding::RLE;
+    encoded.size_ = size_;
+    encoded.null_count_ = null_count_;
+    encoded.validity_ = validity_;
+
+    // NULLs join the run they fall in, whatever its value
+    size_t run_start = 0;
+    for (size_t row = 0; row < size_; ++row) {
+        if (row > 0 && (!valid(row) || compare_entries(run_start, row) == 0)) {
+            encoded.run_ends_.back() = static_cast<uint32_t>(row + 1);
+            continue;
+        }
+        run_start = row;
+        encoded.push_value(*this, row);
+        encoded.run_ends_.push_back(static_cast<uint32_t>(row + 1));
+    }
+    return encoded;
+}
+
+ColumnSegment ColumnSegment::encode_frame_of_reference(const std::vector<int64_t>& values) const {
+    int64_t min = 0;
+    int64_t max = 0;
+    bool any = false;
+    for (size_t row = 0; row < size_; ++row) {
+        if (!valid(row)) continue;
+        min = any ? std::min(min, values[row]) : values[row];
+        max = any ? std::max(max, values[row]) : values[row];
+        any = true;
+    }
+
+    ColumnSegment encoded(type_);
+    encoded.encoding_ = ColumnEncoding::FRAME_OF_REFERENCE;
+    encoded.size_ = size_;
+    encoded.null_count_ = null_count_;
+    encoded.validity_ = validity_;
+    encoded.reference_ = min;
+    encoded.width_ = bit_width(static_cast<uint64_t>(max) - static_cast<uint64_t>(min));
+    std::vector<uint64_t> offsets(size_, 0); // NULLs sit at the reference
+    for (size_t row = 0; row < size_; ++row) {
+        if (valid(row)) offsets[row] = static_cast<uint64_t>(values[row]) - static_cast<uint64_t>(min);
+    }
+    encoded.packed_ = pack(offsets, encoded.width_);
+    return encoded;
+}
+
+void ColumnSegment::compress() {
+    if (encoding_ != ColumnEncoding::PLAIN || size_ == 0) return;
+
+    std::vector<size_t> sample;
+    if (size_ <= sample_stretches * stretch_rows) {
+        sample.resize(size_);
+        std::iota(sample.begin(), sample.end(), 0);
+    } else {
+        for (size_t s = 0; s < sample_stretches; ++s) {
+            const size_t start = s * (size_ - stretch_rows) / (sample_stretches - 1);
+            for (size_t row = start; row < start + stretch_rows; ++row) sample.push_back(row);
+        }
+    }
+
+    // Runs show as neighbouring sampled rows that differ
+    size_t pairs = 0;
+    size_t breaks = 0;
+    size_t sample_bytes = 0;
+    for (size_t i = 0; i < sample.size(); ++i) {
+        if (i > 0 && sample[i] == sample[i - 1] + 1) {
+            pairs++;
+            if (compare_entries(sample[i - 1], sample[i]) != 0) breaks++;
+        }
+        if (kind_ == StorageKind::VARIABLE) sample_bytes += text(sample[i]).size();
+    }
+    std::vector<size_t> sorted = sample;
+    std::sort(sorted.begin(), sorted.end(), [this](size_t a, size_t b) { return compare_entries(a, b) < 0; });
+    size_t distinct = 0;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        if (i == 0 || compare_entries(sorted[i - 1], sorted[i]) != 0) distinct++;
+    }
+
+    // Scale the sample up. A sample mostly of distinct values suggests
+    // distinct values throughout; a few repeated ones, that those are all.
+    const double scale = static_cast<double>(size_) / static_cast<double>(sample.size());
+    const double entry_bytes = kind_ == StorageKind::BOOLEAN ? 1.0
+                             : kind_ != StorageKind::VARIABLE
+                                 ? 8.0
+                                 : static_cast<double>(sample_bytes) / static_cast<double>(sample.size()) + 4.0;
+    const double distinct_values = distinct * 2 > sample.size() ? distinct * scale : static_cast<double>(distinct);
+    const double rows = static_cast<double>(size_);
+    const double runs = pairs == 0 ? rows : 1.0 + static_cast<double>(breaks) * (rows - 1) / static_cast<double>(pairs);
+
+    ColumnEncoding best = ColumnEncoding::PLAIN;
+    double best_bytes = static_cast<double>(bytes_used() - validity_.size() * sizeof(uint64_t));
+    const auto consider = [&](ColumnEncoding encoding, double bytes) {
+        if (bytes < best_bytes) {
+            best = encoding;
+            best_bytes = bytes;
+        }
+    };
+    if (kind_ != StorageKind::BOOLEAN) {
+        consider(ColumnEncoding::DICTIONARY,
+                 distinct_values * entry_bytes + rows * bit_width(static_cast<uint64_t>(distinct_values)) / 8);
+    }
+    consider(ColumnEncoding::RLE, runs * (entry_bytes + sizeof(uint32_t)));
+    std::vector<int64_t> integers;
+    const bool integral = integer_values(integers);
+    if (integral) {
+        int64_t min = 0;
+        int64_t max = 0;
+        bool any = false;
+        for (size_t row : sample) {
+            if (!valid(row)) continue;
+            min = any ? std::min(min, integers[row]) : integers[row];
+            max = any ? std::max(max, integers[row]) : integers[row];
+            any = true;
+        }
+        consider(ColumnEncoding::FRAME_OF_REFERENCE,
+                 rows * bit_width(static_cast<uint64_t>(max) - static_cast<uint64_t>(min)) / 8);
+    }
+
+    if (best == ColumnEncoding::PLAIN) return;
+    ColumnSegment encoded = best == ColumnEncoding::DICTIONARY ? encode_dictionary()
+                          : best == ColumnEncoding::RLE        ? encode_rle()
+                                                               : encode_frame_of_reference(integers);
+    // The sample can mislead; keep whichever is really smaller
+    if (encoded.bytes_used() < bytes_used()) {
+        encoded.zone_ = zone_;
+        *this = std::move(encoded);
+    }
+}
+
+void ColumnSegment::decompress() {
+    if (encoding_ == ColumnEncoding::PLAIN) return;
+    VectorBuffer buffer;
+    const ColumnVector rows = vector(0, size_, buffer);
+    ColumnSegment plain(type_);
+    for (size_t row = 0; row < size_; ++row) {
+        plain.append(rows.value(row));
+    }
+    *this = std::move(plain);
+}
+
+size_t ColumnSegment::bytes_used() const {
+    return validity_.size() * sizeof(uint64_t) + integers_.size() * sizeof(int64_t) +
+           decimals_.size() * sizeof(double) + booleans_.size() +
+           (kind_ == StorageKind::VARIABLE ? offsets_.size() * sizeof(uint32_t) + bytes_.size() : 0) +
+           run_ends_.size() * sizeof(uint32_t) + packed_.size() * sizeof(uint64_t);
+}
+
+ColumnVector ColumnSegment::vector(size_t offset, size_t count) const {
+    if (encoding_ != ColumnEncoding::PLAIN) {
+        throw std::runtime_error("Compressed segments are decoded into a vector buffer");
+    }
+    ColumnVector vector;
+    vector.kind = kind_;
+    vector.count = count;
+    vector.validity = validity_.data() + offset / 64;
+    switch (kind_) {
+        case StorageKind::INTEGER:
+            vector.integers = integers_.data() + offset;
+            break;
+        case StorageKind::DECIMAL:
+            vector.decimals = decimals_.data() + offset;
+            break;
+        case StorageKind::BOOLEAN:
+            vector.booleans = booleans_.data() + offset;
+            break;
+        case StorageKind::VARIABLE:
+            vector.offsets = offsets_.data() + offset;
+            vector.bytes = bytes_.data();
+            break;
+    }
+    return vector;
+}
+
+ColumnVector ColumnSegment::vector(size_t offset, size_t count, VectorBuffer& buffer) const {
+    if (encoding_ == ColumnEncoding::PLAIN) return vector(offset, count);
+
+    ColumnVector vector;
+    vector.kind = kind_;
+    vector.count = count;
+    vector.validity = validity_.data() + offset / 64;
+
+    // Frame of reference decodes integers straight into place
+    if (encoding_ == ColumnEncoding::FRAME_OF_REFERENCE && kind_ == StorageKind::INTEGER) {
+        buffer.integers.resize(count);
+        unpack(packed_, width_, offset, count, static_cast<uint64_t>(reference_),
+               reinterpret_cast<uint64_t*>(buffer.integers.data()));
+        vector.integers = buffer.integers.data();
+        return vector;
+    }
+
+    // Otherwise find the entry of each row: its dictionary code, its run,
+    // or for dates and timestamps its integer form
+    buffer.codes.resize(count);
+    if (encoding_ == ColumnEncoding::RLE) {
+        size_t run = static_cast<size_t>(std::upper_bound(run_ends_.begin(), run_ends_.end(), offset) -
+                                         run_ends_.begin());
+        for (size_t i = 0; i < count; ++i) {
+            while (run_ends_[run] <= offset + i) run++;
+            buffer.codes[i] = run;
+        }
+    } else {
+        const uint64_t base = encoding_ == ColumnEncoding::DICTIONARY ? 0 : static_cast<uint64_t>(reference_);
+        unpack(packed_, width_, offset, count, base, buffer.codes.data());
+    }
+
+    if (encoding_ == ColumnEncoding::FRAME_OF_REFERENCE) {
+        buffer.offsets.assign(1, 0);
+        buffer.bytes.clear();
+        for (size_t i = 0; i < count; ++i) {
+            if (!vector.is_null(i)) {
+                const auto value = static_cast<int64_t>(buffer.codes[i]);
+                buffer.bytes += type_ == ColumnType::DATE ? format_date(value) : format_timestamp(value);
+            }
+            buffer.offsets.push_back(static_cast<uint32_t>(buffer.bytes.size()));
+        }
+        vector.offsets = buffer.offsets.data();
+        vector.bytes = buffer.bytes.data();
+        return vector;
+    }
+
+    switch (kind_) {
+        case StorageKind::INTEGER:
+            buffer.integers.resize(count);
+            for (size_t i = 0; i < count; ++i) buffer.integers[i] = integers_[buffer.codes[i]];
+            vector.integers = buffer.integers.data();
+            break;
+        case StorageKind::DECIMAL:
+            buffer.decimals.resize(count);
+            for (size_t i = 0; i < count; ++i) buffer.decimals[i] = decimals_[buffer.codes[i]];
+            vector.decimals = buffer.decimals.data();
+            break;
+        case StorageKind::BOOLEAN:
+            buffer.booleans.resize(count);
+            for (size_t i = 0; i < count; ++i) buffer.booleans[i] = booleans_[buffer.codes[i]];
+            vector.booleans = buffer.booleans.data();
+            break;
+        case StorageKind::VARIABLE:
+            buffer.offsets.assign(1, 0);
+            buffer.bytes.clear();
+            for (size_t i = 0; i < count; ++i) {
+                buffer.bytes += text(buffer.codes[i]);
+                buffer.offsets.push_back(static_cast<uint32_t>(buffer.bytes.size()));
+            }
+            vector.offsets = buffer.offsets.data();
+            vector.bytes = buffer.bytes.data();
+            break;
+    }
+    return vector;
+}
+
+std::string ColumnSegment::value(size_t row) const {
+    VectorBuffer buffer;
+    return vector(row - row % 64, row % 64 + 1, buffer).value(row % 64);
+}
+
+bool ColumnSegment::entry_matches(const SegmentFilter& filter, size_t index) const {
+    const auto number = [&](size_t i) { return std::isnan(filter.numbers[i]) ? nullptr : &filter.numbers[i]; };
+    switch (kind_) {
+        case StorageKind::INTEGER:
+            return evaluate(filter.predicate, [&](size_t i) {
+                return three_way(static_cast<double>(integers_[index]), filter.numbers[i]);
+            });
+        case StorageKind::DECIMAL:
+            return evaluate(filter.predicate, [&](size_t i) { return three_way(decimals_[index], filter.numbers[i]); });
+        case StorageKind::BOOLEAN:
+            return evaluate(filter.predicate, [&](size_t i) {
+                return compare_value(booleans_[index] ? "true" : "false", filter.predicate.values[i], nullptr);
+            });
+        default:
+            return evaluate(filter.predicate,
+                            [&](size_t i) { return compare_value(text(index), filter.predicate.values[i], number(i)); });
+    }
+}
+
+// Smallest frame-of-reference offset whose value is at least constant, or
+// above it, or one past the largest offset. Values rise with offsets,
+// integers as numbers and dates and timestamps as text, so this is a
+// binary search. A frame is never 64 bits wide, as plain would be smaller.
+uint64_t ColumnSegment::first_offset(const SegmentFilter& filter, size_t constant, bool above) const {
+    const double* number = std::isnan(filter.numbers[constant]) ? nullptr : &filter.numbers[constant];
+    const auto compare = [&](uint64_t offset) {
+        const auto value = static_cast<int64_t>(static_cast<uint64_t>(reference_) + offset);
+        if (kind_ == StorageKind::INTEGER) return three_way(static_cast<double>(value), *number);
+        const std::string text = type_ == ColumnType::DATE ? format_date(value) : format_timestamp(value);
+        return compare_value(text, filter.predicate.values[constant], number);
+    };
+    uint64_t low = 0;
+    uint64_t high = uint64_t{1} << width_;
+    while (low < high) {
+        const uint64_t middle = low + (high - low) / 2;
+        if (above ? compare(middle) > 0 : compare(middle) >= 0) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return low;
+}
+
+SegmentFilter ColumnSegment::prepare(const ColumnPredicate& predicate) const {
+    if (!predicate.applies_to(kind_)) {
+        throw std::runtime_error("Predicate cannot be tested on the encoded values of this column");
+    }
+    SegmentFilter filter;
+    filter.predicate = predicate;
+    for (const auto& value : predicate.values) {
+        // NaN marks a constant compared as text, as a row would compare it
+        double number = 0;
+        if (!read_number(value, number)) number = std::nan("");
+        filter.numbers.push_back(number);
+    }
+
+    if (encoding_ == ColumnEncoding::DICTIONARY || encoding_ == ColumnEncoding::RLE) {
+        filter.entries.assign((values() + 63) / 64, 0);
+        for (size_t index = 0; index < values(); ++index) {
+            if (entry_matches(filter, index)) filter.entries[index / 64] |= uint64_t{1} << (index % 64);
+        }
+    } else if (encoding_ == ColumnEncoding::FRAME_OF_REFERENCE) {
+        const uint64_t end = uint64_t{1} << width_;
+        const auto add = [&](uint64_t first, uint64_t stop) {
+            if (first < stop) filter.ranges.emplace_back(first, stop - 1);
+        };
+        switch (predicate.op) {
+            case ColumnPredicate::Op::LESS:
+                add(0, first_offset(filter, 0, false));
+                break;
+            case ColumnPredicate::Op::LESS_EQUAL:
+                add(0, first_offset(filter, 0, true));
+                break;
+            case ColumnPredicate::Op::GREATER:
+                add(first_offset(filter, 0, true), end);
+                break;
+            case ColumnPredicate::Op::GREATER_EQUAL:
+                add(first_offset(filter, 0, false), end);
+                break;
+            default:
+                // Equal, not equal and IN: the offsets equal to each constant
+                for (size_t i = 0; i < predicate.values.size(); ++i) {
+                    add(first_offset(filter, i, false), first_offset(filter, i, true));
+                }
+                filter.negate = predicate.op == ColumnPredicate::Op::NOT_EQUAL;
+                break;
+        }
+    }
+    return filter;
+}
+
+void ColumnSegment::select(const SegmentFilter& filter, size_t offset, size_t count, uint64_t* selection) const {
+    const uint64_t* valid_rows = validity(offset);
+    const size_t words = (count + 63) / 64;
+
+    // Runs decide whole stretches of rows at once
+    std::vector<uint64_t> run_rows;
+    if (encoding_ == ColumnEncoding::RLE) {
+        run_rows.assign(words, 0);
+        std::vector<ColumnRun> covering;
+        runs(offset, count, covering);
+        size_t row = 0;
+        for (const auto& run : covering) {
+            if ((filter.entries[run.entry / 64] >> (run.entry % 64)) & 1) set_bits(run_rows.data(), row, row + run.length);
+            row += run.length;
+        }
+    }
+
+    uint64_t values_of_word[64];
+    for (size_t w = 0; w < words; ++w) {
+        const size_t first = offset + w * 64;
+        const size_t n = std::min<size_t>(64, count - w * 64);
+        uint64_t matches = 0;
+        switch (encoding_) {
+            case ColumnEncoding::DICTIONARY:
+                unpack(packed_, width_, first, n, 0, values_of_word);
+                for (size_t i = 0; i < n; ++i) {
+                    const uint64_t code = values_of_word[i];
+                    matches |= ((filter.entries[code / 64] >> (code % 64)) & 1) << i;
+                }
+                break;
+            case ColumnEncoding::FRAME_OF_REFERENCE:
+                // One unsigned comparison per range and row, without decoding
+                unpack(packed_, width_, first, n, 0, values_of_word);
+                for (const auto& range : filter.ranges) {
+                    for (size_t i = 0; i < n; ++i) {
+                        matches |= static_cast<uint64_t>(values_of_word[i] - range.first <= range.second - range.first)
+                                   << i;
+                    }
+                }
+                if (filter.negate) matches = ~matches;
+                break;
+            case ColumnEncoding::RLE:
+                matches = run_rows[w];
+                break;
+            case ColumnEncoding::PLAIN:
+                for (size_t i = 0; i < n; ++i) {
+                    if (valid(first + i) && entry_matches(filter, first + i)) matches |= uint64_t{1} << i;
+                }
+                break;
+        }
+        if (n < 64) matches &= (uint64_t{1} << n) - 1;
+        selection[w] &= matches & valid_rows[w];
+    }
+}
+
+void ColumnSegment::codes(size_t offset, size_t count, uint32_t* codes) const {
+    if (encoding_ != ColumnEncoding::DICTIONARY) {
+        throw std::runtime_error("Only dictionary segments have codes");
+    }
+    unpack(packed_, width_, offset, count, 0, codes);
+}
+
+void ColumnSegment::runs(size_t offset, size_t count, std::vector<ColumnRun>& runs) const {
+    if (encoding_ != ColumnEncoding::RLE) {
+        throw std::runtime_error("Only RLE segments have runs");
+    }
+    runs.clear();
+    size_t run = static_cast<size_t>(std::upper_bound(run_ends_.begin(), run_ends_.end(), offset) -
+                                     run_ends_.begin());
+    for (size_t row = offset; row < offset + count; ++run) {
+        const size_t end = std::min<size_t>(run_ends_[run], offset + count);
+        runs.push_back({run, end - row});
+        row = end;
+    }
+}
+
+ColumnVector ColumnSegment::entries(VectorBuffer& buffer) const {
+    ColumnVector vector;
+    vector.kind = kind_;
+    vector.count = values();
+    buffer.validity.assign((vector.count + 63) / 64, ~uint64_t{0});
+    vector.validity = buffer.validity.data();
+    vector.integers = integers_.data();
+    vector.decimals = decimals_.data();
+    vector.booleans = booleans_.data();
+    vector.offsets = offsets_.data();
+    vector.bytes = bytes_.data();
+    return vector;
+}
+
+ColumnarTable::ColumnarTable(const Table& table, size_t row_group_size)
+    : name_(table.name), columns_(table.columns), row_group_size_(row_group_size) {
+    if (row_group_size_ == 0 || row_group_size_ % 64 != 0) {
+        throw std::runtime_error("Row group size " + std::to_string(row_group_size_) + " of table " + name_ +
+                                 " is not a positive multiple of 64");
+    }
+}
+
+size_t ColumnarTable::insert(const std::vector<std::string>& values) {
+    if (values.size() != columns_.size()) {
+        throw std::runtime_error("Row of " + std::to_string(values.size()) + " values for table " + name_ +
+                                 " of " + std::to_string(columns_.size()) + " columns");
+    }
+    for (size_t c = 0; c < columns_.size(); ++c) {
+        if (!ColumnSegment::accepts(storage_kind(columns_[c].type), values[c])) {
+            throw std::runtime_error("Cannot store '" + values[c] + "' in column " + name_ + "." + columns_[c].name);
+        }
+    }
+
+    if (row_groups_.empty() || row_groups_.back().row_count == row_group_size_) {
+        RowGroup group;
+        group.first_row = row_count_;
+        for (const auto& column : columns_) {
+            group.columns.emplace_back(column.type);
+        }
+        row_groups_.push_back(std::move(group));
+    }
+    RowGroup& group = row_groups_.back();
+    for (size_t c = 0; c < columns_.size(); ++c) {
+        group.columns[c].append(values[c]);
+    }
+    group.row_count++;
+    if (group.row_count == row_group_size_) {
+        for (auto& segment : group.columns) segment.compress();
+    }
+    return row_count_++;
+}
+
+size_t ColumnarTable::bytes_used(const std::vector<size_t>& columns) const {
+    size_t bytes = 0;
+    for (const auto& group : row_groups_) {
+        if (columns.empty()) {
+            for (const auto& segment : group.columns) bytes += segment.bytes_used();
+        } else {
+            for (size_t c : columns) bytes += group.columns[c].bytes_used();
+        }
+    }
+    return bytes;
+}
+
+void ColumnarTable::compress() {
+    if (row_groups_.empty()) return;
+    for (auto& segment : row_groups_.back().columns) segment.compress();
+}
+
+std::string ColumnarTable::value(size_t row, size_t column) const {
+    if (row >= row_count_) {
+        throw std::out_of_range("Row " + std::to_string(row) + " of table " + name_);
+    }
+    return column < columns_.size() ? row_groups_[row / row_group_size_].columns[column].value(row % row_group_size_)
+                                    : "";
+}
+
+} // namespace db25
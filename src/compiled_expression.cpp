@@ -0,0 +1,389 @@
+#include "compiled_expression.hpp"
+#include "physical_plan.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace db25 {
+
+static const std::string TRUE_VALUE = "true";
+static const std::string FALSE_VALUE = "false";
+
+static bool parse_integer_value(const std::string& value, long long& result) {
+    if (value.empty() || std::isspace(static_cast<unsigned char>(value[0]))) return false;
+    errno = 0;
+    char* end = nullptr;
+    result = std::strtoll(value.c_str(), &end, 10);
+    return *end == '\0' && errno != ERANGE;
+}
+
+static bool parse_float_value(const std::string& value, double& result) {
+    if (value.empty() || std::isspace(static_cast<unsigned char>(value[0]))) return false;
+    char* end = nullptr;
+    result = std::strtod(value.c_str(), &end);
+    return *end == '\0' && !std::isnan(result);
+}
+
+static std::string format_float(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+    return buffer;
+}
+
+static std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+static std::string uppercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    return text;
+}
+
+std::string expression_to_string(const ExpressionPtr& expr) {
+    if (!expr) return "";
+
+    switch (expr->type) {
+        case ExpressionType::COLUMN_REF:
+            return expr->column_ref ? expr->column_ref->full_name() : expr->value;
+
+        case ExpressionType::CONSTANT: {
+            double number;
+            if (expr->value.empty()) return "NULL";
+            return parse_float_value(expr->value, number) ? expr->value : "'" + expr->value + "'";
+        }
+
+        case ExpressionType::FUNCTION_CALL: {
+            std::string text = expr->value + "(";
+            for (size_t i = 0; i < expr->children.size(); ++i) {
+                if (i > 0) text += ", ";
+                text += expression_to_string(expr->children[i]);
+            }
+            return text + ")";
+        }
+
+        case ExpressionType::BINARY_OP:
+        case ExpressionType::UNARY_OP: {
+            if (expr->children.empty()) return expr->value; // Condition kept as text
+
+            const auto operand = [](const ExpressionPtr& child) {
+                const bool nested = child && child->type == ExpressionType::BINARY_OP && !child->children.empty();
+                return nested ? "(" + expression_to_string(child) + ")" : expression_to_string(child);
+            };
+            if (expr->children.size() == 1) {
+                const bool word = std::isalpha(static_cast<unsigned char>(expr->value.front()));
+                return expr->value + (word ? " " : "") + operand(expr->children[0]);
+            }
+            std::string text = operand(expr->children[0]);
+            for (size_t i = 1; i < expr->children.size(); ++i) {
+                text += " " + expr->value + " " + operand(expr->children[i]);
+            }
+            return text;
+        }
+
+        default:
+            return expr->value;
+    }
+}
+
+bool CompiledExpression::compile(const ExpressionPtr& expr, const std::vector<std::string>& input_columns) {
+    program.clear();
+    constants.clear();
+    if (!emit(expr, input_columns)) {
+        program.clear();
+        constants.clear();
+        return false;
+    }
+    return true;
+}
+
+bool CompiledExpression::emit(const ExpressionPtr& expr, const std::vector<std::string>& input_columns) {
+    if (!expr) return false;
+
+    // Children are emitted first; each instruction pops its operands
+    const auto emit_children = [&]() {
+        for (const auto& child : expr->children) {
+            if (!emit(child, input_columns)) return false;
+        }
+        return true;
+    };
+
+    switch (expr->type) {
+        case ExpressionType::COLUMN_REF: {
+            const int column = resolve_column_index(input_columns, expr);
+            if (column < 0) return false;
+            program.push_back({OpCode::LOAD_COLUMN, static_cast<size_t>(column)});
+            return true;
+        }
+
+        case ExpressionType::CONSTANT:
+            constants.push_back(expr->value);
+            program.push_back({OpCode::LOAD_CONSTANT, constants.size() - 1});
+            return true;
+
+        case ExpressionType::UNARY_OP:
+        case ExpressionType::BINARY_OP: {
+            const std::string op = uppercase(expr->value);
+            if (expr->children.size() == 1) {
+                if (op != "-" && op != "NOT") return false;
+                if (!emit_children()) return false;
+                program.push_back({op == "-" ? OpCode::NEGATE : OpCode::NOT});
+                return true;
+            }
+            if (expr->children.size() < 2) return false; // Text-only conditions
+
+            OpCode code;
+            if (op == "+") code = OpCode::ADD;
+            else if (op == "-") code = OpCode::SUBTRACT;
+            else if (op == "*") code = OpCode::MULTIPLY;
+            else if (op == "/") code = OpCode::DIVIDE;
+            else if (op == "%") code = OpCode::MODULO;
+            else if (op == "||") code = OpCode::CONCAT;
+            else if (op == "=") code = OpCode::EQUAL;
+            else if (op == "<>" || op == "!=") code = OpCode::NOT_EQUAL;
+            else if (op == "<") code = OpCode::LESS;
+            else if (op == "<=") code = OpCode::LESS_EQUAL;
+            else if (op == ">") code = OpCode::GREATER;
+            else if (op == ">=") code = OpCode::GREATER_EQUAL;
+            else if (op == "AND") code = OpCode::AND;
+            else if (op == "OR") code = OpCode::OR;
+            else return false;
+
+            // AND/OR trees may have more than two arguments; fold them pairwise
+            const bool variadic = code == OpCode::AND || code == OpCode::OR;
+            if (!variadic && expr->children.size() != 2) return false;
+            if (!emit(expr->children[0], input_columns)) return false;
+            for (size_t i = 1; i < expr->children.size(); ++i) {
+                if (!emit(expr->children[i], input_columns)) return false;
+                program.push_back({code});
+            }
+            return true;
+        }
+
+        case ExpressionType::FUNCTION_CALL: {
+            const std::string name = lowercase(expr->value);
+            const size_t arguments = expr->children.size();
+            OpCode code;
+            if (name == "upper" && arguments == 1) code = OpCode::UPPER;
+            else if (name == "lower" && arguments == 1) code = OpCode::LOWER;
+            else if ((name == "length" || name == "char_length") && arguments == 1) code = OpCode::LENGTH;
+            else if (name == "abs" && arguments == 1) code = OpCode::ABS;
+            else if (name == "coalesce" && arguments >= 1) code = OpCode::COALESCE;
+            else if (name == "concat" && arguments >= 1) code = OpCode::CONCAT_ALL;
+            else return false;
+
+            if (!emit_children()) return false;
+            program.push_back({code, arguments});
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+int CompiledExpression::column_index() const {
+    return program.size() == 1 && program[0].op == OpCode::LOAD_COLUMN ? static_cast<int>(program[0].operand) : -1;
+}
+
+std::string CompiledExpression::evaluate(const std::vector<std::string>& row) const {
+    stack.clear();
+    for (const auto& instruction : program) {
+        if (instruction.op == OpCode::LOAD_COLUMN) {
+            stack.push_back(instruction.operand < row.size() ? row[instruction.operand] : std::string());
+        } else if (instruction.op == OpCode::LOAD_CONSTANT) {
+            stack.push_back(constants[instruction.operand]);
+        } else {
+            execute(instruction);
+        }
+    }
+    return stack.empty() ? std::string() : std::move(stack.back());
+}
+
+void CompiledExpression::execute(const Instruction& instruction) const {
+    switch (instruction.op) {
+        case OpCode::NEGATE: {
+            std::string& value = stack.back();
+            long long integer;
+            double number;
+            if (parse_integer_value(value, integer) && integer != LLONG_MIN) {
+                value = std::to_string(-integer);
+            } else if (parse_float_value(value, number)) {
+                value = format_float(-number);
+            } else {
+                value.clear();
+            }
+            return;
+        }
+
+        case OpCode::NOT: {
+            std::string& value = stack.back();
+            if (!value.empty()) value = value == TRUE_VALUE ? FALSE_VALUE : TRUE_VALUE;
+            return;
+        }
+
+        case OpCode::UPPER:
+            stack.back() = uppercase(std::move(stack.back()));
+            return;
+        case OpCode::LOWER:
+            stack.back() = lowercase(std::move(stack.back()));
+            return;
+        case OpCode::LENGTH:
+            if (!stack.back().empty()) stack.back() = std::to_string(stack.back().size());
+            return;
+
+        case OpCode::ABS: {
+            std::string& value = stack.back();
+            long long integer;
+            double number;
+            if (parse_integer_value(value, integer) && integer != LLONG_MIN) {
+                value = std::to_string(integer < 0 ? -integer : integer);
+            } else if (parse_float_value(value, number)) {
+                value = format_float(std::fabs(number));
+            } else {
+                value.clear();
+            }
+            return;
+        }
+
+        case OpCode::COALESCE:
+        case OpCode::CONCAT_ALL: {
+            const size_t first = stack.size() - instruction.operand;
+            std::string result;
+            for (size_t i = first; i < stack.size(); ++i) {
+                if (instruction.op == OpCode::CONCAT_ALL) {
+                    result += stack[i]; // concat() skips NULL arguments
+                } else if (!stack[i].empty()) {
+                    result = std::move(stack[i]);
+                    break;
+                }
+            }
+            stack.resize(first);
+            stack.push_back(std::move(result));
+            return;
+        }
+
+        default:
+            break;
+    }
+
+    // Binary operators
+    std::string right = std::move(stack.back());
+    stack.pop_back();
+    std::string& left = stack.back();
+
+    switch (instruction.op) {
+        case OpCode::AND:
+            // Three-valued logic: false dominates NULL
+            if (left == FALSE_VALUE || right == FALSE_VALUE) left = FALSE_VALUE;
+            else if (left.empty() || right.empty()) left.clear();
+            else left = TRUE_VALUE;
+            return;
+        case OpCode::OR:
+            if (left == TRUE_VALUE || right == TRUE_VALUE) left = TRUE_VALUE;
+            else if (left.empty() || right.empty()) left.clear();
+            else left = FALSE_VALUE;
+            return;
+        default:
+            break;
+    }
+
+    if (left.empty() || right.empty()) {
+        left.clear();
+        return;
+    }
+
+    switch (instruction.op) {
+        case OpCode::CONCAT:
+            left += right;
+            return;
+
+        case OpCode::EQUAL:
+        case OpCode::NOT_EQUAL:
+        case OpCode::LESS:
+        case OpCode::LESS_EQUAL:
+        case OpCode::GREATER:
+        case OpCode::GREATER_EQUAL: {
+            double a, b;
+            int cmp;
+            if (parse_float_value(left, a) && parse_float_value(right, b)) {
+                cmp = a < b ? -1 : (a > b ? 1 : 0);
+            } else {
+                const int raw = left.compare(right);
+                cmp = raw < 0 ? -1 : (raw > 0 ? 1 : 0);
+            }
+            bool result;
+            switch (instruction.op) {
+                case OpCode::EQUAL: result = cmp == 0; break;
+                case OpCode::NOT_EQUAL: result = cmp != 0; break;
+                case OpCode::LESS: result = cmp < 0; break;
+                case OpCode::LESS_EQUAL: result = cmp <= 0; break;
+                case OpCode::GREATER: result = cmp > 0; break;
+                default: result = cmp >= 0; break;
+            }
+            left = result ? TRUE_VALUE : FALSE_VALUE;
+            return;
+        }
+
+        default:
+            break;
+    }
+
+    // Arithmetic stays in integers when both operands are integers and the
+    // result fits; division truncates as in SQL. Division by zero yields NULL.
+    long long x, y, integer_result;
+    if (parse_integer_value(left, x) && parse_integer_value(right, y)) {
+        bool overflow = false;
+        switch (instruction.op) {
+            case OpCode::ADD: overflow = __builtin_add_overflow(x, y, &integer_result); break;
+            case OpCode::SUBTRACT: overflow = __builtin_sub_overflow(x, y, &integer_result); break;
+            case OpCode::MULTIPLY: overflow = __builtin_mul_overflow(x, y, &integer_result); break;
+            case OpCode::DIVIDE:
+            case OpCode::MODULO:
+                if (y == 0) {
+                    left.clear();
+                    return;
+                }
+                overflow = x == LLONG_MIN && y == -1;
+                if (!overflow) integer_result = instruction.op == OpCode::DIVIDE ? x / y : x % y;
+                break;
+            default:
+                left.clear();
+                return;
+        }
+        if (!overflow) {
+            left = std::to_string(integer_result);
+            return;
+        }
+    }
+
+    double a, b;
+    if (!parse_float_value(left, a) || !parse_float_value(right, b)) {
+        left.clear();
+        return;
+    }
+    switch (instruction.op) {
+        case OpCode::ADD: left = format_float(a + b); break;
+        case OpCode::SUBTRACT: left = format_float(a - b); break;
+        case OpCode::MULTIPLY: left = format_float(a * b); break;
+        case OpCode::DIVIDE:
+            if (b == 0.0) left.clear();
+            else left = format_float(a / b);
+            break;
+        case OpCode::MODULO:
+            if (b == 0.0) left.clear();
+            else left = format_float(std::fmod(a, b));
+            break;
+        default:
+            left.clear();
+            break;
+    }
+}
+
+} // namespace db25
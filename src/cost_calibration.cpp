@@ -0,0 +1,413 @@
+#include "cost_calibration.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace db25 {
+    namespace {
+        constexpr double page_size = 8192.0; // Bytes, as in the planners' page counts
+        constexpr size_t unit_count = 5;
+
+        using UnitVector = std::array<double, unit_count>;
+
+        UnitVector to_vector(const CostUnits &units) {
+            return {units.seq_pages, units.random_pages, units.tuples, units.index_tuples, units.operators};
+        }
+
+        std::string trim(const std::string &text) {
+            const size_t begin = text.find_first_not_of(" \t\r");
+            if (begin == std::string::npos) return "";
+            const size_t end = text.find_last_not_of(" \t\r");
+            return text.substr(begin, end - begin + 1);
+        }
+
+        // Solves matrix * x = rhs by Gaussian elimination with partial
+        // pivoting; false if the system is singular
+        bool solve(std::vector<std::vector<double> > matrix, std::vector<double> rhs, std::vector<double> &x) {
+            const size_t n = rhs.size();
+            for (size_t column = 0; column < n; ++column) {
+                size_t pivot = column;
+                for (size_t row = column + 1; row < n; ++row) {
+                    if (std::abs(matrix[row][column]) > std::abs(matrix[pivot][column])) pivot = row;
+                }
+                if (std::abs(matrix[pivot][column]) < 1e-12) return false;
+                std::swap(matrix[pivot], matrix[column]);
+                std::swap(rhs[pivot], rhs[column]);
+                for (size_t row = column + 1; row < n; ++row) {
+                    const double factor = matrix[row][column] / matrix[column][column];
+                    for (size_t k = column; k < n; ++k) {
+                        matrix[row][k] -= factor * matrix[column][k];
+                    }
+                    rhs[row] -= factor * rhs[column];
+                }
+            }
+            x.assign(n, 0.0);
+            for (size_t row = n; row-- > 0;) {
+                double sum = rhs[row];
+                for (size_t k = row + 1; k < n; ++k) {
+                    sum -= matrix[row][k] * x[k];
+                }
+                x[row] = sum / matrix[row][row];
+            }
+            return true;
+        }
+
+        // Rows of a key and a payload of width characters; each key is
+        // repeated duplicates times
+        std::vector<Tuple> make_rows(const size_t rows, const size_t width, const size_t duplicates, const bool shuffle,
+                                     std::mt19937 &gen) {
+            std::vector<Tuple> data;
+            data.reserve(rows);
+            for (size_t i = 0; i < rows; ++i) {
+                data.emplace_back(std::vector<std::string>{std::to_string(i / duplicates), std::string(width, 'x')});
+            }
+            if (shuffle) std::shuffle(data.begin(), data.end(), gen);
+            return data;
+        }
+
+        double data_pages(const std::vector<Tuple> &rows) {
+            double bytes = 0.0;
+            for (const auto &row: rows) {
+                for (const auto &value: row.values) {
+                    bytes += static_cast<double>(value.size());
+                }
+            }
+            return bytes / page_size;
+        }
+
+        ExpressionPtr column(const std::string &name) {
+            return std::make_shared<Expression>(ExpressionType::COLUMN_REF, name);
+        }
+
+        std::shared_ptr<SequentialScanNode> make_scan(const std::string &table, const std::vector<Tuple> &rows) {
+            auto scan = std::make_shared<SequentialScanNode>(table);
+            scan->output_columns = {table + ".k", table + ".payload"};
+            scan->mock_data = rows;
+            return scan;
+        }
+
+        // Seconds of the fastest of repetitions runs of a plan built afresh by
+        // make; building it is not timed
+        double time_plan(const std::function<PhysicalPlanNodePtr()> &make, const size_t repetitions) {
+            double best = std::numeric_limits<double>::infinity();
+            for (size_t run = 0; run < std::max<size_t>(repetitions, 1); ++run) {
+                const PhysicalPlanNodePtr root = make();
+                ExecutionContext context;
+                const auto start = std::chrono::steady_clock::now();
+                root->initialize(&context);
+                size_t rows = 0;
+                while (root->has_more_data()) {
+                    rows += root->get_next_batch().size();
+                }
+                const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                best = std::min(best, elapsed.count());
+                root->cleanup();
+            }
+            return best;
+        }
+
+        // Hash join work without the scans feeding it: builds a table over
+        // build keyed like PhysicalHashJoinNode's and probes it with probe
+        double time_hash(const std::vector<Tuple> &build, const std::vector<Tuple> &probe, const size_t repetitions) {
+            double best = std::numeric_limits<double>::infinity();
+            size_t matches = 0;
+            for (size_t run = 0; run < std::max<size_t>(repetitions, 1); ++run) {
+                const auto start = std::chrono::steady_clock::now();
+                std::unordered_map<std::string, std::vector<Tuple> > table;
+                for (const auto &row: build) {
+                    table[row.values[0]].push_back(row);
+                }
+                for (const auto &row: probe) {
+                    const auto it = table.find(row.values[0]);
+                    if (it != table.end()) matches += it->second.size();
+                }
+                const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                best = std::min(best, elapsed.count());
+            }
+            volatile size_t sink = matches; // Keeps the probes from being optimized away
+            (void) sink;
+            return best;
+        }
+    }
+
+    void CostConstants::apply(PlannerConfig &config) const {
+        config.seq_page_cost = seq_page_cost;
+        config.random_page_cost = random_page_cost;
+        config.cpu_tuple_cost = cpu_tuple_cost;
+        config.cpu_index_tuple_cost = cpu_index_tuple_cost;
+        config.cpu_operator_cost = cpu_operator_cost;
+    }
+
+    void CostConstants::apply(PhysicalPlannerConfig &config) const {
+        config.cpu_tuple_cost = cpu_tuple_cost;
+        config.cpu_index_tuple_cost = cpu_index_tuple_cost;
+        config.cpu_operator_cost = cpu_operator_cost;
+    }
+
+    CostConstants read_cost_constants(std::istream &in) {
+        CostConstants constants;
+        const std::unordered_map<std::string, double *> fields = {
+            {"seq_page_cost", &constants.seq_page_cost},
+            {"random_page_cost", &constants.random_page_cost},
+            {"cpu_tuple_cost", &constants.cpu_tuple_cost},
+            {"cpu_index_tuple_cost", &constants.cpu_index_tuple_cost},
+            {"cpu_operator_cost", &constants.cpu_operator_cost},
+        };
+
+        std::string line;
+        size_t line_number = 0;
+        while (std::getline(in, line)) {
+            ++line_number;
+            line = trim(line.substr(0, line.find('#')));
+            if (line.empty()) continue;
+
+            const size_t equals = line.find('=');
+            const std::string name = trim(line.substr(0, equals));
+            const auto field = fields.find(name);
+            if (equals == std::string::npos || field == fields.end()) {
+                throw std::runtime_error("Unknown cost setting on line " + std::to_string(line_number) + ": " + line);
+            }
+            const std::string value = trim(line.substr(equals + 1));
+            char *end = nullptr;
+            const double parsed = std::strtod(value.c_str(), &end);
+            if (value.empty() || *end != '\0' || !std::isfinite(parsed) || parsed < 0.0) {
+                throw std::runtime_error("Invalid value for " + name + " on line " + std::to_string(line_number));
+            }
+            *field->second = parsed;
+        }
+        return constants;
+    }
+
+    CostConstants load_cost_constants(const std::string &path) {
+        std::ifstream in(path);
+        if (!in) throw std::runtime_error("Cannot open cost settings " + path);
+        return read_cost_constants(in);
+    }
+
+    void write_cost_constants(std::ostream &out, const CostConstants &constants) {
+        out << std::setprecision(6);
+        out << "seq_page_cost = " << constants.seq_page_cost << "\n";
+        out << "random_page_cost = " << constants.random_page_cost << "\n";
+        out << "cpu_tuple_cost = " << constants.cpu_tuple_cost << "\n";
+        out << "cpu_index_tuple_cost = " << constants.cpu_index_tuple_cost << "\n";
+        out << "cpu_operator_cost = " << constants.cpu_operator_cost << "\n";
+    }
+
+    CostConstants fit_cost_constants(const std::vector<CalibrationSample> &samples, double *fit_error) {
+        // Dividing each sample by its time makes every target 1, so the
+        // squared residuals are relative errors
+        std::vector<UnitVector> rows;
+        for (const auto &sample: samples) {
+            if (sample.seconds <= 0.0) continue;
+            UnitVector row = to_vector(sample.units);
+            for (double &units: row) {
+                units /= sample.seconds;
+            }
+            rows.push_back(row);
+        }
+        if (rows.empty()) throw std::runtime_error("No calibration samples to fit");
+
+        // With five unknowns every subset of them can be tried: the
+        // non-negative optimum is the best unconstrained fit, over some subset,
+        // that comes out non-negative
+        UnitVector best{};
+        double best_residual = std::numeric_limits<double>::infinity();
+        for (unsigned subset = 1; subset < (1u << unit_count); ++subset) {
+            std::vector<size_t> active;
+            for (size_t unit = 0; unit < unit_count; ++unit) {
+                if (subset & (1u << unit)) active.push_back(unit);
+            }
+            std::vector<std::vector<double> > normal(active.size(), std::vector<double>(active.size(), 0.0));
+            std::vector<double> rhs(active.size(), 0.0);
+            for (const auto &row: rows) {
+                for (size_t i = 0; i < active.size(); ++i) {
+                    for (size_t j = 0; j < active.size(); ++j) {
+                        normal[i][j] += row[active[i]] * row[active[j]];
+                    }
+                    rhs[i] += row[active[i]];
+                }
+            }
+            std::vector<double> solution;
+            if (!solve(normal, rhs, solution) ||
+                std::any_of(solution.begin(), solution.end(), [](double x) { return x < 0.0; })) {
+                continue;
+            }
+
+            UnitVector fitted{};
+            for (size_t i = 0; i < active.size(); ++i) {
+                fitted[active[i]] = solution[i];
+            }
+            double residual = 0.0;
+            for (const auto &row: rows) {
+                double predicted = 0.0;
+                for (size_t unit = 0; unit < unit_count; ++unit) {
+                    predicted += row[unit] * fitted[unit];
+                }
+                residual += (predicted - 1.0) * (predicted - 1.0);
+            }
+            if (residual < best_residual) {
+                best_residual = residual;
+                best = fitted;
+            }
+        }
+        if (!std::isfinite(best_residual)) throw std::runtime_error("Calibration samples admit no fit");
+        if (fit_error) *fit_error = std::sqrt(best_residual / static_cast<double>(rows.size()));
+
+        // Seconds per unit to planner units
+        const CostConstants defaults;
+        double scale;
+        if (best[2] > 0.0) {
+            scale = defaults.cpu_tuple_cost / best[2];
+        } else if (best[0] > 0.0) {
+            scale = defaults.seq_page_cost / best[0];
+        } else {
+            throw std::runtime_error("Calibration samples do not determine the per-row cost");
+        }
+        const double floor = defaults.cpu_tuple_cost / 100.0;
+        const auto constant = [&](size_t unit) { return std::max(best[unit] * scale, floor); };
+
+        CostConstants constants;
+        constants.seq_page_cost = constant(0);
+        constants.random_page_cost = constant(1);
+        constants.cpu_tuple_cost = constant(2);
+        constants.cpu_index_tuple_cost = constant(3);
+        constants.cpu_operator_cost = constant(4);
+        return constants;
+    }
+
+    CostCalibration calibrate_cost_model(const CalibrationConfig &config) {
+        CostCalibration calibration;
+        std::mt19937 gen(42);
+        const auto scaled = [&config](size_t rows) {
+            return std::max<size_t>(static_cast<size_t>(static_cast<double>(rows) * config.scale), 64);
+        };
+        const auto add = [&calibration](std::string workload, const CostUnits &units, double seconds) {
+            calibration.samples.push_back(CalibrationSample{std::move(workload), units, seconds});
+        };
+        const auto scan_units = [](const std::vector<Tuple> &rows) {
+            CostUnits units;
+            units.seq_pages = data_pages(rows);
+            units.tuples = static_cast<double>(rows.size());
+            return units;
+        };
+
+        // Sequential scans: narrow and wide rows separate the per-page cost
+        // from the per-row one
+        for (const size_t rows: {scaled(20000), scaled(80000)}) {
+            for (const size_t width: {16, 512}) {
+                const auto data = make_rows(rows, width, 1, false, gen);
+                const double seconds = time_plan([&] { return make_scan("t", data); }, config.repetitions);
+                add("scan " + std::to_string(rows) + "x" + std::to_string(width), scan_units(data), seconds);
+            }
+        }
+
+        // Filters: one comparison per row on top of the scan
+        for (const size_t rows: {scaled(20000), scaled(80000)}) {
+            const auto data = make_rows(rows, 16, 1, true, gen);
+            auto condition = std::make_shared<Expression>(ExpressionType::BINARY_OP, "<");
+            condition->children = {
+                column("t.k"), std::make_shared<Expression>(ExpressionType::CONSTANT, std::to_string(rows / 2))
+            };
+            const double seconds = time_plan([&] {
+                auto filter = std::make_shared<PhysicalFilterNode>();
+                filter->conditions.push_back(condition);
+                filter->children.push_back(make_scan("t", data));
+                filter->output_columns = filter->children[0]->output_columns;
+                return filter;
+            }, config.repetitions);
+            CostUnits units = scan_units(data);
+            units.operators = static_cast<double>(rows);
+            add("filter " + std::to_string(rows), units, seconds);
+        }
+
+        // Sorts of shuffled keys, charged 2 n log2 n comparisons
+        for (const size_t rows: {scaled(10000), scaled(40000)}) {
+            const auto data = make_rows(rows, 16, 1, true, gen);
+            const double seconds = time_plan([&] {
+                auto sort = std::make_shared<PhysicalSortNode>();
+                PhysicalSortKey key;
+                key.expression = column("t.k");
+                key.type = SortKeyType::INTEGER;
+                sort->sort_keys.push_back(key);
+                sort->children.push_back(make_scan("t", data));
+                sort->output_columns = sort->children[0]->output_columns;
+                return sort;
+            }, config.repetitions);
+            CostUnits units = scan_units(data);
+            units.operators = 2.0 * static_cast<double>(rows) * std::log2(static_cast<double>(rows));
+            add("sort " + std::to_string(rows), units, seconds);
+        }
+
+        // Hash builds and probes, charged a row per build row and half a row
+        // per probe row
+        for (const auto &[build_rows, probe_rows]:
+             {std::pair{scaled(10000), scaled(40000)}, std::pair{scaled(40000), scaled(10000)}}) {
+            const auto build = make_rows(build_rows, 16, 1, true, gen);
+            const auto probe = make_rows(probe_rows, 16, 1, true, gen);
+            CostUnits units;
+            units.tuples = static_cast<double>(build_rows) + 0.5 * static_cast<double>(probe_rows);
+            add("hash " + std::to_string(build_rows) + "/" + std::to_string(probe_rows), units,
+                time_hash(build, probe, config.repetitions));
+        }
+
+        // Index lookups from an index nested loop join: a descent per outer
+        // row, then the matching entries, whose rows are fetched from random
+        // pages. Index size, matches per key and row width vary independently.
+        struct IndexWorkload {
+            size_t rows;
+            size_t matches;
+            size_t width;
+        };
+        for (const auto &workload: {IndexWorkload{scaled(4096), 1, 16}, IndexWorkload{scaled(131072), 1, 16},
+                                    IndexWorkload{scaled(32768), 8, 512}}) {
+            const size_t probes = scaled(5000);
+            const auto inner = make_rows(workload.rows, workload.width, workload.matches, false, gen);
+            std::uniform_int_distribution<size_t> key(0, workload.rows / workload.matches - 1);
+            std::vector<Tuple> outer;
+            outer.reserve(probes);
+            for (size_t i = 0; i < probes; ++i) {
+                outer.emplace_back(std::vector<std::string>{std::to_string(key(gen))});
+            }
+
+            const double seconds = time_plan([&] {
+                auto outer_scan = std::make_shared<SequentialScanNode>("o");
+                outer_scan->output_columns = {"o.k"};
+                outer_scan->mock_data = outer;
+                auto index = std::make_shared<PhysicalIndexScanNode>("t", "t_k");
+                index->output_columns = {"t.k", "t.payload"};
+                index->index_columns = {"k"};
+                index->mock_data = inner;
+                auto join = std::make_shared<PhysicalIndexNestedLoopJoinNode>(JoinType::INNER);
+                join->outer_keys.push_back(column("o.k"));
+                join->inner_keys.push_back(column("t.k"));
+                join->children = {outer_scan, index};
+                join->output_columns = {"o.k", "t.k", "t.payload"};
+                return join;
+            }, config.repetitions);
+
+            const double fetched = static_cast<double>(probes * workload.matches);
+            CostUnits units = scan_units(outer);
+            units.operators = static_cast<double>(probes) * std::log2(static_cast<double>(workload.rows));
+            units.index_tuples = fetched;
+            units.tuples += fetched;
+            units.random_pages = static_cast<double>(probes) + data_pages(inner) * fetched / static_cast<double>(workload.rows);
+            add("index " + std::to_string(workload.rows) + "x" + std::to_string(workload.matches) + "x" +
+                std::to_string(workload.width), units, seconds);
+        }
+
+        calibration.constants = fit_cost_constants(calibration.samples, &calibration.fit_error);
+        return calibration;
+    }
+}
@@ -43,6 +43,7 @@ LogicalPlanNodePtr TableScanNode::copy() const {
     auto node = std::make_shared<TableScanNode>(table_name);
     node->alias = alias;
     node->filter_conditions = filter_conditions;
+    node->required_columns = required_columns;
     node->cost = cost;
     node->output_columns = output_columns;
     return node;
@@ -84,6 +85,7 @@ LogicalPlanNodePtr IndexScanNode::copy() const {
     node->alias = alias;
     node->index_conditions = index_conditions;
     node->filter_conditions = filter_conditions;
+    node->required_columns = required_columns;
     node->cost = cost;
     node->output_columns = output_columns;
     return node;
@@ -171,6 +173,39 @@ LogicalPlanNodePtr HashJoinNode::copy() const {
     return node;
 }
 
+// MergeJoinNode implementation
+std::string MergeJoinNode::to_string(const int indent) const {
+    std::ostringstream oss;
+    oss << indent_string(indent) << "Merge " << join_type_to_string() 
+        << " (" << format_cost(cost) << ")\n";
+    
+    if (!join_conditions.empty()) {
+        oss << indent_string(indent + 1) << "Merge Cond: ";
+        for (size_t i = 0; i < join_conditions.size(); ++i) {
+            if (i > 0) oss << " AND ";
+            oss << join_conditions[i]->value;
+        }
+        oss << "\n";
+    }
+    
+    for (const auto& child : children) {
+        oss << child->to_string(indent + 1);
+    }
+    
+    return oss.str();
+}
+
+LogicalPlanNodePtr MergeJoinNode::copy() const {
+    auto node = std::make_shared<MergeJoinNode>(join_type);
+    node->join_conditions = join_conditions;
+    node->cost = cost;
+    node->output_columns = output_columns;
+    for (const auto& child : children) {
+        node->children.push_back(child->copy());
+    }
+    return node;
+}
+
 // ProjectionNode implementation
 std::string ProjectionNode::to_string(int indent) const {
     std::ostringstream oss;
@@ -512,6 +547,7 @@ LogicalPlan LogicalPlan::copy() const {
     }
     copied_plan.table_aliases = table_aliases;
     copied_plan.total_cost = total_cost;
+    copied_plan.fingerprint = fingerprint;
     return copied_plan;
 }
 
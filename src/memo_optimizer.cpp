@@ -0,0 +1,559 @@
+#include "memo_optimizer.hpp"
+#include "compiled_expression.hpp"
+#include <algorithm>
+#include <limits>
+#include <unordered_set>
+
+namespace db25 {
+    static constexpr size_t max_block_inputs = 64;
+    static constexpr double unbounded = std::numeric_limits<double>::infinity();
+
+    static uint64_t input_bit(const size_t i) { return uint64_t{1} << i; }
+
+    static bool is_inner_join(const LogicalPlanNodePtr &node) {
+        const auto join = std::dynamic_pointer_cast<JoinNode>(node);
+        return join && node->children.size() == 2 &&
+               (join->join_type == JoinType::INNER || join->join_type == JoinType::CROSS);
+    }
+
+    static void gather_block(const LogicalPlanNodePtr &node, std::vector<LogicalPlanNodePtr> &inputs, // NOLINT(misc-no-recursion)
+                             std::vector<ExpressionPtr> &conditions, std::unordered_set<const Expression *> &seen) {
+        if (!is_inner_join(node)) {
+            inputs.push_back(node);
+            return;
+        }
+        for (const auto &condition: std::static_pointer_cast<JoinNode>(node)->join_conditions) {
+            if (seen.insert(condition.get()).second) conditions.push_back(condition);
+        }
+        for (const auto &child: node->children) {
+            gather_block(child, inputs, conditions, seen);
+        }
+    }
+
+    static std::string column_name(const ExpressionPtr &expr) {
+        const std::string name = expr->column_ref ? expr->column_ref->full_name() : expr->value;
+        const size_t dot = name.rfind('.');
+        return dot == std::string::npos ? name : name.substr(dot + 1);
+    }
+
+    MemoOptimizer::MemoOptimizer(const QueryPlanner &planner, std::shared_ptr<DatabaseSchema> schema)
+        : planner_(planner), schema_(std::move(schema)) {
+    }
+
+    LogicalPlanNodePtr MemoOptimizer::optimize(const LogicalPlanNodePtr &root) {
+        groups_.clear();
+        blocks_.assign(1, JoinBlock());
+        relations_.clear();
+        if (!root) return root;
+
+        planner_.estimate_costs(root);
+        collect_relations(root, relations_);
+        root_ = copy_in(root);
+        explore();
+
+        auto plan = optimize_group(root_, {}, unbounded);
+        return plan ? plan : root;
+    }
+
+    std::vector<LogicalPlanNodePtr> MemoOptimizer::alternatives() {
+        std::vector<LogicalPlanNodePtr> plans;
+        if (groups_.empty()) return plans;
+
+        for (size_t i = 0; i < groups_[root_].expressions.size(); ++i) {
+            const MemoExpression expression = groups_[root_].expressions[i];
+            for (auto &plan: implement(root_, expression, {}, unbounded)) {
+                plans.push_back(std::move(plan));
+            }
+        }
+        std::stable_sort(plans.begin(), plans.end(), [](const LogicalPlanNodePtr &a, const LogicalPlanNodePtr &b) {
+            return a->cost.total_cost < b->cost.total_cost;
+        });
+        return plans;
+    }
+
+    size_t MemoOptimizer::expression_count() const {
+        size_t count = 0;
+        for (const auto &group: groups_) {
+            count += group.expressions.size();
+        }
+        return count;
+    }
+
+    MemoOptimizer::GroupId MemoOptimizer::copy_in(const LogicalPlanNodePtr &node) { // NOLINT(misc-no-recursion)
+        if (is_inner_join(node)) {
+            std::vector<LogicalPlanNodePtr> inputs;
+            std::vector<ExpressionPtr> conditions;
+            std::unordered_set<const Expression *> seen;
+            gather_block(node, inputs, conditions, seen);
+
+            if (inputs.size() <= max_block_inputs) {
+                const size_t block = blocks_.size();
+                blocks_.emplace_back();
+
+                std::map<std::string, size_t> owners; // Alias -> input scanning it
+                for (size_t i = 0; i < inputs.size(); ++i) {
+                    const GroupId input = copy_in(inputs[i]);
+                    groups_[input].members = input_bit(i);
+                    blocks_[block].inputs.push_back(input);
+                    for (const auto &relation: groups_[input].relations) {
+                        owners[relation.first] = i;
+                    }
+                }
+
+                // Conditions on unknown relations stay on the join of all inputs
+                const uint64_t all = inputs.size() == max_block_inputs ? ~uint64_t{0} : input_bit(inputs.size()) - 1;
+                for (const auto &condition: conditions) {
+                    std::set<std::string> referenced;
+                    uint64_t reads = 0;
+                    if (referenced_relations(condition, relations_, schema_.get(), referenced)) {
+                        for (const auto &alias: referenced) {
+                            if (owners.count(alias)) reads |= input_bit(owners[alias]);
+                        }
+                    }
+                    blocks_[block].conditions.emplace_back(condition, reads == 0 ? all : reads);
+                }
+                blocks_[block].reorder = inputs.size() <= planner_.get_config().dp_join_limit;
+
+                return copy_in_block(node, block, inputs);
+            }
+        }
+
+        MemoExpression expression;
+        expression.op = node->copy();
+        expression.op->children.clear();
+
+        Group group;
+        for (const auto &child: node->children) {
+            const GroupId input = copy_in(child);
+            expression.inputs.push_back(input);
+            group.relations.insert(groups_[input].relations.begin(), groups_[input].relations.end());
+        }
+        if (node->type == PlanNodeType::TABLE_SCAN) {
+            const auto scan = std::static_pointer_cast<TableScanNode>(node);
+            group.relations[scan->alias.empty() ? scan->table_name : scan->alias] = scan->table_name;
+        } else if (node->type == PlanNodeType::INDEX_SCAN) {
+            const auto scan = std::static_pointer_cast<IndexScanNode>(node);
+            group.relations[scan->alias.empty() ? scan->table_name : scan->alias] = scan->table_name;
+        }
+        group.rows = node->cost.estimated_rows;
+        group.expressions.push_back(std::move(expression));
+
+        groups_.push_back(std::move(group));
+        return groups_.size() - 1;
+    }
+
+    MemoOptimizer::GroupId MemoOptimizer::copy_in_block(const LogicalPlanNodePtr &node, const size_t block, // NOLINT(misc-no-recursion)
+                                                        const std::vector<LogicalPlanNodePtr> &inputs) {
+        if (!is_inner_join(node)) {
+            const auto input = std::find(inputs.begin(), inputs.end(), node);
+            return blocks_[block].inputs[static_cast<size_t>(input - inputs.begin())];
+        }
+        const GroupId left = copy_in_block(node->children[0], block, inputs);
+        const GroupId right = copy_in_block(node->children[1], block, inputs);
+        return join_group(block, left, right);
+    }
+
+    // Group of the join of left and right within a block, created on first use
+    MemoOptimizer::GroupId MemoOptimizer::join_group(const size_t block, const GroupId left, const GroupId right) {
+        MemoExpression expression;
+        auto join = std::make_shared<NestedLoopJoinNode>(JoinType::INNER);
+        join->join_conditions = conditions_between(block, groups_[left].members, groups_[right].members);
+        expression.op = join;
+        expression.inputs = {left, right};
+
+        const InputSet members = groups_[left].members | groups_[right].members;
+        if (const auto existing = blocks_[block].groups.find(members); existing != blocks_[block].groups.end()) {
+            add_expression(existing->second, std::move(expression));
+            return existing->second;
+        }
+
+        // Row estimate from placeholder inputs of the known sizes
+        auto estimate = std::static_pointer_cast<NestedLoopJoinNode>(join->copy());
+        for (const GroupId input: expression.inputs) {
+            auto placeholder = std::make_shared<SelectionNode>();
+            placeholder->cost.estimated_rows = groups_[input].rows;
+            estimate->children.push_back(placeholder);
+        }
+        planner_.estimate_node_cost(estimate);
+
+        Group group;
+        group.relations = groups_[left].relations;
+        group.relations.insert(groups_[right].relations.begin(), groups_[right].relations.end());
+        group.rows = estimate->cost.estimated_rows;
+        group.block = block;
+        group.members = members;
+        group.expressions.push_back(std::move(expression));
+
+        groups_.push_back(std::move(group));
+        blocks_[block].groups[members] = groups_.size() - 1;
+        return groups_.size() - 1;
+    }
+
+    void MemoOptimizer::add_expression(const GroupId group, MemoExpression expression) {
+        auto &expressions = groups_[group].expressions;
+        const bool known = std::any_of(expressions.begin(), expressions.end(), [&](const MemoExpression &e) {
+            return e.op->type == expression.op->type && e.inputs == expression.inputs;
+        });
+        if (!known) expressions.push_back(std::move(expression));
+    }
+
+    // Conditions first evaluable when left and right are joined: those
+    // spanning both sides, and single-input ones when that input joins
+    std::vector<ExpressionPtr> MemoOptimizer::conditions_between(const size_t block, const InputSet left,
+                                                                 const InputSet right) const {
+        std::vector<ExpressionPtr> result;
+        for (const auto &[condition, reads]: blocks_[block].conditions) {
+            if (reads & ~(left | right)) continue;
+            const bool spans = (reads & ~left) && (reads & ~right);
+            const bool single = (reads & (reads - 1)) == 0;
+            if (spans || (single && (reads == left || reads == right))) {
+                result.push_back(condition);
+            }
+        }
+        return result;
+    }
+
+    // Fires every transformation rule on every expression until no rule
+    // adds anything, so groups are complete before any is costed
+    void MemoOptimizer::explore() {
+        static const TransformationRule rules[] = {&MemoOptimizer::commute_join, &MemoOptimizer::associate_join};
+        constexpr size_t rule_count = sizeof(rules) / sizeof(rules[0]);
+
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (GroupId group = 0; group < groups_.size(); ++group) {
+                for (size_t i = 0; i < groups_[group].expressions.size(); ++i) {
+                    for (size_t rule = 0; rule < rule_count; ++rule) {
+                        if (groups_[group].expressions[i].applied_rules & (1u << rule)) continue;
+                        groups_[group].expressions[i].applied_rules |= 1u << rule;
+                        (this->*rules[rule])(group, i);
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+
+    // A JOIN B -> B JOIN A
+    void MemoOptimizer::commute_join(const GroupId group, const size_t expression) {
+        const size_t block = groups_[group].block;
+        if (block == 0) return;
+
+        const auto inputs = groups_[group].expressions[expression].inputs;
+        join_group(block, inputs[1], inputs[0]);
+    }
+
+    // (A JOIN B) JOIN C -> A JOIN (B JOIN C), unless B JOIN C is a cross product
+    void MemoOptimizer::associate_join(const GroupId group, const size_t expression) {
+        const size_t block = groups_[group].block;
+        if (block == 0 || !blocks_[block].reorder) return;
+
+        const auto inputs = groups_[group].expressions[expression].inputs;
+        const GroupId left = inputs[0];
+        const GroupId right = inputs[1];
+        if (groups_[left].block != block) return;
+
+        std::vector<std::vector<GroupId> > left_inputs;
+        for (const auto &e: groups_[left].expressions) {
+            left_inputs.push_back(e.inputs);
+        }
+        for (const auto &pair: left_inputs) {
+            if (conditions_between(block, groups_[pair[1]].members, groups_[right].members).empty()) continue;
+            const GroupId lower = join_group(block, pair[1], right);
+            join_group(block, pair[0], lower);
+        }
+    }
+
+    LogicalPlanNodePtr MemoOptimizer::optimize_group(const GroupId group, const Ordering &ordering, // NOLINT(misc-no-recursion)
+                                                     const double bound) {
+        const std::string key = ordering_key(ordering);
+        if (const auto it = groups_[group].winners.find(key); it != groups_[group].winners.end()) {
+            // A plan found under any bound is the cheapest; a failed search
+            // only rules out bounds up to the one it ran with
+            if (it->second.plan) return it->second.plan->cost.total_cost < bound ? it->second.plan : nullptr;
+            if (bound <= it->second.bound) return nullptr;
+        }
+
+        LogicalPlanNodePtr best;
+        double limit = bound;
+        for (size_t i = 0; i < groups_[group].expressions.size(); ++i) {
+            const MemoExpression expression = groups_[group].expressions[i];
+            for (auto &candidate: implement(group, expression, ordering, limit)) {
+                if (candidate->cost.total_cost < limit) {
+                    limit = candidate->cost.total_cost;
+                    best = std::move(candidate);
+                }
+            }
+        }
+
+        auto &winner = groups_[group].winners[key];
+        winner.plan = best;
+        winner.bound = bound;
+        return best;
+    }
+
+    // Cheapest plan in the given order, either delivered by an operator or
+    // enforced by sorting the cheapest plan in any order
+    LogicalPlanNodePtr MemoOptimizer::optimize_enforced(const GroupId group, const Ordering &ordering, // NOLINT(misc-no-recursion)
+                                                        const double bound) {
+        LogicalPlanNodePtr best = optimize_group(group, ordering, bound);
+        if (ordering.empty()) return best;
+
+        auto sort = std::make_shared<SortNode>();
+        sort->sort_keys = ordering;
+        const double limit = best ? best->cost.total_cost : bound;
+        if (auto sorted = plan_alternative(sort, {{group, {}, false}}, limit)) {
+            best = std::move(sorted);
+        }
+        return best;
+    }
+
+    std::vector<LogicalPlanNodePtr> MemoOptimizer::implement(const GroupId group, const MemoExpression &expression, // NOLINT(misc-no-recursion)
+                                                             const Ordering &ordering, const double bound) {
+        std::vector<LogicalPlanNodePtr> candidates;
+        const auto add = [&candidates](LogicalPlanNodePtr plan) {
+            if (plan) candidates.push_back(std::move(plan));
+        };
+
+        if (groups_[group].block != 0) {
+            implement_join(expression, ordering, bound, candidates);
+            return candidates;
+        }
+
+        const auto &op = expression.op;
+        switch (op->type) {
+            case PlanNodeType::TABLE_SCAN:
+                implement_scan(std::static_pointer_cast<TableScanNode>(op), ordering, bound, candidates);
+                break;
+
+            case PlanNodeType::INDEX_SCAN: {
+                const auto scan = std::static_pointer_cast<IndexScanNode>(op);
+                if (satisfies(index_ordering(scan->table_name, scan->alias, scan->index_name), ordering)) {
+                    add(plan_alternative(op, {}, bound));
+                }
+                break;
+            }
+
+            case PlanNodeType::SORT: {
+                const auto &keys = std::static_pointer_cast<SortNode>(op)->sort_keys;
+                if (!satisfies(keys, ordering)) break;
+
+                // Input already in order: the physical planner drops the sort
+                if (auto input = optimize_group(expression.inputs[0], keys, bound)) {
+                    auto sort = op->copy();
+                    sort->children = {input};
+                    sort->cost = input->cost;
+                    add(sort);
+                }
+                add(plan_alternative(op, {{expression.inputs[0], {}, false}}, bound));
+                break;
+            }
+
+            case PlanNodeType::SELECTION:
+            case PlanNodeType::LIMIT:
+                // Rows keep their input order
+                add(plan_alternative(op, {{expression.inputs[0], ordering, false}}, bound));
+                break;
+
+            case PlanNodeType::PROJECTION:
+                if (ordering.empty() || resolves_within(ordering, expression.inputs[0])) {
+                    add(plan_alternative(op, {{expression.inputs[0], ordering, false}}, bound));
+                }
+                break;
+
+            default: {
+                // Operators without alternatives deliver no order
+                if (!ordering.empty()) break;
+                std::vector<InputRequest> requests;
+                for (const GroupId input: expression.inputs) {
+                    requests.push_back({input, {}, false});
+                }
+                add(plan_alternative(op, requests, bound));
+                break;
+            }
+        }
+        return candidates;
+    }
+
+    // Sequential scan, or an index scan on any index that narrows the scan
+    // with comparisons on a prefix of its columns or delivers the wanted order
+    void MemoOptimizer::implement_scan(const std::shared_ptr<TableScanNode> &scan, const Ordering &ordering,
+                                       const double bound, std::vector<LogicalPlanNodePtr> &candidates) {
+        if (ordering.empty()) {
+            if (auto plan = plan_alternative(scan, {}, bound)) candidates.push_back(std::move(plan));
+        }
+
+        const auto table = schema_ ? schema_->get_table(scan->table_name) : std::nullopt;
+        if (!table || !planner_.get_config().enable_index_scans) return;
+
+        const std::string alias = scan->alias.empty() ? scan->table_name : scan->alias;
+        for (const auto &index: table->indexes) {
+            if (index.columns.empty() || index.type != "BTREE" || !satisfies(index_ordering(scan->table_name, alias, index.name), ordering)) {
+                continue;
+            }
+
+            auto index_scan = std::make_shared<IndexScanNode>(scan->table_name, index.name);
+            index_scan->alias = scan->alias;
+            index_scan->required_columns = scan->required_columns;
+            index_scan->output_columns = scan->output_columns;
+            match_index_conditions(index, scan->filter_conditions, index_scan->index_conditions,
+                                   index_scan->filter_conditions);
+            if (ordering.empty() && index_scan->index_conditions.empty()) continue;
+
+            if (auto plan = plan_alternative(index_scan, {}, bound)) candidates.push_back(std::move(plan));
+        }
+    }
+
+    // Nested loop join keeping its outer order, hash join, and merge join
+    // over inputs ordered on the equi-join keys
+    void MemoOptimizer::implement_join(const MemoExpression &expression, const Ordering &ordering, // NOLINT(misc-no-recursion)
+                                       const double bound, std::vector<LogicalPlanNodePtr> &candidates) {
+        const auto &conditions = std::static_pointer_cast<JoinNode>(expression.op)->join_conditions;
+        const GroupId left = expression.inputs[0];
+        const GroupId right = expression.inputs[1];
+        const auto &config = planner_.get_config();
+        const auto add = [&candidates](LogicalPlanNodePtr plan) {
+            if (plan) candidates.push_back(std::move(plan));
+        };
+
+        if (ordering.empty() || resolves_within(ordering, left)) {
+            auto nested_loop = std::make_shared<NestedLoopJoinNode>(JoinType::INNER);
+            nested_loop->join_conditions = conditions;
+            add(plan_alternative(nested_loop, {{left, ordering, true}, {right, {}, false}}, bound));
+        }
+
+        if (config.enable_hash_joins && ordering.empty()) {
+            auto hash_join = std::make_shared<HashJoinNode>(JoinType::INNER);
+            hash_join->join_conditions = conditions;
+            add(plan_alternative(hash_join, {{left, {}, false}, {right, {}, false}}, bound));
+        }
+
+        if (!config.enable_merge_joins) return;
+
+        Ordering left_keys;
+        Ordering right_keys;
+        for (const auto &condition: conditions) {
+            if (!condition || condition->type != ExpressionType::BINARY_OP || condition->value != "=" ||
+                condition->children.size() != 2) {
+                continue;
+            }
+            for (size_t side = 0; side < 2; ++side) {
+                const auto &left_key = condition->children[side];
+                const auto &right_key = condition->children[1 - side];
+                if (left_key->type != ExpressionType::COLUMN_REF || right_key->type != ExpressionType::COLUMN_REF) {
+                    break;
+                }
+                if (resolves_within({{left_key}}, left) && resolves_within({{right_key}}, right)) {
+                    left_keys.push_back({left_key});
+                    right_keys.push_back({right_key});
+                    break;
+                }
+            }
+        }
+        if (left_keys.empty() || !satisfies(left_keys, ordering)) return;
+
+        auto merge_join = std::make_shared<MergeJoinNode>(JoinType::INNER);
+        merge_join->join_conditions = conditions;
+        add(plan_alternative(merge_join, {{left, left_keys, true}, {right, right_keys, true}}, bound));
+    }
+
+    // Plans node over its requested inputs, or returns null once it cannot
+    // beat bound. The node's own cost is known from the input sizes alone, so
+    // what remains of the bound caps each input's search.
+    LogicalPlanNodePtr MemoOptimizer::plan_alternative(const LogicalPlanNodePtr &node, // NOLINT(misc-no-recursion)
+                                                       const std::vector<InputRequest> &requests, const double bound) {
+        auto plan = node->copy();
+        plan->children.clear();
+        for (const auto &request: requests) {
+            auto placeholder = std::make_shared<SelectionNode>();
+            placeholder->cost.estimated_rows = groups_[request.group].rows;
+            plan->children.push_back(placeholder);
+        }
+
+        // LIMIT reads only part of its input, so its cost does not add up
+        const bool additive = plan->type != PlanNodeType::LIMIT;
+        double budget = unbounded;
+        if (additive) {
+            planner_.estimate_node_cost(plan);
+            budget = bound - plan->cost.total_cost;
+            if (budget <= 0) return nullptr;
+        }
+
+        for (size_t i = 0; i < requests.size(); ++i) {
+            const auto &request = requests[i];
+            auto input = request.enforce
+                             ? optimize_enforced(request.group, request.ordering, budget)
+                             : optimize_group(request.group, request.ordering, budget);
+            if (!input) return nullptr;
+            if (additive) budget -= input->cost.total_cost;
+            plan->children[i] = std::move(input);
+        }
+
+        planner_.estimate_node_cost(plan);
+        return plan->cost.total_cost < bound ? plan : nullptr;
+    }
+
+    // "alias.column" for a column of a known relation, else the expression text
+    std::string MemoOptimizer::column_key(const ExpressionPtr &expr) const {
+        if (expr && expr->type == ExpressionType::COLUMN_REF) {
+            std::set<std::string> referenced;
+            if (referenced_relations(expr, relations_, schema_.get(), referenced) && referenced.size() == 1) {
+                return *referenced.begin() + "." + column_name(expr);
+            }
+        }
+        return expression_to_string(expr);
+    }
+
+    std::string MemoOptimizer::ordering_key(const Ordering &ordering) const {
+        std::string key;
+        for (const auto &sort_key: ordering) {
+            key += column_key(sort_key.expression) + (sort_key.ascending ? " ASC" : " DESC") +
+                   (sort_key.nulls_first ? " NULLS FIRST" : "") + ";";
+        }
+        return key;
+    }
+
+    // Whether rows in provided order are also in required order
+    bool MemoOptimizer::satisfies(const Ordering &provided, const Ordering &required) const {
+        if (required.size() > provided.size()) return false;
+        for (size_t i = 0; i < required.size(); ++i) {
+            if (provided[i].ascending != required[i].ascending ||
+                provided[i].nulls_first != required[i].nulls_first ||
+                column_key(provided[i].expression) != column_key(required[i].expression)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Whether every sort key is a column of a relation scanned by group
+    bool MemoOptimizer::resolves_within(const Ordering &ordering, const GroupId group) const {
+        return std::all_of(ordering.begin(), ordering.end(), [&](const SortNode::SortKey &key) {
+            std::set<std::string> referenced;
+            return key.expression && key.expression->type == ExpressionType::COLUMN_REF &&
+                   referenced_relations(key.expression, groups_[group].relations, schema_.get(), referenced) &&
+                   !referenced.empty();
+        });
+    }
+
+    // B-tree order of an index: its columns ascending, NULLs last
+    MemoOptimizer::Ordering MemoOptimizer::index_ordering(const std::string &table_name, const std::string &alias,
+                                                          const std::string &index_name) const {
+        Ordering ordering;
+        const auto table = schema_ ? schema_->get_table(table_name) : std::nullopt;
+        if (!table) return ordering;
+
+        const std::string qualifier = alias.empty() ? table_name : alias;
+        for (const auto &index: table->indexes) {
+            if (index.name != index_name) continue;
+            for (const auto &column: index.columns) {
+                SortNode::SortKey key;
+                key.expression = std::make_shared<Expression>(ExpressionType::COLUMN_REF, qualifier + "." + column);
+                key.expression->column_ref = ColumnRef{qualifier, column};
+                ordering.push_back(key);
+            }
+        }
+        return ordering;
+    }
+}
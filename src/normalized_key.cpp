@@ -0,0 +1,483 @@
+#include "normalized_key.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <thread>
+#include <utility>
+
+namespace db25 {
+
+// NULL indicator bytes: one precedes every key so NULL placement does not
+// depend on the sort direction of the value bytes that follow it
+static constexpr unsigned char NULLS_FIRST_MARKER = 0x00;
+static constexpr unsigned char VALUE_MARKER = 0x01;
+static constexpr unsigned char NULLS_LAST_MARKER = 0x02;
+
+static constexpr uint64_t SIGN_BIT = 0x8000000000000000ULL;
+
+static bool parse_integer_value(const std::string& value, long long& result) {
+    if (value.empty() || std::isspace(static_cast<unsigned char>(value[0]))) return false;
+    errno = 0;
+    char* end = nullptr;
+    result = std::strtoll(value.c_str(), &end, 10);
+    return *end == '\0' && errno != ERANGE;
+}
+
+static bool parse_float_value(const std::string& value, double& result) {
+    if (value.empty() || std::isspace(static_cast<unsigned char>(value[0]))) return false;
+    char* end = nullptr;
+    result = std::strtod(value.c_str(), &end);
+    return *end == '\0' && !std::isnan(result);
+}
+
+SortKeyType widen_sort_key_type(SortKeyType current, const std::string& value) {
+    if (value.empty()) return current;
+
+    long long integer_value;
+    double float_value;
+    switch (current) {
+        case SortKeyType::INFERRED:
+        case SortKeyType::INTEGER:
+            if (parse_integer_value(value, integer_value)) return SortKeyType::INTEGER;
+            [[fallthrough]];
+        case SortKeyType::FLOAT:
+            if (parse_float_value(value, float_value)) return SortKeyType::FLOAT;
+            [[fallthrough]];
+        case SortKeyType::TEXT:
+        default:
+            return SortKeyType::TEXT;
+    }
+}
+
+// Appends bits most significant byte first, inverted for descending order
+static void append_ordered_bits(std::string& out, uint64_t bits, bool ascending) {
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        const auto byte = static_cast<unsigned char>(bits >> shift);
+        out.push_back(static_cast<char>(ascending ? byte : static_cast<unsigned char>(~byte)));
+    }
+}
+
+void append_normalized_key(std::string& out, const std::string& value, SortKeyType type,
+                           bool ascending, bool nulls_first) {
+    if (value.empty()) {
+        out.push_back(static_cast<char>(nulls_first ? NULLS_FIRST_MARKER : NULLS_LAST_MARKER));
+        return;
+    }
+    out.push_back(static_cast<char>(VALUE_MARKER));
+
+    switch (type) {
+        case SortKeyType::INTEGER: {
+            long long integer_value = 0;
+            parse_integer_value(value, integer_value);
+            // Flipping the sign bit makes two's complement order unsigned
+            append_ordered_bits(out, static_cast<uint64_t>(integer_value) ^ SIGN_BIT, ascending);
+            break;
+        }
+
+        case SortKeyType::FLOAT: {
+            double float_value = 0.0;
+            parse_float_value(value, float_value);
+            if (float_value == 0.0) float_value = 0.0; // -0.0 sorts with 0.0
+            uint64_t bits;
+            std::memcpy(&bits, &float_value, sizeof(bits));
+            // Negative values reverse their magnitude order, positives gain the sign bit
+            bits = (bits & SIGN_BIT) ? ~bits : (bits | SIGN_BIT);
+            append_ordered_bits(out, bits, ascending);
+            break;
+        }
+
+        case SortKeyType::INFERRED:
+        case SortKeyType::TEXT:
+        default: {
+            // Escape 0x00 as 0x00 0xFF and terminate with 0x00 0x00 so a string
+            // sorts before its extensions and the next key starts on a boundary
+            const unsigned char mask = ascending ? 0x00 : 0xFF;
+            for (const char c : value) {
+                out.push_back(static_cast<char>(static_cast<unsigned char>(c) ^ mask));
+                if (c == '\0') out.push_back(static_cast<char>(0xFF ^ mask));
+            }
+            out.push_back(static_cast<char>(mask));
+            out.push_back(static_cast<char>(mask));
+            break;
+        }
+    }
+}
+
+int compare_normalized_keys(const NormalizedKeyRef& a, const NormalizedKeyRef& b) {
+    const size_t common = std::min(a.length, b.length);
+    const int cmp = common > 0 ? std::memcmp(a.data, b.data, common) : 0;
+    if (cmp != 0) return cmp;
+    return a.length < b.length ? -1 : (a.length > b.length ? 1 : 0);
+}
+
+// Pattern-defeating quicksort (Peters): median-of-3 or ninther pivots,
+// insertion sort on small or nearly sorted ranges, and a heapsort fallback
+// once too many unbalanced partitions have been seen
+static constexpr ptrdiff_t PDQ_INSERTION_SORT_THRESHOLD = 24;
+static constexpr ptrdiff_t PDQ_NINTHER_THRESHOLD = 128;
+static constexpr ptrdiff_t PDQ_PARTIAL_INSERTION_LIMIT = 8;
+
+template <typename Iter, typename Compare>
+static void pdq_insertion_sort(Iter begin, Iter end, Compare comp) {
+    if (begin == end) return;
+    for (Iter cur = begin + 1; cur != end; ++cur) {
+        Iter sift = cur;
+        Iter sift_1 = cur - 1;
+        if (comp(*sift, *sift_1)) {
+            auto tmp = std::move(*sift);
+            do {
+                *sift-- = std::move(*sift_1);
+            } while (sift != begin && comp(tmp, *--sift_1));
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// Requires an element before begin that is not greater than any in the range
+template <typename Iter, typename Compare>
+static void pdq_unguarded_insertion_sort(Iter begin, Iter end, Compare comp) {
+    if (begin == end) return;
+    for (Iter cur = begin + 1; cur != end; ++cur) {
+        Iter sift = cur;
+        Iter sift_1 = cur - 1;
+        if (comp(*sift, *sift_1)) {
+            auto tmp = std::move(*sift);
+            do {
+                *sift-- = std::move(*sift_1);
+            } while (comp(tmp, *--sift_1));
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// Insertion sort that gives up after a few moves; returns true when sorted
+template <typename Iter, typename Compare>
+static bool pdq_partial_insertion_sort(Iter begin, Iter end, Compare comp) {
+    if (begin == end) return true;
+    ptrdiff_t moves = 0;
+    for (Iter cur = begin + 1; cur != end; ++cur) {
+        Iter sift = cur;
+        Iter sift_1 = cur - 1;
+        if (comp(*sift, *sift_1)) {
+            auto tmp = std::move(*sift);
+            do {
+                *sift-- = std::move(*sift_1);
+            } while (sift != begin && comp(tmp, *--sift_1));
+            *sift = std::move(tmp);
+            moves += cur - sift;
+        }
+        if (moves > PDQ_PARTIAL_INSERTION_LIMIT) return false;
+    }
+    return true;
+}
+
+template <typename Iter, typename Compare>
+static void pdq_sort2(Iter a, Iter b, Compare comp) {
+    if (comp(*b, *a)) std::iter_swap(a, b);
+}
+
+template <typename Iter, typename Compare>
+static void pdq_sort3(Iter a, Iter b, Iter c, Compare comp) {
+    pdq_sort2(a, b, comp);
+    pdq_sort2(b, c, comp);
+    pdq_sort2(a, b, comp);
+}
+
+// Partitions around *begin; elements equal to the pivot go right. Returns the
+// pivot position and whether the range was already partitioned.
+template <typename Iter, typename Compare>
+static std::pair<Iter, bool> pdq_partition_right(Iter begin, Iter end, Compare comp) {
+    auto pivot = std::move(*begin);
+    Iter first = begin;
+    Iter last = end;
+
+    while (comp(*++first, pivot)) {}
+    if (first - 1 == begin) {
+        while (first < last && !comp(*--last, pivot)) {}
+    } else {
+        while (!comp(*--last, pivot)) {}
+    }
+
+    const bool already_partitioned = first >= last;
+    while (first < last) {
+        std::iter_swap(first, last);
+        while (comp(*++first, pivot)) {}
+        while (!comp(*--last, pivot)) {}
+    }
+
+    Iter pivot_pos = first - 1;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+    return {pivot_pos, already_partitioned};
+}
+
+// Partitions around *begin with equal elements going left; used when the
+// pivot equals the element preceding the range, which skips runs of duplicates
+template <typename Iter, typename Compare>
+static Iter pdq_partition_left(Iter begin, Iter end, Compare comp) {
+    auto pivot = std::move(*begin);
+    Iter first = begin;
+    Iter last = end;
+
+    while (comp(pivot, *--last)) {}
+    if (last + 1 == end) {
+        while (first < last && !comp(pivot, *++first)) {}
+    } else {
+        while (!comp(pivot, *++first)) {}
+    }
+
+    while (first < last) {
+        std::iter_swap(first, last);
+        while (comp(pivot, *--last)) {}
+        while (!comp(pivot, *++first)) {}
+    }
+
+    Iter pivot_pos = last;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+    return pivot_pos;
+}
+
+template <typename Iter, typename Compare>
+static void pdq_sort_loop(Iter begin, Iter end, Compare comp, int bad_allowed, bool leftmost) {
+    while (true) {
+        const ptrdiff_t size = end - begin;
+        if (size < PDQ_INSERTION_SORT_THRESHOLD) {
+            if (leftmost) {
+                pdq_insertion_sort(begin, end, comp);
+            } else {
+                pdq_unguarded_insertion_sort(begin, end, comp);
+            }
+            return;
+        }
+
+        const ptrdiff_t half = size / 2;
+        if (size > PDQ_NINTHER_THRESHOLD) {
+            pdq_sort3(begin, begin + half, end - 1, comp);
+            pdq_sort3(begin + 1, begin + (half - 1), end - 2, comp);
+            pdq_sort3(begin + 2, begin + (half + 1), end - 3, comp);
+            pdq_sort3(begin + (half - 1), begin + half, begin + (half + 1), comp);
+            std::iter_swap(begin, begin + half);
+        } else {
+            pdq_sort3(begin + half, begin, end - 1, comp);
+        }
+
+        // The pivot equals an element left of the range: everything equal to
+        // it is already in place, so only the greater elements need sorting
+        if (!leftmost && !comp(*(begin - 1), *begin)) {
+            begin = pdq_partition_left(begin, end, comp) + 1;
+            continue;
+        }
+
+        const auto partition = pdq_partition_right(begin, end, comp);
+        const Iter pivot_pos = partition.first;
+        const ptrdiff_t left_size = pivot_pos - begin;
+        const ptrdiff_t right_size = end - (pivot_pos + 1);
+
+        if (left_size < size / 8 || right_size < size / 8) {
+            if (--bad_allowed == 0) {
+                std::make_heap(begin, end, comp);
+                std::sort_heap(begin, end, comp);
+                return;
+            }
+
+            // Break up patterns that produced the bad partition
+            if (left_size >= PDQ_INSERTION_SORT_THRESHOLD) {
+                std::iter_swap(begin, begin + left_size / 4);
+                std::iter_swap(pivot_pos - 1, pivot_pos - left_size / 4);
+                if (left_size > PDQ_NINTHER_THRESHOLD) {
+                    std::iter_swap(begin + 1, begin + (left_size / 4 + 1));
+                    std::iter_swap(begin + 2, begin + (left_size / 4 + 2));
+                    std::iter_swap(pivot_pos - 2, pivot_pos - (left_size / 4 + 1));
+                    std::iter_swap(pivot_pos - 3, pivot_pos - (left_size / 4 + 2));
+                }
+            }
+            if (right_size >= PDQ_INSERTION_SORT_THRESHOLD) {
+                std::iter_swap(pivot_pos + 1, pivot_pos + (1 + right_size / 4));
+                std::iter_swap(end - 1, end - right_size / 4);
+                if (right_size > PDQ_NINTHER_THRESHOLD) {
+                    std::iter_swap(pivot_pos + 2, pivot_pos + (2 + right_size / 4));
+                    std::iter_swap(pivot_pos + 3, pivot_pos + (3 + right_size / 4));
+                    std::iter_swap(end - 2, end - (1 + right_size / 4));
+                    std::iter_swap(end - 3, end - (2 + right_size / 4));
+                }
+            }
+        } else if (partition.second &&
+                   pdq_partial_insertion_sort(begin, pivot_pos, comp) &&
+                   pdq_partial_insertion_sort(pivot_pos + 1, end, comp)) {
+            // Input looked sorted and a cheap insertion pass confirmed it
+            return;
+        }
+
+        pdq_sort_loop(begin, pivot_pos, comp, bad_allowed, leftmost);
+        begin = pivot_pos + 1;
+        leftmost = false;
+    }
+}
+
+template <typename Iter, typename Compare>
+static void pdq_sort(Iter begin, Iter end, Compare comp) {
+    if (end - begin < 2) return;
+    int log2_size = 0;
+    for (auto size = end - begin; size > 1; size >>= 1) {
+        log2_size++;
+    }
+    pdq_sort_loop(begin, end, comp, log2_size, true);
+}
+
+// Buckets below this size are cheaper to finish with comparisons
+static constexpr size_t RADIX_SORT_THRESHOLD = 64;
+// Bounds recursion (and stack use) on long shared prefixes
+static constexpr size_t RADIX_MAX_DEPTH = 64;
+
+// All keys in [keys, keys + count) share their first depth bytes
+static void msd_radix_sort(NormalizedKeyRef* keys, NormalizedKeyRef* scratch, size_t count, size_t depth) {
+    while (true) {
+        if (count < RADIX_SORT_THRESHOLD || depth >= RADIX_MAX_DEPTH) {
+            pdq_sort(keys, keys + count, [depth](const NormalizedKeyRef& a, const NormalizedKeyRef& b) {
+                NormalizedKeyRef suffix_a{a.data + depth, a.length - static_cast<uint32_t>(depth), a.row};
+                NormalizedKeyRef suffix_b{b.data + depth, b.length - static_cast<uint32_t>(depth), b.row};
+                return compare_normalized_keys(suffix_a, suffix_b) < 0;
+            });
+            return;
+        }
+
+        // Bucket 0 holds keys that end at this depth; they sort first
+        uint32_t counts[257] = {};
+        for (size_t i = 0; i < count; ++i) {
+            counts[keys[i].length > depth ? keys[i].data[depth] + 1 : 0]++;
+        }
+
+        // Every key shares this byte too: descend without moving anything
+        const auto full_bucket = std::find(std::begin(counts), std::end(counts), count);
+        if (full_bucket != std::end(counts)) {
+            if (full_bucket == std::begin(counts)) return; // All keys are equal
+            depth++;
+            continue;
+        }
+
+        uint32_t offsets[257];
+        uint32_t next = 0;
+        for (size_t bucket = 0; bucket < 257; ++bucket) {
+            offsets[bucket] = next;
+            next += counts[bucket];
+        }
+        for (size_t i = 0; i < count; ++i) {
+            const size_t bucket = keys[i].length > depth ? keys[i].data[depth] + 1 : 0;
+            scratch[offsets[bucket]++] = keys[i];
+        }
+        std::copy(scratch, scratch + count, keys);
+
+        size_t start = counts[0];
+        for (size_t bucket = 1; bucket < 257; ++bucket) {
+            if (counts[bucket] > 1) {
+                msd_radix_sort(keys + start, scratch + start, counts[bucket], depth + 1);
+            }
+            start += counts[bucket];
+        }
+        return;
+    }
+}
+
+void sort_normalized_keys(std::vector<NormalizedKeyRef>& keys) {
+    if (keys.size() < 2) return;
+    std::vector<NormalizedKeyRef> scratch(keys.size());
+    msd_radix_sort(keys.data(), scratch.data(), keys.size(), 0);
+}
+
+// Samples taken per range when choosing splitters
+static constexpr size_t PARALLEL_SORT_OVERSAMPLING = 64;
+
+// Runs task(worker) for every worker, using the calling thread as worker 0
+template <typename Task>
+static void run_on_workers(size_t workers, const Task& task) {
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (size_t worker = 1; worker < workers; ++worker) {
+        threads.emplace_back([&task, worker]() { task(worker); });
+    }
+    task(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void parallel_sort_normalized_keys(std::vector<NormalizedKeyRef>& keys, size_t degree) {
+    const size_t count = keys.size();
+    if (degree < 2 || count < degree * PARALLEL_SORT_OVERSAMPLING) {
+        sort_normalized_keys(keys);
+        return;
+    }
+
+    const auto less = [](const NormalizedKeyRef& a, const NormalizedKeyRef& b) {
+        return compare_normalized_keys(a, b) < 0;
+    };
+
+    // Evenly spaced samples give splitters that follow the key distribution
+    std::vector<NormalizedKeyRef> sample;
+    const size_t sample_size = degree * PARALLEL_SORT_OVERSAMPLING;
+    sample.reserve(sample_size);
+    for (size_t i = 0; i < sample_size; ++i) {
+        sample.push_back(keys[i * count / sample_size]);
+    }
+    sort_normalized_keys(sample);
+
+    std::vector<NormalizedKeyRef> splitters;
+    for (size_t range = 1; range < degree; ++range) {
+        splitters.push_back(sample[range * sample_size / degree]);
+    }
+
+    // Each worker classifies a contiguous chunk; keys equal to a splitter all
+    // land in the range after it, so equal keys never straddle two ranges
+    std::vector<uint32_t> ranges(count);
+    std::vector<std::vector<size_t>> range_counts(degree, std::vector<size_t>(degree, 0));
+    run_on_workers(degree, [&](size_t worker) {
+        const size_t begin = count * worker / degree;
+        const size_t end = count * (worker + 1) / degree;
+        for (size_t i = begin; i < end; ++i) {
+            const auto range = std::upper_bound(splitters.begin(), splitters.end(), keys[i], less) - splitters.begin();
+            ranges[i] = static_cast<uint32_t>(range);
+            range_counts[worker][range]++;
+        }
+    });
+
+    // Lay the ranges out back to back, each worker's slice in chunk order
+    std::vector<std::vector<size_t>> write_offsets(degree, std::vector<size_t>(degree, 0));
+    std::vector<size_t> range_begin(degree + 1, 0);
+    size_t next = 0;
+    for (size_t range = 0; range < degree; ++range) {
+        range_begin[range] = next;
+        for (size_t worker = 0; worker < degree; ++worker) {
+            write_offsets[worker][range] = next;
+            next += range_counts[worker][range];
+        }
+    }
+    range_begin[degree] = next;
+
+    std::vector<NormalizedKeyRef> partitioned(count);
+    run_on_workers(degree, [&](size_t worker) {
+        const size_t begin = count * worker / degree;
+        const size_t end = count * (worker + 1) / degree;
+        auto& offsets = write_offsets[worker];
+        for (size_t i = begin; i < end; ++i) {
+            partitioned[offsets[ranges[i]]++] = keys[i];
+        }
+    });
+
+    // The original array is free now and serves as radix scratch space
+    run_on_workers(degree, [&](size_t range) {
+        const size_t begin = range_begin[range];
+        const size_t size = range_begin[range + 1] - begin;
+        if (size > 1) {
+            msd_radix_sort(partitioned.data() + begin, keys.data() + begin, size, 0);
+        }
+    });
+
+    keys.swap(partitioned);
+}
+
+} // namespace db25
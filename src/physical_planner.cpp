@@ -1,5 +1,8 @@
 #include "physical_planner.hpp"
+#include "cardinality_feedback.hpp"
+#include "cost_calibration.hpp"
 #include <algorithm>
+#include <cmath>
 #include <random>
 
 namespace db25 {
@@ -11,14 +14,6 @@ std::mt19937 MockDataGenerator::gen_(rd_());
 PhysicalPlanner::PhysicalPlanner(std::shared_ptr<DatabaseSchema> schema) 
     : schema_(schema) {
     
-    // Initialize default table statistics
-    for (const auto& table_name : schema_->get_table_names()) {
-        TableStats stats;
-        stats.row_count = 1000;
-        stats.avg_row_size = 100.0;
-        metadata_.table_stats[table_name] = stats;
-    }
-    
     // Set up default execution context
     metadata_.execution_context.work_mem_limit = config_.work_mem;
     metadata_.execution_context.enable_parallel = config_.enable_parallel_execution;
@@ -31,9 +26,11 @@ PhysicalPlan PhysicalPlanner::create_physical_plan(const LogicalPlan& logical_pl
     }
     
     PhysicalPlanNodePtr physical_root = convert_logical_node(logical_plan.root);
+    attach_table_data(physical_root);
     
     PhysicalPlan physical_plan(physical_root);
     physical_plan.context = metadata_.execution_context;
+    physical_plan.fingerprint = logical_plan.fingerprint;
     
     return physical_plan;
 }
@@ -42,6 +39,7 @@ PhysicalPlanNodePtr PhysicalPlanner::convert_logical_node(LogicalPlanNodePtr log
     if (!logical_node) return nullptr;
     
     PhysicalPlanNodePtr physical_node;
+    bool children_converted = false; // Set when the converter built the subtree itself
     
     switch (logical_node->type) {
         case PlanNodeType::TABLE_SCAN: {
@@ -60,36 +58,42 @@ PhysicalPlanNodePtr PhysicalPlanner::convert_logical_node(LogicalPlanNodePtr log
         case PlanNodeType::HASH_JOIN:
         case PlanNodeType::MERGE_JOIN: {
             physical_node = convert_join(logical_node);
+            children_converted = true;
             break;
         }
         
         case PlanNodeType::PROJECTION: {
             auto projection = std::static_pointer_cast<ProjectionNode>(logical_node);
             physical_node = convert_projection(projection);
+            children_converted = true;
             break;
         }
         
         case PlanNodeType::SELECTION: {
             auto selection = std::static_pointer_cast<SelectionNode>(logical_node);
             physical_node = convert_selection(selection);
+            children_converted = true;
             break;
         }
         
         case PlanNodeType::AGGREGATION: {
             auto aggregation = std::static_pointer_cast<AggregationNode>(logical_node);
             physical_node = convert_aggregation(aggregation);
+            children_converted = true;
             break;
         }
         
         case PlanNodeType::SORT: {
             auto sort = std::static_pointer_cast<SortNode>(logical_node);
             physical_node = convert_sort(sort);
+            children_converted = true;
             break;
         }
         
         case PlanNodeType::LIMIT: {
             auto limit = std::static_pointer_cast<LimitNode>(logical_node);
             physical_node = convert_limit(limit);
+            children_converted = true;
             break;
         }
         
@@ -101,29 +105,118 @@ PhysicalPlanNodePtr PhysicalPlanner::convert_logical_node(LogicalPlanNodePtr log
     
     if (physical_node) {
         // Convert children
-        for (const auto& logical_child : logical_node->children) {
-            PhysicalPlanNodePtr physical_child = convert_logical_node(logical_child);
-            if (physical_child) {
-                physical_node->children.push_back(physical_child);
+        if (!children_converted) {
+            for (const auto& logical_child : logical_node->children) {
+                PhysicalPlanNodePtr physical_child = convert_logical_node(logical_child);
+                if (physical_child) {
+                    physical_node->children.push_back(physical_child);
+                }
             }
         }
         
         // Copy cost and output information
+        const PlanCost operator_cost = physical_node->estimated_cost;
         physical_node->estimated_cost = logical_node->cost;
-        physical_node->output_columns = logical_node->output_columns;
+        physical_node->signature = plan_signature(logical_node);
+        if (physical_node->type == PhysicalOperatorType::INDEX_NESTED_LOOP_JOIN) {
+            // The logical estimate prices a nested loop that rescans its inner side
+            physical_node->estimated_cost.startup_cost = operator_cost.startup_cost;
+            physical_node->estimated_cost.total_cost = operator_cost.total_cost;
+        }
+        // Converters that narrow or rename columns (pruned scans, projections) know their own layout
+        if (physical_node->output_columns.empty()) {
+            physical_node->output_columns = logical_node->output_columns.empty()
+                ? derive_output_columns(physical_node) : logical_node->output_columns;
+        }
+        if (physical_node->output_ordering.empty()) {
+            physical_node->output_ordering = derive_output_ordering(physical_node);
+        }
     }
     
     return physical_node;
 }
 
+void PhysicalPlanner::load_cost_config(const std::string& path) {
+    load_cost_constants(path).apply(config_);
+}
+
 void PhysicalPlanner::set_table_stats(const std::string& table_name, const TableStats& stats) {
-    metadata_.table_stats[table_name] = stats;
+    metadata_.statistics->set_table_stats(table_name, stats);
+}
+
+TableStats PhysicalPlanner::analyze_table(const std::string& table_name, const AnalyzeConfig& config) {
+    auto scan = std::make_shared<SequentialScanNode>(table_name);
+    scan->output_columns = get_table_columns(table_name, "");
+    scan->estimated_cost.estimated_rows = get_table_stats(table_name)->row_count;
+    if (metadata_.storage) scan->heap = metadata_.storage->get_table(table_name);
+    return metadata_.statistics->analyze_table(table_name, scan, config);
 }
 
 void PhysicalPlanner::add_access_method(const std::string& table_name, const AccessMethod& method) {
     metadata_.access_methods[table_name].push_back(method);
 }
 
+void PhysicalPlanner::set_table_data(const std::string& table_name, std::vector<Tuple> rows) {
+    metadata_.table_data[table_name] = std::make_shared<const std::vector<Tuple>>(std::move(rows));
+}
+
+void PhysicalPlanner::attach_table_data(const PhysicalPlanNodePtr& node) const { // NOLINT(misc-no-recursion)
+    if (!node) return;
+    for (const auto& child : node->children) {
+        attach_table_data(child);
+    }
+    
+    // Scans of tables with a heap read it in place; plan copies share it
+    const auto heap_of = [this](const std::string& table_name) -> std::shared_ptr<const TableHeap> {
+        return metadata_.storage ? metadata_.storage->get_table(table_name) : nullptr;
+    };
+    
+    if (node->type == PhysicalOperatorType::SEQUENTIAL_SCAN) {
+        auto scan = std::static_pointer_cast<SequentialScanNode>(node);
+        scan->heap = heap_of(scan->table_name);
+        const auto data = metadata_.table_data.find(scan->table_name);
+        if (!scan->heap && data != metadata_.table_data.end()) scan->mock_data = *data->second;
+    } else if (node->type == PhysicalOperatorType::COLUMNAR_SCAN) {
+        auto scan = std::static_pointer_cast<PhysicalColumnarScanNode>(node);
+        scan->table = metadata_.storage ? metadata_.storage->get_columnar_table(scan->table_name) : nullptr;
+    } else if (node->type == PhysicalOperatorType::PARALLEL_SEQ_SCAN) {
+        auto scan = std::static_pointer_cast<ParallelSequentialScanNode>(node);
+        scan->heap = heap_of(scan->table_name);
+    } else if (node->type == PhysicalOperatorType::BITMAP_HEAP_SCAN) {
+        auto scan = std::static_pointer_cast<PhysicalBitmapHeapScanNode>(node);
+        scan->heap = heap_of(scan->table_name);
+        const auto data = metadata_.table_data.find(scan->table_name);
+        if (!scan->heap && data != metadata_.table_data.end()) scan->mock_data = *data->second;
+    } else if (node->type == PhysicalOperatorType::INDEX_ONLY_SCAN) {
+        // The entries are the index itself, built once from the table
+        auto scan = std::static_pointer_cast<PhysicalIndexOnlyScanNode>(node);
+        const auto heap = heap_of(scan->table_name);
+        const auto data = metadata_.table_data.find(scan->table_name);
+        if (heap) {
+            scan->build_entries(TableRows{heap.get(), nullptr});
+        } else if (data != metadata_.table_data.end()) {
+            scan->build_entries(TableRows{nullptr, data->second.get()});
+        }
+    } else if (node->type == PhysicalOperatorType::INDEX_SCAN) {
+        auto scan = std::static_pointer_cast<PhysicalIndexScanNode>(node);
+        scan->heap = heap_of(scan->table_name);
+        if (scan->heap) return;
+        const auto data = metadata_.table_data.find(scan->table_name);
+        if (data == metadata_.table_data.end()) return;
+        
+        // An index returns rows in key order
+        std::vector<size_t> key_positions;
+        for (const auto& column : scan->index_columns) {
+            const int index = resolve_column_index(scan->output_columns,
+                                                   std::make_shared<Expression>(ExpressionType::COLUMN_REF, column));
+            if (index < 0) break;
+            key_positions.push_back(static_cast<size_t>(index));
+        }
+        scan->mock_data = *data->second;
+        sort_index_rows(scan->mock_data, key_positions, scan->index_key_types);
+    }
+}
+
 PhysicalPlan PhysicalPlanner::optimize_physical_plan(const PhysicalPlan& plan) {
     PhysicalPlanOptimizer optimizer(config_);
     return optimizer.optimize(plan);
@@ -162,6 +255,13 @@ size_t PhysicalPlanner::estimate_memory_usage(PhysicalPlanNodePtr node) {
             memory += estimate_memory_for_sort(node->children.empty() ? nullptr : node->children[0]);
             break;
             
+        case PhysicalOperatorType::TOP_N: {
+            // Only the heap is held in memory
+            auto top_n = std::static_pointer_cast<PhysicalTopNNode>(node);
+            memory += (top_n->limit + top_n->offset) * 32;
+            break;
+        }
+            
         case PhysicalOperatorType::HASH_AGGREGATE:
             memory += node->estimated_cost.estimated_rows * 50; // Rough estimate
             break;
@@ -186,24 +286,61 @@ bool PhysicalPlanner::should_use_temp_files(PhysicalPlanNodePtr node) {
 // Private implementation methods
 PhysicalPlanNodePtr PhysicalPlanner::convert_table_scan(std::shared_ptr<TableScanNode> logical_node) {
     // Check if we should use index scan instead
-    AccessMethod best_method = select_best_access_method(logical_node->table_name, logical_node->filter_conditions);
+    AccessMethod best_method = select_best_access_method(logical_node->table_name, logical_node->filter_conditions,
+                                                         logical_node->required_columns);
     
-    if (best_method.type == AccessMethod::INDEX_SCAN && !best_method.index_name.empty()) {
-        auto index_scan = std::make_shared<PhysicalIndexScanNode>(logical_node->table_name, best_method.index_name);
-        index_scan->alias = logical_node->alias;
-        index_scan->filter_conditions = logical_node->filter_conditions;
+    if ((best_method.type == AccessMethod::INDEX_SCAN || best_method.type == AccessMethod::INDEX_ONLY_SCAN) &&
+        !best_method.index_name.empty()) {
+        auto index_scan = make_index_scan(logical_node->table_name, logical_node->alias, best_method.index_name,
+                                          best_method.key_columns.empty()
+                                              ? get_index_columns(logical_node->table_name, best_method.index_name)
+                                              : best_method.key_columns,
+                                          logical_node->required_columns);
+        index_scan->index_conditions = best_method.index_conditions;
+        for (const auto& condition : logical_node->filter_conditions) {
+            if (std::find(index_scan->index_conditions.begin(), index_scan->index_conditions.end(), condition) ==
+                index_scan->index_conditions.end()) {
+                index_scan->filter_conditions.push_back(condition);
+            }
+        }
         return index_scan;
+    } else if (best_method.type == AccessMethod::BITMAP_SCAN && !best_method.bitmap_inputs.empty()) {
+        auto bitmap_scan = std::make_shared<PhysicalBitmapHeapScanNode>(logical_node->table_name);
+        bitmap_scan->alias = logical_node->alias;
+        for (const auto& condition : logical_node->filter_conditions) {
+            if (std::find(best_method.index_conditions.begin(), best_method.index_conditions.end(), condition) ==
+                best_method.index_conditions.end()) {
+                bitmap_scan->filter_conditions.push_back(condition);
+            }
+        }
+        bitmap_scan->output_columns = get_table_columns(logical_node->table_name, logical_node->alias);
+        bitmap_scan->projected_columns = prune_scan_columns(bitmap_scan->output_columns,
+                                                            logical_node->required_columns, {});
+        bitmap_scan->children.push_back(build_bitmap_node(logical_node->table_name, logical_node->alias, best_method));
+        return bitmap_scan;
+    } else if (metadata_.storage && metadata_.storage->get_columnar_table(logical_node->table_name)) {
+        // Tables kept column-wise are scanned a column at a time
+        auto columnar_scan = std::make_shared<PhysicalColumnarScanNode>(logical_node->table_name);
+        columnar_scan->alias = logical_node->alias;
+        columnar_scan->filter_conditions = logical_node->filter_conditions;
+        columnar_scan->output_columns = get_table_columns(logical_node->table_name, logical_node->alias);
+        columnar_scan->projected_columns = prune_scan_columns(columnar_scan->output_columns,
+                                                              logical_node->required_columns, {});
+        return columnar_scan;
     } else {
         auto seq_scan = std::make_shared<SequentialScanNode>(logical_node->table_name);
         seq_scan->alias = logical_node->alias;
         seq_scan->filter_conditions = logical_node->filter_conditions;
+        seq_scan->output_columns = get_table_columns(logical_node->table_name, logical_node->alias);
+        seq_scan->projected_columns = prune_scan_columns(seq_scan->output_columns, logical_node->required_columns, {});
         return seq_scan;
     }
 }
 
 PhysicalPlanNodePtr PhysicalPlanner::convert_index_scan(std::shared_ptr<IndexScanNode> logical_node) {
-    auto physical_index_scan = std::make_shared<PhysicalIndexScanNode>(logical_node->table_name, logical_node->index_name);
-    physical_index_scan->alias = logical_node->alias;
+    auto physical_index_scan = make_index_scan(logical_node->table_name, logical_node->alias, logical_node->index_name,
+                                               get_index_columns(logical_node->table_name, logical_node->index_name),
+                                               logical_node->required_columns);
     physical_index_scan->index_conditions = logical_node->index_conditions;
     physical_index_scan->filter_conditions = logical_node->filter_conditions;
     return physical_index_scan;
@@ -219,71 +356,287 @@ PhysicalPlanNodePtr PhysicalPlanner::convert_join(LogicalPlanNodePtr logical_nod
 }
 
 PhysicalPlanNodePtr PhysicalPlanner::convert_projection(std::shared_ptr<ProjectionNode> logical_node) {
-    // Physical projection is typically implicit - just pass through the child
-    // In a real implementation, might add explicit projection operators for complex expressions
-    if (!logical_node->children.empty()) {
-        return convert_logical_node(logical_node->children[0]);
+    if (logical_node->children.empty()) {
+        return nullptr;
+    }
+    PhysicalPlanNodePtr child = convert_logical_node(logical_node->children[0]);
+    if (!child) {
+        return nullptr;
+    }
+    
+    auto projection = std::make_shared<PhysicalProjectionNode>();
+    bool identity = logical_node->projections.size() == child->output_columns.size();
+    for (size_t i = 0; i < logical_node->projections.size(); ++i) {
+        // The builder appends " AS alias" to the expression text
+        auto expr = std::make_shared<Expression>(*logical_node->projections[i]);
+        std::string name;
+        const size_t as = expr->value.find(" AS ");
+        if (as != std::string::npos) {
+            name = expr->value.substr(as + 4);
+            expr->value.erase(as);
+        }
+        
+        // Lists the operator cannot evaluate (aggregates, "*") pass the input through
+        CompiledExpression compiled;
+        if (!compiled.compile(expr, child->output_columns)) {
+            return child;
+        }
+        const int column = compiled.column_index();
+        if (name.empty()) {
+            name = column >= 0 ? child->output_columns[column] : expression_to_string(expr);
+        }
+        identity = identity && column == static_cast<int>(i) && name == child->output_columns[i];
+        
+        projection->expressions.push_back(expr);
+        projection->output_columns.push_back(name);
+    }
+    
+    // Selecting the input's columns in order needs no operator
+    if (identity) {
+        return child;
     }
-    return nullptr;
+    projection->children.push_back(child);
+    return projection;
 }
 
 PhysicalPlanNodePtr PhysicalPlanner::convert_selection(std::shared_ptr<SelectionNode> logical_node) {
-    // Selection is typically pushed down to scans in physical planning
-    // Return the converted child with filters applied
-    if (!logical_node->children.empty()) {
-        PhysicalPlanNodePtr child = convert_logical_node(logical_node->children[0]);
-        
-        // If child is a scan node, add the selection conditions to it
-        if (auto seq_scan = std::dynamic_pointer_cast<SequentialScanNode>(child)) {
-            seq_scan->filter_conditions.insert(seq_scan->filter_conditions.end(),
-                                              logical_node->conditions.begin(),
-                                              logical_node->conditions.end());
-        } else if (auto index_scan = std::dynamic_pointer_cast<PhysicalIndexScanNode>(child)) {
-            index_scan->filter_conditions.insert(index_scan->filter_conditions.end(),
-                                                 logical_node->conditions.begin(),
-                                                 logical_node->conditions.end());
+    // Predicate pushdown leaves selections only where no scan or join below
+    // can take them; a selection directly over a scan becomes its filter
+    if (logical_node->children.empty()) {
+        return nullptr;
+    }
+    PhysicalPlanNodePtr child = convert_logical_node(logical_node->children[0]);
+    if (!child) {
+        return nullptr;
+    }
+    
+    if (auto seq_scan = std::dynamic_pointer_cast<SequentialScanNode>(child)) {
+        seq_scan->filter_conditions.insert(seq_scan->filter_conditions.end(),
+                                          logical_node->conditions.begin(),
+                                          logical_node->conditions.end());
+        return child;
+    }
+    if (auto index_scan = std::dynamic_pointer_cast<PhysicalIndexScanNode>(child)) {
+        index_scan->filter_conditions.insert(index_scan->filter_conditions.end(),
+                                             logical_node->conditions.begin(),
+                                             logical_node->conditions.end());
+        return child;
+    }
+    if (auto columnar_scan = std::dynamic_pointer_cast<PhysicalColumnarScanNode>(child)) {
+        columnar_scan->filter_conditions.insert(columnar_scan->filter_conditions.end(),
+                                                logical_node->conditions.begin(),
+                                                logical_node->conditions.end());
+        return child;
+    }
+    
+    // Elsewhere the conditions need their own operator. Ones it cannot
+    // evaluate (subqueries, LIKE) stay unenforced, as they were before.
+    auto filter = std::make_shared<PhysicalFilterNode>();
+    for (const auto& condition : logical_node->conditions) {
+        CompiledExpression compiled;
+        if (compiled.compile(condition, child->output_columns)) {
+            filter->conditions.push_back(condition);
         }
-        
+    }
+    if (filter->conditions.empty()) {
         return child;
     }
-    return nullptr;
+    filter->children.push_back(child);
+    return filter;
 }
 
 PhysicalPlanNodePtr PhysicalPlanner::convert_aggregation(std::shared_ptr<AggregationNode> logical_node) {
-    // TODO: Implement HashAggregateNode - returning nullptr for now
+    // TODO: Implement HashAggregateNode for other inputs
     // auto hash_agg = std::make_shared<HashAggregateNode>();
     // hash_agg->group_by_exprs = logical_node->group_by_exprs;
     // hash_agg->aggregate_exprs = logical_node->aggregate_exprs;
     // hash_agg->aggregate_functions = logical_node->aggregate_functions;
-    (void)logical_node; // Suppress unused parameter warning
-    return nullptr;
+    if (logical_node->children.size() != 1 || !logical_node->having_conditions.empty() || !metadata_.storage) {
+        return nullptr;
+    }
+    
+    // Over a column store: group columns and count, sum, avg, min and max
+    // of columns or count(*), aggregated on the encoded segments
+    auto scan = std::dynamic_pointer_cast<PhysicalColumnarScanNode>(convert_logical_node(logical_node->children[0]));
+    const auto table = scan ? metadata_.storage->get_columnar_table(scan->table_name) : nullptr;
+    if (!table) {
+        return nullptr;
+    }
+    const auto kind_of = [&](size_t position) {
+        const size_t column = scan->projected_columns.empty() ? position : scan->projected_columns[position];
+        return storage_kind(table->columns()[column].type);
+    };
+    
+    auto aggregate = std::make_shared<PhysicalColumnarAggregateNode>();
+    for (const auto& expr : logical_node->group_by_exprs) {
+        const int column = resolve_column_index(scan->output_columns, expr);
+        if (column < 0) return nullptr;
+        aggregate->group_columns.push_back(static_cast<size_t>(column));
+        aggregate->output_columns.push_back(scan->output_columns[column]);
+    }
+    for (const auto& expr : logical_node->aggregate_exprs) {
+        if (!expr || expr->type != ExpressionType::FUNCTION_CALL || expr->children.size() > 1) return nullptr;
+        std::string name = expr->value;
+        std::transform(name.begin(), name.end(), name.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        
+        PhysicalColumnarAggregateNode::Aggregate entry;
+        if (name == "count") entry.function = PhysicalColumnarAggregateNode::Function::COUNT;
+        else if (name == "sum") entry.function = PhysicalColumnarAggregateNode::Function::SUM;
+        else if (name == "avg") entry.function = PhysicalColumnarAggregateNode::Function::AVG;
+        else if (name == "min") entry.function = PhysicalColumnarAggregateNode::Function::MIN;
+        else if (name == "max") entry.function = PhysicalColumnarAggregateNode::Function::MAX;
+        else return nullptr;
+        
+        const bool star = expr->children.empty() || expr->children[0]->value == "*";
+        if (!star) {
+            const int column = resolve_column_index(scan->output_columns, expr->children[0]);
+            if (column < 0) return nullptr;
+            entry.column = static_cast<size_t>(column);
+        }
+        const bool numeric = entry.column && (kind_of(*entry.column) == StorageKind::INTEGER ||
+                                              kind_of(*entry.column) == StorageKind::DECIMAL);
+        if (entry.function != PhysicalColumnarAggregateNode::Function::COUNT && !numeric) return nullptr;
+        aggregate->aggregates.push_back(entry);
+        aggregate->output_columns.push_back(expression_to_string(expr));
+    }
+    aggregate->children.push_back(scan);
+    return aggregate;
 }
 
 PhysicalPlanNodePtr PhysicalPlanner::convert_sort(std::shared_ptr<SortNode> logical_node) {
     auto physical_sort = std::make_shared<PhysicalSortNode>();
     
     // Convert logical sort keys to physical sort keys
+    const LogicalPlanNodePtr input = logical_node->children.empty() ? nullptr : logical_node->children[0];
     for (const auto& logical_key : logical_node->sort_keys) {
-        PhysicalSortNode::SortKey physical_key;
-        physical_key.expression = logical_key.expression;
-        physical_key.ascending = logical_key.ascending;
-        physical_key.nulls_first = logical_key.nulls_first;
-        physical_sort->sort_keys.push_back(physical_key);
+        physical_sort->sort_keys.push_back(convert_sort_key(logical_key, input));
     }
     
-    return physical_sort;
+    // Large sorts encode and sort their input on every worker
+    if (config_.enable_parallel_execution &&
+        logical_node->cost.estimated_rows >= config_.parallel_sort_threshold) {
+        physical_sort->parallel_degree = std::max<size_t>(config_.max_parallel_workers, 1);
+    }
+    
+    if (!input) {
+        return physical_sort;
+    }
+    PhysicalPlanNodePtr child = convert_logical_node(input);
+    if (!child) {
+        return physical_sort;
+    }
+    const auto projection = projection_below_sort(child, physical_sort->sort_keys);
+    
+    // Input delivered by an index or an earlier sort needs no second sort
+    if (ordering_satisfies(child, physical_sort->sort_keys)) {
+        return reapply_projection(projection, child, logical_node->cost);
+    }
+    physical_sort->children.push_back(child);
+    return reapply_projection(projection, physical_sort, logical_node->cost);
 }
 
 PhysicalPlanNodePtr PhysicalPlanner::convert_limit(std::shared_ptr<LimitNode> logical_node) {
+    // ORDER BY ... LIMIT keeps only the top rows, so fuse it into a bounded heap
+    if (logical_node->limit && !logical_node->children.empty() &&
+        logical_node->children[0]->type == PlanNodeType::SORT) {
+        return convert_top_n(logical_node, std::static_pointer_cast<SortNode>(logical_node->children[0]));
+    }
+    
     auto physical_limit = std::make_shared<PhysicalLimitNode>();
     physical_limit->limit = logical_node->limit;
     physical_limit->offset = logical_node->offset;
+    if (!logical_node->children.empty()) {
+        if (auto child = convert_logical_node(logical_node->children[0])) {
+            physical_limit->children.push_back(child);
+        }
+    }
     return physical_limit;
 }
 
+PhysicalPlanNodePtr PhysicalPlanner::convert_top_n(std::shared_ptr<LimitNode> limit_node,
+                                                   std::shared_ptr<SortNode> sort_node) {
+    auto top_n = std::make_shared<PhysicalTopNNode>();
+    top_n->limit = *limit_node->limit;
+    top_n->offset = limit_node->offset.value_or(0);
+    
+    const LogicalPlanNodePtr input = sort_node->children.empty() ? nullptr : sort_node->children[0];
+    for (const auto& logical_key : sort_node->sort_keys) {
+        top_n->sort_keys.push_back(convert_sort_key(logical_key, input));
+    }
+    
+    if (sort_node->children.empty()) {
+        return top_n;
+    }
+    
+    PhysicalPlanNodePtr child = convert_logical_node(sort_node->children[0]);
+    if (!child) {
+        return top_n;
+    }
+    const auto projection = projection_below_sort(child, top_n->sort_keys);
+    
+    // Already-ordered input only needs its first rows
+    if (ordering_satisfies(child, top_n->sort_keys)) {
+        auto physical_limit = std::make_shared<PhysicalLimitNode>();
+        physical_limit->limit = limit_node->limit;
+        physical_limit->offset = limit_node->offset;
+        physical_limit->children.push_back(child);
+        return reapply_projection(projection, physical_limit, limit_node->cost);
+    }
+    
+    // Publish the heap boundary to a scan feeding the heap directly; any
+    // operator in between could change which rows reach the heap
+    auto seq_scan = std::dynamic_pointer_cast<SequentialScanNode>(child);
+    if (seq_scan && !top_n->sort_keys.empty() &&
+        resolve_column_index(seq_scan->output_columns, top_n->sort_keys[0].expression) >= 0) {
+        top_n->threshold = std::make_shared<TopNThreshold>();
+        top_n->threshold->key = top_n->sort_keys[0];
+        seq_scan->topn_threshold = top_n->threshold;
+    }
+    
+    top_n->children.push_back(child);
+    return reapply_projection(projection, top_n, limit_node->cost);
+}
+
+std::shared_ptr<PhysicalProjectionNode> PhysicalPlanner::projection_below_sort(
+    PhysicalPlanNodePtr& input, const std::vector<PhysicalSortKey>& keys) const {
+    auto projection = std::dynamic_pointer_cast<PhysicalProjectionNode>(input);
+    if (!projection || projection->children.empty()) return nullptr;
+    
+    // ORDER BY may name a column the SELECT list drops; such keys are only
+    // visible below the projection, so the sort moves under it
+    const auto& below = projection->children[0];
+    bool hidden = false;
+    for (const auto& key : keys) {
+        if (resolve_column_index(below->output_columns, key.expression) < 0) return nullptr;
+        hidden = hidden || resolve_column_index(projection->output_columns, key.expression) < 0;
+    }
+    if (!hidden) return nullptr;
+    
+    input = below;
+    return projection;
+}
+
+PhysicalPlanNodePtr PhysicalPlanner::reapply_projection(const std::shared_ptr<PhysicalProjectionNode>& projection,
+                                                        const PhysicalPlanNodePtr& ordered, const PlanCost& cost) const {
+    if (!projection) return ordered;
+    
+    // convert_logical_node only describes the node it gets back
+    ordered->estimated_cost = cost;
+    if (ordered->output_columns.empty()) {
+        ordered->output_columns = derive_output_columns(ordered);
+    }
+    ordered->output_ordering = derive_output_ordering(ordered);
+    
+    projection->children[0] = ordered;
+    projection->output_ordering = derive_output_ordering(projection);
+    return projection;
+}
+
 AccessMethod PhysicalPlanner::select_best_access_method(const std::string& table_name,
-                                                       const std::vector<ExpressionPtr>& conditions) {
-    auto available_methods = get_available_access_methods(table_name);
+                                                       const std::vector<ExpressionPtr>& conditions,
+                                                       const std::vector<std::string>& required_columns) {
+    auto available_methods = get_available_access_methods(table_name, conditions, required_columns);
     
     if (available_methods.empty()) {
         AccessMethod heap_scan;
@@ -303,13 +656,17 @@ AccessMethod PhysicalPlanner::select_best_access_method(const std::string& table
     return best_method;
 }
 
-std::vector<AccessMethod> PhysicalPlanner::get_available_access_methods(const std::string& table_name) {
+std::vector<AccessMethod> PhysicalPlanner::get_available_access_methods(const std::string& table_name,
+                                                                       const std::vector<ExpressionPtr>& conditions,
+                                                                       const std::vector<std::string>& required_columns) {
     std::vector<AccessMethod> methods;
+    const double rows = static_cast<double>(get_table_stats(table_name)->row_count);
     
-    // Always have heap scan available
+    // Always have heap scan available: every row is read and filtered
     AccessMethod heap_scan;
     heap_scan.type = AccessMethod::HEAP_SCAN;
-    heap_scan.cost = get_table_stats(table_name).row_count * 0.01; // Simplified cost
+    heap_scan.selectivity = estimate_scan_selectivity(table_name, conditions);
+    heap_scan.cost = rows * (config_.cpu_tuple_cost + conditions.size() * config_.cpu_operator_cost);
     methods.push_back(heap_scan);
     
     // Add configured access methods
@@ -318,9 +675,254 @@ std::vector<AccessMethod> PhysicalPlanner::get_available_access_methods(const st
         methods.insert(methods.end(), it->second.begin(), it->second.end());
     }
     
+    // Indexes of the schema not configured by hand
+    auto table = schema_->get_table(table_name);
+    if (!table) return methods;
+    for (const auto& index : table->indexes) {
+        const bool configured = std::any_of(methods.begin(), methods.end(), [&](const AccessMethod& method) {
+            return method.index_name == index.name;
+        });
+        if (configured || index.type != "BTREE") continue;
+        
+        // A covering index is read on its own, searched or in full
+        const bool covering = index_covers(table_name, index.columns, required_columns);
+        AccessMethod index_scan;
+        index_scan.type = covering ? AccessMethod::INDEX_ONLY_SCAN : AccessMethod::INDEX_SCAN;
+        index_scan.index_name = index.name;
+        index_scan.key_columns = index.columns;
+        std::vector<ExpressionPtr> residual;
+        if (match_index_conditions(index, conditions, index_scan.index_conditions, residual) == 0 && !covering) {
+            continue;
+        }
+        
+        // One B-tree descent, then the matching entries and, unless the
+        // entries hold every column read, their rows
+        const double fetched = rows * estimate_scan_selectivity(table_name, index_scan.index_conditions);
+        index_scan.selectivity = heap_scan.selectivity;
+        index_scan.cost = std::log2(std::max(rows, 2.0)) * config_.cpu_operator_cost +
+                          fetched * (config_.cpu_index_tuple_cost + (covering ? 0.0 : config_.cpu_tuple_cost) +
+                                     residual.size() * config_.cpu_operator_cost);
+        methods.push_back(index_scan);
+    }
+    
+    if (auto bitmap_scan = plan_bitmap_scan(table_name, conditions)) {
+        methods.push_back(*bitmap_scan);
+    }
+    
     return methods;
 }
 
+// Branches of an OR tree, each as its conjuncts
+static void collect_disjuncts(const ExpressionPtr& condition, // NOLINT(misc-no-recursion)
+                              std::vector<std::vector<ExpressionPtr>>& disjuncts) {
+    if (condition->type == ExpressionType::BINARY_OP && condition->value == "OR" && condition->children.size() == 2) {
+        collect_disjuncts(condition->children[0], disjuncts);
+        collect_disjuncts(condition->children[1], disjuncts);
+        return;
+    }
+    std::vector<ExpressionPtr> conjuncts;
+    std::vector<ExpressionPtr> pending = {condition};
+    while (!pending.empty()) {
+        const ExpressionPtr conjunct = pending.back();
+        pending.pop_back();
+        if (conjunct->type == ExpressionType::BINARY_OP && conjunct->value == "AND" && conjunct->children.size() == 2) {
+            pending.push_back(conjunct->children[1]);
+            pending.push_back(conjunct->children[0]);
+        } else {
+            conjuncts.push_back(conjunct);
+        }
+    }
+    disjuncts.push_back(std::move(conjuncts));
+}
+
+std::optional<AccessMethod> PhysicalPlanner::plan_bitmap_scan(const std::string& table_name,
+                                                              const std::vector<ExpressionPtr>& conditions) {
+    auto table = schema_->get_table(table_name);
+    if (!table) return std::nullopt;
+    const double rows = static_cast<double>(get_table_stats(table_name)->row_count);
+    const double descent = std::log2(std::max(rows, 2.0)) * config_.cpu_operator_cost;
+    
+    // Bitmap index scan of index for the conditions it searches: one
+    // descent, then a row id per matching entry
+    const auto index_input = [&](const Index& index, const std::vector<ExpressionPtr>& searchable) {
+        AccessMethod input;
+        input.type = AccessMethod::INDEX_SCAN;
+        input.index_name = index.name;
+        input.key_columns = index.columns;
+        std::vector<ExpressionPtr> residual;
+        match_index_conditions(index, searchable, input.index_conditions, residual);
+        input.selectivity = estimate_scan_selectivity(table_name, input.index_conditions);
+        input.cost = descent + rows * input.selectivity * config_.cpu_index_tuple_cost;
+        return input;
+    };
+    
+    std::vector<ExpressionPtr> plain;
+    std::vector<ExpressionPtr> disjunctions;
+    for (const auto& condition : conditions) {
+        (condition->type == ExpressionType::BINARY_OP && condition->value == "OR" ? disjunctions : plain)
+            .push_back(condition);
+    }
+    
+    std::vector<AccessMethod> candidates;
+    
+    // An OR is answered by uniting one bitmap per branch, when an index
+    // searches every conjunct of every branch
+    for (const auto& condition : disjunctions) {
+        std::vector<std::vector<ExpressionPtr>> disjuncts;
+        collect_disjuncts(condition, disjuncts);
+        AccessMethod union_scan;
+        union_scan.type = AccessMethod::BITMAP_SCAN;
+        union_scan.bitmap_or = true;
+        union_scan.index_conditions = {condition};
+        double missing = 1.0;
+        for (const auto& conjuncts : disjuncts) {
+            std::optional<AccessMethod> best;
+            for (const auto& index : table->indexes) {
+                if (index.type != "BTREE") continue;
+                AccessMethod input = index_input(index, conjuncts);
+                if (input.index_conditions.size() == conjuncts.size() && (!best || input.cost < best->cost)) {
+                    best = std::move(input);
+                }
+            }
+            if (!best) {
+                union_scan.bitmap_inputs.clear();
+                break;
+            }
+            union_scan.cost += best->cost + rows * best->selectivity * config_.cpu_operator_cost;
+            missing *= 1.0 - best->selectivity;
+            union_scan.bitmap_inputs.push_back(std::move(*best));
+        }
+        if (union_scan.bitmap_inputs.empty()) continue;
+        union_scan.selectivity = 1.0 - missing;
+        candidates.push_back(std::move(union_scan));
+    }
+    
+    // Plain conditions: one bitmap per index that searches some of them
+    for (const auto& index : table->indexes) {
+        if (index.type != "BTREE") continue;
+        AccessMethod input = index_input(index, plain);
+        if (!input.index_conditions.empty()) candidates.push_back(std::move(input));
+    }
+    
+    // Most selective bitmaps first; each is kept while intersecting it
+    // makes the scan cheaper: its entries against the table rows it saves
+    std::sort(candidates.begin(), candidates.end(), [](const AccessMethod& a, const AccessMethod& b) {
+        return a.selectivity < b.selectivity;
+    });
+    const auto scan_cost = [&](const std::vector<AccessMethod>& inputs, const std::vector<ExpressionPtr>& searched) {
+        double cost = 0.0;
+        for (const auto& input : inputs) {
+            cost += input.cost;
+            if (inputs.size() > 1) cost += rows * input.selectivity * config_.cpu_operator_cost;
+        }
+        const double fetched = rows * estimate_scan_selectivity(table_name, searched);
+        const double residual = static_cast<double>(conditions.size() - searched.size());
+        return cost + fetched * (config_.cpu_tuple_cost + residual * config_.cpu_operator_cost);
+    };
+    
+    AccessMethod bitmap_scan;
+    bitmap_scan.type = AccessMethod::BITMAP_SCAN;
+    double best_cost = 0.0;
+    for (auto& candidate : candidates) {
+        std::vector<ExpressionPtr> searched = bitmap_scan.index_conditions;
+        for (const auto& condition : candidate.index_conditions) {
+            if (std::find(searched.begin(), searched.end(), condition) == searched.end()) searched.push_back(condition);
+        }
+        if (searched.size() == bitmap_scan.index_conditions.size()) continue;
+        
+        std::vector<AccessMethod> inputs = bitmap_scan.bitmap_inputs;
+        inputs.push_back(candidate);
+        const double cost = scan_cost(inputs, searched);
+        if (!bitmap_scan.bitmap_inputs.empty() && cost >= best_cost) continue;
+        bitmap_scan.bitmap_inputs = std::move(inputs);
+        bitmap_scan.index_conditions = std::move(searched);
+        best_cost = cost;
+    }
+    
+    // A single index is an index scan, unless it stands for an OR
+    if (bitmap_scan.bitmap_inputs.empty() ||
+        (bitmap_scan.bitmap_inputs.size() == 1 && bitmap_scan.bitmap_inputs[0].type != AccessMethod::BITMAP_SCAN)) {
+        return std::nullopt;
+    }
+    bitmap_scan.cost = best_cost;
+    bitmap_scan.selectivity = estimate_scan_selectivity(table_name, bitmap_scan.index_conditions);
+    if (bitmap_scan.bitmap_inputs.size() == 1) {
+        // The union's bitmap feeds the heap scan directly
+        AccessMethod union_scan = std::move(bitmap_scan.bitmap_inputs[0]);
+        union_scan.cost = best_cost;
+        return union_scan;
+    }
+    return bitmap_scan;
+}
+
+PhysicalPlanNodePtr PhysicalPlanner::build_bitmap_node(const std::string& table_name, const std::string& alias, // NOLINT(misc-no-recursion)
+                                                       const AccessMethod& method) const {
+    const double rows = static_cast<double>(get_table_stats(table_name)->row_count);
+    PhysicalPlanNodePtr node;
+    if (method.type == AccessMethod::BITMAP_SCAN) {
+        node = std::make_shared<PhysicalBitmapCombineNode>(method.bitmap_or ? PhysicalOperatorType::BITMAP_OR
+                                                                            : PhysicalOperatorType::BITMAP_AND);
+        for (const auto& input : method.bitmap_inputs) {
+            node->children.push_back(build_bitmap_node(table_name, alias, input));
+        }
+    } else {
+        auto index_scan = std::make_shared<PhysicalBitmapIndexScanNode>(table_name, method.index_name);
+        index_scan->index_columns = method.key_columns;
+        index_scan->index_key_types = column_key_types(table_name, method.key_columns);
+        index_scan->index_conditions = method.index_conditions;
+        index_scan->table_columns = get_table_columns(table_name, alias);
+        node = index_scan;
+    }
+    node->estimated_cost.total_cost = method.cost;
+    node->estimated_cost.estimated_rows = static_cast<size_t>(rows * method.selectivity);
+    return node;
+}
+
+double PhysicalPlanner::estimate_scan_selectivity(const std::string& table_name,
+                                                  const std::vector<ExpressionPtr>& conditions) const {
+    const auto stats = get_table_stats(table_name);
+    double selectivity = 1.0;
+    for (const auto& condition : conditions) {
+        if (condition->type == ExpressionType::BINARY_OP && condition->children.size() == 2 &&
+            (condition->value == "AND" || condition->value == "OR")) {
+            const double left = estimate_scan_selectivity(table_name, {condition->children[0]});
+            const double right = estimate_scan_selectivity(table_name, {condition->children[1]});
+            selectivity *= condition->value == "AND" ? left * right : left + right - left * right;
+            continue;
+        }
+        
+        std::string column, op, value;
+        if (!column_comparison(condition, column, op, value)) {
+            selectivity *= 0.5;
+            continue;
+        }
+        
+        // Histograms and MCVs where ANALYZE gathered them, else the logical
+        // planner's defaults
+        const auto analyzed = stats->columns.find(column);
+        if (analyzed != stats->columns.end()) {
+            const ColumnStats& column_stats = analyzed->second;
+            if (op == "=") {
+                selectivity *= column_stats.equal_fraction(value);
+            } else if (op[0] == '<') {
+                selectivity *= column_stats.less_fraction(value, op == "<=");
+            } else {
+                selectivity *= std::max(0.0, 1.0 - column_stats.null_fraction -
+                                             column_stats.less_fraction(value, op == ">"));
+            }
+        } else if (op == "=") {
+            const auto known = stats->column_selectivity.find(column);
+            const auto distinct = stats->distinct_values.find(column);
+            selectivity *= known != stats->column_selectivity.end() ? known->second
+                         : distinct != stats->distinct_values.end() && distinct->second > 0
+                             ? 1.0 / static_cast<double>(distinct->second) : 0.1;
+        } else {
+            selectivity *= 0.3;
+        }
+    }
+    return std::max(1e-9, std::min(1.0, selectivity));
+}
+
 PhysicalPlanNodePtr PhysicalPlanner::select_join_algorithm(LogicalPlanNodePtr logical_join) {
     if (logical_join->children.size() != 2) return nullptr;
     
@@ -331,12 +933,68 @@ PhysicalPlanNodePtr PhysicalPlanner::select_join_algorithm(LogicalPlanNodePtr lo
     std::vector<ExpressionPtr> join_conditions;
     
     // Extract join type and conditions based on logical node type
-    if (auto nl_join = std::dynamic_pointer_cast<NestedLoopJoinNode>(logical_join)) {
-        join_type = nl_join->join_type;
-        join_conditions = nl_join->join_conditions;
-    } else if (auto hash_join = std::dynamic_pointer_cast<HashJoinNode>(logical_join)) {
-        join_type = hash_join->join_type;
-        join_conditions = hash_join->join_conditions;
+    if (auto join = std::dynamic_pointer_cast<JoinNode>(logical_join)) {
+        join_type = join->join_type;
+        join_conditions = join->join_conditions;
+    }
+    
+    // The inputs are planned first so the choice can use their orderings
+    PhysicalPlanNodePtr left_input = convert_logical_node(left);
+    PhysicalPlanNodePtr right_input = convert_logical_node(right);
+    const auto attach_inputs = [&](const PhysicalPlanNodePtr& join_node) {
+        if (left_input) join_node->children.push_back(left_input);
+        if (right_input) join_node->children.push_back(right_input);
+        return join_node;
+    };
+    
+    std::vector<EquiJoinKey> keys;
+    const bool equi_join = join_type != JoinType::CROSS && left_input && right_input &&
+                           extract_equi_join_keys(join_conditions, keys) &&
+                           orient_join_keys(left_input, right_input, keys);
+    // A merge join chosen by the logical planner is kept unless merge joins are disabled
+    const bool forced_merge_join = logical_join->type == PlanNodeType::MERGE_JOIN && config_.enable_merge_join;
+    const bool use_merge_join = equi_join &&
+        (forced_merge_join || should_use_merge_join(left_input, right_input, keys));
+    
+    // An index on the inner join key replaces rescans with O(log n) lookups
+    if (equi_join && !forced_merge_join) {
+        auto index_join = plan_index_nested_loop_join(logical_join, join_type, left_input, keys);
+        if (index_join && (!use_merge_join ||
+                           index_join->estimated_cost.total_cost < estimate_merge_join_cost(left_input, right_input, keys))) {
+            return index_join;
+        }
+    }
+    
+    if (use_merge_join) {
+        auto physical_merge_join = std::make_shared<PhysicalMergeJoinNode>(join_type);
+        physical_merge_join->join_conditions = join_conditions;
+        
+        std::vector<PhysicalSortKey> left_order;
+        std::vector<PhysicalSortKey> right_order;
+        for (const auto& key : keys) {
+            physical_merge_join->left_keys.push_back(key.left);
+            physical_merge_join->right_keys.push_back(key.right);
+            // Both sides order in one type, wide enough for either column
+            SortNode::SortKey left_column;
+            left_column.expression = key.left;
+            SortNode::SortKey right_column;
+            right_column.expression = key.right;
+            const SortKeyType key_type = std::max(convert_sort_key(left_column, left).type,
+                                                  convert_sort_key(right_column, right).type);
+            physical_merge_join->key_types.push_back(key_type);
+            PhysicalSortKey left_key;
+            left_key.expression = key.left;
+            left_key.type = key_type;
+            left_order.push_back(left_key);
+            PhysicalSortKey right_key;
+            right_key.expression = key.right;
+            right_key.type = key_type;
+            right_order.push_back(right_key);
+        }
+        
+        physical_merge_join->children.push_back(ensure_ordering(left_input, left_order));
+        physical_merge_join->children.push_back(ensure_ordering(right_input, right_order));
+        return physical_merge_join;
     }
     
     // Decide between hash join and nested loop join
@@ -344,11 +1002,11 @@ PhysicalPlanNodePtr PhysicalPlanner::select_join_algorithm(LogicalPlanNodePtr lo
         // auto physical_hash_join = std::make_shared<PhysicalHashJoinNode>(join_type); // TODO: Implement PhysicalHashJoinNode
         auto physical_hash_join = std::make_shared<PhysicalNestedLoopJoinNode>(join_type); // Temporary fallback
         physical_hash_join->join_conditions = join_conditions;
-        return physical_hash_join;
+        return attach_inputs(physical_hash_join);
     } else {
         auto physical_nl_join = std::make_shared<PhysicalNestedLoopJoinNode>(join_type);
         physical_nl_join->join_conditions = join_conditions;
-        return physical_nl_join;
+        return attach_inputs(physical_nl_join);
     }
 }
 
@@ -363,9 +1021,279 @@ bool PhysicalPlanner::should_use_hash_join(LogicalPlanNodePtr left, LogicalPlanN
            (left_rows != right_rows); // Avoid hash join for similar sized tables
 }
 
-bool PhysicalPlanner::should_use_merge_join(LogicalPlanNodePtr left, LogicalPlanNodePtr right) {
-    // For now, don't use merge join (would need sort order analysis)
-    return false;
+bool PhysicalPlanner::should_use_merge_join(const PhysicalPlanNodePtr& left_input,
+                                            const PhysicalPlanNodePtr& right_input,
+                                            const std::vector<EquiJoinKey>& keys) {
+    if (!config_.enable_merge_join) return false;
+    
+    std::vector<PhysicalSortKey> left_order;
+    std::vector<PhysicalSortKey> right_order;
+    for (const auto& key : keys) {
+        PhysicalSortKey left_key;
+        left_key.expression = key.left;
+        left_order.push_back(left_key);
+        PhysicalSortKey right_key;
+        right_key.expression = key.right;
+        right_order.push_back(right_key);
+    }
+    const bool left_sorted = ordering_satisfies(left_input, left_order);
+    const bool right_sorted = ordering_satisfies(right_input, right_order);
+    
+    // Both inputs already arrive in key order: the merge is a single pass
+    if (left_sorted && right_sorted) return true;
+    
+    // With one side ordered, sorting the other (n log n) beats the nested loop
+    // the hash join path currently falls back to (n * m)
+    return left_sorted || right_sorted;
+}
+
+PhysicalPlanNodePtr PhysicalPlanner::plan_index_nested_loop_join(LogicalPlanNodePtr logical_join, JoinType join_type,
+                                                                 const PhysicalPlanNodePtr& outer_input,
+                                                                 std::vector<EquiJoinKey> keys) {
+    if (!config_.enable_index_nested_loop_join) return nullptr;
+    if (join_type != JoinType::INNER && join_type != JoinType::LEFT && join_type != JoinType::LEFT_OUTER &&
+        join_type != JoinType::SEMI && join_type != JoinType::ANTI) {
+        return nullptr;
+    }
+    
+    // The inner side must be a base table the index can stand in for
+    const auto inner = logical_join->children[1];
+    std::string table_name;
+    std::string alias;
+    std::vector<ExpressionPtr> filter_conditions;
+    std::vector<std::string> required_columns;
+    if (inner->type == PlanNodeType::TABLE_SCAN) {
+        auto scan = std::static_pointer_cast<TableScanNode>(inner);
+        table_name = scan->table_name;
+        alias = scan->alias;
+        filter_conditions = scan->filter_conditions;
+        required_columns = scan->required_columns;
+    } else if (inner->type == PlanNodeType::INDEX_SCAN) {
+        auto scan = std::static_pointer_cast<IndexScanNode>(inner);
+        if (!scan->index_conditions.empty()) return nullptr;
+        table_name = scan->table_name;
+        alias = scan->alias;
+        filter_conditions = scan->filter_conditions;
+        required_columns = scan->required_columns;
+    } else {
+        return nullptr;
+    }
+    
+    std::vector<Index> indexes;
+    if (auto table = schema_->get_table(table_name)) {
+        indexes = table->indexes;
+    }
+    auto methods = metadata_.access_methods.find(table_name);
+    if (methods != metadata_.access_methods.end()) {
+        for (const auto& method : methods->second) {
+            if (method.type == AccessMethod::INDEX_SCAN && !method.key_columns.empty()) {
+                indexes.push_back(Index{method.index_name, method.key_columns});
+            }
+        }
+    }
+    
+    const auto inner_column = [](const ExpressionPtr& expr) {
+        if (expr->column_ref) return expr->column_ref->column_name;
+        const auto dot = expr->value.rfind('.');
+        return dot == std::string::npos ? expr->value : expr->value.substr(dot + 1);
+    };
+    
+    // Pick the index whose leading columns cover the most join keys
+    const Index* best_index = nullptr;
+    std::vector<EquiJoinKey> best_keys;
+    size_t best_prefix = 0;
+    for (const auto& index : indexes) {
+        if (index.type != "BTREE") continue;
+        
+        std::vector<EquiJoinKey> ordered;
+        std::vector<bool> used(keys.size(), false);
+        for (const auto& column : index.columns) {
+            size_t k = 0;
+            while (k < keys.size() && (used[k] || inner_column(keys[k].right) != column)) ++k;
+            if (k == keys.size()) break;
+            used[k] = true;
+            ordered.push_back(keys[k]);
+        }
+        const size_t prefix = ordered.size();
+        if (prefix == 0 || prefix < best_prefix ||
+            (prefix == best_prefix && !(index.unique && !best_index->unique))) {
+            continue;
+        }
+        for (size_t k = 0; k < keys.size(); ++k) {
+            if (!used[k]) ordered.push_back(keys[k]);
+        }
+        best_index = &index;
+        best_keys = std::move(ordered);
+        best_prefix = prefix;
+    }
+    if (!best_index) return nullptr;
+    
+    const auto stats = get_table_stats(table_name);
+    auto index_scan = make_index_scan(table_name, alias, best_index->name, best_index->columns, required_columns);
+    index_scan->filter_conditions = filter_conditions;
+    index_scan->estimated_cost = inner->cost;
+    index_scan->estimated_cost.estimated_rows = stats->row_count;
+    index_scan->output_ordering = derive_output_ordering(index_scan);
+    
+    auto index_join = std::make_shared<PhysicalIndexNestedLoopJoinNode>(join_type);
+    if (auto join = std::dynamic_pointer_cast<JoinNode>(logical_join)) {
+        index_join->join_conditions = join->join_conditions;
+    }
+    for (const auto& key : best_keys) {
+        index_join->outer_keys.push_back(key.left);
+        index_join->inner_keys.push_back(key.right);
+    }
+    index_join->index_key_count = best_prefix;
+    index_join->children.push_back(outer_input);
+    index_join->children.push_back(index_scan);
+    
+    // Rows per lookup: a unique index returns at most one, otherwise use the join estimate
+    const PlanCost& outer = outer_input->estimated_cost;
+    double matches_per_probe = 1.0;
+    if (!best_index->unique || best_prefix < best_index->columns.size()) {
+        matches_per_probe = std::max(1.0, static_cast<double>(logical_join->cost.estimated_rows) /
+                                          std::max<size_t>(outer.estimated_rows, 1));
+    }
+    index_join->estimated_cost.startup_cost = outer.startup_cost;
+    index_join->estimated_cost.total_cost = estimate_index_nested_loop_cost(outer, stats->row_count, matches_per_probe);
+    index_join->estimated_cost.estimated_rows = logical_join->cost.estimated_rows;
+    
+    // Index lookups only beat the rescanning nested loop the fallback would use
+    if (index_join->estimated_cost.total_cost >= estimate_nested_loop_cost(outer, inner->cost) &&
+        inner->cost.total_cost > 0.0) {
+        return nullptr;
+    }
+    return index_join;
+}
+
+bool PhysicalPlanner::orient_join_keys(const PhysicalPlanNodePtr& left_input, const PhysicalPlanNodePtr& right_input,
+                                       std::vector<EquiJoinKey>& keys) const {
+    // Exact qualified names decide the side before bare-name matching does,
+    // since "users.id" also resolves against a lone "orders.id"
+    const auto names_column = [](const std::vector<std::string>& columns, const ExpressionPtr& expr) {
+        const std::string name = expr->column_ref ? expr->column_ref->full_name() : expr->value;
+        return std::find(columns.begin(), columns.end(), name) != columns.end();
+    };
+    
+    // Every key must name one column from each input; swap sides where needed
+    for (auto& key : keys) {
+        if (!names_column(left_input->output_columns, key.left) &&
+            !names_column(right_input->output_columns, key.right) &&
+            (names_column(left_input->output_columns, key.right) ||
+             names_column(right_input->output_columns, key.left))) {
+            std::swap(key.left, key.right);
+        }
+        if (resolve_column_index(left_input->output_columns, key.left) < 0 ||
+            resolve_column_index(right_input->output_columns, key.right) < 0) {
+            return false;
+        }
+    }
+    return !keys.empty();
+}
+
+std::vector<PhysicalSortKey> PhysicalPlanner::derive_output_ordering(const PhysicalPlanNodePtr& node) const {
+    switch (node->type) {
+        case PhysicalOperatorType::SORT:
+            return std::static_pointer_cast<PhysicalSortNode>(node)->sort_keys;
+        case PhysicalOperatorType::TOP_N:
+            return std::static_pointer_cast<PhysicalTopNNode>(node)->sort_keys;
+        case PhysicalOperatorType::GATHER_MERGE:
+            return std::static_pointer_cast<GatherMergeNode>(node)->sort_keys;
+            
+        case PhysicalOperatorType::INDEX_SCAN:
+        case PhysicalOperatorType::INDEX_ONLY_SCAN: {
+            // B-tree order on the key columns in their schema types, NULLs last
+            auto index_scan = std::static_pointer_cast<PhysicalIndexScanNode>(node);
+            const std::string& qualifier = index_scan->alias.empty() ? index_scan->table_name : index_scan->alias;
+            std::vector<PhysicalSortKey> ordering;
+            for (size_t k = 0; k < index_scan->index_columns.size(); ++k) {
+                const std::string& column = index_scan->index_columns[k];
+                PhysicalSortKey key;
+                key.expression = std::make_shared<Expression>(ExpressionType::COLUMN_REF, qualifier + "." + column);
+                key.expression->column_ref = ColumnRef{qualifier, column};
+                if (k < index_scan->index_key_types.size()) key.type = index_scan->index_key_types[k];
+                ordering.push_back(key);
+            }
+            return ordering;
+        }
+        
+        case PhysicalOperatorType::MERGE_JOIN: {
+            // Outer rows stream through in order; padded inner rows would not
+            const auto join_type = std::static_pointer_cast<PhysicalMergeJoinNode>(node)->join_type;
+            if (join_type == JoinType::RIGHT || join_type == JoinType::RIGHT_OUTER ||
+                join_type == JoinType::FULL || join_type == JoinType::FULL_OUTER) {
+                return {};
+            }
+            return node->children.empty() ? std::vector<PhysicalSortKey>() : node->children[0]->output_ordering;
+        }
+        
+        case PhysicalOperatorType::PROJECTION: {
+            // Input order survives as far as its keys are still in the output
+            std::vector<PhysicalSortKey> ordering;
+            if (node->children.empty()) return ordering;
+            for (const auto& key : node->children[0]->output_ordering) {
+                if (resolve_column_index(node->output_columns, key.expression) < 0) break;
+                ordering.push_back(key);
+            }
+            return ordering;
+        }
+        
+        case PhysicalOperatorType::LIMIT:
+        case PhysicalOperatorType::FILTER:
+        case PhysicalOperatorType::NESTED_LOOP_JOIN:
+        case PhysicalOperatorType::INDEX_NESTED_LOOP_JOIN:
+            // Each emits its (outer) input's rows in arrival order
+            return node->children.empty() ? std::vector<PhysicalSortKey>() : node->children[0]->output_ordering;
+            
+        default:
+            return {};
+    }
+}
+
+bool PhysicalPlanner::ordering_satisfies(const PhysicalPlanNodePtr& node,
+                                         const std::vector<PhysicalSortKey>& required) const {
+    if (!node || required.empty()) return false;
+    
+    const auto& provided = node->output_ordering;
+    if (required.size() > provided.size()) return false;
+    
+    for (size_t i = 0; i < required.size(); ++i) {
+        if (provided[i].ascending != required[i].ascending ||
+            provided[i].nulls_first != required[i].nulls_first) {
+            return false;
+        }
+        
+        // Text and numbers order the same values differently, and an order
+        // inferred from the values may be either
+        const bool provided_text = provided[i].type == SortKeyType::TEXT;
+        const bool required_text = required[i].type == SortKeyType::TEXT;
+        if (required[i].type != SortKeyType::INFERRED &&
+            (provided[i].type == SortKeyType::INFERRED || provided_text != required_text)) {
+            return false;
+        }
+        
+        const int provided_column = resolve_column_index(node->output_columns, provided[i].expression);
+        const int required_column = resolve_column_index(node->output_columns, required[i].expression);
+        if (provided_column < 0 || provided_column != required_column) {
+            return false;
+        }
+    }
+    return true;
+}
+
+PhysicalPlanNodePtr PhysicalPlanner::ensure_ordering(const PhysicalPlanNodePtr& node,
+                                                     const std::vector<PhysicalSortKey>& required) const {
+    if (ordering_satisfies(node, required)) {
+        return node;
+    }
+    
+    auto physical_sort = std::make_shared<PhysicalSortNode>();
+    physical_sort->sort_keys = required;
+    physical_sort->estimated_cost = node->estimated_cost;
+    physical_sort->output_columns = node->output_columns;
+    physical_sort->output_ordering = required;
+    physical_sort->children.push_back(node);
+    return physical_sort;
 }
 
 bool PhysicalPlanner::should_parallelize(LogicalPlanNodePtr node) {
@@ -397,7 +1325,53 @@ PhysicalPlanNodePtr PhysicalPlanner::add_parallelization(PhysicalPlanNodePtr phy
         return parallel_scan;
     }
     
-    return physical_node;
+    return parallelize_sorts(physical_node);
+}
+
+PhysicalPlanNodePtr PhysicalPlanner::parallelize_sorts(PhysicalPlanNodePtr physical_node) {
+    if (!physical_node) return nullptr;
+    
+    for (auto& child : physical_node->children) {
+        child = parallelize_sorts(child);
+    }
+    
+    if (physical_node->type != PhysicalOperatorType::SORT) {
+        return physical_node;
+    }
+    
+    auto sort = std::static_pointer_cast<PhysicalSortNode>(physical_node);
+    const size_t degree = std::max<size_t>(config_.max_parallel_workers, 1);
+    if (degree < 2) return sort;
+    
+    // A sort over a base table splits into per-worker scans and sorts whose
+    // ordered outputs are merged; any other input is range-partitioned by
+    // the sort itself
+    auto scan = sort->children.size() == 1
+        ? std::dynamic_pointer_cast<SequentialScanNode>(sort->children[0]) : nullptr;
+    if (!scan || scan->topn_threshold) {
+        sort->parallel_degree = degree;
+        return sort;
+    }
+    
+    auto gather_merge = std::make_shared<GatherMergeNode>();
+    gather_merge->sort_keys = sort->sort_keys;
+    gather_merge->estimated_cost = sort->estimated_cost;
+    gather_merge->output_columns = sort->output_columns;
+    gather_merge->output_ordering = sort->sort_keys;
+    for (size_t worker = 0; worker < degree; ++worker) {
+        auto worker_scan = std::static_pointer_cast<SequentialScanNode>(scan->copy());
+        worker_scan->partition_index = worker;
+        worker_scan->partition_count = degree;
+        
+        auto worker_sort = std::make_shared<PhysicalSortNode>();
+        worker_sort->sort_keys = sort->sort_keys;
+        worker_sort->output_columns = sort->output_columns;
+        worker_sort->estimated_cost = sort->estimated_cost;
+        worker_sort->estimated_cost.estimated_rows /= degree;
+        worker_sort->children.push_back(worker_scan);
+        gather_merge->children.push_back(worker_sort);
+    }
+    return gather_merge;
 }
 
 double PhysicalPlanner::estimate_physical_cost(PhysicalPlanNodePtr node) {
@@ -421,17 +1395,267 @@ size_t PhysicalPlanner::estimate_memory_for_sort(PhysicalPlanNodePtr input) {
     return input->estimated_cost.estimated_rows * 32; // 32 bytes per row for sorting
 }
 
-TableStats PhysicalPlanner::get_table_stats(const std::string& table_name) const {
-    auto it = metadata_.table_stats.find(table_name);
-    if (it != metadata_.table_stats.end()) {
-        return it->second;
+double PhysicalPlanner::estimate_sort_cost(const PlanCost& input) const {
+    const double rows = std::max<double>(input.estimated_rows, 2.0);
+    return 2.0 * config_.cpu_operator_cost * rows * std::log2(rows);
+}
+
+double PhysicalPlanner::estimate_nested_loop_cost(const PlanCost& outer, const PlanCost& inner) const {
+    // The inner side is rescanned once per outer row
+    return outer.total_cost + std::max<double>(outer.estimated_rows, 1.0) * inner.total_cost;
+}
+
+double PhysicalPlanner::estimate_merge_join_cost(const PhysicalPlanNodePtr& left_input,
+                                                 const PhysicalPlanNodePtr& right_input,
+                                                 const std::vector<EquiJoinKey>& keys) const {
+    std::vector<PhysicalSortKey> left_order;
+    std::vector<PhysicalSortKey> right_order;
+    for (const auto& key : keys) {
+        PhysicalSortKey left_key;
+        left_key.expression = key.left;
+        left_order.push_back(left_key);
+        PhysicalSortKey right_key;
+        right_key.expression = key.right;
+        right_order.push_back(right_key);
+    }
+    
+    const PlanCost& left = left_input->estimated_cost;
+    const PlanCost& right = right_input->estimated_cost;
+    double cost = left.total_cost + right.total_cost +
+                  (left.estimated_rows + right.estimated_rows) * config_.cpu_tuple_cost;
+    if (!ordering_satisfies(left_input, left_order)) cost += estimate_sort_cost(left);
+    if (!ordering_satisfies(right_input, right_order)) cost += estimate_sort_cost(right);
+    return cost;
+}
+
+double PhysicalPlanner::estimate_index_nested_loop_cost(const PlanCost& outer, size_t inner_rows,
+                                                        double matches_per_probe) const {
+    // One B-tree descent per outer row plus the matching entries: O(outer * log n)
+    const double descent = std::log2(std::max<double>(inner_rows, 2.0)) * config_.cpu_operator_cost;
+    const double fetch = matches_per_probe * (config_.cpu_index_tuple_cost + config_.cpu_tuple_cost);
+    return outer.total_cost + std::max<double>(outer.estimated_rows, 1.0) * (descent + fetch);
+}
+
+std::shared_ptr<const TableStats> PhysicalPlanner::get_table_stats(const std::string& table_name) const {
+    // Tables never analyzed get the default estimates
+    return metadata_.statistics->get_table_stats(table_name);
+}
+
+std::vector<std::string> PhysicalPlanner::get_table_columns(const std::string& table_name,
+                                                            const std::string& alias) const {
+    std::vector<std::string> columns;
+    auto table = schema_->get_table(table_name);
+    if (!table) return columns;
+    
+    const std::string& qualifier = alias.empty() ? table_name : alias;
+    for (const auto& column : table->columns) {
+        columns.push_back(qualifier + "." + column.name);
+    }
+    return columns;
+}
+
+std::vector<size_t> PhysicalPlanner::prune_scan_columns(std::vector<std::string>& columns,
+                                                        const std::vector<std::string>& required,
+                                                        const std::vector<std::string>& keep) const {
+    // No requirement recorded: the query may read every column
+    if (required.empty()) return {};
+    
+    const auto listed = [](const std::vector<std::string>& names, const std::string& name) {
+        return std::find(names.begin(), names.end(), name) != names.end();
+    };
+    
+    // Keep "alias.column" when the query names it qualified or bare
+    std::vector<std::string> kept;
+    std::vector<size_t> positions;
+    for (size_t i = 0; i < columns.size(); ++i) {
+        const size_t dot = columns[i].rfind('.');
+        const std::string bare = dot == std::string::npos ? columns[i] : columns[i].substr(dot + 1);
+        if (listed(required, columns[i]) || listed(required, bare) || listed(keep, bare)) {
+            kept.push_back(columns[i]);
+            positions.push_back(i);
+        }
+    }
+    
+    // Rows still have to be counted, so a scan returns at least one column
+    if (kept.empty() && !columns.empty()) {
+        kept.push_back(columns[0]);
+        positions.push_back(0);
+    }
+    if (kept.size() == columns.size()) return {};
+    
+    columns = std::move(kept);
+    return positions;
+}
+
+std::vector<std::string> PhysicalPlanner::derive_output_columns(const PhysicalPlanNodePtr& node) const {
+    std::vector<std::string> columns;
+    switch (node->type) {
+        case PhysicalOperatorType::MERGE_JOIN:
+        case PhysicalOperatorType::INDEX_NESTED_LOOP_JOIN: {
+            // Semi and anti joins return outer rows only
+            const auto join_type = node->type == PhysicalOperatorType::MERGE_JOIN
+                ? std::static_pointer_cast<PhysicalMergeJoinNode>(node)->join_type
+                : std::static_pointer_cast<PhysicalIndexNestedLoopJoinNode>(node)->join_type;
+            if ((join_type == JoinType::SEMI || join_type == JoinType::ANTI) && !node->children.empty()) {
+                columns = node->children[0]->output_columns;
+                break;
+            }
+            for (const auto& child : node->children) {
+                columns.insert(columns.end(), child->output_columns.begin(), child->output_columns.end());
+            }
+            break;
+        }
+        case PhysicalOperatorType::NESTED_LOOP_JOIN:
+        case PhysicalOperatorType::HASH_JOIN:
+        case PhysicalOperatorType::PARALLEL_HASH_JOIN:
+            // Joined tuples are the outer values followed by the inner values
+            for (const auto& child : node->children) {
+                columns.insert(columns.end(), child->output_columns.begin(), child->output_columns.end());
+            }
+            break;
+        default:
+            if (!node->children.empty()) {
+                columns = node->children[0]->output_columns;
+            }
+            break;
+    }
+    return columns;
+}
+
+// Collects the (table, alias) pairs scanned below a logical node
+static void collect_scanned_tables(const LogicalPlanNodePtr& node,
+                                   std::vector<std::pair<std::string, std::string>>& tables) {
+    if (!node) return;
+    if (node->type == PlanNodeType::TABLE_SCAN) {
+        auto scan = std::static_pointer_cast<TableScanNode>(node);
+        tables.emplace_back(scan->table_name, scan->alias);
+    } else if (node->type == PlanNodeType::INDEX_SCAN) {
+        auto scan = std::static_pointer_cast<IndexScanNode>(node);
+        tables.emplace_back(scan->table_name, scan->alias);
+    }
+    for (const auto& child : node->children) {
+        collect_scanned_tables(child, tables);
     }
+}
+
+static SortKeyType sort_key_type_for_column(ColumnType type) {
+    switch (type) {
+        case ColumnType::INTEGER:
+        case ColumnType::BIGINT:
+            return SortKeyType::INTEGER;
+        case ColumnType::DECIMAL:
+            return SortKeyType::FLOAT;
+        case ColumnType::BOOLEAN:
+            return SortKeyType::INFERRED;
+        default:
+            // Character data, and dates/timestamps in ISO form, sort bytewise
+            return SortKeyType::TEXT;
+    }
+}
+
+std::vector<SortKeyType> PhysicalPlanner::column_key_types(const std::string& table_name,
+                                                          const std::vector<std::string>& columns) const {
+    std::vector<SortKeyType> types(columns.size(), SortKeyType::INFERRED);
+    auto table = schema_->get_table(table_name);
+    if (!table) return types;
+    for (size_t k = 0; k < columns.size(); ++k) {
+        for (const auto& column : table->columns) {
+            if (column.name == columns[k]) types[k] = sort_key_type_for_column(column.type);
+        }
+    }
+    return types;
+}
+
+PhysicalSortKey PhysicalPlanner::convert_sort_key(const SortNode::SortKey& logical_key,
+                                                  const LogicalPlanNodePtr& input) const {
+    PhysicalSortKey physical_key;
+    physical_key.expression = logical_key.expression;
+    physical_key.ascending = logical_key.ascending;
+    physical_key.nulls_first = logical_key.nulls_first;
     
-    // Default stats
-    TableStats default_stats;
-    default_stats.row_count = 1000;
-    default_stats.avg_row_size = 100.0;
-    return default_stats;
+    // Type the key from the schema when it names exactly one scanned column;
+    // otherwise the sort infers the type from the values
+    const auto& expr = logical_key.expression;
+    if (!expr || !expr->column_ref) return physical_key;
+    
+    std::vector<std::pair<std::string, std::string>> tables;
+    collect_scanned_tables(input, tables);
+    
+    size_t matches = 0;
+    for (const auto& [table_name, alias] : tables) {
+        const std::string& qualifier = expr->column_ref->table_alias;
+        if (!qualifier.empty() && qualifier != alias && qualifier != table_name) continue;
+        
+        auto table = schema_->get_table(table_name);
+        if (!table) continue;
+        for (const auto& column : table->columns) {
+            if (column.name == expr->column_ref->column_name) {
+                physical_key.type = sort_key_type_for_column(column.type);
+                matches++;
+            }
+        }
+    }
+    if (matches != 1) {
+        physical_key.type = SortKeyType::INFERRED;
+    }
+    return physical_key;
+}
+
+std::vector<std::string> PhysicalPlanner::get_index_columns(const std::string& table_name,
+                                                            const std::string& index_name) const {
+    if (auto table = schema_->get_table(table_name)) {
+        for (const auto& index : table->indexes) {
+            if (index.name == index_name) {
+                return index.columns;
+            }
+        }
+    }
+    
+    auto it = metadata_.access_methods.find(table_name);
+    if (it != metadata_.access_methods.end()) {
+        for (const auto& method : it->second) {
+            if (method.index_name == index_name) {
+                return method.key_columns;
+            }
+        }
+    }
+    return {};
+}
+
+bool PhysicalPlanner::index_covers(const std::string& table_name, const std::vector<std::string>& index_columns,
+                                   const std::vector<std::string>& required_columns) const {
+    if (index_columns.empty()) return false;
+    std::vector<std::string> columns = get_table_columns(table_name, "");
+    prune_scan_columns(columns, required_columns, index_columns);
+    return std::all_of(columns.begin(), columns.end(), [&](const std::string& column) {
+        const std::string bare = column.substr(column.rfind('.') + 1);
+        return std::find(index_columns.begin(), index_columns.end(), bare) != index_columns.end();
+    });
+}
+
+std::shared_ptr<PhysicalIndexScanNode> PhysicalPlanner::make_index_scan(
+    const std::string& table_name, const std::string& alias, const std::string& index_name,
+    const std::vector<std::string>& index_columns, const std::vector<std::string>& required_columns) const {
+    std::shared_ptr<PhysicalIndexScanNode> index_scan;
+    std::vector<std::string> columns = get_table_columns(table_name, alias);
+    std::vector<size_t> positions = prune_scan_columns(columns, required_columns, index_columns);
+    if (index_covers(table_name, index_columns, required_columns)) {
+        // Entries are built with exactly the kept columns, so rows need no projection
+        auto index_only = std::make_shared<PhysicalIndexOnlyScanNode>(table_name, index_name);
+        index_only->entry_columns = std::move(positions);
+        if (index_only->entry_columns.empty()) {
+            for (size_t i = 0; i < columns.size(); ++i) index_only->entry_columns.push_back(i);
+        }
+        index_scan = index_only;
+    } else {
+        index_scan = std::make_shared<PhysicalIndexScanNode>(table_name, index_name);
+        index_scan->projected_columns = std::move(positions);
+    }
+    index_scan->alias = alias;
+    index_scan->index_columns = index_columns;
+    index_scan->index_key_types = column_key_types(table_name, index_columns);
+    index_scan->output_columns = std::move(columns);
+    return index_scan;
 }
 
 bool PhysicalPlanner::table_has_index(const std::string& table_name, const std::vector<std::string>& columns) {
@@ -1,6 +1,10 @@
 #include "query_planner.hpp"
+#include "cost_calibration.hpp"
+#include "memo_optimizer.hpp"
 #include <regex>
 #include <algorithm>
+#include <bitset>
+#include <functional>
 #include <cmath>
 #include <iostream>
 #include <sstream>
@@ -9,14 +13,8 @@
 
 namespace db25 {
     QueryPlanner::QueryPlanner(const std::shared_ptr<DatabaseSchema> &schema)
-        : schema_(schema) {
-        // Initialize default table statistics
-        for (const auto &table_name: schema_->get_table_names()) {
-            TableStats stats;
-            stats.row_count = 1000; // Default estimate
-            stats.avg_row_size = 100.0;
-            table_stats_[table_name] = stats;
-        }
+        : schema_(schema), statistics_(std::make_shared<StatisticsCatalog>()),
+          feedback_(std::make_shared<CardinalityFeedback>()) {
     }
 
     LogicalPlan QueryPlanner::create_plan(const std::string &query) {
@@ -48,6 +46,8 @@ namespace db25 {
         }
 
         LogicalPlan plan(root);
+        plan.fingerprint = parser_.get_query_fingerprint(query).value_or("");
+        fingerprint_ = plan.fingerprint;
 
         // Calculate costs
         if (root) {
@@ -58,21 +58,17 @@ namespace db25 {
         return plan;
     }
 
-    void QueryPlanner::set_table_stats(const std::string &table_name, const TableStats &stats) {
-        table_stats_[table_name] = stats;
+    void QueryPlanner::load_cost_config(const std::string &path) {
+        load_cost_constants(path).apply(config_);
     }
 
-    TableStats QueryPlanner::get_table_stats(const std::string &table_name) const {
-        auto it = table_stats_.find(table_name);
-        if (it != table_stats_.end()) {
-            return it->second;
-        }
+    void QueryPlanner::set_table_stats(const std::string &table_name, const TableStats &stats) {
+        statistics_->set_table_stats(table_name, stats);
+    }
 
-        // Return default stats
-        TableStats default_stats;
-        default_stats.row_count = 1000;
-        default_stats.avg_row_size = 100.0;
-        return default_stats;
+    std::shared_ptr<const TableStats> QueryPlanner::get_table_stats(const std::string &table_name) const {
+        // Tables never analyzed get the default estimates
+        return statistics_->get_table_stats(table_name);
     }
 
     LogicalPlan QueryPlanner::optimize_plan(const LogicalPlan &plan) {
@@ -81,19 +77,33 @@ namespace db25 {
         }
 
         LogicalPlan optimized = plan.copy();
+        fingerprint_ = plan.fingerprint;
 
         // Apply optimization transformations
-        PredicatePushdownTransformer predicate_pushdown;
+        PredicatePushdownTransformer predicate_pushdown(schema_);
         optimized.root = predicate_pushdown.transform(optimized.root);
 
+        JoinEliminationTransformer join_elimination(schema_);
+        optimized.root = join_elimination.transform(optimized.root);
+
+        DistinctEliminationTransformer distinct_elimination(schema_);
+        optimized.root = distinct_elimination.transform(optimized.root);
+
         ProjectionPushdownTransformer projection_pushdown;
         optimized.root = projection_pushdown.transform(optimized.root);
 
         JoinReorderingTransformer join_reordering(*this);
         optimized.root = join_reordering.transform(optimized.root);
 
-        // Recalculate costs after optimization
-        estimate_costs(optimized.root);
+        if (config_.enable_memo_search) {
+            // The reordered plan seeds the memo and bounds the search; the
+            // winner comes back fully costed, with elided sorts costed as free
+            MemoOptimizer memo(*this, schema_);
+            optimized.root = memo.optimize(optimized.root);
+        } else {
+            // Recalculate costs after optimization
+            estimate_costs(optimized.root);
+        }
         optimized.calculate_costs();
 
         return optimized;
@@ -114,7 +124,23 @@ namespace db25 {
                 plans.push_back(optimized);
             }
 
-            // TODO: Generate alternative join orders, index choices, etc.
+            // Cheapest plan for each join algorithm and access path at the root
+            if (config_.enable_memo_search) {
+                MemoOptimizer memo(*this, schema_);
+                LogicalPlan seed = optimized.copy();
+                memo.optimize(seed.root);
+                std::set<std::string> seen;
+                for (const auto &existing: plans) {
+                    seen.insert(existing.root->to_string(0));
+                }
+                for (const auto &root: memo.alternatives()) {
+                    if (!seen.insert(root->to_string(0)).second) continue;
+                    LogicalPlan alternative = base_plan.copy();
+                    alternative.root = root;
+                    alternative.calculate_costs();
+                    plans.push_back(alternative);
+                }
+            }
         }
 
         return plans;
@@ -649,7 +675,7 @@ namespace db25 {
         return expr;
     }
 
-    void QueryPlanner::estimate_costs(const LogicalPlanNodePtr &node) { // NOLINT (recursively defined)
+    void QueryPlanner::estimate_costs(const LogicalPlanNodePtr &node) const { // NOLINT (recursively defined)
         if (!node) return;
 
         // First estimate costs for children
@@ -658,31 +684,43 @@ namespace db25 {
         }
 
         // Then estimate cost for this node
+        estimate_node_cost(node);
+    }
+
+    void QueryPlanner::estimate_node_cost(const LogicalPlanNodePtr &node) const {
         switch (node->type) {
             case PlanNodeType::TABLE_SCAN: {
                 auto scan_node = std::static_pointer_cast<TableScanNode>(node);
+                relation_tables_[scan_node->alias.empty() ? scan_node->table_name : scan_node->alias] =
+                        scan_node->table_name;
                 double base_cost = estimate_table_scan_cost(scan_node->table_name);
                 double selectivity = estimate_selectivity(scan_node->filter_conditions, scan_node->table_name);
 
                 node->cost.startup_cost = 0.0;
                 node->cost.total_cost = base_cost;
                 node->cost.estimated_rows = static_cast<size_t>(
-                    get_table_stats(scan_node->table_name).row_count * selectivity);
+                    get_table_stats(scan_node->table_name)->row_count * selectivity);
                 node->cost.selectivity = selectivity;
                 break;
             }
 
             case PlanNodeType::INDEX_SCAN: {
                 const auto index_node = std::static_pointer_cast<IndexScanNode>(node);
+                relation_tables_[index_node->alias.empty() ? index_node->table_name : index_node->alias] =
+                        index_node->table_name;
                 const double selectivity = estimate_selectivity(index_node->index_conditions, index_node->table_name);
                 const double base_cost =
                         estimate_index_scan_cost(index_node->table_name, index_node->index_name, selectivity);
 
+                // Residual filters are checked on the fetched rows
+                const double filter_selectivity =
+                        estimate_selectivity(index_node->filter_conditions, index_node->table_name);
+
                 node->cost.startup_cost = 0.0;
                 node->cost.total_cost = base_cost;
                 node->cost.estimated_rows = static_cast<size_t>(
-                    get_table_stats(index_node->table_name).row_count * selectivity);
-                node->cost.selectivity = selectivity;
+                    get_table_stats(index_node->table_name)->row_count * selectivity * filter_selectivity);
+                node->cost.selectivity = selectivity * filter_selectivity;
                 break;
             }
 
@@ -728,6 +766,26 @@ namespace db25 {
                 break;
             }
 
+            case PlanNodeType::MERGE_JOIN: {
+                auto join_node = std::static_pointer_cast<MergeJoinNode>(node);
+                if (join_node->children.size() == 2) {
+                    auto left = join_node->children[0];
+                    auto right = join_node->children[1];
+
+                    double selectivity = estimate_selectivity(join_node->join_conditions, "");
+                    // Inputs arrive sorted on the keys, so each is read once
+                    double merge_cost = (left->cost.estimated_rows + right->cost.estimated_rows) *
+                                        config_.cpu_operator_cost;
+
+                    node->cost.startup_cost = left->cost.startup_cost + right->cost.startup_cost;
+                    node->cost.total_cost = left->cost.total_cost + right->cost.total_cost + merge_cost;
+                    node->cost.estimated_rows = static_cast<size_t>(
+                        left->cost.estimated_rows * right->cost.estimated_rows * selectivity);
+                    node->cost.selectivity = selectivity;
+                }
+                break;
+            }
+
             case PlanNodeType::PROJECTION: {
                 if (!node->children.empty()) {
                     auto child = node->children[0];
@@ -773,13 +831,18 @@ namespace db25 {
                 const auto limit_node = std::static_pointer_cast<LimitNode>(node);
                 if (!node->children.empty()) {
                     const auto child = node->children[0];
-                    size_t output_rows = child->cost.estimated_rows;
+                    const size_t offset_rows = std::min(child->cost.estimated_rows, limit_node->offset.value_or(0));
+                    size_t output_rows = child->cost.estimated_rows - offset_rows;
 
                     if (limit_node->limit) {
                         output_rows = std::min(output_rows, *limit_node->limit);
                     }
 
-                    const double fraction = static_cast<double>(output_rows) / child->cost.estimated_rows;
+                    // Skipped OFFSET rows still have to be produced by the child
+                    const double fraction = child->cost.estimated_rows > 0
+                                                ? static_cast<double>(output_rows + offset_rows) /
+                                                  child->cost.estimated_rows
+                                                : 0.0;
 
                     node->cost.startup_cost = child->cost.startup_cost;
                     node->cost.total_cost = child->cost.startup_cost + child->cost.total_cost * fraction;
@@ -797,33 +860,376 @@ namespace db25 {
                 }
                 break;
         }
+
+        // A subplan executed before returns what it returned then
+        if ((feedback_ && !feedback_->empty()) || !materialized_.empty()) {
+            const std::string signature = plan_signature(node);
+            if (const auto rows = feedback_ ? feedback_->actual_rows(fingerprint_, signature) : std::nullopt) {
+                node->cost.estimated_rows = static_cast<size_t>(std::llround(*rows));
+            }
+            // Sorts and projections share their input's signature but still do their work
+            if (node->type != PlanNodeType::SORT && node->type != PlanNodeType::PROJECTION &&
+                materialized_.count(signature) > 0) {
+                node->cost.startup_cost = 0.0;
+                node->cost.total_cost = static_cast<double>(node->cost.estimated_rows) * config_.cpu_tuple_cost;
+            }
+        }
     }
 
     //NOLINTNEXTLINE: xyz
-    double QueryPlanner::estimate_selectivity(const std::vector<ExpressionPtr> &conditions,
+    // Selectivity when nothing is known about the columns involved
+    static double default_selectivity(const std::string &op) {
+        if (op.find('=') != std::string::npos) return 0.1; // Equality conditions are fairly selective
+        if (op.find('<') != std::string::npos || op.find('>') != std::string::npos) return 0.3; // Range conditions
+        if (op.find("LIKE") != std::string::npos || op.find("~~") != std::string::npos) return 0.2; // Pattern matching
+        return 0.5;
+    }
+
+    // The comparison with its operands swapped: 5 < x is x > 5
+    static std::string mirror_comparison(const std::string &op) {
+        if (op == "<") return ">";
+        if (op == "<=") return ">=";
+        if (op == ">") return "<";
+        if (op == ">=") return "<=";
+        return op;
+    }
+
+    static bool is_like(const std::string &op) { return op == "~~" || op == "LIKE" || op == "~~*" || op == "ILIKE"; }
+
+    static bool is_not_like(const std::string &op) {
+        return op == "!~~" || op == "NOT LIKE" || op == "!~~*" || op == "NOT ILIKE";
+    }
+
+    // Conditions joined by AND, nested ANDs included
+    static void flatten_conjunction(const std::vector<ExpressionPtr> &conditions, std::vector<ExpressionPtr> &out) { // NOLINT(misc-no-recursion)
+        for (const auto &condition: conditions) {
+            if (condition && condition->type == ExpressionType::BINARY_OP && condition->value == "AND") {
+                flatten_conjunction(condition->children, out);
+            } else if (condition) {
+                out.push_back(condition);
+            }
+        }
+    }
+
+    double QueryPlanner::estimate_selectivity(const std::vector<ExpressionPtr> &conditions, // NOLINT(misc-no-recursion)
                                               const std::string &table_name) const {
         if (conditions.empty()) {
             return 1.0;
         }
 
-        // Simple selectivity estimation - in a real system this would be much more sophisticated
+        std::vector<ExpressionPtr> conjuncts;
+        flatten_conjunction(conditions, conjuncts);
+
+        // Conjuncts are independent, except a lower and an upper bound on the
+        // same analyzed column: together they select the histogram range
+        // between them rather than the product of two open ranges
+        struct Range {
+            ResolvedColumn column;
+            ExpressionPtr lower; // Constant, with its operator
+            std::string lower_op;
+            ExpressionPtr upper;
+            std::string upper_op;
+        };
+        std::map<std::string, Range> ranges;
+
+        // Equalities on columns with extended statistics, by table
+        std::map<std::string, std::vector<std::pair<ResolvedColumn, std::string> > > correlated;
         double selectivity = 1.0;
 
-        for (const auto &condition: conditions) {
-            // Default selectivity for various condition types
-            if (condition->value.find('=') != std::string::npos) {
-                selectivity *= 0.1; // Equality conditions are fairly selective
-            } else if (condition->value.find('<') != std::string::npos ||
-                       condition->value.find('>') != std::string::npos) {
-                selectivity *= 0.3; // Range conditions
-            } else if (condition->value.find("LIKE") != std::string::npos) {
-                selectivity *= 0.2; // Pattern matching
+        for (const auto &condition: conjuncts) {
+            if (condition->type == ExpressionType::BINARY_OP && condition->children.size() == 2) {
+                std::string op = condition->value;
+                ExpressionPtr column = condition->children[0];
+                ExpressionPtr constant = condition->children[1];
+                if (column->type == ExpressionType::CONSTANT) {
+                    std::swap(column, constant);
+                    op = mirror_comparison(op);
+                }
+                if (op == "=" && column->type == ExpressionType::COLUMN_REF &&
+                    constant->type == ExpressionType::CONSTANT) {
+                    if (auto resolved = resolve_column(column, table_name); resolved && !resolved->stats->extended.empty()) {
+                        correlated[resolved->table_name].emplace_back(std::move(*resolved), constant->value);
+                        continue;
+                    }
+                }
+                const bool bound = op == "<" || op == "<=" || op == ">" || op == ">=";
+                if (bound && column->type == ExpressionType::COLUMN_REF && constant->type == ExpressionType::CONSTANT) {
+                    if (auto resolved = resolve_column(column, table_name); resolved && resolved->column_stats) {
+                        auto &range = ranges.try_emplace(resolved->table_name + "." + resolved->column.name,
+                                                         Range{*resolved, nullptr, "", nullptr, ""}).first->second;
+                        auto &side = op[0] == '>' ? range.lower : range.upper;
+                        if (!side) {
+                            side = constant;
+                            (op[0] == '>' ? range.lower_op : range.upper_op) = op;
+                            continue;
+                        }
+                    }
+                }
+            }
+            selectivity *= condition_selectivity(condition, table_name);
+        }
+
+        for (const auto &[name, range]: ranges) {
+            const ColumnStats &stats = *range.column.column_stats;
+            if (range.lower && range.upper) {
+                const double below_upper = stats.less_fraction(range.upper->value, range.upper_op == "<=");
+                const double up_to_lower = stats.less_fraction(range.lower->value, range.lower_op == ">");
+                selectivity *= std::max(below_upper - up_to_lower, 0.0);
+            } else if (range.lower) {
+                selectivity *= comparison_selectivity(range.lower_op, range.column, range.lower->value);
+            } else {
+                selectivity *= comparison_selectivity(range.upper_op, range.column, range.upper->value);
+            }
+        }
+
+        for (const auto &[table, equalities]: correlated) {
+            selectivity *= correlated_selectivity(equalities);
+        }
+
+        // Never estimate zero rows: an empty estimate makes every plan above free
+        return std::max(1e-9, std::min(1.0, selectivity));
+    }
+
+    double QueryPlanner::condition_selectivity(const ExpressionPtr &condition, // NOLINT(misc-no-recursion)
+                                               const std::string &table_name) const {
+        if (!condition) return 1.0;
+        const std::string &op = condition->value;
+
+        if (condition->type == ExpressionType::BINARY_OP && op == "AND") {
+            return estimate_selectivity(condition->children, table_name);
+        }
+        if (condition->type == ExpressionType::BINARY_OP && op == "OR") {
+            // Independent disjuncts: P(a or b) = P(a) + P(b) - P(a)P(b)
+            double selectivity = 0.0;
+            for (const auto &child: condition->children) {
+                const double child_selectivity = condition_selectivity(child, table_name);
+                selectivity += child_selectivity - selectivity * child_selectivity;
+            }
+            return selectivity;
+        }
+        if ((condition->type == ExpressionType::BINARY_OP || condition->type == ExpressionType::UNARY_OP) &&
+            op == "NOT" && condition->children.size() == 1) {
+            return 1.0 - condition_selectivity(condition->children[0], table_name);
+        }
+        if (condition->type != ExpressionType::BINARY_OP || condition->children.size() != 2) {
+            return default_selectivity(op);
+        }
+
+        ExpressionPtr left = condition->children[0];
+        ExpressionPtr right = condition->children[1];
+        std::string comparison = op;
+        if (left->type == ExpressionType::CONSTANT && right->type == ExpressionType::COLUMN_REF) {
+            std::swap(left, right);
+            comparison = mirror_comparison(op);
+        }
+        if (left->type != ExpressionType::COLUMN_REF) return default_selectivity(op);
+
+        const auto column = resolve_column(left, table_name);
+        if (right->type == ExpressionType::CONSTANT) {
+            return column ? comparison_selectivity(comparison, *column, right->value) : default_selectivity(op);
+        }
+
+        // Equi-join of two columns
+        if (right->type == ExpressionType::COLUMN_REF && comparison == "=") {
+            const auto other = resolve_column(right, table_name);
+            if (column && other) return join_selectivity(*column, *other);
+        }
+        return default_selectivity(op);
+    }
+
+    // Selectivity of column <op> value
+    double QueryPlanner::comparison_selectivity(const std::string &op, const ResolvedColumn &column,
+                                                const std::string &value) const {
+        const ColumnStats *stats = column.column_stats;
+        const double non_null = stats ? 1.0 - stats->null_fraction : 1.0;
+
+        if (op == "=" || op == "<>" || op == "!=") {
+            double equal;
+            if (stats) {
+                equal = stats->equal_fraction(value);
+            } else {
+                const double distinct = distinct_values(column);
+                equal = distinct > 0.0 ? 1.0 / distinct : default_selectivity("=");
+            }
+            return op == "=" ? equal : std::max(non_null - equal, 0.0);
+        }
+        if (op == "<" || op == "<=") {
+            return stats ? stats->less_fraction(value, op == "<=") : default_selectivity(op);
+        }
+        if (op == ">" || op == ">=") {
+            return stats ? std::max(non_null - stats->less_fraction(value, op == ">"), 0.0) : default_selectivity(op);
+        }
+        if (is_like(op) || is_not_like(op)) {
+            double like;
+            if (stats) {
+                like = stats->like_fraction(value);
             } else {
-                selectivity *= 0.5; // Default
+                like = value.find_first_of("%_") == std::string::npos
+                           ? comparison_selectivity("=", column, value)
+                           : default_selectivity("LIKE");
+            }
+            return is_like(op) ? like : std::max(non_null - like, 0.0);
+        }
+        return default_selectivity(op);
+    }
+
+    // Fraction of the cross product kept by left = right. A foreign key
+    // matches each referencing row to exactly one referenced row; otherwise
+    // every value on the side with fewer distinct values is assumed to find
+    // its match on the other side.
+    double QueryPlanner::join_selectivity(const ResolvedColumn &left, const ResolvedColumn &right) const {
+        const auto references = [](const ResolvedColumn &from, const ResolvedColumn &to) {
+            return from.column.references_table == to.table_name && from.column.references_column == to.column.name;
+        };
+        double selectivity;
+        if (references(left, right) && right.stats->row_count > 0) {
+            selectivity = 1.0 / static_cast<double>(right.stats->row_count);
+        } else if (references(right, left) && left.stats->row_count > 0) {
+            selectivity = 1.0 / static_cast<double>(left.stats->row_count);
+        } else {
+            const double distinct = std::max(distinct_values(left), distinct_values(right));
+            if (distinct <= 0.0) return default_selectivity("=");
+            selectivity = 1.0 / distinct;
+        }
+
+        // NULLs join nothing
+        if (left.column_stats) selectivity *= 1.0 - left.column_stats->null_fraction;
+        if (right.column_stats) selectivity *= 1.0 - right.column_stats->null_fraction;
+        return selectivity;
+    }
+
+    // Selectivity of equalities on columns of one table, using its extended
+    // statistics where they cover the columns:
+    // - a column group with every column matched reads its MCV list, or
+    //   spreads the remaining rows over the remaining combinations
+    // - a dependency a -> b of degree d makes P(a, b) = P(a) * (d + (1 - d) * P(b))
+    // Columns covered by neither are assumed independent.
+    double QueryPlanner::correlated_selectivity(
+        const std::vector<std::pair<ResolvedColumn, std::string> > &equalities) const {
+        std::map<std::string, size_t> remaining; // Column -> its equality
+        double selectivity = 1.0;
+        for (size_t i = 0; i < equalities.size(); ++i) {
+            // A second equality on a column is independent of the first
+            if (!remaining.emplace(equalities[i].first.column.name, i).second) {
+                selectivity *= comparison_selectivity("=", equalities[i].first, equalities[i].second);
+            }
+        }
+        const auto single = [&](const std::string &name) {
+            const auto &[column, value] = equalities[remaining.at(name)];
+            return comparison_selectivity("=", column, value);
+        };
+        const auto &extended = equalities.front().first.stats->extended;
+
+        // Widest fully matched groups first
+        std::vector<const ExtendedStats *> groups;
+        for (const auto &group: extended) {
+            groups.push_back(&group);
+        }
+        std::stable_sort(groups.begin(), groups.end(), [](const ExtendedStats *a, const ExtendedStats *b) {
+            return a->columns.size() > b->columns.size();
+        });
+        for (const ExtendedStats *group: groups) {
+            const bool matched = std::all_of(group->columns.begin(), group->columns.end(), [&](const std::string &c) {
+                return remaining.count(c) > 0;
+            });
+            if (!matched) continue;
+
+            std::vector<std::string> values;
+            double bound = 1.0; // A combination is no more common than any of its values
+            for (const auto &name: group->columns) {
+                values.push_back(equalities[remaining.at(name)].second);
+                bound = std::min(bound, single(name));
+            }
+            double combined = -1.0;
+            for (const auto &[common, frequency]: group->most_common_values) {
+                if (common == values) combined = frequency;
+            }
+            if (combined < 0.0) {
+                const double others = group->distinct_values - static_cast<double>(group->most_common_values.size());
+                const double rest = std::max(1.0 - group->common_fraction(), 0.0);
+                combined = others >= 1.0 ? rest / others : rest;
+            }
+            selectivity *= std::min(combined, bound);
+            for (const auto &name: group->columns) {
+                remaining.erase(name);
+            }
+        }
+
+        // Strongest dependency first; the dependent column is then accounted for
+        while (true) {
+            const ExtendedStats::Dependency *strongest = nullptr;
+            for (const auto &group: extended) {
+                for (const auto &dependency: group.dependencies) {
+                    if (remaining.count(dependency.determinant) && remaining.count(dependency.dependent) &&
+                        (!strongest || dependency.degree > strongest->degree)) {
+                        strongest = &dependency;
+                    }
+                }
             }
+            if (!strongest || strongest->degree <= 0.0) break;
+            selectivity *= strongest->degree + (1.0 - strongest->degree) * single(strongest->dependent);
+            remaining.erase(strongest->dependent);
+        }
+
+        for (const auto &[name, index]: remaining) {
+            selectivity *= single(name);
+        }
+        return selectivity;
+    }
+
+    // Distinct values of a column, or 0 if unknown
+    double QueryPlanner::distinct_values(const ResolvedColumn &column) const {
+        if (column.column_stats) return column.column_stats->distinct_values;
+        if (const auto it = column.stats->distinct_values.find(column.column.name);
+            it != column.stats->distinct_values.end()) {
+            return static_cast<double>(it->second);
         }
+        if (column.column.primary_key || column.column.unique) return static_cast<double>(column.stats->row_count);
+        return 0.0;
+    }
 
-        return std::max(0.001, std::min(1.0, selectivity)); // Clamp between 0.1% and 100%
+    // Table column a reference names: through the alias of a scan costed
+    // earlier, the table being scanned, or the only table with that column
+    std::optional<QueryPlanner::ResolvedColumn> QueryPlanner::resolve_column(const ExpressionPtr &expr,
+                                                                             const std::string &table_name) const {
+        if (!expr || expr->type != ExpressionType::COLUMN_REF || !schema_) return std::nullopt;
+
+        std::string qualifier;
+        std::string name = expr->value;
+        if (expr->column_ref) {
+            qualifier = expr->column_ref->table_alias;
+            name = expr->column_ref->column_name;
+        } else if (const size_t dot = name.rfind('.'); dot != std::string::npos) {
+            qualifier = name.substr(0, dot);
+            name = name.substr(dot + 1);
+        }
+
+        std::vector<std::string> candidates;
+        if (const auto it = relation_tables_.find(qualifier); !qualifier.empty() && it != relation_tables_.end()) {
+            candidates.push_back(it->second);
+        } else if (!qualifier.empty() && schema_->get_table(qualifier)) {
+            candidates.push_back(qualifier);
+        } else if (!table_name.empty()) {
+            candidates.push_back(table_name);
+        } else if (qualifier.empty()) {
+            candidates = schema_->get_table_names();
+        }
+
+        std::optional<ResolvedColumn> resolved;
+        for (const auto &candidate: candidates) {
+            const auto table = schema_->get_table(candidate);
+            if (!table) continue;
+            for (const auto &column: table->columns) {
+                if (column.name != name) continue;
+                if (resolved) return std::nullopt; // Ambiguous
+                resolved = ResolvedColumn{candidate, column, get_table_stats(candidate), nullptr};
+            }
+        }
+        if (resolved) {
+            const auto it = resolved->stats->columns.find(name);
+            if (it != resolved->stats->columns.end()) resolved->column_stats = &it->second;
+        }
+        return resolved;
     }
 
     LogicalPlanNodePtr QueryPlanner::build_plan_from_select(const std::string &query) {
@@ -869,11 +1275,14 @@ namespace db25 {
             plan_root = sort_node;
         }
 
-        // Add LIMIT - ENHANCED AST VERSION
-        if (auto limit_value = extract_limit_from_ast(query); limit_value.has_value()) {
+        // Add LIMIT / OFFSET - ENHANCED AST VERSION
+        auto limit_value = extract_limit_from_ast(query);
+        auto offset_value = extract_offset_from_ast(query);
+        if (limit_value.has_value() || offset_value.has_value()) {
             const auto limit_node = std::make_shared<LimitNode>();
             limit_node->children.push_back(plan_root);
-            limit_node->limit = limit_value.value();
+            limit_node->limit = limit_value;
+            limit_node->offset = offset_value;
             plan_root = limit_node;
         }
 
@@ -1008,18 +1417,26 @@ namespace db25 {
                                     }
                                 }
                                 
-                                // Parse NULLS ordering
+                                // Parse NULLS ordering; by default NULLs sort as the
+                                // largest value (last for ASC, first for DESC)
+                                key.nulls_first = !key.ascending;
                                 if (sort_by.contains("sortby_nulls")) {
                                     // Handle both string and integer representations
                                     // SORTBY_NULLS_FIRST = 1, SORTBY_NULLS_LAST = 2, SORTBY_NULLS_DEFAULT = 0
-                                    // For now, we'll store this information in a comment or ignore it
-                                    // since SortKey doesn't have a nulls_first field
                                     if (sort_by["sortby_nulls"].is_string()) {
                                         const std::string nulls_order = sort_by["sortby_nulls"].get<std::string>();
-                                        // Could store or process NULLS FIRST/LAST information here
+                                        if (nulls_order == "SORTBY_NULLS_FIRST") {
+                                            key.nulls_first = true;
+                                        } else if (nulls_order == "SORTBY_NULLS_LAST") {
+                                            key.nulls_first = false;
+                                        }
                                     } else if (sort_by["sortby_nulls"].is_number()) {
                                         const int nulls_order = sort_by["sortby_nulls"].get<int>();
-                                        // Could store or process NULLS FIRST/LAST information here
+                                        if (nulls_order == 1) {
+                                            key.nulls_first = true;
+                                        } else if (nulls_order == 2) {
+                                            key.nulls_first = false;
+                                        }
                                     }
                                 }
                                 
@@ -1041,6 +1458,16 @@ namespace db25 {
     }
 
     std::optional<size_t> QueryPlanner::extract_limit_from_ast(const std::string& query) const {
+        return extract_limit_clause_from_ast(query, "limitCount");
+    }
+
+    std::optional<size_t> QueryPlanner::extract_offset_from_ast(const std::string& query) const {
+        return extract_limit_clause_from_ast(query, "limitOffset");
+    }
+
+    // Reads the constant of a LIMIT ("limitCount") or OFFSET ("limitOffset") clause
+    std::optional<size_t> QueryPlanner::extract_limit_clause_from_ast(const std::string& query,
+                                                                      const std::string& clause) const {
         try {
             PgQueryParseResult parse_result = pg_query_parse(query.c_str());
 
@@ -1060,10 +1487,10 @@ namespace db25 {
                 if (stmt.contains("stmt") && stmt["stmt"].contains("SelectStmt")) {
                     const auto& select_stmt = stmt["stmt"]["SelectStmt"];
 
-                    if (select_stmt.contains("limitCount") && !select_stmt["limitCount"].is_null()) {
-                        const auto& limit_node = select_stmt["limitCount"];
+                    if (select_stmt.contains(clause) && !select_stmt[clause].is_null()) {
+                        const auto& limit_node = select_stmt[clause];
                         
-                        // LIMIT value should be a constant (A_Const)
+                        // LIMIT/OFFSET value should be a constant (A_Const)
                         if (limit_node.contains("A_Const")) {
                             const auto& const_node = limit_node["A_Const"];
                             
@@ -1073,6 +1500,9 @@ namespace db25 {
                                 if (limit_value >= 0) {
                                     return static_cast<size_t>(limit_value);
                                 }
+                            } else if (const_node.contains("ival")) {
+                                // Zero-valued fields are omitted from the JSON tree: {"ival": {}}
+                                return 0;
                             }
                             
                             // Handle string representation of numbers (less common)
@@ -1169,8 +1599,8 @@ namespace db25 {
     }
 
     LogicalPlanNodePtr QueryPlanner::build_scan_node(const std::string &table_name, const std::string &alias) { //NOLINT:static
-        // TODO: Check if we can use an index scan
-        // For now, always use table scan
+        // Filters reach the scan only after predicate pushdown, so the memo
+        // search chooses among its index scans
         auto scan_node = std::make_shared<TableScanNode>(table_name);
         scan_node->alias = alias.empty() ? table_name : alias;
         return scan_node;
@@ -1271,25 +1701,6 @@ namespace db25 {
         return conditions;
     }
 
-    LogicalPlanNodePtr QueryPlanner::optimize_join_order(const std::vector<LogicalPlanNodePtr> &tables,
-                                                         const std::vector<ExpressionPtr> &join_conditions) {
-        if (tables.size() == 1) {
-            return tables[0];
-        }
-
-        if (tables.size() == 2) {
-            return build_join_node(tables[0], tables[1], JoinType::INNER, join_conditions);
-        }
-
-        // For more than 2 tables, use simple left-deep join tree
-        LogicalPlanNodePtr result = tables[0];
-        for (size_t i = 1; i < tables.size(); ++i) {
-            result = build_join_node(result, tables[i], JoinType::INNER, join_conditions);
-        }
-
-        return result;
-    }
-
     // NOLINTNEXTLINE: xyz
     std::vector<ExpressionPtr> QueryPlanner::extract_join_conditions(const std::string &query) const {
         std::vector<ExpressionPtr> conditions;
@@ -1310,20 +1721,56 @@ namespace db25 {
 
     double QueryPlanner::estimate_table_scan_cost(const std::string &table_name) const {
         const auto stats = get_table_stats(table_name);
-        const double pages = (stats.row_count * stats.avg_row_size) / 8192.0; // 8KB pages
-        return pages * config_.seq_page_cost + stats.row_count * config_.cpu_tuple_cost;
+        const double pages = (stats->row_count * stats->avg_row_size) / 8192.0; // 8KB pages
+        return pages * config_.seq_page_cost + stats->row_count * config_.cpu_tuple_cost;
     }
 
     double QueryPlanner::estimate_index_scan_cost(const std::string &table_name,
                                                   const std::string &index_name,
                                                   const double selectivity) const {
         const auto stats = get_table_stats(table_name);
-        const double index_pages = std::log2(stats.row_count) * selectivity; // Simplified B-tree cost
-        const double data_pages = (stats.row_count * selectivity * stats.avg_row_size) / 8192.0;
+        const double index_pages = std::log2(stats->row_count) * selectivity; // Simplified B-tree cost
+        const double data_pages = (stats->row_count * selectivity * stats->avg_row_size) / 8192.0;
 
         return index_pages * config_.random_page_cost +
                data_pages * config_.random_page_cost +
-               stats.row_count * selectivity * config_.cpu_index_tuple_cost;
+               stats->row_count * selectivity * config_.cpu_index_tuple_cost;
+    }
+
+    std::optional<std::string> QueryPlanner::select_best_index(const std::string &table_name,
+                                                               const std::vector<ExpressionPtr> &conditions) const {
+        const auto table = schema_ ? schema_->get_table(table_name) : std::nullopt;
+        if (!table || !config_.enable_index_scans) return std::nullopt;
+
+        std::optional<std::string> best;
+        double best_cost = estimate_table_scan_cost(table_name);
+        for (const auto &index: table->indexes) {
+            if (index.type != "BTREE") continue;
+            std::vector<ExpressionPtr> index_conditions;
+            std::vector<ExpressionPtr> residual;
+            if (match_index_conditions(index, conditions, index_conditions, residual) == 0) continue;
+
+            const double cost = estimate_index_scan_cost(table_name, index.name,
+                                                         estimate_selectivity(index_conditions, table_name));
+            if (cost < best_cost) {
+                best = index.name;
+                best_cost = cost;
+            }
+        }
+        return best;
+    }
+
+    bool QueryPlanner::can_use_index_for_condition(const ExpressionPtr &condition, const std::string &table_name,
+                                                   const std::string &index_name) const {
+        const auto table = schema_ ? schema_->get_table(table_name) : std::nullopt;
+        if (!table) return false;
+        for (const auto &index: table->indexes) {
+            if (index.name != index_name || index.type != "BTREE") continue;
+            std::vector<ExpressionPtr> index_conditions;
+            std::vector<ExpressionPtr> residual;
+            return match_index_conditions(index, {condition}, index_conditions, residual) > 0;
+        }
+        return false;
     }
 
     double QueryPlanner::estimate_join_cost_internal(JoinType join_type,
@@ -1396,43 +1843,1350 @@ namespace db25 {
         return transform_node(node);
     }
 
-    LogicalPlanNodePtr PredicatePushdownTransformer::transform_node(LogicalPlanNodePtr node) {
-        // Simplified predicate pushdown - move selection below projection
-        if (node->type == PlanNodeType::PROJECTION && !node->children.empty()) {
-            auto child = node->children[0];
-            if (child->type == PlanNodeType::SELECTION) {
-                // Swap projection and selection
-                auto proj_node = std::static_pointer_cast<ProjectionNode>(node);
-                auto sel_node = std::static_pointer_cast<SelectionNode>(child);
+    // Adds the names of the columns expr reads to columns ("alias.column" or a
+    // bare "column"). Returns false if they cannot be known: a subquery may
+    // read any column of the outer query.
+    static bool collect_referenced_columns(const ExpressionPtr &expr, std::set<std::string> &columns) { // NOLINT(misc-no-recursion)
+        if (!expr) return true;
+
+        switch (expr->type) {
+            case ExpressionType::SUBQUERY:
+                return false;
+
+            case ExpressionType::COLUMN_REF: {
+                const std::string name = expr->column_ref
+                    ? expr->column_ref->full_name() : expr->value.substr(0, expr->value.find(" AS "));
+                if (name.empty() || name.back() == '*') return false; // "*" and "t.*" read every column
+                columns.insert(name);
+                return true;
+            }
+
+            case ExpressionType::CONSTANT:
+                return true;
+
+            default:
+                break;
+        }
+
+        if (expr->children.empty() && !expr->value.empty()) {
+            // Condition kept as text: keep every identifier that could be a column
+            static const std::regex identifier(R"([A-Za-z_][A-Za-z0-9_]*(\.[A-Za-z_][A-Za-z0-9_]*)?)");
+            for (auto it = std::sregex_iterator(expr->value.begin(), expr->value.end(), identifier);
+                 it != std::sregex_iterator(); ++it) {
+                columns.insert(it->str());
+            }
+            return true;
+        }
+
+        for (const auto &child: expr->children) {
+            if (!collect_referenced_columns(child, columns)) return false;
+        }
+        return true;
+    }
+
+    static bool collect_referenced_columns(const std::vector<ExpressionPtr> &exprs, std::set<std::string> &columns) {
+        for (const auto &expr: exprs) {
+            if (!collect_referenced_columns(expr, columns)) return false;
+        }
+        return true;
+    }
+
+    void collect_relations(const LogicalPlanNodePtr &node, // NOLINT(misc-no-recursion)
+                           std::map<std::string, std::string> &relations) {
+        if (!node) return;
+        if (node->type == PlanNodeType::TABLE_SCAN) {
+            const auto scan = std::static_pointer_cast<TableScanNode>(node);
+            relations[scan->alias.empty() ? scan->table_name : scan->alias] = scan->table_name;
+        } else if (node->type == PlanNodeType::INDEX_SCAN) {
+            const auto scan = std::static_pointer_cast<IndexScanNode>(node);
+            relations[scan->alias.empty() ? scan->table_name : scan->alias] = scan->table_name;
+        }
+        for (const auto &child: node->children) {
+            collect_relations(child, relations);
+        }
+    }
 
-                if (!sel_node->children.empty()) {
-                    proj_node->children[0] = sel_node->children[0];
-                    sel_node->children[0] = proj_node;
-                    return sel_node;
+    // Adds the relation a column name belongs to. The schema attributes
+    // unqualified names; without it only a single relation is certain.
+    static bool resolve_relation(const std::string &column, const std::map<std::string, std::string> &relations,
+                                 const DatabaseSchema *schema, std::set<std::string> &referenced) {
+        const size_t dot = column.rfind('.');
+        if (dot != std::string::npos) {
+            const std::string qualifier = column.substr(0, dot);
+            if (relations.count(qualifier)) {
+                referenced.insert(qualifier);
+                return true;
+            }
+            // Unaliased scans may be qualified by their table name
+            for (const auto &[alias, table_name]: relations) {
+                if (table_name == qualifier && alias == table_name) {
+                    referenced.insert(alias);
+                    return true;
                 }
             }
+            return false;
         }
 
-        return node;
+        if (relations.size() == 1) {
+            referenced.insert(relations.begin()->first);
+            return true;
+        }
+        if (!schema) return false;
+
+        // A bare name belongs to the one scanned table that has such a column
+        std::string owner;
+        for (const auto &[alias, table_name]: relations) {
+            const auto table = schema->get_table(table_name);
+            if (!table) return false;
+            const bool has_column = std::any_of(table->columns.begin(), table->columns.end(),
+                                                [&column](const Column &c) { return c.name == column; });
+            if (has_column) {
+                if (!owner.empty()) return false;
+                owner = alias;
+            }
+        }
+        if (owner.empty()) return false;
+        referenced.insert(owner);
+        return true;
     }
 
-    LogicalPlanNodePtr ProjectionPushdownTransformer::transform_node(LogicalPlanNodePtr node) {
-        // Simplified projection pushdown
-        return node;
+    // "alias.column" of a column reference, if it resolves to one relation
+    static bool qualified_column(const ExpressionPtr &expr, const std::map<std::string, std::string> &relations,
+                                 const DatabaseSchema *schema, std::string &key) {
+        if (!expr || expr->type != ExpressionType::COLUMN_REF) return false;
+        const std::string name = expr->column_ref ? expr->column_ref->full_name() : expr->value;
+        std::set<std::string> referenced;
+        if (!resolve_relation(name, relations, schema, referenced) || referenced.size() != 1) return false;
+        const size_t dot = name.rfind('.');
+        key = *referenced.begin() + "." + (dot == std::string::npos ? name : name.substr(dot + 1));
+        return true;
+    }
+
+    // NOLINTNEXTLINE(misc-no-recursion)
+    bool referenced_relations(const ExpressionPtr &predicate, const std::map<std::string, std::string> &relations,
+                              const DatabaseSchema *schema, std::set<std::string> &referenced) {
+        if (!predicate) return true;
+
+        switch (predicate->type) {
+            case ExpressionType::SUBQUERY:
+                // May be correlated with any outer relation
+                return false;
+            case ExpressionType::CONSTANT:
+                return true;
+            case ExpressionType::COLUMN_REF:
+                return resolve_relation(predicate->column_ref ? predicate->column_ref->full_name() : predicate->value,
+                                        relations, schema, referenced);
+            default:
+                break;
+        }
+
+        if (predicate->children.empty() && !predicate->value.empty()) {
+            // Condition kept as text: its column names cannot be told from
+            // literals or keywords, so only a single relation is certain
+            if (relations.size() != 1) return false;
+            referenced.insert(relations.begin()->first);
+            return true;
+        }
+
+        return std::all_of(predicate->children.begin(), predicate->children.end(),
+                           [&](const ExpressionPtr &child) { return referenced_relations(child, relations, schema, referenced); });
+    }
+
+    static LogicalPlanNodePtr add_selection(const LogicalPlanNodePtr &node, std::vector<ExpressionPtr> conditions) {
+        if (conditions.empty()) return node;
+        auto selection = std::make_shared<SelectionNode>();
+        selection->conditions = std::move(conditions);
+        selection->children.push_back(node);
+        return selection;
+    }
+
+    static bool is_subset(const std::set<std::string> &subset, const std::map<std::string, std::string> &relations) {
+        return std::all_of(subset.begin(), subset.end(),
+                           [&relations](const std::string &alias) { return relations.count(alias) > 0; });
     }
 
-    LogicalPlanNodePtr JoinReorderingTransformer::transform_node(LogicalPlanNodePtr node) {
-        // Simplified join reordering based on cost
-        if (node->type == PlanNodeType::NESTED_LOOP_JOIN && node->children.size() == 2) {
-            auto left = node->children[0];
-            auto right = node->children[1];
+    static void split_conjuncts(const std::vector<ExpressionPtr> &conditions, // NOLINT(misc-no-recursion)
+                                std::vector<ExpressionPtr> &conjuncts) {
+        for (const auto &condition: conditions) {
+            if (!condition) continue;
+            if (condition->type == ExpressionType::BINARY_OP && condition->value == "AND" &&
+                !condition->children.empty()) {
+                split_conjuncts(condition->children, conjuncts);
+            } else {
+                conjuncts.push_back(condition);
+            }
+        }
+    }
 
-            // If right child has fewer estimated rows, swap to make it the outer relation
-            if (right->cost.estimated_rows < left->cost.estimated_rows) {
-                std::swap(node->children[0], node->children[1]);
+    // Whether some join below node lists conjunct in its conditions and scans
+    // every relation in referenced. A conjunct listed by several joins, as in
+    // hand-built plans, belongs to the lowest one.
+    static bool held_by_lower_join(const LogicalPlanNodePtr &node, const Expression *conjunct, // NOLINT(misc-no-recursion)
+                                   const std::set<std::string> &referenced) {
+        if (!node) return false;
+        if (const auto join = std::dynamic_pointer_cast<JoinNode>(node)) {
+            std::vector<ExpressionPtr> conditions;
+            split_conjuncts(join->join_conditions, conditions);
+            const bool holds = std::any_of(conditions.begin(), conditions.end(),
+                                           [conjunct](const ExpressionPtr &c) { return c.get() == conjunct; });
+            if (holds) {
+                std::map<std::string, std::string> relations;
+                collect_relations(node, relations);
+                if (is_subset(referenced, relations)) return true;
             }
         }
+        return std::any_of(node->children.begin(), node->children.end(),
+                           [&](const LogicalPlanNodePtr &child) { return held_by_lower_join(child, conjunct, referenced); });
+    }
 
-        return node;
+    // Whether a NULL in any column makes the expression NULL
+    static bool is_strict(const ExpressionPtr &expr) { // NOLINT(misc-no-recursion)
+        if (!expr) return false;
+        switch (expr->type) {
+            case ExpressionType::COLUMN_REF:
+            case ExpressionType::CONSTANT:
+                return true;
+            case ExpressionType::BINARY_OP:
+            case ExpressionType::UNARY_OP: {
+                static const std::set<std::string> strict_operators = {
+                    "=", "<>", "!=", "<", "<=", ">", ">=", "+", "-", "*", "/", "%", "||"
+                };
+                return !expr->children.empty() && strict_operators.count(expr->value) &&
+                       std::all_of(expr->children.begin(), expr->children.end(), is_strict);
+            }
+            case ExpressionType::FUNCTION_CALL: {
+                static const std::set<std::string> strict_functions = {"upper", "lower", "length", "abs"};
+                return strict_functions.count(expr->value) &&
+                       std::all_of(expr->children.begin(), expr->children.end(), is_strict);
+            }
+            default:
+                return false;
+        }
+    }
+
+    // A comparison that is never true when its columns are NULL discards
+    // every row an outer join pads with NULLs
+    static bool rejects_nulls(const ExpressionPtr &predicate) {
+        static const std::set<std::string> comparisons = {"=", "<>", "!=", "<", "<=", ">", ">="};
+        return predicate && predicate->type == ExpressionType::BINARY_OP && comparisons.count(predicate->value) &&
+               is_strict(predicate);
+    }
+
+    // Selections and inner joins stacked directly on each other share one set of conjuncts
+    struct JoinBlock {
+        std::vector<std::vector<ExpressionPtr> *> condition_lists;
+        std::vector<std::shared_ptr<JoinNode> > joins;
+        std::vector<LogicalPlanNodePtr> inputs; // Operators right below the block
+    };
+
+    static bool extends_join_block(const LogicalPlanNodePtr &node) {
+        if (node->type == PlanNodeType::SELECTION) return true;
+        const auto join = std::dynamic_pointer_cast<JoinNode>(node);
+        return join && (join->join_type == JoinType::INNER || join->join_type == JoinType::CROSS);
+    }
+
+    static void gather_join_block(const LogicalPlanNodePtr &node, JoinBlock &block) { // NOLINT(misc-no-recursion)
+        if (node->type == PlanNodeType::SELECTION) {
+            block.condition_lists.push_back(&std::static_pointer_cast<SelectionNode>(node)->conditions);
+        } else {
+            auto join = std::static_pointer_cast<JoinNode>(node);
+            block.condition_lists.push_back(&join->join_conditions);
+            block.joins.push_back(std::move(join));
+        }
+        for (const auto &child: node->children) {
+            if (child && extends_join_block(child)) {
+                gather_join_block(child, block);
+            } else if (child) {
+                block.inputs.push_back(child);
+            }
+        }
+    }
+
+    // Union-find over "alias.column" names
+    class ColumnEquivalence {
+    public:
+        std::string find(const std::string &column) {
+            auto it = parent_.find(column);
+            if (it == parent_.end()) {
+                parent_.emplace(column, column);
+                return column;
+            }
+            if (it->second == column) return column;
+            it->second = find(it->second);
+            return it->second;
+        }
+
+        void unite(const std::string &a, const std::string &b) { parent_[find(a)] = find(b); }
+
+        bool same(const std::string &a, const std::string &b) { return find(a) == find(b); }
+
+        std::vector<std::string> members(const std::string &column) {
+            std::vector<std::string> result;
+            const std::string root = find(column);
+            for (const auto &entry: parent_) {
+                if (find(entry.first) == root) result.push_back(entry.first);
+            }
+            return result;
+        }
+
+    private:
+        std::map<std::string, std::string> parent_;
+    };
+
+    bool PredicatePushdownTransformer::column_key(const ExpressionPtr &expr, const RelationMap &relations,
+                                                  std::string &key) const {
+        return qualified_column(expr, relations, schema_.get(), key);
+    }
+
+    void PredicatePushdownTransformer::infer_implied_predicates(const LogicalPlanNodePtr &node) { // NOLINT(misc-no-recursion)
+        if (!node) return;
+        if (!extends_join_block(node)) {
+            for (const auto &child: node->children) {
+                infer_implied_predicates(child);
+            }
+            return;
+        }
+
+        JoinBlock block;
+        gather_join_block(node, block);
+        RelationMap relations;
+        collect_relations(node, relations);
+
+        // Conjunct lists are conjunctions, so AND trees can be flattened in place
+        std::vector<ExpressionPtr> conjuncts;
+        std::unordered_set<const Expression *> seen;
+        for (auto *list: block.condition_lists) {
+            std::vector<ExpressionPtr> flat;
+            split_conjuncts(*list, flat);
+            *list = flat;
+            for (auto &conjunct: flat) {
+                if (seen.insert(conjunct.get()).second) conjuncts.push_back(conjunct);
+            }
+        }
+
+        struct Equality {
+            ExpressionPtr conjunct;
+            std::string left;
+            std::string right;
+        };
+        struct Restriction {
+            std::string column;
+            std::string op;
+            ExpressionPtr constant;
+        };
+        static const std::map<std::string, std::string> mirrored = {
+            {"=", "="}, {"<", ">"}, {"<=", ">="}, {">", "<"}, {">=", "<="}
+        };
+
+        std::vector<Equality> equalities;
+        std::vector<Restriction> restrictions;
+        std::map<std::string, ExpressionPtr> column_exprs;
+        ColumnEquivalence classes;
+        for (const auto &conjunct: conjuncts) {
+            if (conjunct->type != ExpressionType::BINARY_OP || conjunct->children.size() != 2 ||
+                !mirrored.count(conjunct->value)) {
+                continue;
+            }
+            const auto &lhs = conjunct->children[0];
+            const auto &rhs = conjunct->children[1];
+            std::string left;
+            std::string right;
+            const bool left_column = column_key(lhs, relations, left);
+            const bool right_column = column_key(rhs, relations, right);
+            if (left_column && right_column && conjunct->value == "=" && left != right) {
+                equalities.push_back({conjunct, left, right});
+                classes.unite(left, right);
+                column_exprs.emplace(left, lhs);
+                column_exprs.emplace(right, rhs);
+            } else if (left_column && rhs->type == ExpressionType::CONSTANT && !rhs->value.empty()) {
+                restrictions.push_back({left, conjunct->value, rhs});
+                column_exprs.emplace(left, lhs);
+            } else if (right_column && lhs->type == ExpressionType::CONSTANT && !lhs->value.empty()) {
+                restrictions.push_back({right, mirrored.at(conjunct->value), lhs});
+                column_exprs.emplace(right, rhs);
+            }
+        }
+        if (equalities.empty()) {
+            for (const auto &input: block.inputs) {
+                infer_implied_predicates(input);
+            }
+            return;
+        }
+
+        // Copy every restriction to the other members of its class
+        std::set<std::string> known;
+        for (const auto &r: restrictions) {
+            known.insert(r.column + " " + r.op + " " + r.constant->value);
+        }
+        std::vector<ExpressionPtr> implied;
+        std::set<std::string> constant_classes;
+        for (const auto &r: restrictions) {
+            if (r.op == "=") constant_classes.insert(classes.find(r.column));
+            for (const auto &member: classes.members(r.column)) {
+                if (!known.insert(member + " " + r.op + " " + r.constant->value).second) continue;
+                auto predicate = std::make_shared<Expression>(ExpressionType::BINARY_OP, r.op);
+                predicate->children = {column_exprs.at(member), r.constant};
+                implied.push_back(predicate);
+            }
+        }
+
+        // Relations of the lowest join that sees both sides of an equality
+        const auto scope_of = [&](const Equality &e) {
+            const std::string left_alias = e.left.substr(0, e.left.rfind('.'));
+            const std::string right_alias = e.right.substr(0, e.right.rfind('.'));
+            RelationMap scope = relations;
+            for (const auto &join: block.joins) {
+                RelationMap join_relations;
+                collect_relations(join, join_relations);
+                if (join_relations.count(left_alias) && join_relations.count(right_alias) &&
+                    join_relations.size() < scope.size()) {
+                    scope = std::move(join_relations);
+                }
+            }
+            return scope;
+        };
+        const auto in_scope = [](const std::string &column, const RelationMap &scope) {
+            return scope.count(column.substr(0, column.rfind('.'))) > 0;
+        };
+
+        // An equality is redundant when both sides are pinned to one constant,
+        // or when the equalities kept so far connect its sides within the
+        // join where it would be evaluated
+        std::unordered_set<const Expression *> redundant;
+        for (size_t i = 0; i < equalities.size(); ++i) {
+            const Equality &e = equalities[i];
+            bool implied_by_rest = constant_classes.count(classes.find(e.left)) > 0;
+            if (!implied_by_rest) {
+                const RelationMap scope = scope_of(e);
+                ColumnEquivalence rest;
+                for (size_t j = 0; j < equalities.size(); ++j) {
+                    const Equality &other = equalities[j];
+                    if (j == i || redundant.count(other.conjunct.get()) ||
+                        !in_scope(other.left, scope) || !in_scope(other.right, scope)) {
+                        continue;
+                    }
+                    rest.unite(other.left, other.right);
+                }
+                implied_by_rest = rest.same(e.left, e.right);
+            }
+            if (implied_by_rest) redundant.insert(e.conjunct.get());
+        }
+
+        for (auto *list: block.condition_lists) {
+            list->erase(std::remove_if(list->begin(), list->end(), [&redundant](const ExpressionPtr &conjunct) {
+                return redundant.count(conjunct.get()) > 0;
+            }), list->end());
+        }
+        // Pushdown routes the implied predicates from the top of the block
+        block.condition_lists.front()->insert(block.condition_lists.front()->end(), implied.begin(), implied.end());
+
+        for (const auto &input: block.inputs) {
+            infer_implied_predicates(input);
+        }
+    }
+
+    LogicalPlanNodePtr PredicatePushdownTransformer::transform(const LogicalPlanNodePtr &node) {
+        placed_.clear();
+        infer_implied_predicates(node);
+        return push_down(node, {});
+    }
+
+    LogicalPlanNodePtr PredicatePushdownTransformer::push_down(const LogicalPlanNodePtr &node, // NOLINT(misc-no-recursion)
+                                                               std::vector<ExpressionPtr> predicates) {
+        if (!node) return nullptr;
+
+        switch (node->type) {
+            case PlanNodeType::SELECTION: {
+                // The selection dissolves into the predicates routed below it
+                std::vector<ExpressionPtr> conjuncts;
+                split_conjuncts(std::static_pointer_cast<SelectionNode>(node)->conditions, conjuncts);
+                for (auto &conjunct: conjuncts) {
+                    if (placed_.insert(conjunct.get()).second) predicates.push_back(std::move(conjunct));
+                }
+                if (node->children.empty()) return add_selection(node, std::move(predicates));
+                return push_down(node->children[0], std::move(predicates));
+            }
+
+            case PlanNodeType::PROJECTION:
+            case PlanNodeType::SORT: {
+                // Filtering commutes with both, except on a name the projection introduces
+                std::set<std::string> aliases;
+                if (node->type == PlanNodeType::PROJECTION) {
+                    for (const auto &projection: std::static_pointer_cast<ProjectionNode>(node)->projections) {
+                        const size_t as = projection->value.find(" AS ");
+                        if (as != std::string::npos) aliases.insert(projection->value.substr(as + 4));
+                    }
+                }
+                std::vector<ExpressionPtr> below;
+                std::vector<ExpressionPtr> above;
+                for (auto &predicate: predicates) {
+                    std::set<std::string> columns;
+                    const bool known = collect_referenced_columns(predicate, columns);
+                    const bool renamed = std::any_of(columns.begin(), columns.end(),
+                                                     [&aliases](const std::string &c) { return aliases.count(c) > 0; });
+                    (known && !renamed ? below : above).push_back(std::move(predicate));
+                }
+                for (auto &child: node->children) {
+                    child = push_down(child, below);
+                    below.clear();
+                }
+                return add_selection(node, std::move(above));
+            }
+
+            case PlanNodeType::TABLE_SCAN:
+            case PlanNodeType::INDEX_SCAN: {
+                RelationMap relations;
+                collect_relations(node, relations);
+                auto &filters = node->type == PlanNodeType::TABLE_SCAN
+                                    ? std::static_pointer_cast<TableScanNode>(node)->filter_conditions
+                                    : std::static_pointer_cast<IndexScanNode>(node)->filter_conditions;
+                std::vector<ExpressionPtr> above;
+                for (auto &predicate: predicates) {
+                    std::set<std::string> referenced;
+                    if (referenced_relations(predicate, relations, schema_.get(), referenced)) {
+                        filters.push_back(std::move(predicate));
+                    } else {
+                        above.push_back(std::move(predicate));
+                    }
+                }
+                return add_selection(node, std::move(above));
+            }
+
+            case PlanNodeType::NESTED_LOOP_JOIN:
+            case PlanNodeType::HASH_JOIN:
+            case PlanNodeType::MERGE_JOIN: {
+                const auto join = std::dynamic_pointer_cast<JoinNode>(node);
+                if (!join || node->children.size() != 2) break;
+
+                RelationMap left_relations;
+                RelationMap right_relations;
+                collect_relations(node->children[0], left_relations);
+                collect_relations(node->children[1], right_relations);
+                RelationMap relations = left_relations;
+                relations.insert(right_relations.begin(), right_relations.end());
+
+                enum class Side { LEFT, RIGHT, BOTH };
+                const auto side_of = [&](const ExpressionPtr &predicate) {
+                    std::set<std::string> referenced;
+                    if (!referenced_relations(predicate, relations, schema_.get(), referenced)) return Side::BOTH;
+                    if (is_subset(referenced, left_relations)) return Side::LEFT;
+                    if (is_subset(referenced, right_relations)) return Side::RIGHT;
+                    return Side::BOTH;
+                };
+
+                // A WHERE predicate that fails on the NULLs an outer join pads
+                // the other side with leaves only the rows an inner join returns
+                const auto rejects_padding = [&](const RelationMap &padded_relations) {
+                    return std::any_of(predicates.begin(), predicates.end(), [&](const ExpressionPtr &predicate) {
+                        std::set<std::string> referenced;
+                        return rejects_nulls(predicate) &&
+                               referenced_relations(predicate, relations, schema_.get(), referenced) &&
+                               std::any_of(referenced.begin(), referenced.end(), [&](const std::string &alias) {
+                                   return padded_relations.count(alias) > 0;
+                               });
+                    });
+                };
+                if (((join->join_type == JoinType::LEFT || join->join_type == JoinType::LEFT_OUTER) &&
+                     rejects_padding(right_relations)) ||
+                    ((join->join_type == JoinType::RIGHT || join->join_type == JoinType::RIGHT_OUTER) &&
+                     rejects_padding(left_relations))) {
+                    join->join_type = JoinType::INNER;
+                }
+
+                const JoinType type = join->join_type;
+                const bool inner = type == JoinType::INNER || type == JoinType::CROSS;
+                const bool left_preserved = type == JoinType::LEFT || type == JoinType::LEFT_OUTER;
+                const bool right_preserved = type == JoinType::RIGHT || type == JoinType::RIGHT_OUTER;
+                const bool semi = type == JoinType::SEMI || type == JoinType::ANTI;
+
+                std::vector<ExpressionPtr> left_predicates;
+                std::vector<ExpressionPtr> right_predicates;
+                std::vector<ExpressionPtr> conditions;
+                std::vector<ExpressionPtr> above;
+
+                // WHERE predicates may only filter a side whose rows reach the output unpadded
+                for (auto &predicate: predicates) {
+                    const Side side = side_of(predicate);
+                    if (side == Side::LEFT && (inner || left_preserved || semi)) {
+                        left_predicates.push_back(std::move(predicate));
+                    } else if (side == Side::RIGHT && (inner || right_preserved)) {
+                        right_predicates.push_back(std::move(predicate));
+                    } else if (inner) {
+                        conditions.push_back(std::move(predicate));
+                    } else {
+                        above.push_back(std::move(predicate));
+                    }
+                }
+
+                // ON conjuncts may filter the side that is padded, never the preserved one
+                std::vector<ExpressionPtr> on_conditions;
+                split_conjuncts(join->join_conditions, on_conditions);
+                for (auto &condition: on_conditions) {
+                    std::set<std::string> referenced;
+                    const bool known = referenced_relations(condition, relations, schema_.get(), referenced);
+                    if (placed_.count(condition.get()) ||
+                        (known && (held_by_lower_join(node->children[0], condition.get(), referenced) ||
+                                   held_by_lower_join(node->children[1], condition.get(), referenced)))) {
+                        continue;
+                    }
+                    placed_.insert(condition.get());
+
+                    const Side side = side_of(condition);
+                    if (side == Side::LEFT && (inner || right_preserved || type == JoinType::SEMI)) {
+                        left_predicates.push_back(std::move(condition));
+                    } else if (side == Side::RIGHT && (inner || left_preserved || semi)) {
+                        right_predicates.push_back(std::move(condition));
+                    } else {
+                        conditions.push_back(std::move(condition));
+                    }
+                }
+
+                join->join_conditions = std::move(conditions);
+                node->children[0] = push_down(node->children[0], std::move(left_predicates));
+                node->children[1] = push_down(node->children[1], std::move(right_predicates));
+                return add_selection(node, std::move(above));
+            }
+
+            default:
+                break;
+        }
+
+        // Other operators (LIMIT, aggregation) change which rows a filter sees
+        for (auto &child: node->children) {
+            child = push_down(child, {});
+        }
+        return add_selection(node, std::move(predicates));
+    }
+
+    LogicalPlanNodePtr ProjectionPushdownTransformer::transform(const LogicalPlanNodePtr &node) {
+        push_down(node, {}, false);
+        return node;
+    }
+
+    void ProjectionPushdownTransformer::push_down(const LogicalPlanNodePtr &node, // NOLINT(misc-no-recursion)
+                                                  std::set<std::string> required, bool projected) {
+        if (!node) return;
+
+        // "*" stands for every column once some reference cannot be resolved
+        const auto require = [&required](const auto &exprs) {
+            if (!collect_referenced_columns(exprs, required)) required.insert("*");
+        };
+
+        switch (node->type) {
+            case PlanNodeType::PROJECTION:
+                // Columns named above that the SELECT list drops (ORDER BY on an
+                // unselected column) stay in the set and still reach the scans
+                require(std::static_pointer_cast<ProjectionNode>(node)->projections);
+                projected = true;
+                break;
+
+            case PlanNodeType::SELECTION:
+                require(std::static_pointer_cast<SelectionNode>(node)->conditions);
+                break;
+
+            case PlanNodeType::SORT:
+                for (const auto &key: std::static_pointer_cast<SortNode>(node)->sort_keys) {
+                    require(key.expression);
+                }
+                break;
+
+            case PlanNodeType::LIMIT:
+                break;
+
+            case PlanNodeType::NESTED_LOOP_JOIN:
+            case PlanNodeType::HASH_JOIN:
+            case PlanNodeType::MERGE_JOIN:
+                if (const auto join = std::dynamic_pointer_cast<JoinNode>(node)) {
+                    require(join->join_conditions);
+                }
+                break;
+
+            case PlanNodeType::TABLE_SCAN: {
+                const auto scan = std::static_pointer_cast<TableScanNode>(node);
+                require(scan->filter_conditions);
+                if (projected && required.count("*") == 0) {
+                    scan->required_columns.assign(required.begin(), required.end());
+                }
+                return;
+            }
+
+            case PlanNodeType::INDEX_SCAN: {
+                const auto scan = std::static_pointer_cast<IndexScanNode>(node);
+                require(scan->index_conditions);
+                require(scan->filter_conditions);
+                if (projected && required.count("*") == 0) {
+                    scan->required_columns.assign(required.begin(), required.end());
+                }
+                return;
+            }
+
+            default:
+                // Operators whose column use is not tracked keep their whole input
+                required.insert("*");
+                break;
+        }
+
+        for (const auto &child: node->children) {
+            push_down(child, required, projected);
+        }
+    }
+
+    // Equalities of join conditions between a column of each side, as
+    // (left "alias.column", right "alias.column")
+    static std::vector<std::pair<std::string, std::string> > join_equalities(const LogicalPlanNodePtr &join,
+                                                                             const DatabaseSchema *schema) {
+        std::map<std::string, std::string> left_relations;
+        std::map<std::string, std::string> right_relations;
+        collect_relations(join->children[0], left_relations);
+        collect_relations(join->children[1], right_relations);
+        std::map<std::string, std::string> relations = left_relations;
+        relations.insert(right_relations.begin(), right_relations.end());
+
+        std::vector<ExpressionPtr> conjuncts;
+        split_conjuncts(std::static_pointer_cast<JoinNode>(join)->join_conditions, conjuncts);
+        std::vector<std::pair<std::string, std::string> > equalities;
+        for (const auto &conjunct: conjuncts) {
+            std::string a;
+            std::string b;
+            if (conjunct->type != ExpressionType::BINARY_OP || conjunct->value != "=" ||
+                conjunct->children.size() != 2 || !qualified_column(conjunct->children[0], relations, schema, a) ||
+                !qualified_column(conjunct->children[1], relations, schema, b)) {
+                continue;
+            }
+            const auto on_left = [&left_relations](const std::string &key) {
+                return left_relations.count(key.substr(0, key.rfind('.'))) > 0;
+            };
+            if (on_left(a) && !on_left(b)) equalities.emplace_back(a, b);
+            if (on_left(b) && !on_left(a)) equalities.emplace_back(b, a);
+        }
+        return equalities;
+    }
+
+    // Whether some key is made of columns in columns
+    static bool covers_key(const std::vector<std::set<std::string> > &keys, const std::set<std::string> &columns) {
+        return std::any_of(keys.begin(), keys.end(), [&columns](const std::set<std::string> &key) {
+            return std::includes(columns.begin(), columns.end(), key.begin(), key.end());
+        });
+    }
+
+    std::vector<std::set<std::string> > unique_keys(const LogicalPlanNodePtr &node, // NOLINT(misc-no-recursion)
+                                                    const DatabaseSchema *schema) {
+        std::vector<std::set<std::string> > keys;
+        if (!node) return keys;
+
+        switch (node->type) {
+            case PlanNodeType::TABLE_SCAN:
+            case PlanNodeType::INDEX_SCAN: {
+                std::string table_name;
+                std::string alias;
+                if (node->type == PlanNodeType::TABLE_SCAN) {
+                    const auto scan = std::static_pointer_cast<TableScanNode>(node);
+                    table_name = scan->table_name;
+                    alias = scan->alias;
+                } else {
+                    const auto scan = std::static_pointer_cast<IndexScanNode>(node);
+                    table_name = scan->table_name;
+                    alias = scan->alias;
+                }
+                const auto table = schema ? schema->get_table(table_name) : std::nullopt;
+                if (!table) break;
+                const std::string qualifier = (alias.empty() ? table_name : alias) + ".";
+
+                // UNIQUE admits any number of NULLs, so only columns that
+                // cannot be NULL make a unique constraint a key
+                std::set<std::string> primary_key;
+                std::set<std::string> not_null;
+                for (const auto &column: table->columns) {
+                    if (column.primary_key) primary_key.insert(qualifier + column.name);
+                    if (column.primary_key || !column.nullable) not_null.insert(qualifier + column.name);
+                }
+                for (const auto &column: table->columns) {
+                    if (column.unique && not_null.count(qualifier + column.name)) {
+                        keys.push_back({qualifier + column.name});
+                    }
+                }
+                if (!primary_key.empty()) keys.push_back(primary_key);
+                for (const auto &index: table->indexes) {
+                    if (!index.unique || index.columns.empty()) continue;
+                    std::set<std::string> key;
+                    for (const auto &column: index.columns) {
+                        key.insert(qualifier + column);
+                    }
+                    if (std::includes(not_null.begin(), not_null.end(), key.begin(), key.end())) {
+                        keys.push_back(key);
+                    }
+                }
+                break;
+            }
+
+            case PlanNodeType::SELECTION:
+            case PlanNodeType::SORT:
+            case PlanNodeType::LIMIT:
+                return unique_keys(node->children[0], schema);
+
+            case PlanNodeType::PROJECTION: {
+                // Keys whose columns all survive the projection
+                std::map<std::string, std::string> relations;
+                collect_relations(node, relations);
+                std::set<std::string> projected;
+                for (const auto &projection: std::static_pointer_cast<ProjectionNode>(node)->projections) {
+                    std::string key;
+                    if (qualified_column(projection, relations, schema, key)) projected.insert(key);
+                }
+                for (auto &key: unique_keys(node->children[0], schema)) {
+                    if (std::includes(projected.begin(), projected.end(), key.begin(), key.end())) {
+                        keys.push_back(std::move(key));
+                    }
+                }
+                break;
+            }
+
+            case PlanNodeType::AGGREGATION: {
+                std::map<std::string, std::string> relations;
+                collect_relations(node, relations);
+                std::set<std::string> grouping;
+                for (const auto &expr: std::static_pointer_cast<AggregationNode>(node)->group_by_exprs) {
+                    std::string key;
+                    if (!qualified_column(expr, relations, schema, key)) return keys;
+                    grouping.insert(key);
+                }
+                if (!grouping.empty()) keys.push_back(grouping);
+                break;
+            }
+
+            case PlanNodeType::NESTED_LOOP_JOIN:
+            case PlanNodeType::HASH_JOIN:
+            case PlanNodeType::MERGE_JOIN: {
+                const auto join = std::dynamic_pointer_cast<JoinNode>(node);
+                if (!join || node->children.size() != 2) break;
+                const auto left_keys = unique_keys(node->children[0], schema);
+                const auto right_keys = unique_keys(node->children[1], schema);
+
+                // A side keeps its keys when each of its rows meets at most
+                // one row of the other, i.e. it is equated to a key there
+                std::set<std::string> left_columns;
+                std::set<std::string> right_columns;
+                for (const auto &[left, right]: join_equalities(node, schema)) {
+                    left_columns.insert(left);
+                    right_columns.insert(right);
+                }
+                const bool outer = join->join_type != JoinType::INNER && join->join_type != JoinType::CROSS;
+                const bool left_preserving = join->join_type == JoinType::LEFT || join->join_type == JoinType::LEFT_OUTER;
+                const bool right_preserving = join->join_type == JoinType::RIGHT || join->join_type == JoinType::RIGHT_OUTER;
+                if (covers_key(right_keys, right_columns) && (!outer || left_preserving)) {
+                    keys.insert(keys.end(), left_keys.begin(), left_keys.end());
+                }
+                if (covers_key(left_keys, left_columns) && (!outer || right_preserving)) {
+                    keys.insert(keys.end(), right_keys.begin(), right_keys.end());
+                }
+
+                // A key of each side together identifies an inner join row
+                if (!outer) {
+                    for (const auto &left: left_keys) {
+                        for (const auto &right: right_keys) {
+                            std::set<std::string> key = left;
+                            key.insert(right.begin(), right.end());
+                            keys.push_back(std::move(key));
+                        }
+                    }
+                }
+                break;
+            }
+
+            default:
+                break;
+        }
+        return keys;
+    }
+
+    size_t match_index_conditions(const Index &index, const std::vector<ExpressionPtr> &conditions,
+                                  std::vector<ExpressionPtr> &index_conditions, std::vector<ExpressionPtr> &residual) {
+        std::vector<std::pair<std::string, std::string> > comparisons; // Column and operator, per condition
+        for (const auto &condition: conditions) {
+            std::string column;
+            std::string op;
+            std::string value;
+            if (!column_comparison(condition, column, op, value)) column.clear();
+            comparisons.emplace_back(column, op);
+        }
+
+        std::vector<bool> searched(conditions.size(), false);
+        size_t matched = 0;
+        for (const auto &key: index.columns) {
+            bool equality = false;
+            for (size_t i = 0; i < conditions.size(); ++i) {
+                if (comparisons[i].first == key && comparisons[i].second == "=") searched[i] = equality = true;
+            }
+            if (equality) {
+                matched++;
+                continue;
+            }
+
+            // A range ends the searchable prefix
+            bool range = false;
+            for (size_t i = 0; i < conditions.size(); ++i) {
+                if (comparisons[i].first == key) searched[i] = range = true;
+            }
+            if (range) matched++;
+            break;
+        }
+
+        for (size_t i = 0; i < conditions.size(); ++i) {
+            (searched[i] ? index_conditions : residual).push_back(conditions[i]);
+        }
+        return matched;
+    }
+
+    LogicalPlanNodePtr JoinEliminationTransformer::transform(const LogicalPlanNodePtr &node) {
+        return eliminate(node, {}, false);
+    }
+
+    // Walks down with the columns read above each node, as projection
+    // pushdown does; until a projection is seen every column is read
+    LogicalPlanNodePtr JoinEliminationTransformer::eliminate(const LogicalPlanNodePtr &node, // NOLINT(misc-no-recursion)
+                                                             std::set<std::string> required, bool projected) {
+        if (!node) return node;
+
+        const auto require = [&required](const auto &exprs) {
+            if (!collect_referenced_columns(exprs, required)) required.insert("*");
+        };
+
+        switch (node->type) {
+            case PlanNodeType::PROJECTION:
+                require(std::static_pointer_cast<ProjectionNode>(node)->projections);
+                projected = true;
+                break;
+
+            case PlanNodeType::AGGREGATION: {
+                const auto aggregation = std::static_pointer_cast<AggregationNode>(node);
+                require(aggregation->group_by_exprs);
+                require(aggregation->aggregate_exprs);
+                require(aggregation->having_conditions);
+                projected = true;
+                break;
+            }
+
+            case PlanNodeType::SELECTION:
+                require(std::static_pointer_cast<SelectionNode>(node)->conditions);
+                break;
+
+            case PlanNodeType::SORT:
+                for (const auto &key: std::static_pointer_cast<SortNode>(node)->sort_keys) {
+                    require(key.expression);
+                }
+                break;
+
+            case PlanNodeType::LIMIT:
+                break;
+
+            case PlanNodeType::NESTED_LOOP_JOIN:
+            case PlanNodeType::HASH_JOIN:
+            case PlanNodeType::MERGE_JOIN:
+                if (node->children.size() == 2) {
+                    for (size_t side = 2; side-- > 0;) {
+                        if (removable(node, side, required, projected)) {
+                            return eliminate(node->children[1 - side], required, projected);
+                        }
+                    }
+                }
+                if (const auto join = std::dynamic_pointer_cast<JoinNode>(node)) {
+                    require(join->join_conditions);
+                }
+                break;
+
+            case PlanNodeType::TABLE_SCAN:
+            case PlanNodeType::INDEX_SCAN:
+                return node;
+
+            default:
+                required.insert("*");
+                break;
+        }
+
+        for (auto &child: node->children) {
+            child = eliminate(child, required, projected);
+        }
+        return node;
+    }
+
+    // Whether the join's child on side can be dropped given the columns
+    // read above the join
+    bool JoinEliminationTransformer::removable(const LogicalPlanNodePtr &join, const size_t side,
+                                               const std::set<std::string> &required, const bool projected) const {
+        const auto join_node = std::dynamic_pointer_cast<JoinNode>(join);
+        const auto scan = std::dynamic_pointer_cast<TableScanNode>(join->children[side]);
+        if (!join_node || !scan || !scan->filter_conditions.empty()) return false;
+        if (!projected || required.count("*")) return false;
+
+        const JoinType type = join_node->join_type;
+        const bool inner = type == JoinType::INNER;
+        const bool left_join = (type == JoinType::LEFT || type == JoinType::LEFT_OUTER) && side == 1;
+        if (!inner && !left_join) return false;
+
+        // Nothing above may read the scan; a name that does not resolve might
+        const std::string alias = scan->alias.empty() ? scan->table_name : scan->alias;
+        std::map<std::string, std::string> relations;
+        collect_relations(join, relations);
+        for (const auto &column: required) {
+            std::set<std::string> referenced;
+            if (!resolve_relation(column, relations, schema_.get(), referenced) || referenced.count(alias)) {
+                return false;
+            }
+        }
+
+        // The only condition is other.x = scan.k, with k a key of the scan
+        std::vector<ExpressionPtr> conjuncts;
+        split_conjuncts(join_node->join_conditions, conjuncts);
+        const auto equalities = join_equalities(join, schema_.get());
+        if (conjuncts.size() != 1 || equalities.size() != 1) return false;
+        const std::string &other_key = side == 1 ? equalities[0].first : equalities[0].second;
+        const std::string &scan_key = side == 1 ? equalities[0].second : equalities[0].first;
+        if (!covers_key(unique_keys(scan, schema_.get()), {scan_key})) return false;
+        if (left_join) return true;
+
+        // An inner join must also find the match: x is a non-nullable
+        // foreign key to k
+        const std::string other_alias = other_key.substr(0, other_key.rfind('.'));
+        const auto table = schema_ ? schema_->get_table(relations[other_alias]) : std::nullopt;
+        if (!table) return false;
+        const std::string column_name = other_key.substr(other_key.rfind('.') + 1);
+        const std::string key_column = scan_key.substr(scan_key.rfind('.') + 1);
+        return std::any_of(table->columns.begin(), table->columns.end(), [&](const Column &column) {
+            return column.name == column_name && !column.nullable && column.references_table == scan->table_name &&
+                   column.references_column == key_column;
+        });
+    }
+
+    LogicalPlanNodePtr DistinctEliminationTransformer::transform(const LogicalPlanNodePtr &node) { // NOLINT(misc-no-recursion)
+        if (!node) return node;
+        for (auto &child: node->children) {
+            child = transform(child);
+        }
+
+        const auto aggregation = std::dynamic_pointer_cast<AggregationNode>(node);
+        if (!aggregation || !aggregation->aggregate_exprs.empty() || !aggregation->aggregate_functions.empty() ||
+            aggregation->group_by_exprs.empty() || node->children.size() != 1) {
+            return node;
+        }
+
+        std::map<std::string, std::string> relations;
+        collect_relations(node, relations);
+        std::set<std::string> grouping;
+        for (const auto &expr: aggregation->group_by_exprs) {
+            std::string key;
+            if (!qualified_column(expr, relations, schema_.get(), key)) return node;
+            grouping.insert(key);
+        }
+        if (!covers_key(unique_keys(node->children[0], schema_.get()), grouping)) return node;
+
+        // Every group is a single row: output the grouping columns as they are
+        LogicalPlanNodePtr input = node->children[0];
+        if (!aggregation->having_conditions.empty()) {
+            auto having = std::make_shared<SelectionNode>();
+            having->conditions = aggregation->having_conditions;
+            having->children.push_back(input);
+            input = having;
+        }
+        auto projection = std::make_shared<ProjectionNode>();
+        projection->projections = aggregation->group_by_exprs;
+        projection->children.push_back(input);
+        return projection;
+    }
+
+    // Join graph over the inputs of one block of inner joins, numbered by bit
+    // position. Conditions between exactly two inputs are the edges the
+    // enumeration follows; inputs no condition connects are linked by cross
+    // product edges so every input can still be reached.
+    class JoinEnumerator {
+    public:
+        using InputSet = uint64_t;
+        using JoinBuilder = std::function<LogicalPlanNodePtr(const LogicalPlanNodePtr &, const LogicalPlanNodePtr &,
+                                                             const std::vector<ExpressionPtr> &)>;
+
+        static constexpr size_t max_inputs = 64;
+
+        JoinEnumerator(const std::vector<LogicalPlanNodePtr> &inputs, const std::vector<ExpressionPtr> &conditions,
+                       const DatabaseSchema *schema, JoinBuilder join)
+            : inputs_(inputs), neighbors_(inputs.size(), 0), join_(std::move(join)) {
+            std::map<std::string, std::string> relations;
+            std::map<std::string, size_t> owners; // Alias -> input scanning it
+            for (size_t i = 0; i < inputs_.size(); ++i) {
+                std::map<std::string, std::string> input_relations;
+                collect_relations(inputs_[i], input_relations);
+                for (const auto &[alias, table_name]: input_relations) {
+                    relations[alias] = table_name;
+                    owners[alias] = i;
+                }
+            }
+
+            std::vector<ExpressionPtr> conjuncts;
+            split_conjuncts(conditions, conjuncts);
+            for (const auto &conjunct: conjuncts) {
+                std::set<std::string> referenced;
+                InputSet reads = 0;
+                if (referenced_relations(conjunct, relations, schema, referenced)) {
+                    for (const auto &alias: referenced) {
+                        reads |= bit(owners[alias]);
+                    }
+                }
+                // Conditions on unknown or no relations wait for the topmost join
+                if (reads == 0) reads = prefix(inputs_.size() - 1);
+                conditions_.push_back({conjunct, reads});
+
+                if (size(reads) == 2) {
+                    const size_t a = lowest(reads);
+                    const size_t b = lowest(reads & ~bit(a));
+                    neighbors_[a] |= bit(b);
+                    neighbors_[b] |= bit(a);
+                }
+            }
+            connect_components();
+        }
+
+        // DPccp: visits every pair of disjoint connected subgraphs joined by
+        // an edge exactly once, so the best tree for a set is built from the
+        // best trees of its parts. Pairs are costed smallest union first.
+        LogicalPlanNodePtr enumerate_dp() {
+            for (size_t i = 0; i < inputs_.size(); ++i) {
+                best_[bit(i)] = inputs_[i];
+            }
+            for (size_t i = inputs_.size(); i-- > 0;) {
+                emit_subgraph(bit(i));
+                enumerate_subgraphs(bit(i), prefix(i));
+            }
+
+            std::stable_sort(pairs_.begin(), pairs_.end(), [](const auto &a, const auto &b) {
+                return size(a.first | a.second) < size(b.first | b.second);
+            });
+            for (const auto &[left, right]: pairs_) {
+                auto &best = best_[left | right];
+                auto candidate = cheaper_join(best_.at(left), best_.at(right), conditions_between(left, right));
+                if (!best || candidate->cost.total_cost < best->cost.total_cost) best = std::move(candidate);
+            }
+            return best_.at(prefix(inputs_.size() - 1));
+        }
+
+        // GOO: repeatedly joins the two trees whose join yields the fewest
+        // rows, preferring pairs a condition connects over cross products
+        LogicalPlanNodePtr enumerate_greedy() {
+            std::vector<std::pair<InputSet, LogicalPlanNodePtr> > trees;
+            for (size_t i = 0; i < inputs_.size(); ++i) {
+                trees.emplace_back(bit(i), inputs_[i]);
+            }
+
+            while (trees.size() > 1) {
+                LogicalPlanNodePtr best;
+                bool best_connected = false;
+                size_t best_left = 0, best_right = 0;
+
+                for (size_t i = 0; i < trees.size(); ++i) {
+                    for (size_t j = i + 1; j < trees.size(); ++j) {
+                        const auto conditions = conditions_between(trees[i].first, trees[j].first);
+                        const bool connected = !conditions.empty();
+                        if (best && best_connected && !connected) continue;
+
+                        auto candidate = cheaper_join(trees[i].second, trees[j].second, conditions);
+                        if (best && connected == best_connected &&
+                            (candidate->cost.estimated_rows > best->cost.estimated_rows ||
+                             (candidate->cost.estimated_rows == best->cost.estimated_rows &&
+                              candidate->cost.total_cost >= best->cost.total_cost))) {
+                            continue;
+                        }
+                        best = std::move(candidate);
+                        best_connected = connected;
+                        best_left = i;
+                        best_right = j;
+                    }
+                }
+
+                trees[best_left] = {trees[best_left].first | trees[best_right].first, best};
+                trees.erase(trees.begin() + static_cast<std::ptrdiff_t>(best_right));
+            }
+            return trees[0].second;
+        }
+
+    private:
+        struct Condition {
+            ExpressionPtr expr;
+            InputSet reads;
+        };
+
+        std::vector<LogicalPlanNodePtr> inputs_;
+        std::vector<InputSet> neighbors_;
+        std::vector<Condition> conditions_;
+        JoinBuilder join_;
+        std::unordered_map<InputSet, LogicalPlanNodePtr> best_;
+        std::vector<std::pair<InputSet, InputSet> > pairs_;
+
+        static InputSet bit(const size_t i) { return InputSet{1} << i; }
+
+        // Inputs 0..i
+        static InputSet prefix(const size_t i) { return i + 1 >= max_inputs ? ~InputSet{0} : bit(i + 1) - 1; }
+
+        static size_t size(const InputSet set) { return std::bitset<max_inputs>(set).count(); }
+
+        static size_t lowest(const InputSet set) {
+            size_t i = 0;
+            while (!(set & bit(i))) ++i;
+            return i;
+        }
+
+        [[nodiscard]] InputSet neighborhood(const InputSet set) const {
+            InputSet result = 0;
+            for (size_t i = 0; i < inputs_.size(); ++i) {
+                if (set & bit(i)) result |= neighbors_[i];
+            }
+            return result & ~set;
+        }
+
+        void connect_components() {
+            std::vector<InputSet> components;
+            InputSet remaining = prefix(inputs_.size() - 1);
+            while (remaining) {
+                InputSet component = bit(lowest(remaining));
+                for (InputSet grown = component | neighborhood(component); grown != component;
+                     grown = component | neighborhood(component)) {
+                    component = grown;
+                }
+                components.push_back(component);
+                remaining &= ~component;
+            }
+
+            InputSet earlier = components[0];
+            for (size_t c = 1; c < components.size(); ++c) {
+                for (size_t i = 0; i < inputs_.size(); ++i) {
+                    if (components[c] & bit(i)) {
+                        neighbors_[i] |= earlier;
+                    } else if (earlier & bit(i)) {
+                        neighbors_[i] |= components[c];
+                    }
+                }
+                earlier |= components[c];
+            }
+        }
+
+        void enumerate_subgraphs(const InputSet set, const InputSet excluded) { // NOLINT(misc-no-recursion)
+            const InputSet extension = neighborhood(set) & ~excluded;
+            for (InputSet subset = extension; subset; subset = (subset - 1) & extension) {
+                emit_subgraph(set | subset);
+            }
+            for (InputSet subset = extension; subset; subset = (subset - 1) & extension) {
+                enumerate_subgraphs(set | subset, excluded | extension);
+            }
+        }
+
+        // Pairs a connected subgraph with every connected complement that
+        // has a higher-numbered lowest input, so each pair is seen once
+        void emit_subgraph(const InputSet left) {
+            const InputSet excluded = left | prefix(lowest(left));
+            const InputSet extension = neighborhood(left) & ~excluded;
+            for (size_t i = inputs_.size(); i-- > 0;) {
+                if (!(extension & bit(i))) continue;
+                pairs_.emplace_back(left, bit(i));
+                enumerate_complements(left, bit(i), excluded | (prefix(i) & extension));
+            }
+        }
+
+        void enumerate_complements(const InputSet left, const InputSet right, const InputSet excluded) { // NOLINT(misc-no-recursion)
+            const InputSet extension = neighborhood(right) & ~excluded;
+            for (InputSet subset = extension; subset; subset = (subset - 1) & extension) {
+                pairs_.emplace_back(left, right | subset);
+            }
+            for (InputSet subset = extension; subset; subset = (subset - 1) & extension) {
+                enumerate_complements(left, right | subset, excluded | extension);
+            }
+        }
+
+        // Conditions first evaluable when left and right are joined: those
+        // spanning both sides, and single-input ones when that input joins
+        [[nodiscard]] std::vector<ExpressionPtr> conditions_between(const InputSet left, const InputSet right) const {
+            std::vector<ExpressionPtr> result;
+            for (const auto &condition: conditions_) {
+                if (condition.reads & ~(left | right)) continue;
+                const bool spans = (condition.reads & ~left) && (condition.reads & ~right);
+                if (spans || (size(condition.reads) == 1 && (condition.reads == left || condition.reads == right))) {
+                    result.push_back(condition.expr);
+                }
+            }
+            return result;
+        }
+
+        LogicalPlanNodePtr cheaper_join(const LogicalPlanNodePtr &a, const LogicalPlanNodePtr &b,
+                                        const std::vector<ExpressionPtr> &conditions) const {
+            auto forward = join_(a, b, conditions);
+            auto backward = join_(b, a, conditions);
+            return backward->cost.total_cost < forward->cost.total_cost ? backward : forward;
+        }
+    };
+
+    LogicalPlanNodePtr QueryPlanner::optimize_join_order(const std::vector<LogicalPlanNodePtr> &inputs,
+                                                         const std::vector<ExpressionPtr> &join_conditions) const {
+        if (inputs.empty()) return nullptr;
+        if (inputs.size() == 1) return inputs[0];
+
+        for (const auto &input: inputs) {
+            estimate_costs(input);
+        }
+
+        if (inputs.size() > JoinEnumerator::max_inputs) {
+            // Too many inputs to enumerate: keep their order, left-deep
+            LogicalPlanNodePtr result = inputs[0];
+            for (size_t i = 1; i < inputs.size(); ++i) {
+                result = build_join_node(result, inputs[i], JoinType::INNER,
+                                         i + 1 == inputs.size() ? join_conditions : std::vector<ExpressionPtr>{});
+                estimate_node_cost(result);
+            }
+            return result;
+        }
+
+        JoinEnumerator enumerator(inputs, join_conditions, schema_.get(),
+                                  [this](const LogicalPlanNodePtr &left, const LogicalPlanNodePtr &right,
+                                         const std::vector<ExpressionPtr> &conditions) {
+                                      auto join = build_join_node(left, right, JoinType::INNER, conditions);
+                                      estimate_node_cost(join);
+                                      return join;
+                                  });
+        return inputs.size() <= config_.dp_join_limit ? enumerator.enumerate_dp() : enumerator.enumerate_greedy();
+    }
+
+    static bool is_inner_join(const LogicalPlanNodePtr &node) {
+        const auto join = std::dynamic_pointer_cast<JoinNode>(node);
+        return join && node->children.size() == 2 &&
+               (join->join_type == JoinType::INNER || join->join_type == JoinType::CROSS);
+    }
+
+    static void gather_inner_joins(const LogicalPlanNodePtr &node, std::vector<LogicalPlanNodePtr> &inputs, // NOLINT(misc-no-recursion)
+                                   std::vector<ExpressionPtr> &conditions,
+                                   std::unordered_set<const Expression *> &seen) {
+        if (!is_inner_join(node)) {
+            inputs.push_back(node);
+            return;
+        }
+        for (const auto &condition: std::static_pointer_cast<JoinNode>(node)->join_conditions) {
+            if (seen.insert(condition.get()).second) conditions.push_back(condition);
+        }
+        for (const auto &child: node->children) {
+            gather_inner_joins(child, inputs, conditions, seen);
+        }
+    }
+
+    LogicalPlanNodePtr JoinReorderingTransformer::transform(const LogicalPlanNodePtr &node) { // NOLINT(misc-no-recursion)
+        if (!node) return nullptr;
+
+        if (!is_inner_join(node)) {
+            for (auto &child: node->children) {
+                child = transform(child);
+            }
+            return node;
+        }
+
+        std::vector<LogicalPlanNodePtr> inputs;
+        std::vector<ExpressionPtr> conditions;
+        std::unordered_set<const Expression *> seen;
+        gather_inner_joins(node, inputs, conditions, seen);
+        for (auto &input: inputs) {
+            input = transform(input);
+        }
+        return planner_.optimize_join_order(inputs, conditions);
     }
 }
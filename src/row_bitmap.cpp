@@ -0,0 +1,213 @@
+#include "row_bitmap.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace db25 {
+
+static constexpr size_t bitset_words = 65536 / 64;
+
+bool RowBitmap::Container::contains(uint16_t low) const {
+    if (is_bitset()) return (bits[low >> 6] >> (low & 63)) & 1;
+    return std::binary_search(array.begin(), array.end(), low);
+}
+
+void RowBitmap::Container::add(uint16_t low) {
+    if (is_bitset()) {
+        uint64_t& word = bits[low >> 6];
+        const uint64_t mask = uint64_t{1} << (low & 63);
+        if (!(word & mask)) {
+            word |= mask;
+            cardinality++;
+        }
+        return;
+    }
+    const auto it = std::lower_bound(array.begin(), array.end(), low);
+    if (it != array.end() && *it == low) return;
+    array.insert(it, low);
+    cardinality++;
+    if (cardinality > array_limit) to_bitset();
+}
+
+void RowBitmap::Container::to_bitset() {
+    bits.assign(bitset_words, 0);
+    for (uint16_t low : array) {
+        bits[low >> 6] |= uint64_t{1} << (low & 63);
+    }
+    array.clear();
+    array.shrink_to_fit();
+}
+
+void RowBitmap::Container::to_array() {
+    array.clear();
+    array.reserve(cardinality);
+    for (size_t w = 0; w < bits.size(); ++w) {
+        for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+            array.push_back(static_cast<uint16_t>(w * 64 + __builtin_ctzll(word)));
+        }
+    }
+    bits.clear();
+    bits.shrink_to_fit();
+}
+
+RowBitmap::RowBitmap(std::vector<uint32_t> rows) {
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    // Sorted ids fill each container in order, one container at a time
+    for (uint32_t row : rows) {
+        const auto key = static_cast<uint16_t>(row >> 16);
+        if (containers_.empty() || containers_.back().key != key) {
+            containers_.emplace_back();
+            containers_.back().key = key;
+        }
+        Container& container = containers_.back();
+        if (container.is_bitset()) {
+            container.add(static_cast<uint16_t>(row));
+        } else {
+            container.array.push_back(static_cast<uint16_t>(row));
+            if (++container.cardinality > array_limit) container.to_bitset();
+        }
+    }
+}
+
+void RowBitmap::add(uint32_t row) {
+    const auto key = static_cast<uint16_t>(row >> 16);
+    auto it = std::lower_bound(containers_.begin(), containers_.end(), key,
+        [](const Container& container, uint16_t k) { return container.key < k; });
+    if (it == containers_.end() || it->key != key) {
+        it = containers_.insert(it, Container());
+        it->key = key;
+    }
+    it->add(static_cast<uint16_t>(row));
+}
+
+bool RowBitmap::contains(uint32_t row) const {
+    const auto key = static_cast<uint16_t>(row >> 16);
+    const auto it = std::lower_bound(containers_.begin(), containers_.end(), key,
+        [](const Container& container, uint16_t k) { return container.key < k; });
+    return it != containers_.end() && it->key == key && it->contains(static_cast<uint16_t>(row));
+}
+
+size_t RowBitmap::cardinality() const {
+    size_t total = 0;
+    for (const auto& container : containers_) {
+        total += container.cardinality;
+    }
+    return total;
+}
+
+size_t RowBitmap::bitset_count() const {
+    return static_cast<size_t>(std::count_if(containers_.begin(), containers_.end(),
+        [](const Container& container) { return container.is_bitset(); }));
+}
+
+RowBitmap::Container RowBitmap::intersect(const Container& a, const Container& b) {
+    Container result;
+    result.key = a.key;
+    if (a.is_bitset() && b.is_bitset()) {
+        result.bits.resize(bitset_words);
+        for (size_t w = 0; w < bitset_words; ++w) {
+            result.bits[w] = a.bits[w] & b.bits[w];
+            result.cardinality += __builtin_popcountll(result.bits[w]);
+        }
+        if (result.cardinality <= array_limit) result.to_array();
+    } else if (a.is_bitset() || b.is_bitset()) {
+        // Probe the dense side with each id of the sparse one
+        const Container& sparse = a.is_bitset() ? b : a;
+        const Container& dense = a.is_bitset() ? a : b;
+        for (uint16_t low : sparse.array) {
+            if (dense.contains(low)) result.array.push_back(low);
+        }
+        result.cardinality = result.array.size();
+    } else {
+        std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                              std::back_inserter(result.array));
+        result.cardinality = result.array.size();
+    }
+    return result;
+}
+
+RowBitmap::Container RowBitmap::unite(const Container& a, const Container& b) {
+    Container result;
+    result.key = a.key;
+    if (!a.is_bitset() && !b.is_bitset()) {
+        std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                       std::back_inserter(result.array));
+        result.cardinality = result.array.size();
+        if (result.cardinality > array_limit) result.to_bitset();
+        return result;
+    }
+
+    result.bits.assign(bitset_words, 0);
+    for (const Container* input : {&a, &b}) {
+        if (input->is_bitset()) {
+            for (size_t w = 0; w < bitset_words; ++w) result.bits[w] |= input->bits[w];
+        } else {
+            for (uint16_t low : input->array) result.bits[low >> 6] |= uint64_t{1} << (low & 63);
+        }
+    }
+    for (uint64_t word : result.bits) {
+        result.cardinality += __builtin_popcountll(word);
+    }
+    return result;
+}
+
+RowBitmap& RowBitmap::operator&=(const RowBitmap& other) {
+    if (&other == this) return *this;
+    std::vector<Container> result;
+    auto a = containers_.begin();
+    auto b = other.containers_.begin();
+    while (a != containers_.end() && b != other.containers_.end()) {
+        if (a->key < b->key) {
+            ++a;
+        } else if (b->key < a->key) {
+            ++b;
+        } else {
+            Container container = intersect(*a, *b);
+            if (container.cardinality > 0) result.push_back(std::move(container));
+            ++a;
+            ++b;
+        }
+    }
+    containers_ = std::move(result);
+    return *this;
+}
+
+RowBitmap& RowBitmap::operator|=(const RowBitmap& other) {
+    if (&other == this) return *this;
+    std::vector<Container> result;
+    result.reserve(containers_.size() + other.containers_.size());
+    auto a = containers_.begin();
+    auto b = other.containers_.begin();
+    while (a != containers_.end() || b != other.containers_.end()) {
+        if (b == other.containers_.end() || (a != containers_.end() && a->key < b->key)) {
+            result.push_back(std::move(*a++));
+        } else if (a == containers_.end() || b->key < a->key) {
+            result.push_back(*b++);
+        } else {
+            result.push_back(unite(*a++, *b++));
+        }
+    }
+    containers_ = std::move(result);
+    return *this;
+}
+
+std::vector<uint32_t> RowBitmap::to_vector() const {
+    std::vector<uint32_t> rows;
+    rows.reserve(cardinality());
+    for (const auto& container : containers_) {
+        const uint32_t high = static_cast<uint32_t>(container.key) << 16;
+        if (!container.is_bitset()) {
+            for (uint16_t low : container.array) rows.push_back(high | low);
+            continue;
+        }
+        for (size_t w = 0; w < container.bits.size(); ++w) {
+            for (uint64_t word = container.bits[w]; word != 0; word &= word - 1) {
+                rows.push_back(high | static_cast<uint32_t>(w * 64 + __builtin_ctzll(word)));
+            }
+        }
+    }
+    return rows;
+}
+
+} // namespace db25
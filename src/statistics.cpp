@@ -0,0 +1,460 @@
+#include "statistics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <unordered_set>
+
+namespace db25 {
+    // Finalizer of splitmix64, so nearby std::hash values spread over all bits
+    static uint64_t mix_hash(uint64_t h) {
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return h;
+    }
+
+    static std::string unqualified(const std::string &column) {
+        const size_t dot = column.rfind('.');
+        return dot == std::string::npos ? column : column.substr(dot + 1);
+    }
+
+    HyperLogLog::HyperLogLog(const uint8_t precision)
+        : precision_(std::clamp<uint8_t>(precision, 4, 18)), registers_(size_t{1} << precision_, 0) {
+    }
+
+    void HyperLogLog::add(const std::string_view value) {
+        const uint64_t hash = mix_hash(std::hash<std::string_view>{}(value));
+        const size_t index = hash >> (64 - precision_);
+
+        // Rank of the first set bit in the remaining bits, 1-based
+        const uint64_t rest = hash << precision_;
+        uint8_t rank = 1;
+        for (uint64_t bit = uint64_t{1} << 63; rank <= 64 - precision_ && !(rest & bit); bit >>= 1) {
+            ++rank;
+        }
+        registers_[index] = std::max(registers_[index], rank);
+    }
+
+    void HyperLogLog::merge(const HyperLogLog &other) {
+        for (size_t i = 0; i < registers_.size() && i < other.registers_.size(); ++i) {
+            registers_[i] = std::max(registers_[i], other.registers_[i]);
+        }
+    }
+
+    double HyperLogLog::estimate() const {
+        const auto m = static_cast<double>(registers_.size());
+        double sum = 0.0;
+        size_t zeros = 0;
+        for (const uint8_t rank: registers_) {
+            sum += std::ldexp(1.0, -rank);
+            if (rank == 0) ++zeros;
+        }
+
+        const double alpha = 0.7213 / (1.0 + 1.079 / m);
+        const double raw = alpha * m * m / sum;
+
+        // Few distinct values leave registers empty; count those instead
+        if (raw <= 2.5 * m && zeros > 0) {
+            return m * std::log(m / static_cast<double>(zeros));
+        }
+        return raw;
+    }
+
+    // Value combination of the given columns as one sketch key
+    static std::string combination_key(const std::vector<std::string> &values, const std::vector<size_t> &columns) {
+        std::string key;
+        for (const size_t c: columns) {
+            if (c >= values.size() || values[c].empty()) return "";
+            key += values[c];
+            key += '\x1f';
+        }
+        return key;
+    }
+
+    static ExtendedStats build_extended_stats(const std::vector<std::string> &names, const std::vector<size_t> &columns,
+                                              const std::vector<std::vector<std::string> > &sample,
+                                              const HyperLogLog &sketch, const size_t rows, const size_t non_null,
+                                              const AnalyzeConfig &config) {
+        ExtendedStats extended;
+        extended.columns = names;
+
+        std::unordered_map<std::string, std::pair<std::vector<std::string>, size_t> > counts;
+        size_t sampled = 0;
+        for (const auto &row: sample) {
+            const std::string key = combination_key(row, columns);
+            if (key.empty()) continue;
+            auto &entry = counts[key];
+            if (entry.second++ == 0) {
+                for (const size_t c: columns) entry.first.push_back(row[c]);
+            }
+            ++sampled;
+        }
+        extended.distinct_values = std::clamp(sketch.estimate(), static_cast<double>(counts.size()),
+                                              static_cast<double>(non_null));
+
+        // Common combinations, chosen as for single columns
+        std::vector<std::pair<std::vector<std::string>, size_t> > candidates;
+        candidates.reserve(counts.size());
+        for (auto &[key, entry]: counts) {
+            candidates.push_back(std::move(entry));
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        });
+        const bool complete = sample.size() == rows && candidates.size() <= config.statistics_target;
+        const double average = candidates.empty() ? 0.0 : static_cast<double>(sampled) / candidates.size();
+        for (size_t i = 0; i < candidates.size() && i < config.statistics_target; ++i) {
+            if (!complete && (candidates[i].second <= 1 || candidates[i].second < 1.25 * average)) break;
+            extended.most_common_values.emplace_back(
+                candidates[i].first, static_cast<double>(candidates[i].second) / static_cast<double>(sample.size()));
+        }
+
+        // a -> b is supported by every sampled row whose a value never
+        // appears with two different b values
+        for (size_t a = 0; a < columns.size(); ++a) {
+            for (size_t b = 0; b < columns.size(); ++b) {
+                if (a == b) continue;
+                std::unordered_map<std::string, std::pair<std::string, size_t> > groups; // a -> first b, rows
+                std::unordered_set<std::string> conflicting;
+                size_t total = 0;
+                for (const auto &row: sample) {
+                    if (columns[a] >= row.size() || columns[b] >= row.size()) continue;
+                    const std::string &x = row[columns[a]];
+                    const std::string &y = row[columns[b]];
+                    if (x.empty() || y.empty()) continue;
+                    auto [group, inserted] = groups.try_emplace(x, y, 0);
+                    ++group->second.second;
+                    if (!inserted && group->second.first != y) conflicting.insert(x);
+                    ++total;
+                }
+                size_t supporting = 0;
+                for (const auto &[x, group]: groups) {
+                    if (!conflicting.count(x)) supporting += group.second;
+                }
+                extended.dependencies.push_back(
+                    {names[a], names[b], total > 0 ? static_cast<double>(supporting) / static_cast<double>(total) : 0.0});
+            }
+        }
+        return extended;
+    }
+
+    TableStats analyze_rows(const PhysicalPlanNodePtr &source, const AnalyzeConfig &config) {
+        TableStats stats;
+        stats.avg_row_size = 0.0;
+        if (!source) return stats;
+
+        ExecutionContext context;
+        source->initialize(&context);
+        const size_t column_count = source->output_columns.size();
+
+        std::vector<HyperLogLog> sketches(column_count, HyperLogLog(config.hll_precision));
+        std::vector<size_t> nulls(column_count, 0);
+        std::vector<double> widths(column_count, 0.0);
+
+        // Declared column groups, as positions in the source rows
+        std::vector<std::vector<size_t> > groups;
+        for (const auto &group: config.column_groups) {
+            std::vector<size_t> positions;
+            for (const auto &name: group) {
+                for (size_t c = 0; c < column_count; ++c) {
+                    if (unqualified(source->output_columns[c]) == unqualified(name)) positions.push_back(c);
+                }
+            }
+            if (positions.size() == group.size() && positions.size() >= 2) groups.push_back(std::move(positions));
+        }
+        std::vector<HyperLogLog> group_sketches(groups.size(), HyperLogLog(config.hll_precision));
+        std::vector<size_t> group_rows(groups.size(), 0);
+
+        // Reservoir sample (algorithm R): row i replaces a kept row with
+        // probability sample_rows / (i + 1)
+        std::vector<std::vector<std::string> > sample;
+        std::mt19937_64 gen(std::random_device{}());
+        size_t rows = 0;
+
+        while (source->has_more_data()) {
+            const TupleBatch batch = source->get_next_batch();
+            for (const auto &tuple: batch.tuples) {
+                for (size_t c = 0; c < column_count; ++c) {
+                    const std::string value = tuple.get_value(c);
+                    if (value.empty()) {
+                        ++nulls[c];
+                        continue;
+                    }
+                    sketches[c].add(value);
+                    widths[c] += static_cast<double>(value.size());
+                }
+                for (size_t g = 0; g < groups.size(); ++g) {
+                    const std::string key = combination_key(tuple.values, groups[g]);
+                    if (key.empty()) continue;
+                    group_sketches[g].add(key);
+                    ++group_rows[g];
+                }
+
+                if (sample.size() < config.sample_rows) {
+                    sample.push_back(tuple.values);
+                } else if (config.sample_rows > 0) {
+                    const size_t slot = std::uniform_int_distribution<size_t>(0, rows)(gen);
+                    if (slot < config.sample_rows) sample[slot] = tuple.values;
+                }
+                ++rows;
+            }
+        }
+        source->cleanup();
+
+        stats.row_count = rows;
+        for (size_t c = 0; c < column_count; ++c) {
+            ColumnStats column;
+            const size_t non_null = rows - nulls[c];
+            column.null_fraction = rows > 0 ? static_cast<double>(nulls[c]) / static_cast<double>(rows) : 0.0;
+            column.avg_width = non_null > 0 ? widths[c] / static_cast<double>(non_null) : 0.0;
+
+            // Value frequencies in the sample
+            std::unordered_map<std::string, size_t> counts;
+            size_t sampled = 0;
+            for (const auto &row: sample) {
+                if (c < row.size() && !row[c].empty()) {
+                    ++counts[row[c]];
+                    ++sampled;
+                }
+            }
+
+            // The sketch can undercount what the sample already shows
+            column.distinct_values = std::clamp(sketches[c].estimate(), static_cast<double>(counts.size()),
+                                                static_cast<double>(non_null));
+
+            // A value is common if it repeats clearly more often than the
+            // average sampled value. A sample of the whole table is exact,
+            // so then every value fits when there are few enough.
+            std::vector<std::pair<std::string, size_t> > candidates(counts.begin(), counts.end());
+            std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+                return a.second != b.second ? a.second > b.second : a.first < b.first;
+            });
+            const bool complete = sample.size() == rows && counts.size() <= config.statistics_target;
+            const double average = counts.empty() ? 0.0 : static_cast<double>(sampled) / counts.size();
+            size_t common = 0;
+            size_t common_rows = 0;
+            while (common < candidates.size() && common < config.statistics_target &&
+                   (complete || (candidates[common].second > 1 &&
+                                 static_cast<double>(candidates[common].second) >= 1.25 * average))) {
+                column.most_common_values.emplace_back(
+                    candidates[common].first,
+                    static_cast<double>(candidates[common].second) / static_cast<double>(sample.size()));
+                common_rows += candidates[common].second;
+                ++common;
+            }
+
+            // Equi-depth bounds over the remaining sampled values, ordered as
+            // a sort on the column would order them
+            if (sampled - common_rows >= 2) {
+                for (size_t i = common; i < candidates.size(); ++i) {
+                    column.value_type = widen_sort_key_type(column.value_type, candidates[i].first);
+                }
+                std::vector<std::pair<std::string, const std::string *> > keyed;
+                keyed.reserve(sampled - common_rows);
+                for (size_t i = common; i < candidates.size(); ++i) {
+                    std::string key;
+                    append_normalized_key(key, candidates[i].first, column.value_type, true, false);
+                    keyed.insert(keyed.end(), candidates[i].second, {key, &candidates[i].first});
+                }
+                std::sort(keyed.begin(), keyed.end());
+
+                const size_t buckets = std::min(config.statistics_target, keyed.size() - 1);
+                for (size_t b = 0; b <= buckets; ++b) {
+                    column.histogram_bounds.push_back(*keyed[b * (keyed.size() - 1) / buckets].second);
+                }
+            }
+
+            const std::string name = unqualified(source->output_columns[c]);
+            stats.avg_row_size += column.avg_width * (1.0 - column.null_fraction);
+            stats.distinct_values[name] = static_cast<size_t>(std::llround(column.distinct_values));
+            if (column.distinct_values > 0.0) {
+                stats.column_selectivity[name] = 1.0 / column.distinct_values;
+            }
+            stats.columns[name] = std::move(column);
+        }
+
+        for (size_t g = 0; g < groups.size(); ++g) {
+            std::vector<std::string> names;
+            for (const size_t c: groups[g]) {
+                names.push_back(unqualified(source->output_columns[c]));
+            }
+            stats.extended.push_back(
+                build_extended_stats(names, groups[g], sample, group_sketches[g], rows, group_rows[g], config));
+        }
+        return stats;
+    }
+
+    // Share of non-MCV rows assumed to match a condition the histogram cannot judge
+    static constexpr double unknown_fraction = 0.2;
+
+    // Orders two values as a column of the given type would, numerically when
+    // both parse as numbers
+    static int compare_values(const std::string &a, const std::string &b, const SortKeyType type) {
+        if (type == SortKeyType::INTEGER || type == SortKeyType::FLOAT) {
+            char *a_end = nullptr;
+            char *b_end = nullptr;
+            const double x = std::strtod(a.c_str(), &a_end);
+            const double y = std::strtod(b.c_str(), &b_end);
+            if (!a.empty() && !b.empty() && *a_end == '\0' && *b_end == '\0') {
+                return x < y ? -1 : (x > y ? 1 : 0);
+            }
+        }
+        return a.compare(b) < 0 ? -1 : (a == b ? 0 : 1);
+    }
+
+    bool like_match(const std::string_view value, const std::string_view pattern) {
+        size_t v = 0;
+        size_t p = 0;
+        size_t star = std::string_view::npos; // Pattern position after the last %
+        size_t resume = 0; // Value position that % is currently matched up to
+        while (v < value.size()) {
+            if (p < pattern.size() && pattern[p] == '%') {
+                star = ++p;
+                resume = v;
+            } else if (p < pattern.size() && (pattern[p] == '_' || pattern[p] == value[v])) {
+                ++v;
+                ++p;
+            } else if (star != std::string_view::npos) {
+                p = star;
+                v = ++resume;
+            } else {
+                return false;
+            }
+        }
+        while (p < pattern.size() && pattern[p] == '%') ++p;
+        return p == pattern.size();
+    }
+
+    double ColumnStats::common_fraction() const {
+        double fraction = 0.0;
+        for (const auto &[value, frequency]: most_common_values) {
+            fraction += frequency;
+        }
+        return fraction;
+    }
+
+    double ExtendedStats::common_fraction() const {
+        double fraction = 0.0;
+        for (const auto &[values, frequency]: most_common_values) {
+            fraction += frequency;
+        }
+        return fraction;
+    }
+
+    double ColumnStats::histogram_position(const std::string &value) const {
+        const size_t n = histogram_bounds.size();
+        if (n < 2) return -1.0;
+        if (compare_values(value, histogram_bounds.front(), value_type) <= 0) return 0.0;
+        if (compare_values(value, histogram_bounds.back(), value_type) >= 0) return 1.0;
+
+        // Bucket i holds values in [bounds[i], bounds[i + 1])
+        const auto upper = std::upper_bound(histogram_bounds.begin(), histogram_bounds.end(), value,
+                                            [this](const std::string &v, const std::string &bound) {
+                                                return compare_values(v, bound, value_type) < 0;
+                                            });
+        const size_t i = static_cast<size_t>(upper - histogram_bounds.begin()) - 1;
+
+        // Numbers are assumed spread evenly within a bucket
+        double within = 0.5;
+        if (value_type == SortKeyType::INTEGER || value_type == SortKeyType::FLOAT) {
+            const double low = std::strtod(histogram_bounds[i].c_str(), nullptr);
+            const double high = std::strtod(histogram_bounds[i + 1].c_str(), nullptr);
+            if (high > low) within = std::clamp((std::strtod(value.c_str(), nullptr) - low) / (high - low), 0.0, 1.0);
+        }
+        return (static_cast<double>(i) + within) / static_cast<double>(n - 1);
+    }
+
+    double ColumnStats::equal_fraction(const std::string &value) const {
+        for (const auto &[common, frequency]: most_common_values) {
+            if (compare_values(common, value, value_type) == 0) return frequency;
+        }
+
+        // The remaining rows are spread evenly over the remaining values
+        const double rest = std::max(0.0, 1.0 - null_fraction - common_fraction());
+        const double others = distinct_values - static_cast<double>(most_common_values.size());
+        return others >= 1.0 ? rest / others : 0.0;
+    }
+
+    double ColumnStats::less_fraction(const std::string &value, const bool or_equal) const {
+        double fraction = 0.0;
+        for (const auto &[common, frequency]: most_common_values) {
+            const int order = compare_values(common, value, value_type);
+            if (order < 0 || (or_equal && order == 0)) fraction += frequency;
+        }
+
+        const double rest = std::max(0.0, 1.0 - null_fraction - common_fraction());
+        const double position = histogram_position(value);
+        return fraction + rest * (position < 0.0 ? unknown_fraction : position);
+    }
+
+    double ColumnStats::like_fraction(const std::string &pattern) const {
+        const size_t wildcard = pattern.find_first_of("%_");
+        if (wildcard == std::string::npos) return equal_fraction(pattern);
+
+        double fraction = 0.0;
+        for (const auto &[common, frequency]: most_common_values) {
+            if (like_match(common, pattern)) fraction += frequency;
+        }
+
+        // A fixed prefix bounds the match to a histogram range: values from
+        // the prefix up to the prefix with its last character incremented
+        double matching = unknown_fraction;
+        std::string prefix = pattern.substr(0, wildcard);
+        const bool text = value_type == SortKeyType::TEXT || value_type == SortKeyType::INFERRED;
+        if (!prefix.empty() && text && histogram_bounds.size() >= 2) {
+            const double low = histogram_position(prefix);
+            while (!prefix.empty() && static_cast<unsigned char>(prefix.back()) == 0xFF) prefix.pop_back();
+            double high = 1.0;
+            if (!prefix.empty()) {
+                ++prefix.back();
+                high = histogram_position(prefix);
+            }
+            matching = std::max(0.0, high - low);
+
+            // Characters after the first wildcard narrow the range further
+            if (pattern.substr(wildcard) != "%") matching *= unknown_fraction;
+        }
+        const double rest = std::max(0.0, 1.0 - null_fraction - common_fraction());
+        return fraction + rest * matching;
+    }
+
+    void StatisticsCatalog::set_table_stats(const std::string &table_name, const TableStats &stats) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tables_[table_name] = std::make_shared<const TableStats>(stats);
+    }
+
+    std::shared_ptr<const TableStats> StatisticsCatalog::find_table_stats(const std::string &table_name) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto it = tables_.find(table_name);
+        return it != tables_.end() ? it->second : nullptr;
+    }
+
+    std::shared_ptr<const TableStats> StatisticsCatalog::get_table_stats(const std::string &table_name) const {
+        static const auto defaults = std::make_shared<const TableStats>();
+        auto stats = find_table_stats(table_name);
+        return stats ? stats : defaults;
+    }
+
+    void StatisticsCatalog::create_statistics(const std::string &table_name, std::vector<std::string> columns) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        column_groups_[table_name].push_back(std::move(columns));
+    }
+
+    TableStats StatisticsCatalog::analyze_table(const std::string &table_name, const PhysicalPlanNodePtr &source,
+                                                const AnalyzeConfig &config) {
+        AnalyzeConfig with_groups = config;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (const auto it = column_groups_.find(table_name); it != column_groups_.end()) {
+                with_groups.column_groups.insert(with_groups.column_groups.end(), it->second.begin(), it->second.end());
+            }
+        }
+        TableStats stats = analyze_rows(source, with_groups);
+        set_table_stats(table_name, stats);
+        return stats;
+    }
+}
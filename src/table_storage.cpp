@@ -0,0 +1,559 @@
+#include "table_storage.hpp"
+#include "columnar_storage.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace db25 {
+
+// Page header: slot count, then the offset where row images begin
+static constexpr size_t page_header_size = 4;
+static constexpr size_t slot_size = 4; // Offset and length of a row image
+
+template <typename T>
+static T load(const uint8_t* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+template <typename T>
+static void store(uint8_t* data, T value) {
+    std::memcpy(data, &value, sizeof(T));
+}
+
+StorageKind storage_kind(ColumnType type) {
+    switch (type) {
+        case ColumnType::INTEGER:
+        case ColumnType::BIGINT:
+            return StorageKind::INTEGER;
+        case ColumnType::DECIMAL:
+            return StorageKind::DECIMAL;
+        case ColumnType::BOOLEAN:
+            return StorageKind::BOOLEAN;
+        default:
+            return StorageKind::VARIABLE;
+    }
+}
+
+bool parse_integer(const std::string& text, int64_t& value) {
+    char* end = nullptr;
+    errno = 0;
+    const long long parsed = std::strtoll(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || errno == ERANGE) return false;
+    value = parsed;
+    return true;
+}
+
+bool parse_decimal(const std::string& text, double& value) {
+    char* end = nullptr;
+    const double parsed = std::strtod(text.c_str(), &end);
+    if (text.empty() || *end != '\0') return false;
+    value = parsed;
+    return true;
+}
+
+bool parse_boolean(const std::string& text, bool& value) {
+    if (text == "true" || text == "t" || text == "1") {
+        value = true;
+    } else if (text == "false" || text == "f" || text == "0") {
+        value = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string format_decimal(double value) {
+    char buffer[32];
+    for (int precision = 15; precision <= 17; ++precision) {
+        std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+        if (std::strtod(buffer, nullptr) == value) break;
+    }
+    return buffer;
+}
+
+// Days from 1970-01-01 to a proleptic Gregorian date, and back
+static int64_t days_from_civil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned year_of_era = static_cast<unsigned>(year - era * 400);
+    const unsigned day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + static_cast<int64_t>(day_of_era) - 719468;
+}
+
+static void civil_from_days(int64_t days, int64_t& year, unsigned& month, unsigned& day) {
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned day_of_era = static_cast<unsigned>(days - era * 146097);
+    const unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    const unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    const unsigned mp = (5 * day_of_year + 2) / 153;
+    day = day_of_year - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = static_cast<int64_t>(year_of_era) + era * 400 + (month <= 2);
+}
+
+bool parse_date(const std::string& text, int64_t& days) {
+    int year = 0;
+    unsigned month = 0;
+    unsigned day = 0;
+    int consumed = 0;
+    if (std::sscanf(text.c_str(), "%4d-%2u-%2u%n", &year, &month, &day, &consumed) != 3 ||
+        static_cast<size_t>(consumed) != text.size() || month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+    days = days_from_civil(year, month, day);
+    return true;
+}
+
+bool parse_timestamp(const std::string& text, int64_t& micros) {
+    int64_t days = 0;
+    unsigned hour = 0;
+    unsigned minute = 0;
+    unsigned second = 0;
+    int consumed = 0;
+    if (text.size() < 19 || text[10] != ' ' || !parse_date(text.substr(0, 10), days) ||
+        std::sscanf(text.c_str() + 11, "%2u:%2u:%2u%n", &hour, &minute, &second, &consumed) != 3 ||
+        consumed != 8 || hour > 23 || minute > 59 || second > 59) {
+        return false;
+    }
+    int64_t fraction = 0;
+    if (text.size() > 19) {
+        if (text.size() != 26 || text[19] != '.') return false;
+        for (size_t i = 20; i < 26; ++i) {
+            if (text[i] < '0' || text[i] > '9') return false;
+            fraction = fraction * 10 + (text[i] - '0');
+        }
+    }
+    micros = ((days * 24 + hour) * 60 + minute) * 60 * 1000000 + second * int64_t{1000000} + fraction;
+    return true;
+}
+
+std::string format_date(int64_t days) {
+    int64_t year = 0;
+    unsigned month = 0;
+    unsigned day = 0;
+    civil_from_days(days, year, month, day);
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%04lld-%02u-%02u", static_cast<long long>(year), month, day);
+    return buffer;
+}
+
+std::string format_timestamp(int64_t micros) {
+    constexpr int64_t micros_per_day = int64_t{86400} * 1000000;
+    int64_t days = micros / micros_per_day;
+    int64_t time = micros % micros_per_day;
+    if (time < 0) {
+        days--;
+        time += micros_per_day;
+    }
+    const int64_t seconds = time / 1000000;
+    const int64_t fraction = time % 1000000;
+    char buffer[48];
+    if (fraction == 0) {
+        std::snprintf(buffer, sizeof(buffer), "%s %02lld:%02lld:%02lld", format_date(days).c_str(),
+                      static_cast<long long>(seconds / 3600), static_cast<long long>(seconds / 60 % 60),
+                      static_cast<long long>(seconds % 60));
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%s %02lld:%02lld:%02lld.%06lld", format_date(days).c_str(),
+                      static_cast<long long>(seconds / 3600), static_cast<long long>(seconds / 60 % 60),
+                      static_cast<long long>(seconds % 60), static_cast<long long>(fraction));
+    }
+    return buffer;
+}
+
+bool read_number(std::string_view text, double& number) {
+    if (text.empty() || std::isspace(static_cast<unsigned char>(text[0]))) return false;
+    const std::string copy(text);
+    char* end = nullptr;
+    number = std::strtod(copy.c_str(), &end);
+    return *end == '\0' && !std::isnan(number);
+}
+
+int compare_value(std::string_view value, const std::string& constant, const double* number) {
+    double value_number = 0;
+    if (number && read_number(value, value_number)) {
+        return (value_number > *number) - (value_number < *number);
+    }
+    const int cmp = value.compare(constant);
+    return (cmp > 0) - (cmp < 0);
+}
+
+bool ColumnPredicate::applies_to(StorageKind kind) const {
+    if (values.empty() || (op != Op::IN && values.size() != 1)) return false;
+    for (const auto& value : values) {
+        double number = 0;
+        if (value.empty()) return false;
+        if ((kind == StorageKind::INTEGER || kind == StorageKind::DECIMAL) && !read_number(value, number)) return false;
+    }
+    return true;
+}
+
+bool ColumnPredicate::satisfied_by(int cmp) const {
+    switch (op) {
+        case Op::NOT_EQUAL:
+            return cmp != 0;
+        case Op::LESS:
+            return cmp < 0;
+        case Op::LESS_EQUAL:
+            return cmp <= 0;
+        case Op::GREATER:
+            return cmp > 0;
+        case Op::GREATER_EQUAL:
+            return cmp >= 0;
+        default:
+            return cmp == 0;
+    }
+}
+
+bool ColumnPredicate::matches(const std::string& value) const {
+    if (value.empty()) return false;
+    for (const auto& constant : values) {
+        double number = 0;
+        const bool satisfied = satisfied_by(compare_value(value, constant, read_number(constant, number) ? &number : nullptr));
+        if (op != Op::IN || satisfied) return satisfied;
+    }
+    return false;
+}
+
+void ZoneMap::add(const std::string& value) {
+    row_count_++;
+    if (value.empty()) {
+        null_count_++;
+        return;
+    }
+    const bool first = row_count_ - null_count_ == 1;
+    int64_t integer = 0;
+    double decimal = 0;
+    bool boolean = false;
+    switch (kind_) {
+        case StorageKind::INTEGER:
+        case StorageKind::BOOLEAN:
+            if (kind_ == StorageKind::INTEGER) {
+                parse_integer(value, integer);
+            } else {
+                parse_boolean(value, boolean);
+                integer = boolean ? 1 : 0;
+            }
+            integer_min_ = first ? integer : std::min(integer_min_, integer);
+            integer_max_ = first ? integer : std::max(integer_max_, integer);
+            break;
+        case StorageKind::DECIMAL:
+            parse_decimal(value, decimal);
+            if (std::isnan(decimal)) ordered_ = false;
+            decimal_min_ = first ? decimal : std::min(decimal_min_, decimal);
+            decimal_max_ = first ? decimal : std::max(decimal_max_, decimal);
+            break;
+        case StorageKind::VARIABLE:
+            if (first || value < text_min_) text_min_ = value;
+            if (first || value > text_max_) text_max_ = value;
+            break;
+    }
+}
+
+std::string ZoneMap::min() const {
+    if (null_count_ == row_count_) return "";
+    switch (kind_) {
+        case StorageKind::INTEGER:
+            return std::to_string(integer_min_);
+        case StorageKind::BOOLEAN:
+            return integer_min_ ? "true" : "false";
+        case StorageKind::DECIMAL:
+            return format_decimal(decimal_min_);
+        default:
+            return text_min_;
+    }
+}
+
+std::string ZoneMap::max() const {
+    if (null_count_ == row_count_) return "";
+    switch (kind_) {
+        case StorageKind::INTEGER:
+            return std::to_string(integer_max_);
+        case StorageKind::BOOLEAN:
+            return integer_max_ ? "true" : "false";
+        case StorageKind::DECIMAL:
+            return format_decimal(decimal_max_);
+        default:
+            return text_max_;
+    }
+}
+
+// The smallest or largest value against a constant
+int ZoneMap::compare_bound(bool max, size_t constant, const std::vector<double>& numbers,
+                           const ColumnPredicate& predicate) const {
+    switch (kind_) {
+        case StorageKind::INTEGER: {
+            const auto bound = static_cast<double>(max ? integer_max_ : integer_min_);
+            return (bound > numbers[constant]) - (bound < numbers[constant]);
+        }
+        case StorageKind::DECIMAL: {
+            const double bound = max ? decimal_max_ : decimal_min_;
+            return (bound > numbers[constant]) - (bound < numbers[constant]);
+        }
+        case StorageKind::BOOLEAN:
+            return compare_value((max ? integer_max_ : integer_min_) ? "true" : "false", predicate.values[constant],
+                                 nullptr);
+        default:
+            return compare_value(max ? text_max_ : text_min_, predicate.values[constant], nullptr);
+    }
+}
+
+bool ZoneMap::may_match(const ColumnPredicate& predicate) const {
+    if (null_count_ == row_count_) return false;
+    if (!ordered_ || !predicate.applies_to(kind_)) return true;
+
+    // Bounds only order text compared as text: not against numbers
+    std::vector<double> numbers;
+    for (const auto& value : predicate.values) {
+        double number = 0;
+        const bool numeric = read_number(value, number);
+        if (numeric && kind_ == StorageKind::VARIABLE) return true;
+        numbers.push_back(number);
+    }
+
+    using Op = ColumnPredicate::Op;
+    const auto min_against = [&](size_t i) { return compare_bound(false, i, numbers, predicate); };
+    const auto max_against = [&](size_t i) { return compare_bound(true, i, numbers, predicate); };
+    switch (predicate.op) {
+        case Op::LESS:
+            return min_against(0) < 0;
+        case Op::LESS_EQUAL:
+            return min_against(0) <= 0;
+        case Op::GREATER:
+            return max_against(0) > 0;
+        case Op::GREATER_EQUAL:
+            return max_against(0) >= 0;
+        case Op::NOT_EQUAL:
+            return min_against(0) != 0 || max_against(0) != 0;
+        default:
+            for (size_t i = 0; i < predicate.values.size(); ++i) {
+                if (min_against(i) <= 0 && max_against(i) >= 0) return true;
+            }
+            return false;
+    }
+}
+
+static size_t field_size(StorageKind kind) {
+    switch (kind) {
+        case StorageKind::INTEGER:
+        case StorageKind::DECIMAL:
+            return 8;
+        case StorageKind::BOOLEAN:
+            return 1;
+        default:
+            return 4; // Offset and length within the row image
+    }
+}
+
+TableHeap::TableHeap(const Table& table) : name_(table.name), columns_(table.columns) {
+    fixed_size_ = (columns_.size() + 7) / 8;
+    for (const auto& column : columns_) {
+        field_offsets_.push_back(fixed_size_);
+        fixed_size_ += field_size(storage_kind(column.type));
+    }
+}
+
+size_t TableHeap::insert(const std::vector<std::string>& values) {
+    if (values.size() != columns_.size()) {
+        throw std::runtime_error("Row of " + std::to_string(values.size()) + " values for table " + name_ +
+                                 " of " + std::to_string(columns_.size()) + " columns");
+    }
+
+    std::vector<uint8_t> image(fixed_size_, 0);
+    for (size_t c = 0; c < columns_.size(); ++c) {
+        const std::string& value = values[c];
+        if (value.empty()) {
+            image[c / 8] |= static_cast<uint8_t>(1u << (c % 8));
+            continue;
+        }
+
+        uint8_t* field = image.data() + field_offsets_[c];
+        const auto invalid = [&]() {
+            return std::runtime_error("Cannot store '" + value + "' in column " + name_ + "." + columns_[c].name);
+        };
+        switch (storage_kind(columns_[c].type)) {
+            case StorageKind::INTEGER: {
+                int64_t parsed = 0;
+                if (!parse_integer(value, parsed)) throw invalid();
+                store<int64_t>(field, parsed);
+                break;
+            }
+            case StorageKind::DECIMAL: {
+                double parsed = 0;
+                if (!parse_decimal(value, parsed)) throw invalid();
+                store<double>(field, parsed);
+                break;
+            }
+            case StorageKind::BOOLEAN: {
+                bool parsed = false;
+                if (!parse_boolean(value, parsed)) throw invalid();
+                *field = parsed ? 1 : 0;
+                break;
+            }
+            case StorageKind::VARIABLE:
+                store<uint16_t>(field, static_cast<uint16_t>(std::min(image.size(), page_size)));
+                store<uint16_t>(field + 2, static_cast<uint16_t>(std::min(value.size(), page_size)));
+                image.insert(image.end(), value.begin(), value.end());
+                break;
+        }
+    }
+    if (image.size() + slot_size > page_size - page_header_size) {
+        throw std::runtime_error("Row of " + std::to_string(image.size()) + " bytes does not fit a page of table " +
+                                 name_);
+    }
+
+    // Start a page when the last one cannot take the image and its slot
+    uint8_t* page = pages_.empty() ? nullptr : pages_.back()->data();
+    if (page) {
+        const size_t slots = load<uint16_t>(page);
+        const size_t free_end = load<uint16_t>(page + 2);
+        if (free_end - (page_header_size + slots * slot_size) < image.size() + slot_size) page = nullptr;
+    }
+    if (!page) {
+        pages_.push_back(std::make_unique<Page>());
+        page = pages_.back()->data();
+        store<uint16_t>(page, 0);
+        store<uint16_t>(page + 2, static_cast<uint16_t>(page_size));
+        page_first_row_.push_back(row_count_);
+        page_zones_.emplace_back();
+        for (const auto& column : columns_) {
+            page_zones_.back().emplace_back(storage_kind(column.type));
+        }
+    }
+
+    const size_t slots = load<uint16_t>(page);
+    const size_t free_end = load<uint16_t>(page + 2);
+    const size_t offset = free_end - image.size();
+    std::memcpy(page + offset, image.data(), image.size());
+    store<uint16_t>(page + page_header_size + slots * slot_size, static_cast<uint16_t>(offset));
+    store<uint16_t>(page + page_header_size + slots * slot_size + 2, static_cast<uint16_t>(image.size()));
+    store<uint16_t>(page, static_cast<uint16_t>(slots + 1));
+    store<uint16_t>(page + 2, static_cast<uint16_t>(offset));
+    for (size_t c = 0; c < columns_.size(); ++c) {
+        page_zones_.back()[c].add(values[c]);
+    }
+    return row_count_++;
+}
+
+size_t TableHeap::page_of(size_t row) const {
+    return static_cast<size_t>(std::upper_bound(page_first_row_.begin(), page_first_row_.end(), row) -
+                               page_first_row_.begin()) - 1;
+}
+
+size_t TableHeap::bytes_used() const {
+    size_t bytes = 0;
+    for (const auto& page : pages_) {
+        const size_t slots = load<uint16_t>(page->data());
+        const size_t free_end = load<uint16_t>(page->data() + 2);
+        bytes += page_header_size + slots * slot_size + (page_size - free_end);
+    }
+    return bytes;
+}
+
+const uint8_t* TableHeap::row_image(size_t row) const {
+    if (row >= row_count_) {
+        throw std::out_of_range("Row " + std::to_string(row) + " of table " + name_);
+    }
+    const size_t page = page_of(row);
+    const uint8_t* data = pages_[page]->data();
+    const size_t slot = row - page_first_row_[page];
+    return data + load<uint16_t>(data + page_header_size + slot * slot_size);
+}
+
+std::string TableHeap::decode(const uint8_t* image, size_t column) const {
+    if (image[column / 8] & (1u << (column % 8))) return "";
+
+    const uint8_t* field = image + field_offsets_[column];
+    switch (storage_kind(columns_[column].type)) {
+        case StorageKind::INTEGER:
+            return std::to_string(load<int64_t>(field));
+        case StorageKind::DECIMAL:
+            return format_decimal(load<double>(field));
+        case StorageKind::BOOLEAN:
+            return *field ? "true" : "false";
+        default:
+            return std::string(reinterpret_cast<const char*>(image + load<uint16_t>(field)), load<uint16_t>(field + 2));
+    }
+}
+
+std::string TableHeap::value(size_t row, size_t column) const {
+    return column < columns_.size() ? decode(row_image(row), column) : "";
+}
+
+std::vector<std::string> TableHeap::read(size_t row, const std::vector<size_t>& columns) const {
+    const uint8_t* image = row_image(row);
+    std::vector<std::string> values;
+    if (columns.empty()) {
+        values.reserve(columns_.size());
+        for (size_t c = 0; c < columns_.size(); ++c) values.push_back(decode(image, c));
+        return values;
+    }
+    values.reserve(columns.size());
+    for (size_t c : columns) {
+        values.push_back(c < columns_.size() ? decode(image, c) : "");
+    }
+    return values;
+}
+
+TableStorage::TableStorage(std::shared_ptr<const DatabaseSchema> schema) : schema_(std::move(schema)) {}
+
+Table TableStorage::schema_table(const std::string& table_name) const {
+    const auto table = schema_ ? schema_->get_table(table_name) : std::nullopt;
+    if (!table) {
+        throw std::runtime_error("Table " + table_name + " is not in the schema");
+    }
+    return *table;
+}
+
+std::shared_ptr<TableHeap> TableStorage::create_table(const std::string& table_name) {
+    auto it = tables_.find(table_name);
+    if (it != tables_.end()) return it->second;
+
+    auto heap = std::make_shared<TableHeap>(schema_table(table_name));
+    tables_[table_name] = heap;
+    return heap;
+}
+
+std::shared_ptr<const TableHeap> TableStorage::get_table(const std::string& table_name) const {
+    const auto it = tables_.find(table_name);
+    return it == tables_.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<ColumnarTable> TableStorage::create_columnar_table(const std::string& table_name,
+                                                                   size_t row_group_size) {
+    auto it = columnar_tables_.find(table_name);
+    if (it != columnar_tables_.end()) return it->second;
+
+    auto table = std::make_shared<ColumnarTable>(schema_table(table_name), row_group_size);
+    columnar_tables_[table_name] = table;
+    return table;
+}
+
+std::shared_ptr<ColumnarTable> TableStorage::create_columnar_table(const std::string& table_name) {
+    return create_columnar_table(table_name, ColumnarTable::default_row_group_size);
+}
+
+std::shared_ptr<const ColumnarTable> TableStorage::get_columnar_table(const std::string& table_name) const {
+    const auto it = columnar_tables_.find(table_name);
+    return it == columnar_tables_.end() ? nullptr : it->second;
+}
+
+size_t TableStorage::insert(const std::string& table_name, const std::vector<std::string>& values) {
+    const auto heap = tables_.find(table_name);
+    const auto columnar = columnar_tables_.find(table_name);
+    if (columnar == columnar_tables_.end()) return create_table(table_name)->insert(values);
+
+    // The heap also rejects rows too long for a page, so it goes first
+    if (heap != tables_.end()) heap->second->insert(values);
+    return columnar->second->insert(values);
+}
+
+} // namespace db25
@@ -1,12 +1,48 @@
 #include <iostream>
 #include <cassert>
+#include <cmath>
+#include <functional>
 #include <memory>
 #include "query_planner.hpp"
+#include "memo_optimizer.hpp"
 #include "database.hpp"
 #include "simple_schema.hpp"
 
 using namespace db25;
 
+// Expression builders for the tests that assemble plans by hand
+static ExpressionPtr column(const std::string& table, const std::string& name) {
+    auto expr = std::make_shared<Expression>(ExpressionType::COLUMN_REF, table + "." + name);
+    expr->column_ref = ColumnRef{table, name};
+    return expr;
+}
+
+static ExpressionPtr constant(const std::string& value) {
+    return std::make_shared<Expression>(ExpressionType::CONSTANT, value);
+}
+
+static ExpressionPtr binary(const std::string& op, ExpressionPtr left, ExpressionPtr right) {
+    auto expr = std::make_shared<Expression>(ExpressionType::BINARY_OP, op);
+    expr->children = {std::move(left), std::move(right)};
+    return expr;
+}
+
+// Schema builders for the tables the tests add
+static Column schema_column(const std::string& name, ColumnType type) {
+    Column column;
+    column.name = name;
+    column.type = type;
+    return column;
+}
+
+static Table schema_table(const std::string& name, std::vector<Column> columns, std::vector<Index> indexes = {}) {
+    Table table;
+    table.name = name;
+    table.columns = std::move(columns);
+    table.indexes = std::move(indexes);
+    return table;
+}
+
 void test_basic_plan_creation() {
     std::cout << "Testing basic plan creation..." << std::endl;
     
@@ -200,6 +236,131 @@ void test_cost_estimation() {
     std::cout << "✓ Cost estimation passed" << std::endl;
 }
 
+void test_selectivity_estimation() {
+    std::cout << "Testing selectivity estimation..." << std::endl;
+    
+    auto schema = std::make_shared<DatabaseSchema>(create_simple_schema());
+    Column owner = schema_column("owner_id", ColumnType::INTEGER);
+    owner.references_table = "users";
+    owner.references_column = "id";
+    schema->add_table(schema_table("accounts", {schema_column("id", ColumnType::INTEGER),
+                                                schema_column("age", ColumnType::INTEGER),
+                                                schema_column("city", ColumnType::VARCHAR), owner}));
+    QueryPlanner planner(schema);
+    
+    TableStats users;
+    users.row_count = 10000;
+    planner.set_table_stats("users", users);
+    
+    // Ages spread evenly over 0..100; two cities cover half the rows
+    TableStats accounts;
+    accounts.row_count = 100000;
+    ColumnStats age;
+    age.distinct_values = 101;
+    age.value_type = SortKeyType::INTEGER;
+    for (int bound = 0; bound <= 100; bound += 10) {
+        age.histogram_bounds.push_back(std::to_string(bound));
+    }
+    accounts.columns["age"] = age;
+    ColumnStats city;
+    city.distinct_values = 50;
+    city.most_common_values = {{"paris", 0.4}, {"rome", 0.1}};
+    accounts.columns["city"] = city;
+    planner.set_table_stats("accounts", accounts);
+    
+    const auto estimate = [&](const std::vector<ExpressionPtr>& conditions) {
+        return planner.estimate_selectivity(conditions, "");
+    };
+    const auto near = [](double actual, double expected) { return std::abs(actual - expected) < 1e-6; };
+    
+    // Ranges read the histogram; a lower and an upper bound form one range
+    assert(near(estimate({binary("<", column("accounts", "age"), constant("25"))}), 0.25));
+    assert(near(estimate({binary(">", constant("25"), column("accounts", "age"))}), 0.25));
+    assert(near(estimate({binary(">", column("accounts", "age"), constant("20")),
+                          binary("<", column("accounts", "age"), constant("30"))}), 0.1));
+    
+    // Equality reads the MCV list, else spreads the rest over the other values
+    const auto paris = binary("=", column("accounts", "city"), constant("paris"));
+    const auto rome = binary("=", column("accounts", "city"), constant("rome"));
+    assert(near(estimate({paris}), 0.4));
+    assert(near(estimate({binary("=", column("accounts", "city"), constant("oslo"))}), 0.5 / 48));
+    assert(near(estimate({binary("~~", column("accounts", "city"), constant("par%"))}), 0.4 + 0.5 * 0.2));
+    
+    // Boolean combinations
+    auto either = std::make_shared<Expression>(ExpressionType::BINARY_OP, "OR");
+    either->children = {paris, rome};
+    assert(near(estimate({either}), 0.46));
+    auto negated = std::make_shared<Expression>(ExpressionType::BINARY_OP, "NOT");
+    negated->children = {paris};
+    assert(near(estimate({negated}), 0.6));
+    
+    // A foreign key matches each account to one user
+    assert(near(estimate({binary("=", column("accounts", "owner_id"), column("users", "id"))}), 1.0 / 10000));
+    
+    // Without statistics a primary key is unique, other columns get defaults
+    assert(near(planner.estimate_selectivity({binary("=", column("users", "id"), constant("7"))}, "users"),
+                1.0 / 10000));
+    assert(near(estimate({binary("=", column("products", "name"), constant("x"))}), 0.1));
+    
+    // Scans make their alias known to the conditions above them
+    auto scan = std::make_shared<TableScanNode>("accounts");
+    scan->alias = "a";
+    scan->filter_conditions.push_back(binary("<", column("a", "age"), constant("25")));
+    planner.estimate_costs(scan);
+    assert(scan->cost.estimated_rows == 25000);
+    
+    std::cout << "✓ Selectivity estimation passed" << std::endl;
+}
+
+void test_correlated_statistics() {
+    std::cout << "Testing correlated statistics..." << std::endl;
+    
+    auto schema = std::make_shared<DatabaseSchema>(create_simple_schema());
+    schema->add_table(schema_table("addresses", {schema_column("street", ColumnType::VARCHAR),
+                                                 schema_column("zip", ColumnType::VARCHAR),
+                                                 schema_column("city", ColumnType::VARCHAR)}));
+    QueryPlanner planner(schema);
+    
+    // 100 zip codes, ten per city: the zip code determines the city
+    auto scan = std::make_shared<SequentialScanNode>("addresses");
+    scan->output_columns = {"addresses.street", "addresses.zip", "addresses.city"};
+    for (size_t i = 0; i < 1000; ++i) {
+        const size_t zip = i % 100;
+        scan->mock_data.push_back(Tuple({"street" + std::to_string(i), "z" + std::to_string(zip),
+                                         "c" + std::to_string(zip / 10)}));
+    }
+    auto catalog = planner.get_statistics_catalog();
+    catalog->create_statistics("addresses", {"zip", "city"});
+    catalog->create_statistics("addresses", {"street", "zip", "city"});
+    const TableStats stats = catalog->analyze_table("addresses", scan);
+    assert(stats.extended.size() == 2);
+    assert(std::abs(stats.extended[0].distinct_values - 100) < 5);
+    for (const auto& dependency : stats.extended[0].dependencies) {
+        assert(dependency.determinant == "zip" ? dependency.degree == 1.0 : dependency.degree == 0.0);
+    }
+    
+    const auto equals = [](const std::string& name, const std::string& value) {
+        return binary("=", column("addresses", name), constant(value));
+    };
+    const auto near = [](double actual, double expected) { return std::abs(actual - expected) < 1e-6; };
+    
+    // The pair is as selective as the zip code alone, not a tenth of it
+    assert(near(planner.estimate_selectivity({equals("city", "c3"), equals("zip", "z35")}, "addresses"), 0.01));
+    
+    // A combination never seen is rare however common its values are
+    assert(planner.estimate_selectivity({equals("city", "c4"), equals("zip", "z35")}, "addresses") < 1e-6);
+    
+    // Without the pair statistics, the dependency still links the columns
+    catalog->set_table_stats("addresses", [&] {
+        TableStats dependencies_only = stats;
+        dependencies_only.extended.erase(dependencies_only.extended.begin());
+        return dependencies_only;
+    }());
+    assert(near(planner.estimate_selectivity({equals("city", "c3"), equals("zip", "z35")}, "addresses"), 0.01));
+    
+    std::cout << "✓ Correlated statistics passed" << std::endl;
+}
+
 void test_plan_optimization() {
     std::cout << "Testing plan optimization..." << std::endl;
     
@@ -216,6 +377,307 @@ void test_plan_optimization() {
     std::cout << "✓ Plan optimization passed" << std::endl;
 }
 
+void test_predicate_pushdown() {
+    std::cout << "Testing predicate pushdown..." << std::endl;
+    
+    auto schema = std::make_shared<DatabaseSchema>(create_simple_schema());
+    
+    const auto coalesce = [](ExpressionPtr argument, ExpressionPtr fallback) {
+        auto expr = std::make_shared<Expression>(ExpressionType::FUNCTION_CALL, "coalesce");
+        expr->children = {std::move(argument), std::move(fallback)};
+        return expr;
+    };
+    
+    // SELECT ... FROM users JOIN products [ON on] WHERE where
+    const auto optimize = [&](JoinType join_type, std::vector<ExpressionPtr> on, std::vector<ExpressionPtr> where) {
+        auto join = std::make_shared<NestedLoopJoinNode>(join_type);
+        join->children = {std::make_shared<TableScanNode>("users"), std::make_shared<TableScanNode>("products")};
+        join->join_conditions = std::move(on);
+        auto selection = std::make_shared<SelectionNode>();
+        selection->conditions = std::move(where);
+        selection->children.push_back(join);
+        
+        PredicatePushdownTransformer pushdown(schema);
+        return pushdown.transform(selection);
+    };
+    const auto scan_filters = [](const LogicalPlanNodePtr& node) {
+        return std::static_pointer_cast<TableScanNode>(node)->filter_conditions.size();
+    };
+    
+    // Inner join: conjuncts split per table, the cross-table one joins
+    auto root = optimize(JoinType::INNER, {},
+                         {binary("AND", binary("=", column("users", "name"), constant("alice")),
+                                        binary(">", column("products", "price"), constant("10"))),
+                          binary("=", column("users", "id"), column("products", "id"))});
+    assert(root->type == PlanNodeType::NESTED_LOOP_JOIN);
+    assert(std::static_pointer_cast<JoinNode>(root)->join_conditions.size() == 1);
+    assert(scan_filters(root->children[0]) == 1);
+    assert(scan_filters(root->children[1]) == 1);
+    
+    // Left join: ON filters only the padded side, a WHERE predicate that
+    // tolerates NULLs stays above the join
+    root = optimize(JoinType::LEFT,
+                    {binary("=", column("users", "id"), column("products", "id")),
+                     binary(">", column("products", "price"), constant("10"))},
+                    {binary("=", column("users", "name"), constant("alice")),
+                     binary(">", coalesce(column("products", "price"), constant("0")), constant("10"))});
+    assert(root->type == PlanNodeType::SELECTION);
+    auto join = std::static_pointer_cast<JoinNode>(root->children[0]);
+    assert(join->join_type == JoinType::LEFT);
+    assert(join->join_conditions.size() == 1);
+    assert(scan_filters(join->children[0]) == 1);
+    assert(scan_filters(join->children[1]) == 1);
+    
+    // A WHERE comparison on the padded side discards padded rows: inner join
+    root = optimize(JoinType::LEFT, {binary("=", column("users", "id"), column("products", "id"))},
+                    {binary(">", column("products", "price"), constant("10"))});
+    join = std::static_pointer_cast<JoinNode>(root);
+    assert(join->join_type == JoinType::INNER);
+    assert(scan_filters(join->children[0]) == 0);
+    assert(scan_filters(join->children[1]) == 1);
+    
+    std::cout << "✓ Predicate pushdown passed" << std::endl;
+}
+
+void test_transitive_predicates() {
+    std::cout << "Testing transitive predicate inference..." << std::endl;
+    
+    auto schema = std::make_shared<DatabaseSchema>(create_simple_schema());
+    
+    const auto optimize = [&](ExpressionPtr restriction) {
+        auto join = std::make_shared<NestedLoopJoinNode>(JoinType::INNER);
+        join->children = {std::make_shared<TableScanNode>("users"), std::make_shared<TableScanNode>("products")};
+        join->join_conditions = {binary("=", column("users", "id"), column("products", "id")),
+                                 binary("=", column("products", "id"), column("users", "id"))};
+        auto selection = std::make_shared<SelectionNode>();
+        selection->conditions = {std::move(restriction)};
+        selection->children.push_back(join);
+        
+        PredicatePushdownTransformer pushdown(schema);
+        return std::static_pointer_cast<JoinNode>(pushdown.transform(selection));
+    };
+    const auto filters = [](const LogicalPlanNodePtr& node) {
+        return std::static_pointer_cast<TableScanNode>(node)->filter_conditions;
+    };
+    
+    // users.id = 42 implies products.id = 42, which makes the join key redundant
+    auto join = optimize(binary("=", column("users", "id"), constant("42")));
+    assert(join->join_conditions.empty());
+    assert(filters(join->children[0]).size() == 1);
+    assert(filters(join->children[1]).size() == 1);
+    const auto implied = filters(join->children[1])[0];
+    assert(implied->value == "=" && implied->children[0]->column_ref->table_alias == "products");
+    
+    // Ranges carry over too; the mirrored duplicate of the join key is dropped
+    join = optimize(binary(">", column("products", "id"), constant("10")));
+    assert(join->join_conditions.size() == 1);
+    assert(filters(join->children[0]).size() == 1 && filters(join->children[0])[0]->value == ">");
+    assert(filters(join->children[1]).size() == 1);
+    
+    std::cout << "✓ Transitive predicate inference passed" << std::endl;
+}
+
+void test_join_enumeration() {
+    std::cout << "Testing join enumeration..." << std::endl;
+    
+    auto schema = std::make_shared<DatabaseSchema>(create_simple_schema());
+    schema->add_table(schema_table("orders", {schema_column("id", ColumnType::INTEGER),
+                                              schema_column("user_id", ColumnType::INTEGER),
+                                              schema_column("product_id", ColumnType::INTEGER)}));
+    schema->add_table(schema_table("reviews", {schema_column("id", ColumnType::INTEGER),
+                                               schema_column("product_id", ColumnType::INTEGER)}));
+    QueryPlanner planner(schema);
+    for (const auto& [table, rows] : std::vector<std::pair<std::string, size_t>>{
+             {"users", 1000}, {"products", 200}, {"orders", 100000}, {"reviews", 50000}}) {
+        TableStats stats;
+        stats.row_count = rows;
+        planner.set_table_stats(table, stats);
+    }
+    
+    const auto equals = [](const std::string& left_table, const std::string& left_column,
+                           const std::string& right_table, const std::string& right_column) {
+        return binary("=", column(left_table, left_column), column(right_table, right_column));
+    };
+    const std::vector<ExpressionPtr> conditions = {equals("users", "id", "orders", "user_id"),
+                                                   equals("products", "id", "orders", "product_id"),
+                                                   equals("products", "id", "reviews", "product_id")};
+    
+    // FROM users, products, reviews, orders: left-deep in FROM order starts
+    // with a cross product, and every join lists every condition
+    const auto reorder = [&](size_t dp_join_limit) {
+        auto config = planner.get_config();
+        config.dp_join_limit = dp_join_limit;
+        planner.set_config(config);
+        
+        LogicalPlanNodePtr root = std::make_shared<TableScanNode>("users");
+        for (const std::string table : {"products", "reviews", "orders"}) {
+            auto join = std::make_shared<NestedLoopJoinNode>(JoinType::INNER);
+            join->children = {root, std::make_shared<TableScanNode>(table)};
+            join->join_conditions = conditions;
+            root = join;
+        }
+        JoinReorderingTransformer reordering(planner);
+        return reordering.transform(root);
+    };
+    // Every join applies exactly one condition, so none is a cross product
+    const std::function<size_t(const LogicalPlanNodePtr&)> count_scans = [&](const LogicalPlanNodePtr& node) -> size_t {
+        const auto join = std::dynamic_pointer_cast<JoinNode>(node);
+        if (!join) return node->type == PlanNodeType::TABLE_SCAN ? 1 : 0;
+        assert(join->join_conditions.size() == 1);
+        return count_scans(node->children[0]) + count_scans(node->children[1]);
+    };
+    
+    // Exhaustive enumeration joins each small table to its large one first
+    auto root = reorder(10);
+    assert(count_scans(root) == 4);
+    assert(std::dynamic_pointer_cast<JoinNode>(root->children[0]));
+    assert(std::dynamic_pointer_cast<JoinNode>(root->children[1]));
+    
+    // Above the limit the greedy fallback still avoids cross products
+    root = reorder(2);
+    assert(count_scans(root) == 4);
+    
+    std::cout << "✓ Join enumeration passed" << std::endl;
+}
+
+void test_memo_search() {
+    std::cout << "Testing memo search..." << std::endl;
+    
+    auto schema = std::make_shared<DatabaseSchema>(create_simple_schema());
+    schema->add_table(schema_table("orders", {schema_column("id", ColumnType::INTEGER),
+                                              schema_column("user_id", ColumnType::INTEGER)},
+                                   {Index{"idx_orders_user_id", {"user_id"}}}));
+    QueryPlanner planner(schema);
+    TableStats stats;
+    stats.row_count = 100000;
+    planner.set_table_stats("orders", stats);
+    
+    const auto optimize = [&](const LogicalPlanNodePtr& root) {
+        LogicalPlan plan;
+        plan.root = root;
+        return planner.optimize_plan(plan).root;
+    };
+    
+    // A selective filter on the indexed column becomes an index condition
+    auto scan = std::make_shared<TableScanNode>("orders");
+    scan->filter_conditions.push_back(binary("=", column("orders", "user_id"), constant("42")));
+    auto root = optimize(scan);
+    assert(root->type == PlanNodeType::INDEX_SCAN);
+    assert(std::static_pointer_cast<IndexScanNode>(root)->index_conditions.size() == 1);
+    
+    // Reading the index in order is cheaper than sorting the whole table
+    auto sort = std::make_shared<SortNode>();
+    sort->sort_keys.push_back({column("orders", "user_id")});
+    sort->children.push_back(std::make_shared<TableScanNode>("orders"));
+    auto sorted_scan = sort->copy();
+    planner.estimate_costs(sorted_scan);
+    root = optimize(sort);
+    assert(root->type == PlanNodeType::SORT);
+    assert(root->children[0]->type == PlanNodeType::INDEX_SCAN);
+    assert(root->cost.total_cost < sorted_scan->cost.total_cost);
+    
+    // Every join algorithm of both join orders is costed
+    auto join = std::make_shared<NestedLoopJoinNode>(JoinType::INNER);
+    join->join_conditions.push_back(binary("=", column("users", "id"), column("orders", "user_id")));
+    join->children = {std::make_shared<TableScanNode>("users"), std::make_shared<TableScanNode>("orders")};
+    planner.estimate_costs(join);
+    MemoOptimizer memo(planner, schema);
+    root = memo.optimize(join);
+    assert(memo.group_count() == 3);
+    assert(memo.expression_count() == 4);
+    assert(root->cost.total_cost <= join->cost.total_cost);
+    const auto alternatives = memo.alternatives();
+    assert(alternatives.size() >= 4);
+    for (size_t i = 1; i < alternatives.size(); ++i) {
+        assert(alternatives[i - 1]->cost.total_cost <= alternatives[i]->cost.total_cost);
+    }
+    
+    // Without the search the planner keeps the access path it was given
+    auto config = planner.get_config();
+    config.enable_memo_search = false;
+    planner.set_config(config);
+    assert(optimize(scan)->type == PlanNodeType::TABLE_SCAN);
+    
+    std::cout << "✓ Memo search passed" << std::endl;
+}
+
+void test_join_elimination() {
+    std::cout << "Testing join elimination..." << std::endl;
+    
+    auto schema = std::make_shared<DatabaseSchema>(create_simple_schema());
+    Column order_id = schema_column("id", ColumnType::INTEGER);
+    order_id.nullable = false;
+    Column user_id = schema_column("user_id", ColumnType::INTEGER);
+    user_id.nullable = false;
+    user_id.references_table = "users";
+    user_id.references_column = "id";
+    Column coupon = schema_column("coupon", ColumnType::VARCHAR);
+    coupon.unique = true;
+    schema->add_table(schema_table("orders", {order_id, schema_column("total", ColumnType::DECIMAL), user_id, coupon}));
+    
+    // SELECT columns FROM orders JOIN users ON orders.user_id = users.id
+    const auto join_plan = [&](JoinType join_type, std::vector<ExpressionPtr> columns) {
+        auto join = std::make_shared<NestedLoopJoinNode>(join_type);
+        join->children = {std::make_shared<TableScanNode>("orders"), std::make_shared<TableScanNode>("users")};
+        join->join_conditions = {binary("=", column("orders", "user_id"), column("users", "id"))};
+        auto projection = std::make_shared<ProjectionNode>();
+        projection->projections = std::move(columns);
+        projection->children.push_back(join);
+        return projection;
+    };
+    const auto eliminate = [&](const LogicalPlanNodePtr& plan) {
+        JoinEliminationTransformer elimination(schema);
+        return elimination.transform(plan);
+    };
+    
+    // Every order has exactly one user, and nothing reads it
+    auto plan = eliminate(join_plan(JoinType::INNER, {column("orders", "total")}));
+    assert(plan->children[0]->type == PlanNodeType::TABLE_SCAN);
+    assert(std::static_pointer_cast<TableScanNode>(plan->children[0])->table_name == "orders");
+    
+    // The user is read
+    plan = eliminate(join_plan(JoinType::INNER, {column("orders", "total"), column("users", "name")}));
+    assert(plan->children[0]->type == PlanNodeType::NESTED_LOOP_JOIN);
+    
+    // A filter on users may reject the match
+    auto filtered = join_plan(JoinType::INNER, {column("orders", "total")});
+    std::static_pointer_cast<TableScanNode>(filtered->children[0]->children[1])->filter_conditions.push_back(
+        binary("=", column("users", "name"), constant("bob")));
+    assert(eliminate(filtered)->children[0]->type == PlanNodeType::NESTED_LOOP_JOIN);
+    
+    // Without the foreign key only an outer join keeps every order once
+    auto join = std::make_shared<NestedLoopJoinNode>(JoinType::INNER);
+    join->children = {std::make_shared<TableScanNode>("products"), std::make_shared<TableScanNode>("users")};
+    join->join_conditions = {binary("=", column("products", "id"), column("users", "id"))};
+    auto projection = std::make_shared<ProjectionNode>();
+    projection->projections = {column("products", "name")};
+    projection->children.push_back(join);
+    assert(eliminate(projection)->children[0]->type == PlanNodeType::NESTED_LOOP_JOIN);
+    join->join_type = JoinType::LEFT;
+    assert(eliminate(projection)->children[0]->type == PlanNodeType::TABLE_SCAN);
+    
+    // Join rows stay unique on the order key, so grouping by it is a no-op
+    const auto grouped = [&](std::vector<ExpressionPtr> group_by) {
+        auto aggregation = std::make_shared<AggregationNode>();
+        aggregation->group_by_exprs = std::move(group_by);
+        aggregation->children.push_back(join_plan(JoinType::INNER, {column("orders", "id"), column("orders", "total"),
+                                                                    column("users", "email")})->children[0]);
+        DistinctEliminationTransformer elimination(schema);
+        return elimination.transform(aggregation);
+    };
+    schema->add_index("orders", Index{"orders_pkey", {"id"}, true});
+    assert(grouped({column("users", "email"), column("orders", "id")})->type == PlanNodeType::PROJECTION);
+    assert(grouped({column("users", "email")})->type == PlanNodeType::AGGREGATION);
+    assert(grouped({column("orders", "total")})->type == PlanNodeType::AGGREGATION);
+    
+    // Orders without a coupon share its NULL, so a nullable unique column is no key
+    assert(grouped({column("orders", "coupon")})->type == PlanNodeType::AGGREGATION);
+    schema->add_index("orders", Index{"orders_coupon_key", {"coupon", "user_id"}, true});
+    assert(grouped({column("orders", "coupon"), column("orders", "user_id")})->type == PlanNodeType::AGGREGATION);
+    
+    std::cout << "✓ Join elimination passed" << std::endl;
+}
+
 void test_alternative_plans() {
     std::cout << "Testing alternative plan generation..." << std::endl;
     
@@ -299,7 +761,14 @@ int main() {
         test_sort_plans();
         test_limit_plans();
         test_cost_estimation();
+        test_selectivity_estimation();
+        test_correlated_statistics();
         test_plan_optimization();
+        test_predicate_pushdown();
+        test_transitive_predicates();
+        test_join_enumeration();
+        test_memo_search();
+        test_join_elimination();
         test_alternative_plans();
         test_complex_query_planning();
         test_planner_configuration();
@@ -1,15 +1,60 @@
 #include <iostream>
+#include <algorithm>
 #include <cassert>
+#include <map>
 #include <memory>
 #include <vector>
+#include <random>
+#include <stdexcept>
 #include "physical_plan.hpp"
 #include "physical_planner.hpp"
 #include "query_planner.hpp"
 #include "database.hpp"
 #include "simple_schema.hpp"
+#include "table_storage.hpp"
 
 using namespace db25;
 
+// Expression builders for the tests that assemble plans by hand
+static ExpressionPtr column(const std::string& name) {
+    return std::make_shared<Expression>(ExpressionType::COLUMN_REF, name);
+}
+
+static ExpressionPtr constant(const std::string& value) {
+    return std::make_shared<Expression>(ExpressionType::CONSTANT, value);
+}
+
+static ExpressionPtr call(ExpressionType type, const std::string& name, std::vector<ExpressionPtr> arguments) {
+    auto expr = std::make_shared<Expression>(type, name);
+    expr->children = std::move(arguments);
+    return expr;
+}
+
+static ExpressionPtr operation(const std::string& op, std::vector<ExpressionPtr> operands) {
+    return call(ExpressionType::BINARY_OP, op, std::move(operands));
+}
+
+// <column> <op> '<value>'
+static ExpressionPtr comparison(const std::string& op, const std::string& name, const std::string& value) {
+    return operation(op, {column(name), constant(value)});
+}
+
+// Schema of database holding one table, for the tests over table storage
+static std::shared_ptr<DatabaseSchema> table_schema(const std::string& database, const std::string& table_name,
+                                                    const std::vector<std::pair<std::string, ColumnType>>& columns) {
+    Table table;
+    table.name = table_name;
+    for (const auto& [name, type] : columns) {
+        Column column;
+        column.name = name;
+        column.type = type;
+        table.columns.push_back(column);
+    }
+    auto schema = std::make_shared<DatabaseSchema>(database);
+    schema->add_table(table);
+    return schema;
+}
+
 void test_sequential_scan_execution() {
     std::cout << "Testing sequential scan execution..." << std::endl;
     
@@ -45,6 +90,23 @@ void test_index_scan_execution() {
     auto batch = index_scan->get_next_batch();
     assert(batch.size() <= 50);
     
+    // A text column whose values all look like numbers is still ordered as text
+    auto names = std::make_shared<PhysicalIndexScanNode>("users", "users_name_idx");
+    names->output_columns = {"users.name"};
+    names->index_columns = {"name"};
+    names->index_key_types = {SortKeyType::TEXT};
+    for (const std::string name : {"9", "10", "100", "2"}) {
+        names->mock_data.emplace_back(std::vector<std::string>{name});
+    }
+    std::vector<size_t> key_columns = {0};
+    assert(sort_index_rows(names->mock_data, key_columns, names->index_key_types)[0] == SortKeyType::TEXT);
+    names->initialize(&context);
+    std::vector<std::string> found;
+    while (names->has_more_data()) {
+        for (const auto& tuple : names->get_next_batch().tuples) found.push_back(tuple.values[0]);
+    }
+    assert((found == std::vector<std::string>{"10", "100", "2", "9"}));
+    
     std::cout << "✓ Index scan execution passed (rows: " << batch.size() << ")" << std::endl;
 }
 
@@ -84,7 +146,7 @@ void test_sort_execution() {
     
     // Add a sort key
     PhysicalSortNode::SortKey sort_key;
-    sort_key.expression = std::make_shared<Expression>(ExpressionType::COLUMN_REF, "name");
+    sort_key.expression = column("name");
     sort_key.ascending = true;
     sort_node->sort_keys.push_back(sort_key);
     
@@ -97,6 +159,465 @@ void test_sort_execution() {
     std::cout << "✓ Sort execution passed (rows: " << batch.size() << ")" << std::endl;
 }
 
+void test_multi_column_sort_execution() {
+    std::cout << "Testing multi-column sort execution..." << std::endl;
+    
+    auto seq_scan = std::make_shared<SequentialScanNode>("measurements");
+    seq_scan->output_columns = {"measurements.reading", "measurements.label"};
+    const std::vector<std::vector<std::string>> rows = {
+        {"10", "b"}, {"9", "a"}, {"", "c"}, {"-3", "z"}, {"9", "b"}, {"2.5", "x"}
+    };
+    for (const auto& row : rows) {
+        seq_scan->mock_data.emplace_back(row);
+    }
+    
+    auto sort_node = std::make_shared<PhysicalSortNode>();
+    sort_node->children.push_back(seq_scan);
+    sort_node->output_columns = seq_scan->output_columns;
+    
+    // reading DESC NULLS LAST, label ASC: readings must compare numerically
+    PhysicalSortKey reading_key;
+    reading_key.expression = column("reading");
+    reading_key.ascending = false;
+    reading_key.nulls_first = false;
+    reading_key.type = SortKeyType::INTEGER; // Widened to FLOAT by "2.5"
+    sort_node->sort_keys.push_back(reading_key);
+    
+    PhysicalSortKey label_key;
+    label_key.expression = column("label");
+    sort_node->sort_keys.push_back(label_key);
+    
+    ExecutionContext context;
+    sort_node->initialize(&context);
+    auto batch = sort_node->get_next_batch();
+    
+    const std::vector<std::vector<std::string>> expected = {
+        {"10", "b"}, {"9", "a"}, {"9", "b"}, {"2.5", "x"}, {"-3", "z"}, {"", "c"}
+    };
+    assert(batch.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        assert(batch.tuples[i].values == expected[i]);
+    }
+    
+    // Enough rows to go through the radix passes, with negatives and duplicates
+    auto large_scan = std::make_shared<SequentialScanNode>("measurements");
+    large_scan->output_columns = {"measurements.reading"};
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dist(-5000, 5000);
+    for (int i = 0; i < 5000; ++i) {
+        large_scan->mock_data.emplace_back(std::vector<std::string>{std::to_string(dist(rng))});
+    }
+    
+    auto large_sort = std::make_shared<PhysicalSortNode>();
+    large_sort->children.push_back(large_scan);
+    reading_key.ascending = true;
+    reading_key.type = SortKeyType::INFERRED;
+    large_sort->sort_keys.push_back(reading_key);
+    
+    context.work_mem_limit = 10000 * 1000;
+    large_sort->initialize(&context);
+    auto large_batch = large_sort->get_next_batch();
+    assert(large_batch.size() == 5000);
+    for (size_t i = 1; i < large_batch.size(); ++i) {
+        assert(std::stoi(large_batch.tuples[i - 1].values[0]) <= std::stoi(large_batch.tuples[i].values[0]));
+    }
+    
+    std::cout << "✓ Multi-column sort execution passed" << std::endl;
+}
+
+void test_parallel_sort_execution() {
+    std::cout << "Testing parallel sort execution..." << std::endl;
+    
+    ExecutionContext context;
+    context.max_parallel_workers = 4;
+    context.work_mem_limit = 100000 * 1000;
+    
+    // Range-partitioned sort inside a single sort node
+    auto scan = std::make_shared<SequentialScanNode>("measurements");
+    scan->output_columns = {"measurements.reading"};
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> dist(-1000000, 1000000);
+    for (int i = 0; i < 100000; ++i) {
+        scan->mock_data.emplace_back(std::vector<std::string>{std::to_string(dist(rng))});
+    }
+    
+    auto sort_node = std::make_shared<PhysicalSortNode>();
+    sort_node->children.push_back(scan);
+    sort_node->parallel_degree = 4;
+    PhysicalSortKey reading_key;
+    reading_key.expression = column("reading");
+    sort_node->sort_keys.push_back(reading_key);
+    
+    sort_node->initialize(&context);
+    auto batch = sort_node->get_next_batch();
+    assert(batch.size() == 100000);
+    for (size_t i = 1; i < batch.size(); ++i) {
+        assert(std::stoi(batch.tuples[i - 1].values[0]) <= std::stoi(batch.tuples[i].values[0]));
+    }
+    
+    // Per-worker scans and sorts merged by a gather merge
+    auto gather_merge = std::make_shared<GatherMergeNode>();
+    PhysicalSortKey id_key;
+    id_key.expression = column("id");
+    id_key.ascending = false;
+    gather_merge->sort_keys.push_back(id_key);
+    for (size_t worker = 0; worker < 3; ++worker) {
+        auto worker_scan = std::make_shared<SequentialScanNode>("users");
+        worker_scan->output_columns = {"users.id", "users.email", "users.name"};
+        worker_scan->generate_mock_data(3000);
+        worker_scan->partition_index = worker;
+        worker_scan->partition_count = 3;
+        
+        auto worker_sort = std::make_shared<PhysicalSortNode>();
+        worker_sort->sort_keys.push_back(id_key);
+        worker_sort->output_columns = worker_scan->output_columns;
+        worker_sort->children.push_back(worker_scan);
+        gather_merge->children.push_back(worker_sort);
+    }
+    gather_merge->output_columns = gather_merge->children[0]->output_columns;
+    
+    gather_merge->initialize(&context);
+    auto merged = gather_merge->get_next_batch();
+    assert(merged.size() == 3000);
+    for (size_t i = 0; i < merged.size(); ++i) {
+        assert(merged.tuples[i].values[0] == std::to_string(3000 - i));
+    }
+    assert(!gather_merge->has_more_data());
+    
+    // A text value in one worker widens the key for all of them, so the
+    // merge matches one sort over every row
+    const std::vector<std::vector<std::string>> worker_codes = {{"9", "10", "2"}, {"10", "a", "02"}, {"9", "", "100"}};
+    PhysicalSortKey code_key;
+    code_key.expression = column("code");
+    code_key.type = SortKeyType::INTEGER;
+    auto mixed_merge = std::make_shared<GatherMergeNode>();
+    mixed_merge->sort_keys.push_back(code_key);
+    auto all_codes = std::make_shared<SequentialScanNode>("codes");
+    all_codes->output_columns = {"codes.code"};
+    for (const auto& codes : worker_codes) {
+        auto worker_scan = std::make_shared<SequentialScanNode>("codes");
+        worker_scan->output_columns = all_codes->output_columns;
+        for (const auto& code : codes) {
+            worker_scan->mock_data.emplace_back(std::vector<std::string>{code});
+            all_codes->mock_data.emplace_back(std::vector<std::string>{code});
+        }
+        auto worker_sort = std::make_shared<PhysicalSortNode>();
+        worker_sort->sort_keys.push_back(code_key);
+        worker_sort->output_columns = worker_scan->output_columns;
+        worker_sort->children.push_back(worker_scan);
+        mixed_merge->children.push_back(worker_sort);
+    }
+    mixed_merge->output_columns = all_codes->output_columns;
+    auto single_sort = std::make_shared<PhysicalSortNode>();
+    single_sort->sort_keys.push_back(code_key);
+    single_sort->output_columns = all_codes->output_columns;
+    single_sort->children.push_back(all_codes);
+    
+    const auto merged_codes = PhysicalPlan(mixed_merge).execute();
+    const auto sorted_codes = PhysicalPlan(single_sort).execute();
+    assert(merged_codes.size() == 9 && sorted_codes.size() == 9);
+    for (size_t i = 0; i < merged_codes.size(); ++i) {
+        assert(merged_codes[i].values == sorted_codes[i].values);
+    }
+    assert(merged_codes[0].values[0] == "02" && merged_codes[7].values[0] == "a");
+    
+    std::cout << "✓ Parallel sort execution passed" << std::endl;
+}
+
+static size_t run_merge_join(JoinType join_type, ExecutionContext* context) {
+    // Both inputs arrive sorted ascending on the key, NULLs last
+    auto users = std::make_shared<SequentialScanNode>("users");
+    users->output_columns = {"users.id", "users.name"};
+    for (const std::string id : {"1", "2", "2", "3", "5", ""}) {
+        users->mock_data.emplace_back(std::vector<std::string>{id, "user" + id});
+    }
+    auto orders = std::make_shared<SequentialScanNode>("orders");
+    orders->output_columns = {"orders.user_id", "orders.amount"};
+    for (const std::string id : {"2", "2", "3", "4", "5", "5", ""}) {
+        orders->mock_data.emplace_back(std::vector<std::string>{id, "10"});
+    }
+    
+    auto merge_join = std::make_shared<PhysicalMergeJoinNode>(join_type);
+    merge_join->left_keys.push_back(column("users.id"));
+    merge_join->right_keys.push_back(column("orders.user_id"));
+    merge_join->children = {users, orders};
+    if (join_type == JoinType::SEMI || join_type == JoinType::ANTI) {
+        merge_join->output_columns = users->output_columns;
+    } else {
+        merge_join->output_columns = {"users.id", "users.name", "orders.user_id", "orders.amount"};
+    }
+    
+    merge_join->initialize(context);
+    size_t rows = 0;
+    while (merge_join->has_more_data()) {
+        auto batch = merge_join->get_next_batch();
+        for (const auto& tuple : batch.tuples) {
+            assert(tuple.values.size() == merge_join->output_columns.size());
+            if (tuple.values.size() == 4 && !tuple.values[0].empty() && !tuple.values[2].empty()) {
+                assert(tuple.values[0] == tuple.values[2]);
+            }
+        }
+        rows += batch.size();
+    }
+    return rows;
+}
+
+void test_merge_join_execution() {
+    std::cout << "Testing merge join execution..." << std::endl;
+    
+    ExecutionContext context;
+    context.work_mem_limit = 2 * 1000; // Two-row batches split the duplicate groups
+    
+    assert(run_merge_join(JoinType::INNER, &context) == 7);
+    assert(run_merge_join(JoinType::LEFT, &context) == 9);
+    assert(run_merge_join(JoinType::RIGHT, &context) == 9);
+    assert(run_merge_join(JoinType::FULL, &context) == 11);
+    assert(run_merge_join(JoinType::SEMI, &context) == 4);
+    assert(run_merge_join(JoinType::ANTI, &context) == 2);
+    
+    // Unsorted inputs sorted below the join: a text key on one side widens
+    // both sorts, and the key type decides whether "02134" equals "2134"
+    const auto sorted_join = [&](const std::vector<std::string>& left_ids, const std::vector<std::string>& right_ids,
+                                 SortKeyType key_type) {
+        auto merge_join = std::make_shared<PhysicalMergeJoinNode>(JoinType::INNER);
+        for (const auto& [name, ids] : {std::make_pair(std::string("l"), left_ids), std::make_pair(std::string("r"), right_ids)}) {
+            auto scan = std::make_shared<SequentialScanNode>(name);
+            scan->output_columns = {name + ".id"};
+            for (const auto& id : ids) {
+                scan->mock_data.emplace_back(std::vector<std::string>{id});
+            }
+            PhysicalSortKey id_key;
+            id_key.expression = column(name + ".id");
+            id_key.type = key_type;
+            auto sort = std::make_shared<PhysicalSortNode>();
+            sort->sort_keys.push_back(id_key);
+            sort->output_columns = scan->output_columns;
+            sort->children.push_back(scan);
+            merge_join->children.push_back(sort);
+            (name == "l" ? merge_join->left_keys : merge_join->right_keys).push_back(id_key.expression);
+        }
+        merge_join->key_types = {key_type};
+        merge_join->output_columns = {"l.id", "r.id"};
+        return PhysicalPlan(merge_join).execute();
+    };
+    const auto mixed = sorted_join({"9", "10", "a"}, {"10", "9"}, SortKeyType::INFERRED);
+    assert(mixed.size() == 2);
+    for (const auto& row : mixed) {
+        assert(row.values[0] == row.values[1]);
+    }
+    assert(sorted_join({"02134", "2134", "9"}, {"2134", "10"}, SortKeyType::TEXT).size() == 1);
+    assert(sorted_join({"02134", "2134", "9"}, {"2134", "10"}, SortKeyType::INTEGER).size() == 2);
+    
+    // An index input ordered as numbers is sorted again for a text merge
+    auto text_join = std::make_shared<PhysicalMergeJoinNode>(JoinType::INNER);
+    auto names = std::make_shared<SequentialScanNode>("l");
+    names->output_columns = {"l.id"};
+    auto indexed = std::make_shared<PhysicalIndexScanNode>("r", "r_id_idx");
+    indexed->output_columns = {"r.id"};
+    indexed->index_columns = {"id"};
+    for (const std::string id : {"2", "9", "10", "100"}) {
+        names->mock_data.emplace_back(std::vector<std::string>{id});
+        indexed->mock_data.emplace_back(std::vector<std::string>{id});
+    }
+    PhysicalSortKey name_key;
+    name_key.expression = column("l.id");
+    name_key.type = SortKeyType::TEXT;
+    auto sorted_names = std::make_shared<PhysicalSortNode>();
+    sorted_names->sort_keys.push_back(name_key);
+    sorted_names->output_columns = names->output_columns;
+    sorted_names->children.push_back(names);
+    text_join->children = {sorted_names, indexed};
+    text_join->left_keys.push_back(column("l.id"));
+    text_join->right_keys.push_back(column("r.id"));
+    text_join->key_types = {SortKeyType::TEXT};
+    text_join->output_columns = {"l.id", "r.id"};
+    assert(PhysicalPlan(text_join).execute().size() == 4);
+    
+    std::cout << "✓ Merge join execution passed" << std::endl;
+}
+
+void test_index_nested_loop_join_execution() {
+    std::cout << "Testing index nested loop join execution..." << std::endl;
+    
+    ExecutionContext context;
+    context.work_mem_limit = 4 * 1000; // Output spans several four-row batches
+    
+    const auto make_join = [](JoinType join_type) {
+        auto orders = std::make_shared<SequentialScanNode>("orders");
+        orders->output_columns = {"orders.id", "orders.customer"};
+        for (const std::string id : {"3", "1", "", "2", "3", "7"}) {
+            orders->mock_data.emplace_back(std::vector<std::string>{id, "c" + id});
+        }
+        
+        // Index on order_items.order_id: entries are kept in key order
+        auto items = std::make_shared<PhysicalIndexScanNode>("order_items", "idx_order_items_order_id");
+        items->output_columns = {"order_items.order_id", "order_items.sku"};
+        items->index_columns = {"order_id"};
+        for (const std::string id : {"1", "1", "2", "3", "3", "3", "5"}) {
+            items->mock_data.emplace_back(std::vector<std::string>{id, "sku" + id});
+        }
+        
+        auto join = std::make_shared<PhysicalIndexNestedLoopJoinNode>(join_type);
+        join->outer_keys.push_back(column("orders.id"));
+        join->inner_keys.push_back(column("order_items.order_id"));
+        join->children = {orders, items};
+        join->output_columns = {"orders.id", "orders.customer", "order_items.order_id", "order_items.sku"};
+        if (join_type == JoinType::SEMI || join_type == JoinType::ANTI) {
+            join->output_columns.resize(2);
+        }
+        return join;
+    };
+    
+    const auto run = [&](JoinType join_type, std::vector<std::string>* outer_ids = nullptr) {
+        auto join = make_join(join_type);
+        join->initialize(&context);
+        size_t rows = 0;
+        while (join->has_more_data()) {
+            auto batch = join->get_next_batch();
+            for (const auto& tuple : batch.tuples) {
+                if (tuple.values.size() == 4 && !tuple.values[2].empty()) {
+                    assert(tuple.values[0] == tuple.values[2]);
+                }
+                if (outer_ids) outer_ids->push_back(tuple.values[0]);
+            }
+            rows += batch.size();
+        }
+        // One lookup per distinct non-NULL key in each outer batch
+        assert(join->get_probe_count() == 5);
+        return rows;
+    };
+    
+    std::vector<std::string> inner_order;
+    assert(run(JoinType::INNER, &inner_order) == 9);
+    // Output follows the outer row order
+    const std::vector<std::string> expected_order = {"3", "3", "3", "1", "1", "2", "3", "3", "3"};
+    assert(inner_order == expected_order);
+    assert(run(JoinType::LEFT) == 11);
+    assert(run(JoinType::SEMI) == 4);
+    assert(run(JoinType::ANTI) == 2);
+    
+    // The inner scan's own conditions apply to every probed row
+    auto filtered = make_join(JoinType::INNER);
+    auto not_sku3 = comparison("<>", "order_items.sku", "sku3");
+    std::static_pointer_cast<PhysicalIndexScanNode>(filtered->children[1])->filter_conditions.push_back(not_sku3);
+    filtered->initialize(&context);
+    size_t filtered_rows = 0;
+    while (filtered->has_more_data()) {
+        for (const auto& tuple : filtered->get_next_batch().tuples) {
+            assert(tuple.values[3] != "sku3");
+            filtered_rows++;
+        }
+    }
+    assert(filtered_rows == 3);
+    
+    // A key past the index prefix compares in its index type, as the probe
+    // would: under text "02" is not "2"
+    auto coded = std::make_shared<SequentialScanNode>("orders");
+    coded->output_columns = {"orders.id", "orders.code"};
+    coded->mock_data = {Tuple(std::vector<std::string>{"1", "02"}), Tuple(std::vector<std::string>{"1", "2"})};
+    auto codes = std::make_shared<PhysicalIndexScanNode>("order_items", "idx_order_items_order_id_code");
+    codes->output_columns = {"order_items.order_id", "order_items.code"};
+    codes->index_columns = {"order_id", "code"};
+    codes->index_key_types = {SortKeyType::INTEGER, SortKeyType::TEXT};
+    codes->mock_data = {Tuple(std::vector<std::string>{"1", "2"})};
+    auto coded_join = std::make_shared<PhysicalIndexNestedLoopJoinNode>(JoinType::INNER);
+    coded_join->outer_keys = {column("orders.id"), column("orders.code")};
+    coded_join->inner_keys = {column("order_items.order_id"), column("order_items.code")};
+    coded_join->children = {coded, codes};
+    coded_join->output_columns = {"orders.id", "orders.code", "order_items.order_id", "order_items.code"};
+    const auto coded_rows = PhysicalPlan(coded_join).execute();
+    assert(coded_rows.size() == 1 && coded_rows[0].values[1] == "2");
+    
+    std::cout << "✓ Index nested loop join execution passed" << std::endl;
+}
+
+void test_top_n_execution() {
+    std::cout << "Testing top-N execution..." << std::endl;
+    
+    auto seq_scan = std::make_shared<SequentialScanNode>("users");
+    seq_scan->output_columns = {"users.id", "users.email", "users.name"};
+    seq_scan->generate_mock_data(1000);
+    
+    auto top_n = std::make_shared<PhysicalTopNNode>();
+    top_n->children.push_back(seq_scan);
+    top_n->limit = 10;
+    top_n->offset = 5;
+    
+    PhysicalSortKey sort_key;
+    sort_key.expression = column("id");
+    sort_key.ascending = true;
+    top_n->sort_keys.push_back(sort_key);
+    
+    // Push the heap boundary into the scan
+    top_n->threshold = std::make_shared<TopNThreshold>();
+    top_n->threshold->key = sort_key;
+    seq_scan->topn_threshold = top_n->threshold;
+    
+    ExecutionContext context;
+    context.work_mem_limit = 100 * 1000;  // 100-row scan batches
+    top_n->initialize(&context);
+    
+    std::vector<Tuple> results;
+    while (top_n->has_more_data()) {
+        auto batch = top_n->get_next_batch();
+        results.insert(results.end(), batch.tuples.begin(), batch.tuples.end());
+    }
+    
+    // Numeric order, rows 6..15 after skipping the offset
+    assert(results.size() == 10);
+    assert(results.front().get_value(0) == "6");
+    assert(results.back().get_value(0) == "15");
+    
+    // Once the heap filled up during the first batch, the scan dropped
+    // every later row itself
+    assert(top_n->threshold->rows_skipped == 1000 - 100);
+    
+    // Keys that turn out to mix numbers and text order as the full sort
+    // orders them, also when the text only arrives after rows were dropped
+    for (const bool text_last : {false, true}) {
+        const auto make_scan = [&]() {
+            auto scan = std::make_shared<SequentialScanNode>("items");
+            scan->output_columns = {"items.code", "items.id"};
+            for (size_t i = 0; i < 300; ++i) {
+                const std::string code = i % 3 == 0 ? std::to_string(i % 40) : i % 3 == 1 ? std::to_string(i) + ".5" : "";
+                scan->mock_data.emplace_back(std::vector<std::string>{code, std::to_string(i)});
+            }
+            scan->mock_data.insert(text_last ? scan->mock_data.end() : scan->mock_data.begin(),
+                                   Tuple(std::vector<std::string>{"a", "300"}));
+            return scan;
+        };
+        PhysicalSortKey code_key;
+        code_key.expression = column("items.code");
+        code_key.type = SortKeyType::INTEGER; // A hint the values widen past
+        PhysicalSortKey id_key = code_key;
+        id_key.expression = column("items.id");
+        id_key.ascending = false;
+        
+        auto full_sort = std::make_shared<PhysicalSortNode>();
+        full_sort->sort_keys = {code_key, id_key};
+        full_sort->children.push_back(make_scan());
+        const auto sorted = PhysicalPlan(full_sort).execute();
+        
+        auto mixed = std::make_shared<PhysicalTopNNode>();
+        mixed->sort_keys = {code_key, id_key};
+        mixed->limit = 25;
+        mixed->offset = 3;
+        auto scan = make_scan();
+        mixed->threshold = std::make_shared<TopNThreshold>();
+        mixed->threshold->key = code_key;
+        scan->topn_threshold = mixed->threshold;
+        mixed->children.push_back(scan);
+        const auto top = PhysicalPlan(mixed).execute();
+        assert(top.size() == 25);
+        for (size_t i = 0; i < top.size(); ++i) {
+            assert(top[i].values == sorted[i + 3].values);
+        }
+        assert(sorted[0].values[0] == "0" && sorted[3].values[0] == "1"); // "10" sorts before "9" as text
+    }
+    
+    std::cout << "✓ Top-N execution passed (rows: " << results.size() << ")" << std::endl;
+}
+
 void test_limit_execution() {
     std::cout << "Testing limit execution..." << std::endl;
     
@@ -119,6 +640,96 @@ void test_limit_execution() {
     std::cout << "✓ Limit execution passed (rows: " << batch.size() << ")" << std::endl;
 }
 
+void test_projection_execution() {
+    std::cout << "Testing projection execution..." << std::endl;
+    
+    // Scan pruned to name and price: stored rows still carry every column
+    auto products = std::make_shared<SequentialScanNode>("products");
+    products->output_columns = {"p.name", "p.price"};
+    products->projected_columns = {1, 2};
+    products->mock_data.emplace_back(std::vector<std::string>{"1", "apple", "10"});
+    products->mock_data.emplace_back(std::vector<std::string>{"2", "pear", ""});
+    products->mock_data.emplace_back(std::vector<std::string>{"3", "fig", "-4"});
+    
+    auto projection = std::make_shared<PhysicalProjectionNode>();
+    projection->expressions = {
+        call(ExpressionType::FUNCTION_CALL, "upper", {column("p.name")}),
+        operation("*", {column("p.price"), constant("2")}),
+        call(ExpressionType::FUNCTION_CALL, "coalesce", {column("p.price"), constant("0")}),
+        operation(">", {call(ExpressionType::FUNCTION_CALL, "abs", {column("p.price")}), constant("3")}),
+        column("p.price")
+    };
+    projection->output_columns = {"upper(p.name)", "doubled", "price_or_zero", "large", "p.price"};
+    projection->children.push_back(products);
+    
+    ExecutionContext context;
+    projection->initialize(&context);
+    
+    std::vector<std::vector<std::string>> rows;
+    while (projection->has_more_data()) {
+        auto batch = projection->get_next_batch();
+        assert(batch.column_names == projection->output_columns);
+        for (const auto& tuple : batch.tuples) {
+            rows.push_back(tuple.values);
+        }
+    }
+    
+    // NULL propagates through arithmetic and comparisons; coalesce replaces it
+    const std::vector<std::vector<std::string>> expected = {
+        {"APPLE", "20", "10", "true", "10"},
+        {"PEAR", "", "0", "", ""},
+        {"FIG", "-8", "-4", "true", "-4"}
+    };
+    assert(rows == expected);
+    
+    // Expressions naming a column the input lacks are rejected up front
+    auto invalid = std::make_shared<PhysicalProjectionNode>();
+    invalid->expressions = {column("p.id")};
+    invalid->output_columns = {"p.id"};
+    invalid->children.push_back(products->copy());
+    bool threw = false;
+    try {
+        invalid->initialize(&context);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    
+    std::cout << "✓ Projection execution passed (rows: " << rows.size() << ")" << std::endl;
+}
+
+void test_filter_execution() {
+    std::cout << "Testing filter execution..." << std::endl;
+    
+    auto users = std::make_shared<SequentialScanNode>("users");
+    users->output_columns = {"users.id", "users.name"};
+    for (const std::string id : {"1", "2", "3", "4", "5", "6"}) {
+        users->mock_data.emplace_back(std::vector<std::string>{id, id == "5" ? "" : "user" + id});
+    }
+    users->filter_conditions.push_back(comparison(">", "users.id", "2"));
+    
+    // Filter above the scan; NULL names fail the comparison
+    auto filter = std::make_shared<PhysicalFilterNode>();
+    filter->conditions.push_back(comparison("<>", "users.name", "user4"));
+    filter->output_columns = users->output_columns;
+    filter->children.push_back(users);
+    
+    ExecutionContext context;
+    context.work_mem_limit = 2 * 1000; // Two-row scan batches, some filtered out entirely
+    filter->initialize(&context);
+    
+    std::vector<std::string> ids;
+    while (filter->has_more_data()) {
+        for (const auto& tuple : filter->get_next_batch().tuples) {
+            ids.push_back(tuple.values[0]);
+        }
+    }
+    assert((ids == std::vector<std::string>{"3", "6"}));
+    assert(users->get_stats().rows_returned == 4);
+    
+    std::cout << "✓ Filter execution passed (rows: " << ids.size() << ")" << std::endl;
+}
+
 void test_parallel_scan_execution() {
     std::cout << "Testing parallel scan execution..." << std::endl;
     
@@ -286,6 +897,639 @@ void test_plan_display() {
     std::cout << "✓ Plan display passed" << std::endl;
 }
 
+void test_row_bitmap() {
+    std::cout << "Testing row bitmaps..." << std::endl;
+    
+    // Sparse ids in two containers, dense ids filling a third as a bitset
+    std::vector<uint32_t> evens;
+    std::vector<uint32_t> threes;
+    for (uint32_t row = 0; row < 3 * 65536; row += 2) evens.push_back(row);
+    for (uint32_t row = 65536; row < 70000; row += 3) threes.push_back(row);
+    threes.push_back(200000);
+    
+    RowBitmap a(evens);
+    RowBitmap b(threes);
+    assert(a.cardinality() == evens.size() && a.bitset_count() == a.container_count());
+    assert(b.container_count() == 2 && b.bitset_count() == 0);
+    assert(a.contains(65538) && !a.contains(65539) && b.contains(200000));
+    
+    RowBitmap both = a;
+    both &= b;
+    std::vector<uint32_t> expected;
+    for (uint32_t row : threes) {
+        if (row % 2 == 0 && row < 3 * 65536) expected.push_back(row);
+    }
+    assert(both.to_vector() == expected);
+    assert(both.bitset_count() == 0); // Small results shrink back to arrays
+    
+    RowBitmap either = b;
+    either |= a;
+    expected = evens;
+    expected.insert(expected.end(), threes.begin(), threes.end());
+    std::sort(expected.begin(), expected.end());
+    expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+    assert(either.to_vector() == expected);
+    
+    // Arrays turn into bitsets once they pass the limit
+    RowBitmap grown;
+    for (uint32_t row = RowBitmap::array_limit; row-- > 0;) grown.add(row * 7);
+    assert(grown.bitset_count() == 0);
+    grown.add(7 * RowBitmap::array_limit);
+    assert(grown.cardinality() == RowBitmap::array_limit + 1 && grown.bitset_count() == 1);
+    
+    std::cout << "✓ Row bitmaps passed" << std::endl;
+}
+
+void test_table_storage() {
+    std::cout << "Testing table storage..." << std::endl;
+    
+    auto schema = table_schema("shop", "items", {{"id", ColumnType::INTEGER}, {"price", ColumnType::DECIMAL},
+                                                 {"active", ColumnType::BOOLEAN}, {"name", ColumnType::VARCHAR}});
+    
+    // Enough rows to spill over several pages; every tenth name is NULL
+    TableStorage storage(schema);
+    const auto heap = storage.create_table("items");
+    const auto row_values = [](size_t i) {
+        return std::vector<std::string>{std::to_string(i), std::to_string(i) + ".5", i % 2 ? "true" : "false",
+                                        i % 10 ? "item" + std::to_string(i) : ""};
+    };
+    for (size_t i = 0; i < 2000; ++i) {
+        assert(storage.insert("items", row_values(i)) == i);
+    }
+    assert(heap->row_count() == 2000 && heap->page_count() > 1);
+    assert(heap->page_of(0) == 0 && heap->page_of(1999) == heap->page_count() - 1);
+    assert(heap->bytes_used() <= heap->page_count() * TableHeap::page_size);
+    for (size_t i = 0; i < 2000; i += 37) {
+        assert(heap->read(i) == row_values(i));
+    }
+    assert((heap->read(5, {3, 0}) == std::vector<std::string>{"item5", "5"}));
+    assert(heap->value(10, 3).empty());
+    
+    // Values that do not fit the column type are rejected, and nothing is stored
+    const auto rejects = [&](const std::vector<std::string>& values) {
+        try {
+            storage.insert("items", values);
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    assert(rejects({"x", "1", "true", "a"}));
+    assert(rejects({"1", "1", "maybe", "a"}));
+    assert(rejects({"1", "1"}));
+    assert(rejects({"1", "1", "true", std::string(TableHeap::page_size, 'x')}));
+    assert(heap->row_count() == 2000);
+    assert(storage.get_table("orders") == nullptr);
+    bool threw = false;
+    try {
+        storage.create_table("orders");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    
+    // Scans decode the projected columns in place; copies share the heap
+    auto scan = std::make_shared<SequentialScanNode>("items");
+    scan->heap = heap;
+    scan->output_columns = {"items.name", "items.id"};
+    scan->projected_columns = {3, 0};
+    auto copy = std::static_pointer_cast<SequentialScanNode>(scan->copy());
+    assert(copy->heap == heap && copy->mock_data.empty());
+    
+    ExecutionContext context;
+    PhysicalPlan plan(copy);
+    const auto rows = plan.execute();
+    assert(rows.size() == 2000 && copy->mock_data.empty());
+    assert((rows[7].values == std::vector<std::string>{"item7", "7"}));
+    
+    // Index scans search entries built over the heap and fetch rows by id
+    auto index_scan = std::make_shared<PhysicalIndexScanNode>("items", "items_name_idx");
+    index_scan->heap = heap;
+    index_scan->index_columns = {"name"};
+    index_scan->index_conditions = {comparison("=", "items.name", "item42")};
+    index_scan->output_columns = {"items.id", "items.price", "items.active", "items.name"};
+    index_scan->initialize(&context);
+    std::vector<std::vector<std::string>> found;
+    while (index_scan->has_more_data()) {
+        for (const auto& tuple : index_scan->get_next_batch().tuples) {
+            found.push_back(tuple.values);
+        }
+    }
+    assert(found.size() == 1 && found[0] == row_values(42));
+    assert(index_scan->mock_data.empty());
+    
+    std::cout << "✓ Table storage passed (pages: " << heap->page_count() << ")" << std::endl;
+}
+
+void test_columnar_scan() {
+    std::cout << "Testing columnar scan..." << std::endl;
+    
+    // A wide table: an id, a price, a flag and nine text columns
+    std::vector<std::pair<std::string, ColumnType>> event_columns = {
+        {"id", ColumnType::INTEGER}, {"price", ColumnType::DECIMAL}, {"flagged", ColumnType::BOOLEAN}};
+    for (size_t c = 0; c < 9; ++c) {
+        event_columns.emplace_back("attribute" + std::to_string(c), ColumnType::VARCHAR);
+    }
+    auto schema = table_schema("shop", "events", event_columns);
+    
+    TableStorage storage(schema);
+    storage.create_table("events");
+    const auto table = storage.create_columnar_table("events", 4096);
+    const auto row_values = [](size_t i) {
+        std::vector<std::string> values = {std::to_string(i), i % 7 ? std::to_string(i % 100) + ".25" : "",
+                                           i % 3 ? "false" : "true"};
+        for (size_t c = 0; c < 9; ++c) {
+            values.push_back("attribute " + std::to_string(c) + " of event " + std::to_string(i));
+        }
+        return values;
+    };
+    for (size_t i = 0; i < 10000; ++i) {
+        assert(storage.insert("events", row_values(i)) == i);
+    }
+    const auto heap = storage.get_table("events");
+    assert(table->row_count() == 10000 && heap->row_count() == 10000);
+    assert(table->row_group_count() == 3 && table->row_group(2).row_count == 10000 - 2 * 4096);
+    assert(table->value(4321, 1) == "21.25" && table->value(4326, 1).empty() && table->value(9999, 2) == "true");
+    assert(table->row_group(0).columns[1].null_count() == (4096 + 6) / 7);
+    
+    // Rejected rows reach neither store
+    bool threw = false;
+    try {
+        storage.insert("events", {"1", "cheap", "true", "", "", "", "", "", "", "", "", ""});
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw && table->row_count() == 10000 && heap->row_count() == 10000);
+    
+    // Reading two of twelve columns touches a fraction of the heap's bytes
+    auto scan = std::make_shared<PhysicalColumnarScanNode>("events");
+    scan->table = table;
+    scan->output_columns = {"events.price", "events.id"};
+    scan->projected_columns = {1, 0};
+    assert(table->bytes_used({1, 0}) * 10 < heap->bytes_used());
+    
+    // Column batches are typed views of the segments
+    ExecutionContext context;
+    scan->initialize(&context);
+    ColumnBatch columns = scan->next_column_batch();
+    assert(columns.row_count == PhysicalColumnarScanNode::vector_size && columns.columns.size() == 2);
+    assert(columns.columns[0].kind == StorageKind::DECIMAL && columns.columns[1].kind == StorageKind::INTEGER);
+    assert(columns.columns[0].is_null(0) && columns.columns[0].decimals[1] == 1.25);
+    size_t rows_read = columns.row_count;
+    size_t batches = 1;
+    for (columns = scan->next_column_batch(); columns.row_count > 0; columns = scan->next_column_batch()) {
+        assert(columns.first_row == rows_read && columns.columns[1].integers[0] == static_cast<int64_t>(rows_read));
+        if (columns.first_row == 2 * 4096) {
+            // The last row group is not full, so not compressed, and is read in place
+            assert(columns.columns[1].integers == table->row_group(2).columns[0].vector(0, 1).integers);
+        }
+        rows_read += columns.row_count;
+        batches++;
+    }
+    assert(rows_read == 10000 && batches == 5); // Two per full row group, one for the last
+    assert(scan->actual_stats.disk_reads * 5 < heap->page_count());
+    
+    // As rows, after the filters; copies share the column store
+    auto filtered = std::static_pointer_cast<PhysicalColumnarScanNode>(scan->copy());
+    assert(filtered->table == table);
+    auto cheap = comparison("<", "events.price", "2");
+    filtered->filter_conditions.push_back(cheap);
+    PhysicalPlan plan(filtered);
+    const auto rows = plan.execute();
+    size_t expected = 0;
+    for (size_t i = 0; i < 10000; ++i) {
+        if (i % 7 != 0 && i % 100 < 2) expected++;
+    }
+    assert(rows.size() == expected);
+    for (const auto& row : rows) {
+        assert(row.values.size() == 2 && row_values(std::stoul(row.values[1]))[1] == row.values[0]);
+    }
+    
+    std::cout << "✓ Columnar scan passed (bytes read: " << table->bytes_used({1, 0}) << " of "
+              << heap->bytes_used() << ")" << std::endl;
+}
+
+void test_column_compression() {
+    std::cout << "Testing column compression..." << std::endl;
+    
+    auto schema = table_schema("shop", "orders", {{"id", ColumnType::INTEGER},      {"customer_id", ColumnType::INTEGER},
+                                                  {"status", ColumnType::VARCHAR},  {"created_at", ColumnType::TIMESTAMP},
+                                                  {"order_date", ColumnType::DATE}, {"note", ColumnType::TEXT},
+                                                  {"total", ColumnType::DECIMAL}});
+    
+    // Order history: ascending ids and creation times, a few statuses, a
+    // few hundred orders a day and a unique note each
+    int64_t start = 0;
+    assert(parse_timestamp("2024-01-01 08:00:00", start));
+    const std::vector<std::string> statuses = {"pending", "paid", "shipped", "delivered", "cancelled"};
+    const auto row_values = [&](size_t i) {
+        const int64_t created = start + static_cast<int64_t>(i) * 37000000;
+        return std::vector<std::string>{std::to_string(i + 1),
+                                        std::to_string(i * 7919 % 5000),
+                                        i % 97 ? statuses[i * 31 % 7 % 5] : "",
+                                        format_timestamp(created),
+                                        format_date(created / 86400000000),
+                                        "note for order " + std::to_string(i + 1),
+                                        std::to_string(i % 1000) + ".5"};
+    };
+    TableStorage storage(schema);
+    const auto table = storage.create_columnar_table("orders", 8192);
+    for (size_t i = 0; i < 20000; ++i) {
+        storage.insert("orders", row_values(i));
+    }
+    
+    // Full row groups are compressed with the scheme that suits each column
+    const auto& group = table->row_group(0);
+    assert(group.columns[0].encoding() == ColumnEncoding::FRAME_OF_REFERENCE);
+    assert(group.columns[1].encoding() == ColumnEncoding::FRAME_OF_REFERENCE);
+    assert(group.columns[2].encoding() == ColumnEncoding::DICTIONARY);
+    assert(group.columns[3].encoding() == ColumnEncoding::FRAME_OF_REFERENCE);
+    assert(group.columns[4].encoding() == ColumnEncoding::RLE);
+    assert(group.columns[5].encoding() == ColumnEncoding::PLAIN);
+    assert(group.columns[2].null_count() == (8192 + 96) / 97);
+    
+    // The last one once the load is done
+    assert(table->row_group(2).columns[0].encoding() == ColumnEncoding::PLAIN);
+    table->compress();
+    assert(table->row_group(2).columns[0].encoding() == ColumnEncoding::FRAME_OF_REFERENCE);
+    
+    for (size_t i = 0; i < 20000; ++i) {
+        const auto values = row_values(i);
+        for (size_t c = 0; c < values.size(); ++c) {
+            assert(table->value(i, c) == values[c]);
+        }
+    }
+    
+    // All but the notes take several times less space than plain
+    size_t compressed = 0;
+    size_t plain = 0;
+    for (size_t g = 0; g < table->row_group_count(); ++g) {
+        for (size_t c = 0; c < 5; ++c) {
+            ColumnSegment segment = table->row_group(g).columns[c];
+            compressed += segment.bytes_used();
+            segment.decompress();
+            assert(segment.encoding() == ColumnEncoding::PLAIN);
+            plain += segment.bytes_used();
+        }
+    }
+    assert(compressed * 4 < plain);
+    
+    // Scans decode the segments they read
+    auto scan = std::make_shared<PhysicalColumnarScanNode>("orders");
+    scan->table = table;
+    scan->output_columns = {"orders.status", "orders.created_at", "orders.id"};
+    scan->projected_columns = {2, 3, 0};
+    PhysicalPlan plan(scan);
+    const auto rows = plan.execute();
+    assert(rows.size() == 20000);
+    for (const auto& row : rows) {
+        const auto values = row_values(std::stoul(row.values[2]) - 1);
+        assert(row.values[0] == values[2] && row.values[1] == values[3]);
+    }
+    
+    // Runs of booleans, dictionaries of decimals either side of zero, and
+    // appends to a compressed segment
+    ColumnSegment flags(ColumnType::BOOLEAN);
+    ColumnSegment prices(ColumnType::DECIMAL);
+    for (size_t i = 0; i < 3000; ++i) {
+        flags.append(i < 1000 ? "true" : i % 500 ? "false" : "");
+        prices.append(i % 4 == 3 ? "" : std::to_string(static_cast<int>(i % 6) - 3) + ".75");
+    }
+    flags.compress();
+    prices.compress();
+    assert(flags.encoding() == ColumnEncoding::RLE && prices.encoding() == ColumnEncoding::DICTIONARY);
+    assert(flags.value(999) == "true" && flags.value(1000) == "" && flags.value(1001) == "false");
+    assert(prices.value(0) == "-3.75" && prices.value(3) == "" && prices.value(5) == "2.75");
+    prices.append("9.5");
+    assert(prices.encoding() == ColumnEncoding::PLAIN && prices.size() == 3001);
+    assert(prices.value(4) == "1.75" && prices.value(3000) == "9.5");
+    
+    // Timestamps frame of reference cannot restore stay as they are
+    ColumnSegment stamps(ColumnType::TIMESTAMP);
+    for (size_t i = 0; i < 1000; ++i) {
+        stamps.append(i == 500 ? "2024-03-01T12:30:00" : format_timestamp(start + static_cast<int64_t>(i) * 250000));
+    }
+    stamps.compress();
+    assert(stamps.encoding() != ColumnEncoding::FRAME_OF_REFERENCE);
+    assert(stamps.value(500) == "2024-03-01T12:30:00" && stamps.value(1) == "2024-01-01 08:00:00.250000");
+    
+    std::cout << "✓ Column compression passed (" << compressed << " of " << plain << " bytes)" << std::endl;
+}
+
+void test_encoded_execution() {
+    std::cout << "Testing execution on encoded columns..." << std::endl;
+    
+    auto schema = table_schema("shop", "orders", {{"id", ColumnType::INTEGER},     {"customer_id", ColumnType::INTEGER},
+                                                  {"status", ColumnType::VARCHAR}, {"created_at", ColumnType::TIMESTAMP},
+                                                  {"region", ColumnType::INTEGER}, {"total", ColumnType::DECIMAL}});
+    
+    int64_t start = 0;
+    assert(parse_timestamp("2024-01-01 08:00:00", start));
+    const std::vector<std::string> statuses = {"pending", "paid", "shipped", "delivered", "cancelled"};
+    const auto row_values = [&](size_t i) {
+        return std::vector<std::string>{std::to_string(i + 1),
+                                        std::to_string(i * 7919 % 5000),
+                                        i % 97 ? statuses[i * 31 % 7 % 5] : "",
+                                        format_timestamp(start + static_cast<int64_t>(i) * 37000000),
+                                        std::to_string(i / 2500),
+                                        std::to_string(i % 1000) + ".5"};
+    };
+    TableStorage storage(schema);
+    const auto heap = storage.create_table("orders");
+    const auto table = storage.create_columnar_table("orders", 4096);
+    for (size_t i = 0; i < 12000; ++i) {
+        storage.insert("orders", row_values(i));
+    }
+    table->compress();
+    const auto& group = table->row_group(0);
+    assert(group.columns[1].encoding() == ColumnEncoding::FRAME_OF_REFERENCE);
+    assert(group.columns[2].encoding() == ColumnEncoding::DICTIONARY);
+    assert(group.columns[3].encoding() == ColumnEncoding::FRAME_OF_REFERENCE);
+    assert(group.columns[4].encoding() == ColumnEncoding::RLE);
+    
+    const std::vector<std::string> all_columns = {"orders.id",         "orders.customer_id", "orders.status",
+                                                  "orders.created_at", "orders.region",      "orders.total"};
+    
+    // Each filter list against the heap's rows; conditions the heap scan
+    // cannot compile are given to it in an equivalent form
+    const auto check = [&](const std::vector<ExpressionPtr>& filters, size_t encoded,
+                           const std::vector<ExpressionPtr>& reference_filters) {
+        auto scan = std::make_shared<PhysicalColumnarScanNode>("orders");
+        scan->table = table;
+        scan->output_columns = all_columns;
+        scan->filter_conditions = filters;
+        auto reference = std::make_shared<SequentialScanNode>("orders");
+        reference->heap = heap;
+        reference->output_columns = all_columns;
+        reference->filter_conditions = reference_filters;
+        
+        PhysicalPlan plan(scan);
+        const auto rows = plan.execute();
+        assert(scan->encoded_filter_count() == encoded);
+        const auto expected = PhysicalPlan(reference).execute();
+        assert(rows.size() == expected.size());
+        for (size_t i = 0; i < rows.size(); ++i) {
+            assert(rows[i].values == expected[i].values);
+        }
+        return rows.size();
+    };
+    const auto paid = comparison("=", "orders.status", "paid");
+    const auto paid_or_shipped = operation("OR", {paid, comparison("=", "orders.status", "shipped")});
+    assert(check({paid}, 1, {paid}) > 0);
+    assert(check({paid_or_shipped}, 1, {paid_or_shipped}) > check({paid}, 1, {paid}));
+    assert(check({operation("<>", {constant("paid"), column("orders.status")})}, 1,
+                 {comparison("<>", "orders.status", "paid")}) > 0);
+    const auto in_list = operation("IN", {column("orders.status"), constant("cancelled"), constant("refunded")});
+    const auto or_list = operation("OR", {comparison("=", "orders.status", "cancelled"),
+                                          comparison("=", "orders.status", "refunded")});
+    assert(check({in_list}, 1, {or_list}) > 0);
+    
+    // Time ranges on frame-of-reference timestamps, also against a date
+    const std::vector<ExpressionPtr> window = {comparison(">=", "orders.created_at", "2024-01-02 09:30:00"),
+                                               comparison("<", "orders.created_at", "2024-01-03")};
+    assert(check(window, 2, window) > 0);
+    assert(check({comparison(">", "orders.created_at", "2024-01-05")}, 1,
+                 {comparison(">", "orders.created_at", "2024-01-05")}) > 0);
+    const std::vector<ExpressionPtr> cheap = {comparison("<", "orders.customer_id", "100.5"),
+                                              comparison(">", "orders.total", "900")};
+    assert(check(cheap, 2, cheap) > 0);
+    assert(check({comparison("=", "orders.region", "2")}, 1, {comparison("=", "orders.region", "2")}) == 2500);
+    assert(check({comparison("=", "orders.status", "5")}, 1, {comparison("=", "orders.status", "5")}) == 0);
+    
+    // Conditions the segments cannot test run on the rows left
+    const std::vector<ExpressionPtr> mixed = {
+        operation("=", {operation("%", {column("orders.id"), constant("2")}), constant("0")}),
+        comparison("=", "orders.status", "pending"),
+        comparison("=", "orders.customer_id", "abc")
+    };
+    assert(check(mixed, 1, mixed) == 0);
+    assert(check({mixed[0], mixed[1]}, 1, {mixed[0], mixed[1]}) > 0);
+    
+    // GROUP BY on dictionary codes, within a time range
+    const auto aggregate_scan = [&](const std::vector<ExpressionPtr>& filters) {
+        auto scan = std::make_shared<PhysicalColumnarScanNode>("orders");
+        scan->table = table;
+        scan->output_columns = all_columns;
+        scan->filter_conditions = filters;
+        return scan;
+    };
+    using Function = PhysicalColumnarAggregateNode::Function;
+    auto by_status = std::make_shared<PhysicalColumnarAggregateNode>();
+    by_status->children.push_back(aggregate_scan({window[1]}));
+    by_status->group_columns = {2};
+    by_status->aggregates = {{Function::COUNT, std::nullopt}, {Function::SUM, 5}, {Function::MIN, 0},
+                             {Function::MAX, 0},              {Function::AVG, 1}, {Function::COUNT, 2}};
+    std::map<std::string, std::vector<double>> expected; // count, sum, min, max, customer sum
+    for (size_t i = 0; i < 12000; ++i) {
+        const auto values = row_values(i);
+        if (!(values[3] < "2024-01-03")) continue;
+        auto& totals = expected[values[2]];
+        if (totals.empty()) totals = {0, 0, 1e18, 0, 0};
+        totals[0]++;
+        totals[1] += std::stod(values[5]);
+        totals[2] = std::min(totals[2], std::stod(values[0]));
+        totals[3] = std::max(totals[3], std::stod(values[0]));
+        totals[4] += std::stod(values[1]);
+    }
+    const auto groups = PhysicalPlan(by_status).execute();
+    assert(groups.size() == expected.size() && expected.size() == statuses.size() + 1);
+    for (const auto& row : groups) {
+        const auto& totals = expected.at(row.values[0]);
+        assert(row.values[1] == std::to_string(static_cast<size_t>(totals[0])));
+        assert(row.values[2] == format_decimal(totals[1]));
+        assert(std::stod(row.values[3]) == totals[2] && std::stod(row.values[4]) == totals[3]);
+        assert(row.values[5] == format_decimal(totals[4] / totals[0]));
+        assert(row.values[6] == (row.values[0].empty() ? "0" : row.values[1])); // NULLs are not counted
+    }
+    assert(by_status->to_string().find("Group Key: orders.status") != std::string::npos);
+    
+    // Without GROUP BY an RLE column adds a run at a time
+    auto regions = std::make_shared<PhysicalColumnarAggregateNode>();
+    regions->children.push_back(aggregate_scan({paid}));
+    regions->aggregates = {{Function::SUM, 4}, {Function::COUNT, 4}, {Function::MAX, 4}, {Function::COUNT, std::nullopt}};
+    int64_t region_sum = 0;
+    size_t paid_rows = 0;
+    for (size_t i = 0; i < 12000; ++i) {
+        if (row_values(i)[2] != "paid") continue;
+        region_sum += static_cast<int64_t>(i / 2500);
+        paid_rows++;
+    }
+    const auto totals = PhysicalPlan(regions).execute();
+    assert(totals.size() == 1);
+    assert((totals[0].values == std::vector<std::string>{std::to_string(region_sum), std::to_string(paid_rows), "4",
+                                                         std::to_string(paid_rows)}));
+    
+    // GROUP BY an RLE column numbers its runs; no input row leaves one row
+    auto by_region = std::make_shared<PhysicalColumnarAggregateNode>();
+    by_region->children.push_back(aggregate_scan({}));
+    by_region->group_columns = {4};
+    by_region->aggregates = {{Function::COUNT, std::nullopt}};
+    const auto region_counts = PhysicalPlan(by_region).execute();
+    assert(region_counts.size() == 5 && (region_counts[4].values == std::vector<std::string>{"4", "2000"}));
+    auto none = std::make_shared<PhysicalColumnarAggregateNode>();
+    none->children.push_back(aggregate_scan({comparison("=", "orders.status", "lost")}));
+    none->aggregates = {{Function::COUNT, std::nullopt}, {Function::SUM, 5}};
+    assert((PhysicalPlan(none).execute()[0].values == std::vector<std::string>{"0", ""}));
+    
+    // Several group columns group on their values
+    auto pairs = std::make_shared<PhysicalColumnarAggregateNode>();
+    pairs->children.push_back(aggregate_scan({}));
+    pairs->group_columns = {4, 2};
+    pairs->aggregates = {{Function::COUNT, std::nullopt}};
+    size_t counted = 0;
+    const auto pair_rows = PhysicalPlan(pairs).execute();
+    for (const auto& row : pair_rows) counted += std::stoul(row.values[2]);
+    assert(pair_rows.size() == 5 * 6 && counted == 12000);
+    
+    // Text mixing digits and letters: "12ab" is compared as text, never as 12
+    auto tag_schema = table_schema("tags", "tags", {{"id", ColumnType::INTEGER}, {"code", ColumnType::VARCHAR}});
+    TableStorage tag_storage(tag_schema);
+    const auto tag_heap = tag_storage.create_table("tags");
+    const auto tag_table = tag_storage.create_columnar_table("tags", 4096);
+    const std::vector<std::string> codes = {"12", "12ab", "7", "7x", "a7", "120", "1e2", "100"};
+    for (size_t i = 0; i < 6000; ++i) {
+        tag_storage.insert("tags", {std::to_string(i), codes[i * 13 % codes.size()]});
+    }
+    tag_table->compress();
+    assert(tag_table->row_group(0).columns[1].encoding() == ColumnEncoding::DICTIONARY);
+    for (const std::string op : {"=", "<>", "<", "<=", ">", ">="}) {
+        for (const std::string value : {"12ab", "7x", "12", "1e2"}) {
+            auto scan = std::make_shared<PhysicalColumnarScanNode>("tags");
+            scan->table = tag_table;
+            scan->output_columns = {"tags.id", "tags.code"};
+            scan->filter_conditions = {comparison(op, "tags.code", value)};
+            auto reference = std::make_shared<SequentialScanNode>("tags");
+            reference->heap = tag_heap;
+            reference->output_columns = scan->output_columns;
+            reference->filter_conditions = scan->filter_conditions;
+            const auto rows = PhysicalPlan(scan).execute();
+            assert(scan->encoded_filter_count() == 1);
+            const auto expected = PhysicalPlan(reference).execute();
+            assert(rows.size() == expected.size());
+            for (size_t i = 0; i < rows.size(); ++i) {
+                assert(rows[i].values == expected[i].values);
+            }
+        }
+    }
+    
+    std::cout << "✓ Execution on encoded columns passed" << std::endl;
+}
+
+void test_zone_maps() {
+    std::cout << "Testing zone maps..." << std::endl;
+    
+    using Op = ColumnPredicate::Op;
+    const auto predicate = [](Op op, std::vector<std::string> values) {
+        ColumnPredicate result;
+        result.op = op;
+        result.values = std::move(values);
+        return result;
+    };
+    ZoneMap integers(StorageKind::INTEGER);
+    for (const std::string value : {"12", "", "5", "9"}) integers.add(value);
+    assert(integers.row_count() == 4 && integers.null_count() == 1);
+    assert(integers.min() == "5" && integers.max() == "12");
+    assert(!integers.may_match(predicate(Op::EQUAL, {"20"})) && integers.may_match(predicate(Op::EQUAL, {"7"})));
+    assert(!integers.may_match(predicate(Op::LESS, {"5"})) && integers.may_match(predicate(Op::LESS_EQUAL, {"5"})));
+    assert(!integers.may_match(predicate(Op::GREATER, {"12.5"})) && integers.may_match(predicate(Op::GREATER_EQUAL, {"12"})));
+    assert(!integers.may_match(predicate(Op::IN, {"1", "13"})) && integers.may_match(predicate(Op::IN, {"1", "6"})));
+    assert(integers.may_match(predicate(Op::NOT_EQUAL, {"5"})));
+    assert(integers.may_match(predicate(Op::EQUAL, {"abc"}))); // Compares as text, so not ruled out
+    
+    // A block of one value rules out <> that value; an all-NULL block rules out everything
+    ZoneMap flags(StorageKind::BOOLEAN);
+    flags.add("true");
+    flags.add("true");
+    assert(flags.min() == "true" && !flags.may_match(predicate(Op::NOT_EQUAL, {"true"})));
+    ZoneMap nulls(StorageKind::DECIMAL);
+    nulls.add("");
+    assert(nulls.min().empty() && nulls.null_count() == 1);
+    assert(!nulls.may_match(predicate(Op::NOT_EQUAL, {"1"})) && !nulls.may_match(predicate(Op::LESS, {"1"})));
+    
+    // Text bounds, also of ISO timestamps, compare as the executor's text does
+    ZoneMap names(StorageKind::VARIABLE);
+    for (const std::string value : {"dave", "bob", "carol"}) names.add(value);
+    assert(names.min() == "bob" && names.max() == "dave");
+    assert(!names.may_match(predicate(Op::EQUAL, {"alice"})) && names.may_match(predicate(Op::IN, {"alice", "cat"})));
+    assert(!names.may_match(predicate(Op::GREATER, {"dave"})) && names.may_match(predicate(Op::GREATER, {"d"})));
+    
+    // Orders appended in time order: a time range touches only the blocks
+    // holding it, in the heap and in the column store
+    auto schema = table_schema("shop", "orders",
+                               {{"id", ColumnType::INTEGER}, {"created_at", ColumnType::TIMESTAMP}, {"total", ColumnType::DECIMAL}});
+    int64_t start = 0;
+    assert(parse_timestamp("2024-03-01 00:00:00", start));
+    TableStorage storage(schema);
+    const auto heap = storage.create_table("orders");
+    const auto table = storage.create_columnar_table("orders", 1024);
+    std::vector<std::vector<std::string>> rows;
+    for (size_t i = 0; i < 20000; ++i) {
+        rows.push_back({std::to_string(i + 1), i % 50 ? format_timestamp(start + static_cast<int64_t>(i) * 60000000) : "",
+                        std::to_string(i % 300) + ".25"});
+        storage.insert("orders", rows.back());
+    }
+    table->compress();
+    assert(heap->zone(0, 1).null_count() == (heap->first_row(1) + 49) / 50); // Every 50th row from the first
+    assert(heap->zone(0, 1).min() == "2024-03-01 00:01:00");
+    assert(table->row_group(1).columns[0].zone().min() == "1025" && table->row_group(1).columns[0].zone().max() == "2048");
+    
+    const std::vector<ExpressionPtr> day = {comparison(">=", "orders.created_at", "2024-03-05"),
+                                            comparison("<", "orders.created_at", "2024-03-06")};
+    std::vector<std::vector<std::string>> expected;
+    for (const auto& row : rows) {
+        if (row[1] >= "2024-03-05" && row[1] < "2024-03-06") expected.push_back(row);
+    }
+    assert(expected.size() > 1000);
+    const auto check = [&](const PhysicalPlanNodePtr& scan) {
+        const auto result = PhysicalPlan(scan).execute();
+        assert(result.size() == expected.size());
+        for (size_t i = 0; i < result.size(); ++i) {
+            assert(result[i].values == expected[i]);
+        }
+    };
+    
+    auto heap_scan = std::make_shared<SequentialScanNode>("orders");
+    heap_scan->heap = heap;
+    heap_scan->output_columns = {"orders.id", "orders.created_at", "orders.total"};
+    heap_scan->filter_conditions = day;
+    check(heap_scan);
+    assert(heap_scan->actual_stats.disk_reads + heap_scan->actual_stats.blocks_skipped == heap->page_count());
+    assert(heap_scan->actual_stats.disk_reads * 4 < heap->page_count());
+    assert(heap_scan->actual_stats.rows_processed < 2 * expected.size());
+    
+    auto columnar_scan = std::make_shared<PhysicalColumnarScanNode>("orders");
+    columnar_scan->table = table;
+    columnar_scan->output_columns = heap_scan->output_columns;
+    columnar_scan->filter_conditions = day;
+    check(columnar_scan);
+    assert(columnar_scan->actual_stats.blocks_skipped + 2 >= table->row_group_count() - 2);
+    auto full_scan = std::make_shared<PhysicalColumnarScanNode>("orders");
+    full_scan->table = table;
+    full_scan->output_columns = heap_scan->output_columns;
+    PhysicalPlan(full_scan).execute();
+    assert(full_scan->actual_stats.blocks_skipped == 0);
+    assert(columnar_scan->actual_stats.disk_reads * 4 < full_scan->actual_stats.disk_reads);
+    
+    // Only the projected columns' positions count, and a range no block holds reads nothing
+    heap_scan = std::make_shared<SequentialScanNode>("orders");
+    heap_scan->heap = heap;
+    heap_scan->output_columns = {"orders.created_at"};
+    heap_scan->projected_columns = {1};
+    heap_scan->filter_conditions = {comparison(">", "orders.created_at", "2025-01-01")};
+    assert(PhysicalPlan(heap_scan).execute().empty());
+    assert(heap_scan->actual_stats.disk_reads == 0 && heap_scan->actual_stats.blocks_skipped == heap->page_count());
+    columnar_scan = std::make_shared<PhysicalColumnarScanNode>("orders");
+    columnar_scan->table = table;
+    columnar_scan->output_columns = {"orders.id"};
+    columnar_scan->filter_conditions = {comparison("<", "orders.id", "0")};
+    assert(PhysicalPlan(columnar_scan).execute().empty());
+    assert(columnar_scan->actual_stats.disk_reads == 0);
+    assert(columnar_scan->actual_stats.blocks_skipped == table->row_group_count());
+    
+    std::cout << "✓ Zone maps passed (pages: " << heap->page_count() << ", row groups: " << table->row_group_count()
+              << ")" << std::endl;
+}
+
 int main() {
     std::cout << "=== Physical Execution Tests ===" << std::endl;
     
@@ -294,7 +1538,20 @@ int main() {
         test_index_scan_execution();
         test_nested_loop_join_execution();
         test_sort_execution();
+        test_multi_column_sort_execution();
+        test_parallel_sort_execution();
+        test_merge_join_execution();
+        test_index_nested_loop_join_execution();
+        test_row_bitmap();
+        test_table_storage();
+        test_columnar_scan();
+        test_column_compression();
+        test_encoded_execution();
+        test_zone_maps();
+        test_top_n_execution();
         test_limit_execution();
+        test_projection_execution();
+        test_filter_execution();
         test_parallel_scan_execution();
         test_physical_plan_execution();
         test_batch_processing();